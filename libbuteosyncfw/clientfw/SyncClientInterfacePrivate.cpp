@@ -22,7 +22,7 @@
  */
 
 #include <QString>
-#include <QDomDocument>
+#include <QXmlStreamReader>
 #include <ProfileManager.h>
 #include <SyncProfile.h>
 #include <SyncResults.h>
@@ -174,13 +174,15 @@ void SyncClientInterfacePrivate::resultsAvailable(QString aProfileId,
                                                   QString aLastResultsAsXml)
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
-    QDomDocument doc;
-    if (doc.setContent(aLastResultsAsXml, true)) {
-        Buteo::SyncResults results(doc.documentElement());
-        emit resultsAvailable(aProfileId, results);
-    } else {
-        qCDebug(lcButeoCore) << "Invalid Profile Xml Received from msyncd";
+    QXmlStreamReader reader(aLastResultsAsXml);
+    if (reader.readNextStartElement()) {
+        Buteo::SyncResults results(reader);
+        if (!reader.hasError()) {
+            emit resultsAvailable(aProfileId, results);
+            return;
+        }
     }
+    qCDebug(lcButeoCore) << "Invalid Profile Xml Received from msyncd";
 }
 
 bool SyncClientInterfacePrivate::setSyncSchedule(const QString &aProfileId,
@@ -233,14 +235,15 @@ Buteo::SyncResults SyncClientInterfacePrivate::getLastSyncResult(const QString &
 
     if (iSyncDaemon) {
         QString resultASXmlString = iSyncDaemon->getLastSyncResult(aProfileId);
-        QDomDocument doc;
+        QXmlStreamReader reader(resultASXmlString);
 
-        if (doc.setContent(resultASXmlString, true)) {
-            Buteo::SyncResults result(doc.documentElement());
-            return result;
-        } else {
-            qCCritical(lcButeoCore) << "Invalid Profile Xml Received from msyncd";
+        if (reader.readNextStartElement()) {
+            Buteo::SyncResults result(reader);
+            if (!reader.hasError()) {
+                return result;
+            }
         }
+        qCCritical(lcButeoCore) << "Invalid Profile Xml Received from msyncd";
     }
     return SyncResults(QDateTime(),
                        SyncResults::SYNC_RESULT_INVALID, SyncResults::NO_ERROR);
@@ -102,6 +102,34 @@ public Q_SLOTS: // METHODS
         return asyncCallWithArgumentList(QLatin1String("getLastSyncResult"), argumentList);
     }
 
+    //! \see SyncDBusInterface::syncHistory()
+    inline QDBusPendingReply<QStringList> syncHistory(const QString &aProfileId, qlonglong aFrom,
+                                                      qlonglong aTo, int aLimit, int aOffset)
+    {
+        QList<QVariant> argumentList;
+        argumentList << qVariantFromValue(aProfileId) << qVariantFromValue(aFrom)
+                     << qVariantFromValue(aTo) << qVariantFromValue(aLimit) << qVariantFromValue(aOffset);
+        return asyncCallWithArgumentList(QLatin1String("syncHistory"), argumentList);
+    }
+
+    //! \see SyncDBusInterface::syncHistoryByResult()
+    inline QDBusPendingReply<QStringList> syncHistoryByResult(int aMajorCode, int aMinorCode, qlonglong aFrom,
+                                                              qlonglong aTo, int aLimit, int aOffset)
+    {
+        QList<QVariant> argumentList;
+        argumentList << qVariantFromValue(aMajorCode) << qVariantFromValue(aMinorCode)
+                     << qVariantFromValue(aFrom) << qVariantFromValue(aTo)
+                     << qVariantFromValue(aLimit) << qVariantFromValue(aOffset);
+        return asyncCallWithArgumentList(QLatin1String("syncHistoryByResult"), argumentList);
+    }
+
+    //! \see SyncDBusInterface::sessionStatistics()
+    inline QDBusPendingReply<QVariantMap> sessionStatistics()
+    {
+        QList<QVariant> argumentList;
+        return asyncCallWithArgumentList(QLatin1String("sessionStatistics"), argumentList);
+    }
+
     //! \see SyncDBusInterface::isLastSyncScheduled()
     inline QDBusPendingReply<bool> isLastSyncScheduled(const QString &aProfileId)
     {
@@ -0,0 +1,272 @@
+/*
+ * This file is part of buteo-syncfw package
+ *
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+#include "StorageChangeSet.h"
+#include <QHash>
+#include <QSharedData>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+
+namespace Buteo {
+
+static const QString TAG_CHANGE_SET("changeset");
+static const QString TAG_STORAGE("storage");
+static const QString TAG_ITEM("item");
+static const QString ATTR_NAME("name");
+static const QString ATTR_COMPLETE("complete");
+static const QString ATTR_ID("id");
+static const QString ATTR_KIND("kind");
+static const QString KIND_ADDED("added");
+static const QString KIND_MODIFIED("modified");
+static const QString KIND_DELETED("deleted");
+
+// Private implementation class for StorageChangeSet, shared until modified.
+class StorageChangeSetPrivate : public QSharedData
+{
+public:
+    struct Storage {
+        Storage() : iComplete(true) {}
+
+        // Kind of the merged change of each item.
+        QHash<QString, StorageChangeSet::ChangeKind> iItems;
+        bool iComplete;
+    };
+
+    void addChange(Storage &aStorage, const QString &aItemId, StorageChangeSet::ChangeKind aKind);
+
+    QHash<QString, Storage> iStorages;
+};
+
+}
+
+using namespace Buteo;
+
+const int StorageChangeSet::MAX_ITEMS = 10000;
+
+void StorageChangeSetPrivate::addChange(Storage &aStorage, const QString &aItemId,
+                                        StorageChangeSet::ChangeKind aKind)
+{
+    QHash<QString, StorageChangeSet::ChangeKind>::iterator it = aStorage.iItems.find(aItemId);
+    if (it == aStorage.iItems.end()) {
+        aStorage.iItems.insert(aItemId, aKind);
+    } else if (!StorageChangeSet::mergeChange(it.value(), aKind)) {
+        aStorage.iItems.erase(it);
+    }
+}
+
+bool StorageChangeSet::mergeChange(ChangeKind &aKind, ChangeKind aLater)
+{
+    switch (aKind) {
+    case ItemAdded:
+        // Added and deleted again, nothing to sync.
+        if (aLater == ItemDeleted) {
+            return false;
+        }
+        break;
+    case ItemModified:
+        if (aLater == ItemDeleted) {
+            aKind = aLater;
+        }
+        break;
+    case ItemDeleted:
+        // The item came back, the other side still has the old one.
+        if (aLater != ItemDeleted) {
+            aKind = ItemModified;
+        }
+        break;
+    }
+    return true;
+}
+
+StorageChangeSet::StorageChangeSet()
+    :   d_ptr(new StorageChangeSetPrivate())
+{
+}
+
+StorageChangeSet::StorageChangeSet(const StorageChangeSet &aSource)
+    :   d_ptr(aSource.d_ptr)
+{
+}
+
+StorageChangeSet::StorageChangeSet(QXmlStreamReader &aReader)
+    :   d_ptr(new StorageChangeSetPrivate())
+{
+    while (aReader.readNextStartElement()) {
+        if (aReader.name() != TAG_STORAGE) {
+            aReader.skipCurrentElement();
+            continue;
+        }
+
+        const QString name = aReader.attributes().value(ATTR_NAME).toString();
+        StorageChangeSetPrivate::Storage &storage = d_ptr->iStorages[name];
+        storage.iComplete = aReader.attributes().value(ATTR_COMPLETE) != QLatin1String("false");
+        while (aReader.readNextStartElement()) {
+            if (aReader.name() == TAG_ITEM && storage.iComplete) {
+                const QXmlStreamAttributes attributes = aReader.attributes();
+                const QStringRef kind = attributes.value(ATTR_KIND);
+                storage.iItems.insert(attributes.value(ATTR_ID).toString(),
+                                      kind == KIND_ADDED ? ItemAdded :
+                                      kind == KIND_DELETED ? ItemDeleted : ItemModified);
+            }
+            aReader.skipCurrentElement();
+        }
+    }
+}
+
+StorageChangeSet::~StorageChangeSet()
+{
+}
+
+StorageChangeSet &StorageChangeSet::operator=(const StorageChangeSet &aRhs)
+{
+    d_ptr = aRhs.d_ptr;
+    return *this;
+}
+
+void StorageChangeSet::addChanges(const QString &aStorage, const QStringList &aItemIds, ChangeKind aKind)
+{
+    StorageChangeSetPrivate::Storage &storage = d_ptr->iStorages[aStorage];
+    if (!storage.iComplete) {
+        return;
+    }
+
+    foreach (const QString &itemId, aItemIds) {
+        d_ptr->addChange(storage, itemId, aKind);
+    }
+
+    if (storage.iItems.size() > MAX_ITEMS) {
+        setIncomplete(aStorage);
+    }
+}
+
+void StorageChangeSet::setIncomplete(const QString &aStorage)
+{
+    StorageChangeSetPrivate::Storage &storage = d_ptr->iStorages[aStorage];
+    storage.iComplete = false;
+    storage.iItems.clear();
+}
+
+void StorageChangeSet::merge(const StorageChangeSet &aOther)
+{
+    QHash<QString, StorageChangeSetPrivate::Storage>::const_iterator it;
+    for (it = aOther.d_ptr->iStorages.constBegin(); it != aOther.d_ptr->iStorages.constEnd(); ++it) {
+        if (!it->iComplete) {
+            setIncomplete(it.key());
+            continue;
+        }
+
+        StorageChangeSetPrivate::Storage &storage = d_ptr->iStorages[it.key()];
+        if (!storage.iComplete) {
+            continue;
+        }
+        QHash<QString, ChangeKind>::const_iterator item;
+        for (item = it->iItems.constBegin(); item != it->iItems.constEnd(); ++item) {
+            d_ptr->addChange(storage, item.key(), item.value());
+        }
+        if (storage.iItems.size() > MAX_ITEMS) {
+            setIncomplete(it.key());
+        }
+    }
+}
+
+StorageChangeSet StorageChangeSet::take(const QString &aStorage)
+{
+    StorageChangeSet changes;
+    if (d_ptr->iStorages.contains(aStorage)) {
+        changes.d_ptr->iStorages.insert(aStorage, d_ptr->iStorages.take(aStorage));
+    }
+    return changes;
+}
+
+void StorageChangeSet::clear()
+{
+    d_ptr->iStorages.clear();
+}
+
+bool StorageChangeSet::isEmpty() const
+{
+    return d_ptr->iStorages.isEmpty();
+}
+
+QStringList StorageChangeSet::storages() const
+{
+    return d_ptr->iStorages.keys();
+}
+
+bool StorageChangeSet::isComplete(const QString &aStorage) const
+{
+    return d_ptr->iStorages.value(aStorage).iComplete;
+}
+
+QStringList StorageChangeSet::items(const QString &aStorage, ChangeKind aKind) const
+{
+    QStringList items;
+    QHash<QString, StorageChangeSetPrivate::Storage>::const_iterator storage = d_ptr->iStorages.constFind(aStorage);
+    if (storage != d_ptr->iStorages.constEnd()) {
+        QHash<QString, ChangeKind>::const_iterator it;
+        for (it = storage->iItems.constBegin(); it != storage->iItems.constEnd(); ++it) {
+            if (it.value() == aKind) {
+                items.append(it.key());
+            }
+        }
+    }
+    return items;
+}
+
+int StorageChangeSet::itemCount() const
+{
+    int count = 0;
+    foreach (const StorageChangeSetPrivate::Storage &storage, d_ptr->iStorages) {
+        count += storage.iItems.size();
+    }
+    return count;
+
+void StorageChangeSet::toXml(QXmlStreamWriter &aWriter) const
+{
+    aWriter.writeStartElement(TAG_CHANGE_SET);
+    QHash<QString, StorageChangeSetPrivate::Storage>::const_iterator it;
+    for (it = d_ptr->iStorages.constBegin(); it != d_ptr->iStorages.constEnd(); ++it) {
+        aWriter.writeStartElement(TAG_STORAGE);
+        aWriter.writeAttribute(ATTR_NAME, it.key());
+        aWriter.writeAttribute(ATTR_COMPLETE, it->iComplete ? "true" : "false");
+        QHash<QString, ChangeKind>::const_iterator item;
+        for (item = it->iItems.constBegin(); item != it->iItems.constEnd(); ++item) {
+            aWriter.writeEmptyElement(TAG_ITEM);
+            aWriter.writeAttribute(ATTR_ID, item.key());
+            aWriter.writeAttribute(ATTR_KIND, item.value() == ItemAdded ? KIND_ADDED :
+                                   item.value() == ItemDeleted ? KIND_DELETED : KIND_MODIFIED);
+        }
+        aWriter.writeEndElement();
+    }
+    aWriter.writeEndElement();
+}
+
+QString StorageChangeSet::toString() const
+{
+    QString xml;
+    QXmlStreamWriter writer(&xml);
+    writer.writeStartDocument();
+    toXml(writer);
+    writer.writeEndDocument();
+
+    return xml;
+}
+
+}
@@ -0,0 +1,189 @@
+/*
+ * This file is part of buteo-syncfw package
+ *
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+#ifndef STORAGECHANGESET_H
+#define STORAGECHANGESET_H
+
+#include <QMetaType>
+#include <QSharedDataPointer>
+#include <QString>
+#include <QStringList>
+
+class QXmlStreamReader;
+class QXmlStreamWriter;
+
+namespace Buteo {
+
+class StorageChangeSetPrivate;
+
+/*! \brief Items changed in storages, by storage and change kind.
+ *
+ * Storage change notifier plug-ins report the items they see changing.
+ * msyncd collects the changes while a sync on change is pending and hands
+ * them to the client plug-in with the sync profile, so that the plug-in
+ * can sync the changed items only instead of comparing the whole storage.
+ *
+ * Repeated changes to an item are merged: an item added and then modified
+ * is added, an item added and then deleted drops out, and an item deleted
+ * and then added again is modified. A storage whose changes are not known
+ * item by item, because the notifier can not tell or because too many
+ * items changed, is incomplete; the client plug-in must then find the
+ * changes itself.
+ *
+ * Change sets are implicitly shared.
+ */
+class StorageChangeSet
+{
+public:
+    //! Kind of change to an item.
+    enum ChangeKind {
+        //! The item was added.
+        ItemAdded,
+        //! The item was modified.
+        ItemModified,
+        //! The item was deleted.
+        ItemDeleted
+    };
+
+    //! Maximum number of items tracked per storage before the storage is
+    //! marked incomplete.
+    static const int MAX_ITEMS;
+
+    /*! \brief Merges a later change of an item into an earlier one.
+     *
+     * \param aKind Kind of the earlier change, updated to the merged kind.
+     * \param aLater Kind of the later change.
+     * \return False if the changes cancel out, as for an item added and
+     *  then deleted.
+     */
+    static bool mergeChange(ChangeKind &aKind, ChangeKind aLater);
+
+    //! \brief Constructs an empty change set.
+    StorageChangeSet();
+
+    /*! \brief Copy constructor.
+     *
+     * \param aSource Copy source.
+     */
+    StorageChangeSet(const StorageChangeSet &aSource);
+
+    /*! \brief Constructs the change set from an XML stream.
+     *
+     * The reader must be positioned at the start element of the change set
+     * representation. It is left at the matching end element.
+     * \param aReader XML stream reader.
+     */
+    explicit StorageChangeSet(QXmlStreamReader &aReader);
+
+    //! \brief Destructor.
+    ~StorageChangeSet();
+
+    /*! \brief Assignment operator.
+     *
+     * \param aRhs Source.
+     * \return This change set.
+     */
+    StorageChangeSet &operator=(const StorageChangeSet &aRhs);
+
+    /*! \brief Records changes to items of a storage.
+     *
+     * \param aStorage Well-known name of the storage, for example hcontacts.
+     * \param aItemIds Changed items.
+     * \param aKind Kind of the change.
+     */
+    void addChanges(const QString &aStorage, const QStringList &aItemIds, ChangeKind aKind);
+
+    /*! \brief Records that a storage changed without knowing the items.
+     *
+     * \param aStorage Well-known name of the storage.
+     */
+    void setIncomplete(const QString &aStorage);
+
+    /*! \brief Merges another change set into this one.
+     *
+     * \param aOther Later changes.
+     */
+    void merge(const StorageChangeSet &aOther);
+
+    /*! \brief Takes the changes of one storage out of this set.
+     *
+     * \param aStorage Well-known name of the storage.
+     * \return The changes of the storage, empty if it has none.
+     */
+    StorageChangeSet take(const QString &aStorage);
+
+    /*! \brief Removes all changes. */
+    void clear();
+
+    /*! \brief Checks if any storage has changed.
+     *
+     * \return True if no storage has changed.
+     */
+    bool isEmpty() const;
+
+    /*! \brief Gets the storages that have changed.
+     *
+     * \return Well-known storage names.
+     */
+    QStringList storages() const;
+
+    /*! \brief Checks if the changes of a storage are known item by item.
+     *
+     * \param aStorage Well-known name of the storage.
+     * \return False if the storage changed in unknown ways.
+     */
+    bool isComplete(const QString &aStorage) const;
+
+    /*! \brief Gets the changed items of a storage.
+     *
+     * \param aStorage Well-known name of the storage.
+     * \param aKind Kind of the change.
+     * \return Identifiers of the items with that kind of change.
+     */
+    QStringList items(const QString &aStorage, ChangeKind aKind) const;
+
+    /*! \brief Gets the number of changed items in all storages.
+     *
+     * \return Number of items.
+     */
+    int itemCount() const;
+
+    /*! \brief Writes the change set to an XML stream.
+     *
+     * Used for handing the change set to out-of-process client plug-ins.
+     * \param aWriter XML stream writer.
+     */
+    void toXml(QXmlStreamWriter &aWriter) const;
+
+    /*! \brief Exports the change set to QString.
+     *
+     * \return The change set as an XML formatted string.
+     */
+    QString toString() const;
+
+private:
+    QSharedDataPointer<StorageChangeSetPrivate> d_ptr;
+};
+
+}
+
+Q_DECLARE_METATYPE(Buteo::StorageChangeSet)
+
+#endif // STORAGECHANGESET_H
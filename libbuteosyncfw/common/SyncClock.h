@@ -0,0 +1,65 @@
+/*
+ * This file is part of buteo-syncfw package
+ *
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+#ifndef SYNCCLOCK_H
+#define SYNCCLOCK_H
+
+#include <QDateTime>
+
+namespace Buteo {
+
+/*! \brief Source of the current time for sync scheduling.
+ *
+ * Schedule calculations ask this class for the current time instead of
+ * calling QDateTime::currentDateTime() directly, so that tests and
+ * simulations can run them against a virtual clock. By default the system
+ * clock is used.
+ */
+class SyncClock
+{
+public:
+    //! \brief Destructor.
+    virtual ~SyncClock();
+
+    /*! \brief Gets the current time of this clock.
+     *
+     * The default implementation returns the system time.
+     * \return Current time.
+     */
+    virtual QDateTime now() const;
+
+    /*! \brief Gets the current time of the installed clock.
+     *
+     * \return Current time.
+     */
+    static QDateTime currentDateTime();
+
+    /*! \brief Installs a clock.
+     *
+     * Not thread safe: install the clock before scheduling starts.
+     * \param aClock The clock to use. Ownership is not transferred. Null
+     *  restores the system clock.
+     */
+    static void setClock(SyncClock *aClock);
+};
+
+}
+
+#endif // SYNCCLOCK_H
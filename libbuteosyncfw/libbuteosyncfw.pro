@@ -3,8 +3,17 @@ TARGET = buteosyncfw5
 DEPENDPATH += . clientfw common pluginmgr profile
 INCLUDEPATH += . clientfw common pluginmgr profile
 
-VER_MAJ = 0
-VER_MIN = 1
+# 1: Binary incompatible with 0:
+#    - SyncResults holds its data in a QSharedDataPointer, which changes
+#      sizeof(SyncResults).
+#    - StoragePlugin has the new virtuals openCursor and changesSince, which
+#      change the vtable of plugin subclasses.
+#    - StoragePlugin has a new private d_ptr member, which changes the size
+#      and member layout of plugin subclasses.
+#    - StorageItem has the new virtuals view, setData and getFilePath, which
+#      change the vtable of storage item subclasses.
+VER_MAJ = 1
+VER_MIN = 0
 VER_PAT = 0
 
 QT += sql xml dbus network
@@ -23,6 +32,8 @@ PUBLIC_HEADERS += \
            common/Logger.h \
            common/LogMacros.h \
            common/SyncCommonDefs.h \
+           common/SyncClock.h \
+           common/StorageChangeSet.h \
            common/TransportTracker.h \
            common/NetworkManager.h \
            clientfw/SyncClientInterface.h \
@@ -34,6 +45,7 @@ PUBLIC_HEADERS += \
            pluginmgr/StorageChangeNotifierPlugin.h \
            pluginmgr/StorageChangeNotifierPluginLoader.h \
            pluginmgr/StorageItem.h \
+           pluginmgr/StorageItemCursor.h \
            pluginmgr/StoragePlugin.h \
            pluginmgr/StoragePluginLoader.h \
            pluginmgr/SyncPluginBase.h \
@@ -58,10 +70,15 @@ HEADERS += $$PUBLIC_HEADERS \
            clientfw/SyncClientInterfacePrivate.h \
            clientfw/SyncDaemonProxy.h \
            profile/Profile_p.h \
+           profile/ProfileField_p.h \
+           profile/ProfileStore.h \
+           profile/SyncProfile_p.h \
            profile/SyncSchedule_p.h \
 
 
 SOURCES += common/Logger.cpp \
+           common/SyncClock.cpp \
+           common/StorageChangeSet.cpp \
            common/TransportTracker.cpp \
            common/NetworkManager.cpp \
            clientfw/SyncClientInterface.cpp \
@@ -72,6 +89,7 @@ SOURCES += common/Logger.cpp \
            pluginmgr/PluginManager.cpp \
            pluginmgr/ServerPlugin.cpp \
            pluginmgr/StorageItem.cpp \
+           pluginmgr/StorageItemCursor.cpp \
            pluginmgr/StoragePlugin.cpp \
            pluginmgr/SyncPluginBase.cpp \
            pluginmgr/SyncPluginLoader.cpp \
@@ -80,6 +98,7 @@ SOURCES += common/Logger.cpp \
            profile/ProfileFactory.cpp \
            profile/ProfileField.cpp \
            profile/ProfileManager.cpp \
+           profile/ProfileStore.cpp \
            profile/StorageProfile.cpp \
            profile/SyncLog.cpp \
            profile/SyncProfile.cpp \
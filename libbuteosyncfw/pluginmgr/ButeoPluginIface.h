@@ -78,6 +78,13 @@ public Q_SLOTS: // METHODS
         return asyncCallWithArgumentList(QLatin1String("resume"), argumentList);
     }
 
+    inline QDBusPendingReply<> setChangeSet(const QString &aChangeSet)
+    {
+        QList<QVariant> argumentList;
+        argumentList << QVariant::fromValue(aChangeSet);
+        return asyncCallWithArgumentList(QLatin1String("setChangeSet"), argumentList);
+    }
+
     inline QDBusPendingReply<bool> startListen()
     {
         QList<QVariant> argumentList;
@@ -24,11 +24,15 @@
 #include "LogMacros.h"
 #include <QSqlQuery>
 #include <QSqlError>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
 #include <QVariant>
 
 using namespace Buteo;
 
 DeletedItemsIdStorage::DeletedItemsIdStorage()
+    : iChangeLogEnabled(false)
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
 }
@@ -58,7 +62,15 @@ bool DeletedItemsIdStorage::init(const QString &aDbFile)
         return false;
     }
 
-    if (!ensureItemSnapshotExists() || !ensureDeletedItemsExists()) {
+    // Snapshot updates are frequent small writes; the write-ahead log makes
+    // them cheaper and does not block readers.
+    QSqlQuery walQuery(iDb);
+    if (!walQuery.exec("PRAGMA journal_mode=WAL")) {
+        qCWarning(lcButeoCore) << "Could not enable write-ahead logging:" << walQuery.lastError();
+    }
+
+    if (!ensureItemSnapshotExists() || !ensureDeletedItemsExists() ||
+            !ensureChangeLogExists()) {
         return false;
     }
 
@@ -78,6 +90,11 @@ bool DeletedItemsIdStorage::uninit()
     return true;
 }
 
+void DeletedItemsIdStorage::enableChangeLog()
+{
+    iChangeLogEnabled = true;
+}
+
 bool DeletedItemsIdStorage::getSnapshot(QList<QString> &aItems, QList<QDateTime> &aCreationTimes) const
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
@@ -155,13 +172,127 @@ bool DeletedItemsIdStorage::setSnapshot(const QList<QString> &aItems,
     return true;
 }
 
-void DeletedItemsIdStorage::addDeletedItem(const QString &aItem, const QDateTime &aCreationTime,
+bool DeletedItemsIdStorage::updateSnapshot(const QList<QString> &aItems,
+                                           const QList<QDateTime> &aCreationTimes,
+                                           const QDateTime &aDeleteTime,
+                                           QList<QString> &aAddedItems,
+                                           QList<QString> &aRemovedItems)
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    if (aItems.count() != aCreationTimes.count()) {
+        qCWarning(lcButeoCore) << "Could not update snapshot:" << aItems.count() << "items but"
+                               << aCreationTimes.count() << "creation times";
+        return false;
+    }
+
+    bool supportsTransaction = iDb.transaction();
+    if (!supportsTransaction) {
+        qCDebug(lcButeoCore) << "SQL Db doesn't support transactions";
+    }
+
+    // Read the old snapshot inside the transaction, so that the difference
+    // is applied to what was read.
+    QHash<QString, QDateTime> snapshot;
+    QSqlQuery selectQuery(iDb);
+    selectQuery.prepare("SELECT itemid, creationtime FROM snapshot");
+    bool success = selectQuery.exec();
+    while (success && selectQuery.next()) {
+        QDateTime t = selectQuery.value(1).toDateTime();
+        t.setTimeSpec(Qt::UTC);
+        snapshot.insert(selectQuery.value(0).toString(), t);
+    }
+
+    QVariantList addedIds;
+    QVariantList addedCreationTimes;
+    QSet<QString> current;
+    current.reserve(aItems.count());
+    for (int i = 0; i < aItems.count(); ++i) {
+        const QString &itemId = aItems.at(i);
+        current.insert(itemId);
+        if (!snapshot.contains(itemId)) {
+            aAddedItems.append(itemId);
+            addedIds << itemId;
+            addedCreationTimes << aCreationTimes.at(i).toUTC();
+        }
+    }
+
+    QVariantList removedIds;
+    QVariantList removedCreationTimes;
+    QVariantList deleteTimes;
+    for (QHash<QString, QDateTime>::const_iterator i = snapshot.constBegin();
+            i != snapshot.constEnd(); ++i) {
+        if (!current.contains(i.key())) {
+            aRemovedItems.append(i.key());
+            removedIds << i.key();
+            removedCreationTimes << i.value();
+            deleteTimes << aDeleteTime.toUTC();
+        }
+    }
+
+    if (success && !removedIds.isEmpty()) {
+        QSqlQuery deleteQuery(iDb);
+        deleteQuery.prepare("DELETE FROM snapshot WHERE itemid = :itemid");
+        deleteQuery.addBindValue(removedIds);
+
+        // An id may have been deleted before, keep its latest deletion.
+        QSqlQuery deletedQuery(iDb);
+        deletedQuery.prepare("INSERT OR REPLACE INTO deleteditems VALUES(:itemid, :creationtime, :deletetime)");
+        deletedQuery.addBindValue(removedIds);
+        deletedQuery.addBindValue(removedCreationTimes);
+        deletedQuery.addBindValue(deleteTimes);
+
+        success = deleteQuery.execBatch() && deletedQuery.execBatch() &&
+                  (!iChangeLogEnabled || logChanges(aRemovedItems, StorageChangeSet::ItemDeleted));
+        if (!success) {
+            qCWarning(lcButeoCore) << "Could not remove items from snapshot:"
+                                   << deleteQuery.lastError() << deletedQuery.lastError();
+        }
+    }
+
+    if (success && !addedIds.isEmpty()) {
+        QSqlQuery insertQuery(iDb);
+        insertQuery.prepare("INSERT INTO snapshot VALUES (:itemid, :creationtime)");
+        insertQuery.addBindValue(addedIds);
+        insertQuery.addBindValue(addedCreationTimes);
+
+        success = insertQuery.execBatch() &&
+                  (!iChangeLogEnabled || logChanges(aAddedItems, StorageChangeSet::ItemAdded));
+        if (!success) {
+            qCWarning(lcButeoCore) << "Could not add items to snapshot:" << insertQuery.lastError();
+        }
+    }
+
+    if (supportsTransaction) {
+        if (success ? !iDb.commit() : !iDb.rollback()) {
+            qCWarning(lcButeoCore) << "Error while ending transaction : " << iDb.lastError();
+            success = false;
+        }
+    }
+
+    if (success) {
+        qCDebug(lcButeoCore) << "Snapshot updated," << addedIds.count() << "items added,"
+                             << removedIds.count() << "removed";
+    } else {
+        aAddedItems.clear();
+        aRemovedItems.clear();
+    }
+
+    return success;
+}
+
+bool DeletedItemsIdStorage::addDeletedItem(const QString &aItem, const QDateTime &aCreationTime,
                                            const QDateTime &aDeleteTime)
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
 
     const QString queryString("INSERT INTO deleteditems VALUES(:itemid, :creationtime, :deletetime)");
 
+    bool supportsTransaction = iDb.transaction();
+    if (!supportsTransaction) {
+        qCDebug(lcButeoCore) << "SQL Db doesn't support transactions";
+    }
+
     QSqlQuery query(iDb);
 
     query.prepare(queryString);
@@ -169,16 +300,29 @@ void DeletedItemsIdStorage::addDeletedItem(const QString &aItem, const QDateTime
     query.bindValue(":creationtime", aCreationTime.toUTC());
     query.bindValue(":deletetime", aDeleteTime.toUTC());
 
-    if (query.exec()) {
-        qCDebug(lcButeoCore) << "Added item" << aItem << "as deleted at time" << aDeleteTime << ", creation time:" << aCreationTime ;
+    bool success = query.exec();
+    if (success) {
+        success = !iChangeLogEnabled || logChanges(QList<QString>() << aItem, StorageChangeSet::ItemDeleted);
     } else {
         qCWarning(lcButeoCore) << "Could not add item as deleted:" << aItem ;
         qCWarning(lcButeoCore) << "Reason:" << query.lastError() ;
     }
 
+    if (supportsTransaction) {
+        if (success ? !iDb.commit() : !iDb.rollback()) {
+            qCWarning(lcButeoCore) << "Error while ending transaction : " << iDb.lastError();
+            success = false;
+        }
+    }
+
+    if (success) {
+        qCDebug(lcButeoCore) << "Added item" << aItem << "as deleted at time" << aDeleteTime << ", creation time:" << aCreationTime ;
+    }
+
+    return success;
 }
 
-void DeletedItemsIdStorage::addDeletedItems(const QList<QString> &aItems, const QList<QDateTime> &aCreationTimes,
+bool DeletedItemsIdStorage::addDeletedItems(const QList<QString> &aItems, const QList<QDateTime> &aCreationTimes,
                                             const QList<QDateTime> &aDeleteTimes)
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
@@ -208,18 +352,26 @@ void DeletedItemsIdStorage::addDeletedItems(const QList<QString> &aItems, const
     query.addBindValue(creationTimes);
     query.addBindValue(deleteTimes);
 
-    if (query.execBatch()) {
-        qCDebug(lcButeoCore) << "Added" << items.count()  << "items as deleted" ;
+    bool success = query.execBatch();
+    if (success) {
+        success = !iChangeLogEnabled || logChanges(aItems, StorageChangeSet::ItemDeleted);
     } else {
         qCWarning(lcButeoCore) << "Could not add items as deleted" ;
         qCWarning(lcButeoCore) << "Reason:" << query.lastError() ;
     }
 
     if (supportsTransaction) {
-        if (!iDb.commit()) {
-            qCWarning(lcButeoCore) << "Error while committing : " << iDb.lastError();
+        if (success ? !iDb.commit() : !iDb.rollback()) {
+            qCWarning(lcButeoCore) << "Error while ending transaction : " << iDb.lastError();
+            success = false;
         }
     }
+
+    if (success) {
+        qCDebug(lcButeoCore) << "Added" << items.count()  << "items as deleted" ;
+    }
+
+    return success;
 }
 
 bool DeletedItemsIdStorage::getDeletedItems(QList<QString> &aItems, const QDateTime &aTime)
@@ -248,28 +400,162 @@ bool DeletedItemsIdStorage::getDeletedItems(QList<QString> &aItems, const QDateT
     return true;
 }
 
-bool DeletedItemsIdStorage::ensureItemSnapshotExists()
+bool DeletedItemsIdStorage::addChanges(const QList<QString> &aItems,
+                                       StorageChangeSet::ChangeKind aKind)
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
 
-    const QString queryString("CREATE TABLE IF NOT EXISTS snapshot(itemid varchar(512) primary key, creationtime timestamp)");
+    if (aItems.isEmpty()) {
+        return true;
+    }
+
+    bool supportsTransaction = iDb.transaction();
+    if (!supportsTransaction) {
+        qCDebug(lcButeoCore) << "SQL Db doesn't support transactions";
+    }
+
+    bool success = logChanges(aItems, aKind);
+
+    if (supportsTransaction) {
+        if (success ? !iDb.commit() : !iDb.rollback()) {
+            qCWarning(lcButeoCore) << "Error while ending transaction : " << iDb.lastError();
+            success = false;
+        }
+    }
+
+    return success;
+}
+
+qint64 DeletedItemsIdStorage::lastChange() const
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    // Changes up to the pruned one may all be gone, but their numbers are
+    // never reused.
+    const QString queryString("SELECT MAX(IFNULL((SELECT MAX(seq) FROM changelog), 0), pruned) "
+                              "FROM changelogstate WHERE id = 0");
+    QSqlQuery query(iDb);
+    query.prepare(queryString);
+
+    if (!query.exec() || !query.next()) {
+        qCWarning(lcButeoCore) << "Could not read last change:" << query.lastError();
+        return -1;
+    }
+
+    return query.value(0).toLongLong();
+}
+
+bool DeletedItemsIdStorage::getChanges(qint64 aSince, QList<QString> &aItems,
+                                       QList<StorageChangeSet::ChangeKind> &aKinds,
+                                       qint64 &aLast) const
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    QSqlQuery prunedQuery(iDb);
+    prunedQuery.prepare("SELECT pruned FROM changelogstate WHERE id = 0");
+    if (!prunedQuery.exec() || !prunedQuery.next()) {
+        qCWarning(lcButeoCore) << "Could not read change log state:" << prunedQuery.lastError();
+        return false;
+    }
+
+    if (aSince < prunedQuery.value(0).toLongLong()) {
+        qCDebug(lcButeoCore) << "Changes since" << aSince << "have been pruned";
+        return false;
+    }
+
+    const QString queryString("SELECT itemid, kind, seq FROM changelog WHERE seq > :since ORDER BY seq");
     QSqlQuery query(iDb);
     query.prepare(queryString);
+    query.bindValue(":since", aSince);
 
     if (!query.exec()) {
-        qCWarning(lcButeoCore) << "Query failed: " << query.lastError();
+        qCWarning(lcButeoCore) << "Could not retrieve changes:" << query.lastError();
         return false;
-    } else {
-        qCDebug(lcButeoCore) << "Ensured database table: snapshot" ;
-        return true;
     }
+
+    aLast = aSince;
+    while (query.next()) {
+        aItems.append(query.value(0).toString());
+        aKinds.append(static_cast<StorageChangeSet::ChangeKind>(query.value(1).toInt()));
+        aLast = query.value(2).toLongLong();
+    }
+
+    qCDebug(lcButeoCore) << "Found" << aItems.count() << "changes since" << aSince;
+
+    return true;
 }
 
-bool DeletedItemsIdStorage::ensureDeletedItemsExists()
+bool DeletedItemsIdStorage::pruneChanges(qint64 aUpTo)
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    // Never mark changes pruned before they have been logged, they would be
+    // lost to readers.
+    qint64 upTo = qMin(aUpTo, lastChange());
+    if (upTo <= 0) {
+        return upTo == 0;
+    }
+
+    bool supportsTransaction = iDb.transaction();
+    if (!supportsTransaction) {
+        qCDebug(lcButeoCore) << "SQL Db doesn't support transactions";
+    }
+
+    QSqlQuery deleteQuery(iDb);
+    deleteQuery.prepare("DELETE FROM changelog WHERE seq <= :upto");
+    deleteQuery.bindValue(":upto", upTo);
+
+    QSqlQuery stateQuery(iDb);
+    stateQuery.prepare("UPDATE changelogstate SET pruned = MAX(pruned, :upto) WHERE id = 0");
+    stateQuery.bindValue(":upto", upTo);
+
+    bool success = deleteQuery.exec() && stateQuery.exec();
+    if (!success) {
+        qCWarning(lcButeoCore) << "Could not prune changes:" << deleteQuery.lastError()
+                               << stateQuery.lastError();
+    }
+
+    if (supportsTransaction) {
+        if (success ? !iDb.commit() : !iDb.rollback()) {
+            qCWarning(lcButeoCore) << "Error while ending transaction : " << iDb.lastError();
+            success = false;
+        }
+    }
+
+    return success;
+}
+
+bool DeletedItemsIdStorage::logChanges(const QList<QString> &aItems,
+                                       StorageChangeSet::ChangeKind aKind)
+{
+    const QString queryString("INSERT INTO changelog(itemid, kind) VALUES(:itemid, :kind)");
+    QSqlQuery query(iDb);
+    query.prepare(queryString);
+
+    QVariantList items;
+    QVariantList kinds;
+
+    foreach (const QString &item, aItems) {
+        items << item;
+        kinds << static_cast<int>(aKind);
+    }
+
+    query.addBindValue(items);
+    query.addBindValue(kinds);
+
+    if (!query.execBatch()) {
+        qCWarning(lcButeoCore) << "Could not log changes:" << query.lastError();
+        return false;
+    }
+
+    return true;
+}
+
+bool DeletedItemsIdStorage::ensureItemSnapshotExists()
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
 
-    const QString queryString("CREATE TABLE IF NOT EXISTS deleteditems(itemid varchar(512) primary key, creationtime timestamp, deletetime timestamp)");
+    const QString queryString("CREATE TABLE IF NOT EXISTS snapshot(itemid varchar(512) primary key, creationtime timestamp)");
     QSqlQuery query(iDb);
     query.prepare(queryString);
 
@@ -277,7 +563,52 @@ bool DeletedItemsIdStorage::ensureDeletedItemsExists()
         qCWarning(lcButeoCore) << "Query failed: " << query.lastError();
         return false;
     } else {
-        qCDebug(lcButeoCore) << "Ensured database table: deleteditems" ;
+        qCDebug(lcButeoCore) << "Ensured database table: snapshot" ;
         return true;
     }
 }
+
+bool DeletedItemsIdStorage::ensureDeletedItemsExists()
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    QStringList queryStrings;
+    queryStrings << "CREATE TABLE IF NOT EXISTS deleteditems(itemid varchar(512) primary key, creationtime timestamp, deletetime timestamp)"
+                 << "CREATE INDEX IF NOT EXISTS deleteditems_deletetime ON deleteditems(deletetime)";
+
+    foreach (const QString &queryString, queryStrings) {
+        QSqlQuery query(iDb);
+        query.prepare(queryString);
+
+        if (!query.exec()) {
+            qCWarning(lcButeoCore) << "Query failed: " << query.lastError();
+            return false;
+        }
+    }
+
+    qCDebug(lcButeoCore) << "Ensured database table: deleteditems" ;
+    return true;
+}
+
+bool DeletedItemsIdStorage::ensureChangeLogExists()
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    QStringList queryStrings;
+    queryStrings << "CREATE TABLE IF NOT EXISTS changelog(seq integer primary key autoincrement, itemid varchar(512), kind integer)"
+                 << "CREATE TABLE IF NOT EXISTS changelogstate(id integer primary key, pruned integer)"
+                 << "INSERT OR IGNORE INTO changelogstate VALUES(0, 0)";
+
+    foreach (const QString &queryString, queryStrings) {
+        QSqlQuery query(iDb);
+        query.prepare(queryString);
+
+        if (!query.exec()) {
+            qCWarning(lcButeoCore) << "Query failed: " << query.lastError();
+            return false;
+        }
+    }
+
+    qCDebug(lcButeoCore) << "Ensured database table: changelog" ;
+    return true;
+}
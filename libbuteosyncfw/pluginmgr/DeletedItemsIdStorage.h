@@ -25,11 +25,18 @@
 
 #include <QSqlDatabase>
 #include <QDateTime>
+#include "StorageChangeSet.h"
 
 namespace Buteo {
 
 /*!
  * \brief Persistent storage for storing deleted item IDs
+ *
+ * Also keeps a log of item changes, numbered in the order they were
+ * recorded. Storage plugins record their additions and modifications in
+ * the log; once the change log is enabled, deletions added to this storage
+ * are logged automatically. The changes after a known point can then be
+ * read in one query, without depending on item timestamps or the clock.
  */
 class DeletedItemsIdStorage
 {
@@ -59,6 +66,13 @@ public:
      */
     bool uninit();
 
+    /*! \brief Enables logging of deletions in the change log
+     *
+     * Off by default, so that plugins that do not read the change log do
+     * not grow it.
+     */
+    void enableChangeLog();
+
     /*! \brief Retrieves persistently stored snapshot of item id's
      *
      * @param aItems Items of the snapshot
@@ -75,21 +89,49 @@ public:
      */
     bool setSnapshot(const QList<QString> &aItems, const QList<QDateTime> &aCreationTimes);
 
+    /*! \brief Updates the persistent snapshot to the current items
+     *
+     * Compares the current items to the stored snapshot and writes only the
+     * difference, in one transaction. Items that are no longer present are
+     * added as deleted, with their creation times from the snapshot. If the
+     * change log is enabled, the removed and the added items are recorded in
+     * it in the same transaction. Replaces reading the
+     * snapshot, comparing it in memory and setting it again in full.
+     *
+     * @param aItems Ids of the current items
+     * @param aCreationTimes Creation times of the current items, one for
+     *  each item
+     * @param aDeleteTime Time of deletion for the removed items
+     * @param aAddedItems Returned ids of the items not in the old snapshot
+     * @param aRemovedItems Returned ids of the items no longer present
+     * @return True on success, otherwise false. On failure the stored
+     *  snapshot and deleted items are left unchanged.
+     */
+    bool updateSnapshot(const QList<QString> &aItems, const QList<QDateTime> &aCreationTimes,
+                        const QDateTime &aDeleteTime, QList<QString> &aAddedItems,
+                        QList<QString> &aRemovedItems);
+
     /*! \brief Adds a deleted item to backend
      *
+     * The deletion is also recorded in the change log if it is enabled.
      * @param aItem Item Id
      * @param aCreationTime Time when item was initially created
      * @param aDeleteTime Time of deletion
+     * @return True on success, otherwise false. On failure neither the
+     *  item nor its deletion is stored.
      */
-    void addDeletedItem(const QString &aItem, const QDateTime &aCreationTime, const QDateTime &aDeleteTime);
+    bool addDeletedItem(const QString &aItem, const QDateTime &aCreationTime, const QDateTime &aDeleteTime);
 
     /*! \brief Adds deleted items to backend
      *
+     * The deletions are also recorded in the change log if it is enabled.
      * @param aItems Items Ids
      * @param aCreationTimes Times when the items were initially created
      * @param aDeleteTimes Times of deletion
+     * @return True on success, otherwise false. On failure none of the
+     *  items or their deletions are stored.
      */
-    void addDeletedItems(const QList<QString> &aItems, const QList<QDateTime> &aCreationTimes,
+    bool addDeletedItems(const QList<QString> &aItems, const QList<QDateTime> &aCreationTimes,
                          const QList<QDateTime> &aDeleteTimes);
 
     /*! \brief Returns the deleted items after given time
@@ -100,6 +142,43 @@ public:
      */
     bool getDeletedItems(QList<QString> &aItems, const QDateTime &aTime);
 
+    /*! \brief Records changes to items in the change log
+     *
+     * @param aItems Ids of the changed items
+     * @param aKind Kind of the change
+     * @return True on success, otherwise false
+     */
+    bool addChanges(const QList<QString> &aItems, StorageChangeSet::ChangeKind aKind);
+
+    /*! \brief Returns the number of the last change in the change log
+     *
+     * @return Change number, 0 if nothing has been logged, -1 on error
+     */
+    qint64 lastChange() const;
+
+    /*! \brief Returns the changes logged after a given change
+     *
+     * The changes are returned in the order they were logged, without
+     * merging repeated changes of the same item.
+     * @param aSince Number of the last change already known
+     * @param aItems Returned item ids
+     * @param aKinds Returned change kinds, one for each item id
+     * @param aLast Number of the last returned change, or aSince if none
+     * @return True on success, false on error or if changes after aSince
+     *  have already been pruned
+     */
+    bool getChanges(qint64 aSince, QList<QString> &aItems,
+                    QList<StorageChangeSet::ChangeKind> &aKinds, qint64 &aLast) const;
+
+    /*! \brief Removes changes from the change log
+     *
+     * Changes can be pruned once all their readers have read past them.
+     * Reading changes since an earlier change fails afterwards.
+     * @param aUpTo Number of the last change to remove
+     * @return True on success, otherwise false
+     */
+    bool pruneChanges(qint64 aUpTo);
+
 protected:
 
     /**
@@ -114,10 +193,19 @@ protected:
      */
     bool ensureDeletedItemsExists();
 
+    /**
+     * \brief Checks whether change log tables exist and creates them if needed
+     * @return True on success, otherwise false
+     */
+    bool ensureChangeLogExists();
+
 private:
 
+    bool logChanges(const QList<QString> &aItems, StorageChangeSet::ChangeKind aKind);
+
     QSqlDatabase iDb;           ///< Database handle
     QString iConnectionName;    ///< Database connection ID string
+    bool iChangeLogEnabled;     ///< Deletions are logged in the change log
 };
 
 }
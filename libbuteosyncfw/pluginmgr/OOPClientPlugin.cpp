@@ -20,7 +20,7 @@
 * 02110-1301 USA
 */
 
-#include <QDomDocument>
+#include <QXmlStreamReader>
 #include "OOPClientPlugin.h"
 #include "LogMacros.h"
 
@@ -90,6 +90,17 @@ OOPClientPlugin::~OOPClientPlugin()
 bool OOPClientPlugin::init()
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    // The runner loads the profile from disk, which does not carry the
+    // change set, so hand it over before the plugin is created.
+    if (!iProfile.changeSet().isEmpty()) {
+        QDBusPendingReply<> changeSetReply = iOopPluginIface->setChangeSet(iProfile.changeSet().toString());
+        changeSetReply.waitForFinished();
+        if (!changeSetReply.isValid()) {
+            qCWarning(lcButeoCore) << "Invalid reply for setChangeSet from plugin, syncing without changes" ;
+        }
+    }
+
     QDBusPendingReply<bool> reply = iOopPluginIface->init();
     reply.waitForFinished();
     if (!reply.isValid()) {
@@ -165,15 +176,17 @@ SyncResults OOPClientPlugin::getSyncResults() const
     }
 
     QString resultAsXml = reply.value();
-    QDomDocument doc;
-    if (doc.setContent(resultAsXml, true)) {
-        SyncResults syncResult(doc.documentElement());
-        return syncResult;
-    } else {
-        qCCritical(lcButeoCore) << "Invalid sync results returned from plugin" ;
-        return SyncResults(QDateTime::currentDateTime(),
-                           SyncResults::SYNC_RESULT_INVALID, SyncResults::NO_ERROR);
+    QXmlStreamReader reader(resultAsXml);
+    if (reader.readNextStartElement()) {
+        SyncResults syncResult(reader);
+        if (!reader.hasError()) {
+            return syncResult;
+        }
     }
+
+    qCCritical(lcButeoCore) << "Invalid sync results returned from plugin" ;
+    return SyncResults(QDateTime::currentDateTime(),
+                       SyncResults::SYNC_RESULT_INVALID, SyncResults::NO_ERROR);
 }
 
 void OOPClientPlugin::connectivityStateChanged(Sync::ConnectivityType aType, bool aState)
@@ -3,6 +3,8 @@
 
 #include <QObject>
 #include <QString>
+#include <QStringList>
+#include "StorageChangeSet.h"
 
 namespace Buteo {
 
@@ -67,6 +69,20 @@ Q_SIGNALS:
      */
     void storageChange();
 
+    /*! \brief emit this signal to tell which items changed, before
+     * emitting storageChange() for the same changes.
+     *
+     * Optional. When a plug-in reports its items, the sync triggered by
+     * the change gets the changed items with its profile, see
+     * SyncProfile::changeSet(). Otherwise the client plug-in has to find
+     * the changes itself. A plug-in that emits this signal should do so
+     * for all of its changes.
+     *
+     * @param aItemIds identifiers of the changed items
+     * @param aKind kind of the change
+     */
+    void itemsChanged(const QStringList &aItemIds, Buteo::StorageChangeSet::ChangeKind aKind);
+
 protected:
     QString iStorageName;
 };
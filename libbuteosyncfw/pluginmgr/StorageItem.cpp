@@ -72,3 +72,18 @@ const QString &StorageItem::getVersion() const
     return iVersion;
 }
 
+bool StorageItem::view(qint64 aOffset, qint64 aLength, QByteArray &aView) const
+{
+    aView.clear();
+    return read(aOffset, aLength, aView);
+}
+
+bool StorageItem::setData(const QByteArray &aData)
+{
+    return write(0, aData) && (getSize() == aData.size() || resize(aData.size()));
+}
+
+QString StorageItem::getFilePath() const
+{
+    return QString();
+}
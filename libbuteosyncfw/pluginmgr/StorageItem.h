@@ -124,6 +124,44 @@ public:
      */
     virtual qint64 getSize() const = 0;
 
+    /*! \brief Gets a read-only view of (part of) the item data
+     *
+     * Items that keep their data in memory or in a mapped file can return
+     * a view of it without copying, for example with
+     * QByteArray::fromRawData. The view is only valid until the item is
+     * modified or destroyed; copy it to keep it longer. The default
+     * implementation reads a copy of the data with read().
+     *
+     * @param aOffset The offset in bytes from where the data is viewed
+     * @param aLength The number of bytes to view
+     * @param aView Returned view of the data
+     * @return True on success, otherwise false
+     */
+    virtual bool view(qint64 aOffset, qint64 aLength, QByteArray &aView) const;
+
+    /*! \brief Replaces the item data
+     *
+     * Items that keep their data in memory can share the implicitly shared
+     * buffer instead of copying it. The default implementation writes the
+     * data with write() and only then truncates the item to its length,
+     * so that a failed write does not leave the item truncated.
+     *
+     * @param aData New data of the item
+     * @return True on success, otherwise false
+     */
+    virtual bool setData(const QByteArray &aData);
+
+    /*! \brief Gets the file holding the item data
+     *
+     * Items whose data is exactly the contents of a file can return its
+     * path, so that the data can be mapped or sent straight from the file
+     * instead of being read through the item. The default implementation
+     * returns an empty string.
+     *
+     * @return Path of the file, empty if the data is not in a file of its own
+     */
+    virtual QString getFilePath() const;
+
 private:
     QString iId;
     QString iParentId;
@@ -0,0 +1,70 @@
+/*
+ * This file is part of buteo-syncfw package
+ *
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+#include "StorageItemCursor.h"
+#include "StoragePlugin.h"
+
+using namespace Buteo;
+
+StorageItemCursor::~StorageItemCursor()
+{
+}
+
+int StorageItemCursor::count() const
+{
+    return -1;
+}
+
+StorageItemIdCursor::StorageItemIdCursor(StoragePlugin *aPlugin,
+                                         const QStringList &aItemIds)
+    : iPlugin(aPlugin), iItemIds(aItemIds), iPosition(0)
+{
+}
+
+StorageItemIdCursor::~StorageItemIdCursor()
+{
+}
+
+bool StorageItemIdCursor::fetch(QList<StorageItem *> &aItems, int aMaxItems)
+{
+    if (iPlugin == 0) {
+        return false;
+    }
+
+    if (aMaxItems <= 0 || atEnd()) {
+        return true;
+    }
+
+    QStringList batch = iItemIds.mid(iPosition, aMaxItems);
+    iPosition += batch.count();
+    aItems.append(iPlugin->getItems(batch));
+
+    return true;
+}
+
+bool StorageItemIdCursor::atEnd() const
+{
+    return iPosition >= iItemIds.count();
+}
+
+int StorageItemIdCursor::count() const
+{
+    return iItemIds.count();
+}
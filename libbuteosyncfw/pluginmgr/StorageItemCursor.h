@@ -0,0 +1,102 @@
+/*
+ * This file is part of buteo-syncfw package
+ *
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+#ifndef STORAGEITEMCURSOR_H
+#define STORAGEITEMCURSOR_H
+
+#include <QList>
+#include <QStringList>
+
+namespace Buteo {
+
+class StorageItem;
+class StoragePlugin;
+
+/*! \brief Cursor for reading storage items in batches.
+ *
+ * A cursor is opened with StoragePlugin::openCursor. The client plug-in
+ * then fetches items a batch at a time, and can encode and send each batch
+ * before reading the next one, so that only one batch of items needs to be
+ * in memory at a time. Deleting the cursor closes it. The storage plug-in
+ * must outlive its cursors.
+ */
+class StorageItemCursor
+{
+public:
+    //! \brief Destructor, closes the cursor.
+    virtual ~StorageItemCursor();
+
+    /*! \brief Fetches the next batch of items.
+     *
+     * @param aItems List where to append the items. The caller owns them.
+     * @param aMaxItems Maximum number of items to fetch.
+     * @return True on success, otherwise false
+     */
+    virtual bool fetch(QList<StorageItem *> &aItems, int aMaxItems) = 0;
+
+    /*! \brief Checks if all items have been fetched.
+     *
+     * @return True if there are no more items
+     */
+    virtual bool atEnd() const = 0;
+
+    /*! \brief Returns the total number of items the cursor yields.
+     *
+     * Items removed from the storage while the cursor is open are skipped,
+     * so fewer items may be fetched than counted.
+     * @return Number of items, -1 if not known in advance
+     */
+    virtual int count() const;
+};
+
+/*! \brief Cursor over a list of item ids.
+ *
+ * Fetches the items of each batch with StoragePlugin::getItems. This is the
+ * cursor StoragePlugin::openCursor returns by default, built from the item
+ * ids of the selection. Plug-ins that already have the ids can use it too.
+ */
+class StorageItemIdCursor : public StorageItemCursor
+{
+public:
+    /*! \brief Constructor
+     *
+     * @param aPlugin Storage plug-in to read the items from
+     * @param aItemIds Ids of the items to read, in order
+     */
+    StorageItemIdCursor(StoragePlugin *aPlugin, const QStringList &aItemIds);
+
+    //! \brief Destructor
+    virtual ~StorageItemIdCursor();
+
+    virtual bool fetch(QList<StorageItem *> &aItems, int aMaxItems);
+
+    virtual bool atEnd() const;
+
+    virtual int count() const;
+
+private:
+    StoragePlugin *iPlugin;
+    QStringList iItemIds;
+    int iPosition;
+};
+
+}
+
+#endif // STORAGEITEMCURSOR_H
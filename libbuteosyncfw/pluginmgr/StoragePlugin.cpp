@@ -21,16 +21,76 @@
  *
  */
 #include "StoragePlugin.h"
+#include "StorageItemCursor.h"
+#include "DeletedItemsIdStorage.h"
+#include "LogMacros.h"
+#include <QHash>
+#include <QMap>
+
+namespace Buteo {
+
+class StoragePluginPrivate
+{
+public:
+    StoragePluginPrivate();
+
+    //! Change log used by changesSince, if any
+    DeletedItemsIdStorage *iChangeLog;
+};
+
+}
 
 using namespace Buteo;
 
+// Prefixes of change log and time based sync anchors.
+static const QString LOG_ANCHOR_PREFIX("log:");
+static const QString TIME_ANCHOR_PREFIX("time:");
+
+// Merges the changes of each item, ordered by their last change, and
+// appends them to aChanges.
+static void appendMergedChanges(const QList<QString> &aItemIds,
+                                const QList<StorageChangeSet::ChangeKind> &aKinds,
+                                QList<StoragePlugin::ItemChange> &aChanges)
+{
+    QHash<QString, StorageChangeSet::ChangeKind> merged;
+    QMap<int, QString> order;
+    QHash<QString, int> position;
+    for (int i = 0; i < aItemIds.count(); ++i) {
+        const QString &itemId = aItemIds.at(i);
+        QHash<QString, StorageChangeSet::ChangeKind>::iterator it = merged.find(itemId);
+        if (it == merged.end()) {
+            merged.insert(itemId, aKinds.at(i));
+        } else {
+            order.remove(position.value(itemId));
+            if (!StorageChangeSet::mergeChange(it.value(), aKinds.at(i))) {
+                merged.erase(it);
+                position.remove(itemId);
+                continue;
+            }
+        }
+        order.insert(i, itemId);
+        position.insert(itemId, i);
+    }
+
+    for (QMap<int, QString>::const_iterator i = order.constBegin(); i != order.constEnd(); ++i) {
+        aChanges.append(StoragePlugin::ItemChange(i.value(), merged.value(i.value())));
+    }
+}
+
+StoragePluginPrivate::StoragePluginPrivate()
+    : iChangeLog(0)
+{
+}
+
 StoragePlugin::StoragePlugin(const QString &aPluginName)
-    : iPluginName(aPluginName)
+    : iPluginName(aPluginName), d_ptr(new StoragePluginPrivate())
 {
 }
 
 StoragePlugin::~StoragePlugin()
 {
+    delete d_ptr;
+    d_ptr = 0;
 }
 
 const QString &StoragePlugin::getPluginName() const
@@ -52,3 +112,110 @@ void StoragePlugin::getProperties(QMap<QString, QString> &aProperties) const
 {
     aProperties = iProperties;
 }
+
+StorageItemCursor *StoragePlugin::openCursor(ItemSelection aSelection,
+                                             const QDateTime &aTime)
+{
+    QList<QString> itemIds;
+    bool success = false;
+
+    switch (aSelection) {
+    case ALL_ITEMS:
+        success = getAllItemIds(itemIds);
+        break;
+    case NEW_ITEMS:
+        success = getNewItemIds(itemIds, aTime);
+        break;
+    case MODIFIED_ITEMS:
+        success = getModifiedItemIds(itemIds, aTime);
+        break;
+    }
+
+    return success ? new StorageItemIdCursor(this, itemIds) : 0;
+}
+
+bool StoragePlugin::changesSince(const QString &aAnchor, QList<ItemChange> &aChanges,
+                                 QString &aNewAnchor)
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    if (aAnchor.isEmpty()) {
+        // Take the anchor before reading, so that changes made meanwhile
+        // are reported again next time rather than missed.
+        QString newAnchor;
+        if (d_ptr->iChangeLog) {
+            qint64 last = d_ptr->iChangeLog->lastChange();
+            if (last < 0) {
+                return false;
+            }
+            newAnchor = LOG_ANCHOR_PREFIX + QString::number(last);
+        } else {
+            newAnchor = TIME_ANCHOR_PREFIX
+                        + QString::number(QDateTime::currentMSecsSinceEpoch());
+        }
+
+        QList<QString> itemIds;
+        if (!getAllItemIds(itemIds)) {
+            return false;
+        }
+        foreach (const QString &itemId, itemIds) {
+            aChanges.append(ItemChange(itemId, StorageChangeSet::ItemAdded));
+        }
+        aNewAnchor = newAnchor;
+        return true;
+    }
+
+    bool valid = false;
+    if (d_ptr->iChangeLog && aAnchor.startsWith(LOG_ANCHOR_PREFIX)) {
+        qint64 since = aAnchor.mid(LOG_ANCHOR_PREFIX.length()).toLongLong(&valid);
+        QList<QString> itemIds;
+        QList<StorageChangeSet::ChangeKind> kinds;
+        qint64 last = since;
+        if (!valid || !d_ptr->iChangeLog->getChanges(since, itemIds, kinds, last)) {
+            return false;
+        }
+
+        appendMergedChanges(itemIds, kinds, aChanges);
+        aNewAnchor = LOG_ANCHOR_PREFIX + QString::number(last);
+        return true;
+    } else if (!d_ptr->iChangeLog && aAnchor.startsWith(TIME_ANCHOR_PREFIX)) {
+        qint64 msecs = aAnchor.mid(TIME_ANCHOR_PREFIX.length()).toLongLong(&valid);
+        if (!valid) {
+            return false;
+        }
+        QDateTime since = QDateTime::fromMSecsSinceEpoch(msecs);
+        QString newAnchor = TIME_ANCHOR_PREFIX
+                            + QString::number(QDateTime::currentMSecsSinceEpoch());
+        QList<QString> newIds;
+        QList<QString> modifiedIds;
+        QList<QString> deletedIds;
+        if (!getNewItemIds(newIds, since) || !getModifiedItemIds(modifiedIds, since) ||
+                !getDeletedItemIds(deletedIds, since)) {
+            return false;
+        }
+        // An item can be listed by more than one of the functions, for
+        // example when it was added and deleted again.
+        QList<QString> itemIds = newIds + modifiedIds + deletedIds;
+        QList<StorageChangeSet::ChangeKind> kinds;
+        kinds.reserve(itemIds.count());
+        for (int i = 0; i < itemIds.count(); ++i) {
+            kinds.append(i < newIds.count() ? StorageChangeSet::ItemAdded :
+                         i < newIds.count() + modifiedIds.count() ? StorageChangeSet::ItemModified :
+                         StorageChangeSet::ItemDeleted);
+        }
+        appendMergedChanges(itemIds, kinds, aChanges);
+        aNewAnchor = newAnchor;
+        return true;
+    }
+
+    qCWarning(lcButeoCore) << "Sync anchor" << aAnchor << "not valid for storage" << iPluginName;
+    return false;
+}
+
+void StoragePlugin::setChangeLog(DeletedItemsIdStorage *aChangeLog)
+{
+    d_ptr->iChangeLog = aChangeLog;
+    if (aChangeLog) {
+        aChangeLog->enableChangeLog();
+    }
+}
@@ -26,11 +26,16 @@
 #include <QObject>
 #include <QMap>
 #include <QList>
+#include <QPair>
 #include <QDateTime>
+#include "StorageChangeSet.h"
 
 namespace Buteo {
 
 class StorageItem;
+class StorageItemCursor;
+class DeletedItemsIdStorage;
+class StoragePluginPrivate;
 
 /*! \brief Base class for storage plugins
  *
@@ -53,6 +58,18 @@ public:
         STATUS_OK = 0                /*!< Operation was completed successfully*/
     };
 
+    /*! \brief Items selected by a cursor
+     *
+     */
+    enum ItemSelection {
+        ALL_ITEMS,                   /*!< All known items, as getAllItems*/
+        NEW_ITEMS,                   /*!< New items since a time, as getNewItems*/
+        MODIFIED_ITEMS               /*!< Modified items since a time, as getModifiedItems*/
+    };
+
+    //! Change of an item: its id and the kind of the change.
+    typedef QPair<QString, StorageChangeSet::ChangeKind> ItemChange;
+
     /*! \brief Constructor
      *
      * @param aPluginName Name of this storage plugin
@@ -228,12 +245,67 @@ public:
      */
     virtual QList<OperationStatus> deleteItems(const QList<QString> &aItemIds) = 0;
 
+    /*! \brief Opens a cursor for reading items in batches
+     *
+     * Alternative to getAllItems, getNewItems and getModifiedItems that does
+     * not need all the items in memory at once. The default implementation
+     * reads the ids of the selected items with the matching id function, and
+     * returns a StorageItemIdCursor that fetches the items with getItems.
+     * Plug-ins that can read their backend incrementally should override it.
+     *
+     * @param aSelection Items to select
+     * @param aTime Time for NEW_ITEMS and MODIFIED_ITEMS, ignored otherwise
+     * @return On success the cursor, owned by the caller, otherwise NULL
+     */
+    virtual StorageItemCursor *openCursor(ItemSelection aSelection,
+                                          const QDateTime &aTime = QDateTime());
+
+    /*! \brief Returns the changes since a sync anchor
+     *
+     * Replaces separate calls to getNewItemIds, getModifiedItemIds and
+     * getDeletedItemIds. Repeated changes to an item are merged into one as
+     * in StorageChangeSet, and items added and deleted again are left out.
+     * The anchor is opaque to the caller: it is stored after a successful
+     * sync and passed back on the next one.
+     *
+     * With a change log set, the changes are read from the log in the order
+     * they happened, and anchors are change numbers in the log, independent
+     * of the clock. Otherwise the default implementation falls back to the
+     * time based id functions: anchors are times, and the changes are
+     * merged as if the new items changed first, then the modified and the
+     * deleted ones.
+     *
+     * @param aAnchor Anchor returned by the previous call. If empty, all
+     *  items are returned as added.
+     * @param aChanges List where to place the changes
+     * @param aNewAnchor Anchor to pass to the next call
+     * @return True on success. False on error, or if the anchor is not
+     *  valid anymore, in which case the caller should start over with an
+     *  empty anchor.
+     */
+    virtual bool changesSince(const QString &aAnchor, QList<ItemChange> &aChanges,
+                              QString &aNewAnchor);
+
 protected:
+    /*! \brief Sets the change log used by changesSince
+     *
+     * Enables the change log of aChangeLog. The plug-in must record its
+     * additions and modifications in the log with
+     * DeletedItemsIdStorage::addChanges, and its deletions with
+     * DeletedItemsIdStorage::addDeletedItems.
+     * @param aChangeLog Change log, owned by the plug-in. NULL to use the
+     *  time based id functions instead.
+     */
+    void setChangeLog(DeletedItemsIdStorage *aChangeLog);
+
     //! Name of the plugin
     QString iPluginName;
 
     //! Properties of the plugin as read from profile xml
     QMap<QString, QString> iProperties;
+
+private:
+    StoragePluginPrivate *d_ptr;
 };
 
 }
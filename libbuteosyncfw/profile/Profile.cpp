@@ -89,9 +89,25 @@ Profile::Profile(const QDomElement &aRoot)
     }
 }
 
+// Stops sharing the sub-profiles before the const accessors hand out
+// pointers to them. Otherwise the pointers would dangle once this profile
+// is modified and the copies it shared its data with are deleted.
+static void exposeSubProfiles(const QSharedDataPointer<ProfilePrivate> &aData)
+{
+    if (!aData->iSubProfilesExposed) {
+        QSharedDataPointer<ProfilePrivate> &data = const_cast<QSharedDataPointer<ProfilePrivate> &>(aData);
+        data->iSubProfilesExposed = true;
+    }
+}
+
 Profile::Profile(const Profile &aSource)
-    : d_ptr(new ProfilePrivate(*aSource.d_ptr))
+    : d_ptr(aSource.d_ptr)
 {
+    // Read the flag through the const source, a non-const access would
+    // detach right away.
+    if (aSource.d_ptr->iSubProfilesExposed) {
+        d_ptr.detach();
+    }
 }
 
 Profile *Profile::clone() const
@@ -101,8 +117,6 @@ Profile *Profile::clone() const
 
 Profile::~Profile()
 {
-    delete d_ptr;
-    d_ptr = 0;
 }
 
 QString Profile::name() const
@@ -303,7 +317,7 @@ QDomElement Profile::toXml(QDomDocument &aDoc, bool aLocalOnly) const
     }
 
     // Set sub-profiles.
-    foreach (Profile *p, d_ptr->iSubProfiles) {
+    foreach (const Profile *p, d_ptr->iSubProfiles) {
         if (!p->d_ptr->iMerged || !p->d_ptr->iLocalKeys.isEmpty() ||
                 !p->d_ptr->iLocalFields.isEmpty()) {
             root.appendChild(p->toXml(aDoc, aLocalOnly));
@@ -384,6 +398,8 @@ QStringList Profile::subProfileNames(const QString &aType) const
 Profile *Profile::subProfile(const QString &aName,
                              const QString &aType)
 {
+    d_ptr->iSubProfilesExposed = true;
+
     bool checkType = !aType.isEmpty();
     foreach (Profile *p, d_ptr->iSubProfiles) {
         if (aName == p->name() && (!checkType || aType == p->type())) {
@@ -396,6 +412,13 @@ Profile *Profile::subProfile(const QString &aName,
 
 const Profile *Profile::subProfile(const QString &aName,
                                    const QString &aType) const
+{
+    exposeSubProfiles(d_ptr);
+    return findSubProfile(aName, aType);
+}
+
+const Profile *Profile::findSubProfile(const QString &aName,
+                                       const QString &aType) const
 {
     bool checkType = !aType.isEmpty();
     foreach (Profile *p, d_ptr->iSubProfiles) {
@@ -412,6 +435,8 @@ const Profile *Profile::subProfileByKeyValue(const QString &aKey,
                                              const QString &aType,
                                              bool aEnabledOnly) const
 {
+    exposeSubProfiles(d_ptr);
+
     bool checkType = !aType.isEmpty();
     foreach (Profile *p, d_ptr->iSubProfiles) {
         if ((!checkType || aType == p->type()) &&
@@ -426,11 +451,14 @@ const Profile *Profile::subProfileByKeyValue(const QString &aKey,
 
 QList<Profile *> Profile::allSubProfiles()
 {
+    d_ptr->iSubProfilesExposed = true;
     return d_ptr->iSubProfiles;
 }
 
 QList<const Profile *> Profile::allSubProfiles() const
 {
+    exposeSubProfiles(d_ptr);
+
     QList<const Profile *> constProfiles;
     foreach (Profile *p, d_ptr->iSubProfiles) {
         constProfiles.append(p);
@@ -441,8 +469,15 @@ QList<const Profile *> Profile::allSubProfiles() const
 
 void Profile::merge(const Profile &aSource)
 {
-    // Get target sub-profile. Create new if not found.
-    Profile *target = subProfile(aSource.name(), aSource.type());
+    // Get target sub-profile. Create new if not found. The pointer stays
+    // internal, so the lookup does not go through subProfile().
+    Profile *target = 0;
+    foreach (Profile *p, d_ptr->iSubProfiles) {
+        if (p->name() == aSource.name() && p->type() == aSource.type()) {
+            target = p;
+            break;
+        }
+    }
     if (0 == target) {
         ProfileFactory pf;
         target = pf.createProfile(aSource.name(), aSource.type());
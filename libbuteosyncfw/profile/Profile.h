@@ -26,6 +26,7 @@
 
 #include <QList>
 #include <QMap>
+#include <QSharedDataPointer>
 #include <QString>
 #include <QStringList>
 #include "ProfileField.h"
@@ -48,6 +49,12 @@ class ProfilePrivate;
  * interface does not use XML. New classes can be derived from this class for
  * different profile types to add helper functions for accessing specific keys
  * and fields known by the profile type.
+ *
+ * Profiles are implicitly shared: copying or cloning a profile is cheap, and
+ * the data is only copied when one of the copies is modified. Once
+ * sub-profile pointers have been got from one of the accessors, the profile
+ * no longer shares its data and copies of it get their own data right away,
+ * so the pointers never refer to sub-profiles of another copy.
  */
 class Profile
 {
@@ -84,13 +91,15 @@ public:
 
     /*! \brief Copy constructor.
      *
+     * The data is shared with the source until either one is modified.
      * \param aSource Copy source.
      */
     Profile(const Profile &aSource);
 
     /*! \brief Creates a clone of the profile.
      *
-     * \return The clone.
+     * \return The clone. It shares its data with this profile until either
+     *  one is modified.
      */
     virtual Profile *clone() const;
 
@@ -281,6 +290,8 @@ public:
 
     /*! \brief const method for subProfile \see Profile::subProfile
      *
+     * The profile stops sharing its sub-profiles with its copies, so the
+     * returned pointer stays valid until the profile is deleted.
      */
     const Profile *subProfile(const QString &aName, const QString &aType = "") const;
 
@@ -307,6 +318,8 @@ public:
 
     /*! \brief Gets all sub-profiles as const
      *
+     * The profile stops sharing its sub-profiles with its copies, so the
+     * returned pointers stay valid until the profile is deleted.
      * \return List of sub-profiles. The returned sub-profiles are const and are owned by the main
      *  profile and the user must not delete them.
      */
@@ -369,9 +382,21 @@ public:
      */
     bool isProtected() const;
 
+protected:
+    /*! \brief Gets a sub-profile for a lookup inside the profile classes.
+     *
+     * Unlike subProfile(), this keeps the sub-profiles shared with the
+     * copies of the profile, so the pointer must not be kept.
+     * \param aName Name of the sub-profile to get.
+     * \param aType Type of the sub-profile to get. If the type is empty,
+     *  any type is accepted.
+     * \return The first matching sub-profile. NULL if not found.
+     */
+    const Profile *findSubProfile(const QString &aName, const QString &aType) const;
+
 private:
     Profile &operator=(const Profile &aRhs);
-    ProfilePrivate *d_ptr;
+    QSharedDataPointer<ProfilePrivate> d_ptr;
 
     /*! \brief Generates a profile id based on keys
      *
@@ -381,6 +406,9 @@ private:
      */
     QString generateProfileId(const QStringList &aKeys);
 
+    friend class ProfilePrivate;
+    friend class ProfileStore;
+
 #ifdef SYNCFW_UNIT_TESTS
     friend class ProfileTest;
 #endif
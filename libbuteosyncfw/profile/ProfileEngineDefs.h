@@ -100,6 +100,7 @@ const QString KEY_SYNC_ALWAYS_UP_TO_DATE("sync_always_up_to_date");
 const QString KEY_SYNC_EXTERNALLY("sync_externally");
 const QString KEY_SOC("sync_on_change");
 const QString KEY_SOC_AFTER("sync_on_change_after");
+const QString KEY_SOC_MIN_GAP("sync_on_change_min_gap");
 const QString KEY_LOCAL_URI("Local URI");
 const QString KEY_ALWAYS_ON_ENABLED("always_on_enabled");
 const QString KEY_REMOTE_NAME("remote_name");
@@ -110,6 +111,8 @@ const QString KEY_HTTP_PROXY_HOST("http_proxy_host");
 const QString KEY_HTTP_PROXY_PORT("http_proxy_port");
 const QString KEY_PROFILE_ID("profile_id");
 const QString KEY_INTERNET_CONNECTION_TYPES("internet_connection_types");
+const QString KEY_LOG_RETENTION("log_retention");
+const QString KEY_REMOTE_HOST("remote_host");
 
 const QString BOOLEAN_TRUE("true");
 const QString BOOLEAN_FALSE("false");
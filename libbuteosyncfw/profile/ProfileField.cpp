@@ -22,6 +22,7 @@
  */
 
 #include "ProfileField.h"
+#include "ProfileField_p.h"
 #include "ProfileEngineDefs.h"
 #include <QDomDocument>
 
@@ -39,38 +40,6 @@ const QString ProfileField::VISIBLE_USER = "user";
 //! ProfileField Visbility Const string for boolean
 const QString ProfileField::TYPE_BOOLEAN = "boolean";
 
-// Private implementation class for ProfileField.
-class ProfileFieldPrivate
-{
-public:
-    //! \brief Constructor
-    ProfileFieldPrivate();
-
-    //! \brief Copy Constructor
-    ProfileFieldPrivate(const ProfileFieldPrivate &aSource);
-
-    //! \brief Name of the ProfileField
-    QString iName;
-
-    //! \brief Type of the ProfileField
-    QString iType;
-
-    //! \brief DefaultValue of the ProfileField
-    QString iDefaultValue;
-
-    //! \brief List of Options of the ProfileField
-    QStringList iOptions;
-
-    //! \brief Label of the ProfileField
-    QString iLabel;
-
-    //! \brief Visibility of the ProfileField
-    QString iVisible;
-
-    //! \brief Write Access Specifier of the ProfileField
-    bool iReadOnly;
-};
-
 }
 
 using namespace Buteo;
@@ -133,6 +102,11 @@ ProfileField::~ProfileField()
     d_ptr = 0;
 }
 
+ProfileField::ProfileField()
+    :   d_ptr(new ProfileFieldPrivate())
+{
+}
+
 QString ProfileField::name() const
 {
     return d_ptr->iName;
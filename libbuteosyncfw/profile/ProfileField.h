@@ -142,8 +142,13 @@ public:
     bool isReadOnly() const;
 
 private:
+    //! \brief Constructs an empty field, used by ProfileStore.
+    ProfileField();
+
     ProfileField &operator=(const ProfileField &aRhs);
     ProfileFieldPrivate *d_ptr;
+
+    friend class ProfileStore;
 };
 
 }
@@ -0,0 +1,63 @@
+/*
+ * This file is part of buteo-syncfw package
+ *
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+#ifndef PROFILEFIELD_P_H
+#define PROFILEFIELD_P_H
+
+#include <QString>
+#include <QStringList>
+
+namespace Buteo {
+
+//! Private implementation class for ProfileField.
+class ProfileFieldPrivate
+{
+public:
+    //! \brief Constructor
+    ProfileFieldPrivate();
+
+    //! \brief Copy Constructor
+    ProfileFieldPrivate(const ProfileFieldPrivate &aSource);
+
+    //! \brief Name of the ProfileField
+    QString iName;
+
+    //! \brief Type of the ProfileField
+    QString iType;
+
+    //! \brief DefaultValue of the ProfileField
+    QString iDefaultValue;
+
+    //! \brief List of Options of the ProfileField
+    QStringList iOptions;
+
+    //! \brief Label of the ProfileField
+    QString iLabel;
+
+    //! \brief Visibility of the ProfileField
+    QString iVisible;
+
+    //! \brief Write Access Specifier of the ProfileField
+    bool iReadOnly;
+};
+
+}
+
+#endif // PROFILEFIELD_P_H
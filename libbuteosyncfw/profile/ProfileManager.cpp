@@ -25,16 +25,27 @@
 
 #include <QDir>
 #include <QFile>
-#include <QTextStream>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QSet>
+#include <QTemporaryFile>
 #include <QDomDocument>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
 
 #include "ProfileFactory.h"
 #include "ProfileEngineDefs.h"
+#include "ProfileStore.h"
 #include "SyncCommonDefs.h"
 
 #include "LogMacros.h"
 #include "BtHelper.h"
 
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 // implement here in lack of better place. not sure should this even be included in the api
 const QString Sync::syncConfigDir()
 {
@@ -51,22 +62,51 @@ const QString Sync::syncCacheDir()
 }
 
 static const QString FORMAT_EXT = ".xml";
+static const QString TEMP_EXT = ".new";
 static const QString BACKUP_EXT = ".bak";
 static const QString LOG_EXT = ".log";
+static const QString JOURNAL_EXT = ".journal";
 static const QString LOG_DIRECTORY = "logs";
 static const QString BT_PROFILE_TEMPLATE("bt_template");
+static const QString STORE_DIRECTORY = "cache";
+static const QString STORE_FILE = "profiles.bin";
 
 static const QString DEFAULT_PRIMARY_PROFILE_PATH = Sync::syncConfigDir();
 static const QString DEFAULT_SECONDARY_PROFILE_PATH = "/etc/buteo/profiles";
 
+/*! \brief Identifies the current state of a file system entry.
+ *
+ * Files are replaced by renaming, so the inode changes with every write.
+ * Modification times alone are too coarse to tell apart two writes made
+ * in quick succession.
+ * \return The stamp, empty if the entry does not exist.
+ */
+static QByteArray fileStamp(const QString &aPath)
+{
+    struct stat st;
+    if (::stat(QFile::encodeName(aPath).constData(), &st) != 0) {
+        return QByteArray();
+    }
+
+    return QByteArray::number(qulonglong(st.st_ino)) + ':' +
+           QByteArray::number(qlonglong(st.st_mtim.tv_sec)) + '.' +
+           QByteArray::number(qlonglong(st.st_mtim.tv_nsec)) + ':' +
+           QByteArray::number(qlonglong(st.st_size));
+}
+
 namespace Buteo {
 
 class ProfileManagerPrivate
 {
 public:
-    ProfileManagerPrivate();
+    ProfileManagerPrivate(ProfileManager *aParent);
+
+    ~ProfileManagerPrivate();
 
     /*! \brief Loads a profile from persistent storage.
+     *
+     * Profiles are parsed only once and kept in an in-memory cache until
+     * the backing file changes. The caller receives a private copy.
      *
      * \param aName Name of the profile to load.
      * \param aType Type of the profile to load.
@@ -74,20 +114,122 @@ public:
      */
     Profile *load(const QString &aName, const QString &aType);
 
+    /*! \brief Gets the cached instance of a profile, loading it if needed.
+     *
+     * Used for merging sub-profiles without copying them first. Profiles
+     * found missing during a batch are not looked up again until the
+     * batch ends.
+     *
+     * \param aName Name of the profile.
+     * \param aType Type of the profile.
+     * \return The cached profile, owned by the cache and valid until the
+     *  cache is next modified. 0 if the profile was not found.
+     */
+    const Profile *sharedProfile(const QString &aName, const QString &aType);
+
+    //! Starts a batch of loads, e.g. a full profile scan.
+    void beginBatch();
+
+    //! Ends a batch of loads. Forgets missing profiles and flushes the store.
+    void endBatch();
+
     /*! \brief Loads the synchronization log associated with the given profile.
+     *
+     * The log is read from its journal, or from the XML file written
+     * before journals were used if there is no journal yet.
      *
      * \param aProfileName Name of the sync profile whose log shall be loaded.
+     * \param aRetention Number of results the log keeps.
      * \return The loaded log. 0 if the log was not found.
      */
-    SyncLog *loadLog(const QString &aProfileName);
+    SyncLog *loadLog(const QString &aProfileName, int aRetention);
+
+    /*! \brief Appends sync results to the log journal of a profile.
+     *
+     * The journal is rewritten with only the retained results when it has
+     * grown to twice the retention count, when it is damaged, or when
+     * there is no journal yet.
+     *
+     * \param aProfileName Name of the sync profile.
+     * \param aResults Results to append.
+     * \param aRetention Number of results the log keeps.
+     * \return False if writing failed.
+     */
+    bool appendLog(const QString &aProfileName, const SyncResults &aResults, int aRetention);
+
+    /*! \brief Replaces the log journal of a profile with the given log.
+     *
+     * \param aLog Log to write.
+     * \return False if writing failed.
+     */
+    bool writeJournal(const SyncLog &aLog);
 
-    bool parseFile(const QString &aPath, QDomDocument &aDoc);
-    void restoreBackupIfFound(const QString &aProfilePath,
-                              const QString &aBackupPath);
+    /*! \brief Reads the results of a log journal into a log.
+     *
+     * \param aData Contents of the journal.
+     * \param aLog Log the results are added to.
+     * \param aRecords Number of results read.
+     * \return False if the journal is damaged. The results before the
+     *  damaged part are still read.
+     */
+    bool readJournal(const QByteArray &aData, SyncLog &aLog, int &aRecords);
+
+    //! Number of results kept in the log of a profile.
+    int logRetention(const QString &aProfileName);
+
+    /*! \brief Parses an XML file, or its queued contents.
+     *
+     * \param aPath Path of the file.
+     * \param aDoc Receives the parsed document.
+     * \param aContents If not NULL, receives the bytes that were parsed.
+     * \return False if the file could not be read or parsed.
+     */
+    bool parseFile(const QString &aPath, QDomDocument &aDoc, QByteArray *aContents = 0);
+
+    /*! \brief Recovers profiles from backups left by the old write format.
+     *
+     * Profiles used to be copied to a .bak file and then rewritten in
+     * place. A profile damaged by a crash during such a write is restored
+     * from its backup. The backups are removed.
+     */
+    void recoverBackups();
     QDomDocument constructProfileDocument(const Profile &aProfile);
-    bool writeProfileFile(const QString &aProfilePath, const QDomDocument &aDoc);
     QString findProfileFile(const QString &aName, const QString &aType);
-    bool createBackup(const QString &aProfilePath, const QString &aBackupPath);
+
+    /*! \brief Replaces the contents of a file atomically.
+     *
+     * Inside a write group the file is only queued and written when the
+     * group ends. Reads through parseFile() see queued contents.
+     *
+     * \param aPath Path of the file.
+     * \param aData New contents.
+     * \return False if writing failed. Inside a write group only queueing
+     *  can fail, write errors are reported by commitWrites().
+     */
+    bool writeFile(const QString &aPath, const QByteArray &aData);
+
+    /*! \brief Writes all queued files.
+     *
+     * Each file is written to a uniquely named temporary file next to it
+     * and renamed over the original once all temporary files are on disk,
+     * so a crash leaves either the old or the new contents. Directories are
+     * synced once per group, not once per file.
+     *
+     * \param aFailed If not NULL, receives the paths that were not written.
+     * \return False if any of the files could not be written.
+     */
+    bool commitWrites(QStringList *aFailed = 0);
+
+    /*! \brief Removes a file made obsolete by a write.
+     *
+     * Inside a write group the file is removed once the group has been
+     * written successfully.
+     * \param aPath Path of the file.
+     */
+    void removeObsoleteFile(const QString &aPath);
+
+    //! Removes the files queued by removeObsoleteFile().
+    void removeObsoleteFiles();
     bool matchProfile(const Profile &aProfile,
                       const ProfileManager::SearchCriteria &aCriteria);
     bool matchKey(const Profile &aProfile,
@@ -96,71 +238,1025 @@ public:
     bool remove(const QString &aName, const QString &aType);
     bool profileExists(const QString &aProfileId, const QString &aType);
 
+    /*! \brief Adds a parsed profile to the cache.
+     *
+     * \param aName Name the profile was requested with.
+     * \param aType Type the profile was requested with.
+     * \param aPath Path of the file the profile was parsed from.
+     * \param aStamp fileStamp() of the file taken before it was read.
+     * \param aProfile Profile to cache. Ownership is transferred.
+     */
+    void cacheProfile(const QString &aName, const QString &aType,
+                      const QString &aPath, const QByteArray &aStamp, Profile *aProfile);
+
+    /*! \brief Adds a parsed sync log to the cache.
+     *
+     * \param aProfileName Name of the profile owning the log.
+     * \param aPath Path of the file the log was parsed from.
+     * \param aStamp fileStamp() of the file taken before it was read.
+     * \param aLog Log to cache. Ownership is transferred.
+     */
+    void cacheLog(const QString &aProfileName, const QString &aPath, const QByteArray &aStamp,
+                  SyncLog *aLog);
+
+    /*! \brief Checks if a cached object still matches its source file.
+     *
+     * Another process may have replaced the file before the watcher has
+     * reported it, for example when reacting to a change signal.
+     * \param aPath Path of the source file.
+     * \param aStamp fileStamp() of the source when it was read.
+     * \return True if the file is unchanged or has a pending write.
+     */
+    bool isCurrent(const QString &aPath, const QByteArray &aStamp) const;
+
+    //! Removes a profile from the cache.
+    void uncacheProfile(const QString &aName, const QString &aType);
+
+    //! Removes a sync log from the cache.
+    void uncacheLog(const QString &aProfileName);
+
+    //! Drops all cached profiles and logs.
+    void clearCache();
+
+    //! Invalidates cache entries affected by a change in the given path.
+    void pathChanged(const QString &aPath);
+
+    //! Starts watching the given path, if it exists.
+    void watchPath(const QString &aPath);
+
+    /*! \brief Records that this instance has just changed the given file.
+     *
+     * The containing directory is recorded as well, since replacing,
+     * creating or removing the file changes it too. Cache entries of the
+     * file take its new stamp, they hold the data that was written.
+     * \param aPath Path of the changed file.
+     */
+    void noteOwnChange(const QString &aPath);
+
+    //! Checks if the given path is still as this instance last left it.
+    bool isOwnChange(const QString &aPath) const;
+
+    //! Path of the log journal of a profile.
+    QString logFilePath(const QString &aProfileName) const;
+
+    //! Path of the XML log file written before journals were used.
+    QString legacyLogFilePath(const QString &aProfileName) const;
+
+    //! Path of the compiled profile store in the primary profile directory.
+    QString storeFilePath() const;
+
+    //! Writes pending changes of the compiled profile store, if enabled.
+    void flushStore();
+
+    /*! \brief Makes sure the search index is up to date.
+     *
+     * Builds the whole index on first use, afterwards only profiles that
+     * have been marked dirty or whose files have changed are re-indexed.
+     * Watcher notifications arrive late, so the stamps of the indexed files
+     * and of the sync profile directories are checked on every call.
+     * \param aManager Profile manager used for loading and expanding.
+     */
+    void ensureIndex(ProfileManager &aManager);
+
+    //! Marks indexed profiles whose files have changed on disk dirty.
+    void checkIndexStamps();
+
+    //! fileStamp() of both sync profile directories.
+    QList<QByteArray> indexDirStamps() const;
+
+    //! Re-indexes a single sync profile.
+    void reindex(ProfileManager &aManager, const QString &aName);
+
+    //! Adds the keys of an expanded sync profile to the index.
+    void indexProfile(const Profile &aProfile, const QString &aName);
+
+    //! Removes a sync profile from the index.
+    void unindexProfile(const QString &aName);
+
+    //! Marks the index out of date after a change in the given profile.
+    void invalidateIndex(const QString &aName, const QString &aType);
+
+    /*! \brief Gets the sync profiles that may satisfy the given criteria.
+     *
+     * The returned set is a superset of the matching profiles; candidates
+     * still need to be verified with matchProfile().
+     * \param aCriteria Search criteria.
+     * \param aCandidates Candidate profile names.
+     * \return False if none of the criteria can be answered by the index.
+     */
+    bool indexCandidates(const QList<ProfileManager::SearchCriteria> &aCriteria,
+                         QSet<QString> &aCandidates) const;
+
+    //! Cache entry, the parsed object together with its source file.
+    template <typename T>
+    struct CacheEntry {
+        QString iPath;
+        //! fileStamp() of the source, checked on every cache hit.
+        QByteArray iStamp;
+        T *iObject;
+    };
+
     QString iConfigPath;
     QString iSystemConfigPath;
     QHash<QString, QList<quint32> > iSyncRetriesInfo;
+
+    //! Compiled binary profiles, NULL if not enabled.
+    ProfileStore *iStore;
+
+    //! Nesting level of load batches.
+    int iBatchDepth;
+
+    //! Profiles found missing during the current batch, as "<type>/<name>".
+    QSet<QString> iMissingProfiles;
+
+    //! Parsed profiles, keyed by "<type>/<name>".
+    QHash<QString, CacheEntry<Profile> > iProfileCache;
+
+    //! Parsed sync logs, keyed by profile name.
+    QHash<QString, CacheEntry<SyncLog> > iLogCache;
+
+    //! The ProfileManager notified of watched path changes.
+    ProfileManager *iParent;
+
+    //! Watches profile files and directories for external modifications.
+    //! Created when the first path is watched, as each watcher takes one
+    //! of the inotify instances available to the user.
+    QFileSystemWatcher *iWatcher;
+
+    //! Stamps of the files and directories last changed by this instance,
+    //! see fileStamp(). Watcher notifications for them are ignored.
+    QHash<QString, QByteArray> iOwnChanges;
+
+    //! Is the search index built.
+    bool iIndexValid;
+
+    //! Sync profiles that need to be re-indexed before the next search.
+    QSet<QString> iDirtyIndex;
+
+    //! Profile directories have changed, profiles may have been added or
+    //! removed since the index was built.
+    bool iIndexNamesDirty;
+
+    //! Nesting level of write groups.
+    int iWriteGroupDepth;
+
+    //! Files waiting to be written at the end of the write group.
+    QMap<QString, QByteArray> iPendingWrites;
+
+    //! Log journals appended to during the write group, synced when the
+    //! group ends.
+    QSet<QString> iUnsyncedAppends;
+
+    //! Files to remove once the write group has been written.
+    QSet<QString> iObsoleteFiles;
+
+    //! Change notification held back until the write group is written.
+    struct PendingSignal {
+        QString iProfileName;
+        int iChangeType;
+        QString iProfileAsXml;
+        //! File the change depends on, empty if already on disk.
+        QString iPath;
+    };
+
+    //! Change notifications of the current write group, in order.
+    QList<PendingSignal> iPendingSignals;
+
+    //! Number of results in each log journal, -1 if the journal is
+    //! damaged. Only known for journals read or written by this instance.
+    QHash<QString, int> iJournalRecords;
+
+    //! Key name -> key value -> names of sync profiles having that key,
+    //! either in the main profile or in any of its sub-profiles.
+    QHash<QString, QHash<QString, QSet<QString> > > iKeyIndex;
+
+    //! "<type>/<name>" of a sub-profile -> names of sync profiles using it.
+    QHash<QString, QSet<QString> > iSubProfileIndex;
+
+    //! Sync profile name -> indexed key/value pairs, needed for removal.
+    QHash<QString, QList<QPair<QString, QString> > > iIndexedKeys;
+
+    //! Sync profile name -> indexed sub-profiles, needed for removal.
+    QHash<QString, QStringList> iIndexedSubProfiles;
+
+    //! Sync profile name -> path -> fileStamp() of the files it was indexed
+    //! from, its own file and those of its sub-profiles.
+    QHash<QString, QHash<QString, QByteArray> > iIndexedStamps;
+
+    //! indexDirStamps() taken before the profile names were last listed.
+    QList<QByteArray> iIndexDirStamps;
 };
 
 }
 
 using namespace Buteo;
 
-ProfileManagerPrivate::ProfileManagerPrivate()
+ProfileManagerPrivate::ProfileManagerPrivate(ProfileManager *aParent)
     : iConfigPath(DEFAULT_PRIMARY_PROFILE_PATH),
-      iSystemConfigPath(DEFAULT_SECONDARY_PROFILE_PATH)
+      iSystemConfigPath(DEFAULT_SECONDARY_PROFILE_PATH),
+      iStore(0),
+      iBatchDepth(0),
+      iParent(aParent),
+      iWatcher(0),
+      iIndexValid(false),
+      iIndexNamesDirty(false),
+      iWriteGroupDepth(0)
+{
+}
+
+ProfileManagerPrivate::~ProfileManagerPrivate()
+{
+    commitWrites();
+    clearCache();
+    delete iStore;
+    iStore = 0;
+    delete iWatcher;
+    iWatcher = 0;
+}
+
+static QString profileCacheKey(const QString &aName, const QString &aType)
 {
+    return aType + QDir::separator() + aName;
 }
 
 Profile *ProfileManagerPrivate::load(const QString &aName, const QString &aType)
 {
+    const Profile *profile = sharedProfile(aName, aType);
+    return profile != 0 ? profile->clone() : 0;
+}
+
+const Profile *ProfileManagerPrivate::sharedProfile(const QString &aName, const QString &aType)
+{
+    const QString key = profileCacheKey(aName, aType);
+    QHash<QString, CacheEntry<Profile> >::const_iterator cached = iProfileCache.constFind(key);
+    if (cached != iProfileCache.constEnd()) {
+        if (isCurrent(cached->iPath, cached->iStamp)) {
+            return cached->iObject;
+        }
+        // Changed on disk, the watcher has not reported it yet.
+        invalidateIndex(aName, aType);
+        uncacheProfile(aName, aType);
+    }
+
+    if (iBatchDepth > 0 && iMissingProfiles.contains(key)) {
+        return 0;
+    }
+
     QString profilePath = findProfileFile(aName, aType);
-    QString backupProfilePath = profilePath + BACKUP_EXT;
+    bool pending = iPendingWrites.contains(profilePath);
+    // Taken before reading, a write in between is detected on the next hit.
+    const QByteArray stamp = fileStamp(profilePath);
 
-    QDomDocument doc;
     Profile *profile = 0;
 
-    restoreBackupIfFound(profilePath, backupProfilePath);
+    if (iStore != 0 && !pending) {
+        profile = iStore->load(aName, aType, profilePath, stamp);
+    }
 
-    if (parseFile(profilePath, doc)) {
-        ProfileFactory pf;
-        profile = pf.createProfile(doc.documentElement());
+    if (profile == 0) {
+        QDomDocument doc;
+        QByteArray source;
+        if (parseFile(profilePath, doc, &source)) {
+            ProfileFactory pf;
+            profile = pf.createProfile(doc.documentElement());
 
-        if (QFile::exists(backupProfilePath)) {
-            QFile::remove(backupProfilePath);
+            if (profile != 0 && iStore != 0 && !pending) {
+                iStore->update(aName, aType, profilePath, stamp, source, *profile);
+            }
+        } else {
+            qCDebug(lcButeoCore) << "Failed to load profile:" << aName;
         }
-    } else {
-        qCDebug(lcButeoCore) << "Failed to load profile:" << aName;
+    }
+
+    if (profile != 0) {
+        cacheProfile(aName, aType, profilePath, stamp, profile);
+    } else if (iBatchDepth > 0) {
+        iMissingProfiles.insert(key);
     }
 
     return profile;
 }
 
-SyncLog *ProfileManagerPrivate::loadLog(const QString &aProfileName)
+void ProfileManagerPrivate::beginBatch()
 {
-    QString fileName = iConfigPath + QDir::separator() + Profile::TYPE_SYNC + QDir::separator() +
-                       LOG_DIRECTORY + QDir::separator() + aProfileName + LOG_EXT + FORMAT_EXT;
+    ++iBatchDepth;
+}
 
-    if (!QFile::exists(fileName)) {
-        return 0;
+void ProfileManagerPrivate::endBatch()
+{
+    if (iBatchDepth > 0 && --iBatchDepth == 0) {
+        iMissingProfiles.clear();
+        flushStore();
     }
+}
 
-    QFile file(fileName);
-    if (!file.open(QIODevice::ReadOnly)) {
-        qCWarning(lcButeoCore) << "Failed to open sync log file for reading:"
-                    << file.fileName();
-        return 0;
+SyncLog *ProfileManagerPrivate::loadLog(const QString &aProfileName, int aRetention)
+{
+    QHash<QString, CacheEntry<SyncLog> >::const_iterator cached =
+        iLogCache.constFind(aProfileName);
+    if (cached != iLogCache.constEnd()) {
+        // A journal is read again if its record count has been dropped,
+        // appends need the count.
+        if (isCurrent(cached->iPath, cached->iStamp) &&
+                (iJournalRecords.contains(aProfileName) ||
+                 cached->iPath != logFilePath(aProfileName))) {
+            return new SyncLog(*cached->iObject);
+        }
+        // Changed on disk, the watcher has not reported it yet.
+        uncacheLog(aProfileName);
+        iJournalRecords.remove(aProfileName);
     }
 
-    QDomDocument doc;
-    if (!doc.setContent(&file)) {
+    QString fileName = logFilePath(aProfileName);
+    QByteArray stamp = fileStamp(fileName);
+    SyncLog *log = 0;
+
+    QByteArray journal;
+    bool journalFound = false;
+    QMap<QString, QByteArray>::const_iterator pending = iPendingWrites.constFind(fileName);
+    if (pending != iPendingWrites.constEnd()) {
+        journal = *pending;
+        journalFound = true;
+    } else if (QFile::exists(fileName)) {
+        QFile file(fileName);
+        if (!file.open(QIODevice::ReadOnly)) {
+            qCWarning(lcButeoCore) << "Failed to open sync log journal for reading:" << fileName;
+            return 0;
+        }
+        journal = file.readAll();
         file.close();
-        qCWarning(lcButeoCore) << "Failed to parse XML from sync log file:"
-                    << file.fileName();
-        return 0;
+        journalFound = true;
+    }
+
+    if (journalFound) {
+        log = new SyncLog(aProfileName);
+        log->setMaxResults(aRetention);
+        int records = 0;
+        if (!readJournal(journal, *log, records)) {
+            qCWarning(lcButeoCore) << "Sync log journal is damaged, results after the damage are lost:"
+                        << fileName;
+            records = -1;
+        }
+        iJournalRecords.insert(aProfileName, records);
+    } else {
+        fileName = legacyLogFilePath(aProfileName);
+        stamp = fileStamp(fileName);
+        if (stamp.isEmpty()) {
+            return 0;
+        }
+
+        QFile file(fileName);
+        if (!file.open(QIODevice::ReadOnly)) {
+            qCWarning(lcButeoCore) << "Failed to open sync log file for reading:"
+                        << file.fileName();
+            return 0;
+        }
+
+        // Logs can hold thousands of item entries, stream them instead of
+        // building a DOM tree first.
+        QXmlStreamReader reader(&file);
+        if (reader.readNextStartElement()) {
+            log = new SyncLog(reader);
+        }
+        if (log == 0 || reader.hasError()) {
+            file.close();
+            qCWarning(lcButeoCore) << "Failed to parse XML from sync log file:"
+                        << file.fileName() << reader.errorString();
+            delete log;
+            return 0;
+        }
+        file.close();
+        log->setMaxResults(aRetention);
+    }
+
+    cacheLog(aProfileName, fileName, stamp, new SyncLog(*log));
+
+    return log;
+}
+
+static QByteArray journalRecord(const SyncResults &aResults)
+{
+    QByteArray record;
+    {
+        QXmlStreamWriter writer(&record);
+        aResults.toXml(writer);
+    }
+    record.append('\n');
+    return record;
+}
+
+bool ProfileManagerPrivate::readJournal(const QByteArray &aData, SyncLog &aLog, int &aRecords)
+{
+    aRecords = 0;
+
+    // The journal is only ever appended to, so the end tag of the log
+    // element is never written. A record cut short by a crash ends the
+    // journal with a parse error.
+    QXmlStreamReader reader;
+    reader.addData(aData);
+    reader.addData("</" + TAG_SYNC_LOG.toUtf8() + ">");
+
+    if (!reader.readNextStartElement() || reader.name() != TAG_SYNC_LOG) {
+        return false;
+    }
+
+    while (reader.readNextStartElement()) {
+        if (reader.name() == TAG_SYNC_RESULTS) {
+            SyncResults results(reader);
+            if (reader.hasError()) {
+                break;
+            }
+            aLog.addResults(results);
+            ++aRecords;
+        } else {
+            reader.skipCurrentElement();
+        }
+    }
+
+    return !reader.hasError();
+}
+
+bool ProfileManagerPrivate::writeJournal(const SyncLog &aLog)
+{
+    const QString profileName = aLog.profileName();
+    const QString fileName = logFilePath(profileName);
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+
+    QByteArray data;
+    {
+        QXmlStreamWriter writer(&data);
+        writer.writeStartElement(TAG_SYNC_LOG);
+        writer.writeAttribute(ATTR_NAME, profileName);
+        // Closes the start tag, results are appended after it.
+        writer.writeCharacters("\n");
+    }
+
+    QList<const SyncResults *> results = aLog.allResults();
+    const SyncResults *lastSuccess = aLog.lastSuccessfulResults();
+    if (lastSuccess != 0 && (results.isEmpty() || *lastSuccess < *results.first())) {
+        results.prepend(lastSuccess);
+    }
+    foreach (const SyncResults *r, results) {
+        data.append(journalRecord(*r));
+    }
+
+    iUnsyncedAppends.remove(fileName);
+    if (!writeFile(fileName, data)) {
+        iJournalRecords.remove(profileName);
+        return false;
+    }
+
+    iJournalRecords.insert(profileName, results.size());
+    removeObsoleteFile(legacyLogFilePath(profileName));
+
+    SyncLog *cached = new SyncLog(aLog);
+    cacheLog(profileName, fileName, fileStamp(fileName), cached);
+
+    return true;
+}
+
+bool ProfileManagerPrivate::appendLog(const QString &aProfileName, const SyncResults &aResults,
+                                      int aRetention)
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    const QString fileName = logFilePath(aProfileName);
+
+    QHash<QString, CacheEntry<SyncLog> >::iterator stale = iLogCache.find(aProfileName);
+    if (stale != iLogCache.end() && !isCurrent(stale->iPath, stale->iStamp)) {
+        // Appended to by another process, read it again.
+        uncacheLog(aProfileName);
+        iJournalRecords.remove(aProfileName);
+    }
+
+    if (!iJournalRecords.contains(aProfileName)) {
+        // Counts the records of an existing journal.
+        delete loadLog(aProfileName, aRetention);
+    }
+
+    const int records = iJournalRecords.value(aProfileName, -1);
+    QMap<QString, QByteArray>::iterator pending = iPendingWrites.find(fileName);
+    const bool exists = pending != iPendingWrites.end() || QFile::exists(fileName);
+
+    if (records < 0 || records >= 2 * aRetention || !exists) {
+        SyncLog *log = loadLog(aProfileName, aRetention);
+        if (log == 0) {
+            log = new SyncLog(aProfileName);
+        }
+        log->setMaxResults(aRetention);
+        log->addResults(aResults);
+        bool success = writeJournal(*log);
+        delete log;
+        log = 0;
+        return success;
+    }
+
+    const QByteArray record = journalRecord(aResults);
+
+    if (pending != iPendingWrites.end()) {
+        pending->append(record);
+    } else {
+        QFile file(fileName);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Append) ||
+                file.write(record) != record.size() ||
+                !file.flush()) {
+            qCWarning(lcButeoCore) << "Failed to append to sync log journal:" << fileName;
+            // Anything written may be a partial record.
+            iJournalRecords.insert(aProfileName, -1);
+            return false;
+        }
+
+        if (iWriteGroupDepth > 0) {
+            iUnsyncedAppends.insert(fileName);
+        } else {
+            ::fdatasync(file.handle());
+        }
+        file.close();
+        noteOwnChange(fileName);
+
+        // Left behind if the journal was written by a process that exited
+        // before it could remove the old log.
+        removeObsoleteFile(legacyLogFilePath(aProfileName));
+    }
+
+    iJournalRecords.insert(aProfileName, records + 1);
+
+    QHash<QString, CacheEntry<SyncLog> >::iterator cached = iLogCache.find(aProfileName);
+    if (cached != iLogCache.end()) {
+        cached->iObject->setMaxResults(aRetention);
+        cached->iObject->addResults(aResults);
+    }
+
+    return true;
+}
+
+int ProfileManagerPrivate::logRetention(const QString &aProfileName)
+{
+    const Profile *profile = sharedProfile(aProfileName, Profile::TYPE_SYNC);
+    if (profile != 0 && profile->type() == Profile::TYPE_SYNC) {
+        // RTTI is not allowed, use static_cast. Should be safe, because
+        // type is verified.
+        return static_cast<const SyncProfile *>(profile)->logRetention();
+    }
+
+    return SyncLog::DEFAULT_MAX_RESULTS;
+}
+
+QString ProfileManagerPrivate::storeFilePath() const
+{
+    return iConfigPath + QDir::separator() + STORE_DIRECTORY + QDir::separator() + STORE_FILE;
+}
+
+void ProfileManagerPrivate::flushStore()
+{
+    if (iStore != 0) {
+        iStore->flush();
+    }
+}
+
+QString ProfileManagerPrivate::logFilePath(const QString &aProfileName) const
+{
+    return iConfigPath + QDir::separator() + Profile::TYPE_SYNC + QDir::separator() +
+           LOG_DIRECTORY + QDir::separator() + aProfileName + LOG_EXT + JOURNAL_EXT;
+}
+
+QString ProfileManagerPrivate::legacyLogFilePath(const QString &aProfileName) const
+{
+    return iConfigPath + QDir::separator() + Profile::TYPE_SYNC + QDir::separator() +
+           LOG_DIRECTORY + QDir::separator() + aProfileName + LOG_EXT + FORMAT_EXT;
+}
+
+void ProfileManagerPrivate::cacheProfile(const QString &aName, const QString &aType,
+                                         const QString &aPath, const QByteArray &aStamp,
+                                         Profile *aProfile)
+{
+    uncacheProfile(aName, aType);
+
+    CacheEntry<Profile> entry;
+    entry.iPath = aPath;
+    entry.iStamp = aStamp;
+    entry.iObject = aProfile;
+    iProfileCache.insert(profileCacheKey(aName, aType), entry);
+
+    // The file itself is watched for in-place modifications. Both type
+    // directories are watched, because a profile added to the primary path
+    // shadows the system profile with the same name.
+    watchPath(aPath);
+    watchPath(iConfigPath);
+    watchPath(iConfigPath + QDir::separator() + aType);
+    watchPath(iSystemConfigPath + QDir::separator() + aType);
+}
+
+void ProfileManagerPrivate::cacheLog(const QString &aProfileName, const QString &aPath,
+                                     const QByteArray &aStamp, SyncLog *aLog)
+{
+    uncacheLog(aProfileName);
+
+    CacheEntry<SyncLog> entry;
+    entry.iPath = aPath;
+    entry.iStamp = aStamp;
+    entry.iObject = aLog;
+    iLogCache.insert(aProfileName, entry);
+
+    watchPath(aPath);
+    watchPath(QFileInfo(aPath).absolutePath());
+}
+
+void ProfileManagerPrivate::uncacheProfile(const QString &aName, const QString &aType)
+{
+    QHash<QString, CacheEntry<Profile> >::iterator i =
+        iProfileCache.find(profileCacheKey(aName, aType));
+    if (i != iProfileCache.end()) {
+        delete i->iObject;
+        iProfileCache.erase(i);
+    }
+}
+
+void ProfileManagerPrivate::uncacheLog(const QString &aProfileName)
+{
+    QHash<QString, CacheEntry<SyncLog> >::iterator i = iLogCache.find(aProfileName);
+    if (i != iLogCache.end()) {
+        delete i->iObject;
+        iLogCache.erase(i);
+    }
+}
+
+void ProfileManagerPrivate::clearCache()
+{
+    foreach (const CacheEntry<Profile> &entry, iProfileCache) {
+        delete entry.iObject;
+    }
+    iProfileCache.clear();
+
+    foreach (const CacheEntry<SyncLog> &entry, iLogCache) {
+        delete entry.iObject;
+    }
+    iLogCache.clear();
+}
+
+bool ProfileManagerPrivate::isCurrent(const QString &aPath, const QByteArray &aStamp) const
+{
+    return iPendingWrites.contains(aPath) || (!aStamp.isEmpty() && aStamp == fileStamp(aPath));
+}
+
+void ProfileManagerPrivate::noteOwnChange(const QString &aPath)
+{
+    const QByteArray stamp = fileStamp(aPath);
+    iOwnChanges.insert(aPath, stamp);
+
+    // Anything cached from the file holds what was just written to it.
+    QMutableHashIterator<QString, CacheEntry<Profile> > profiles(iProfileCache);
+    while (profiles.hasNext()) {
+        if (profiles.next().value().iPath == aPath) {
+            profiles.value().iStamp = stamp;
+        }
+    }
+    QMutableHashIterator<QString, CacheEntry<SyncLog> > logs(iLogCache);
+    while (logs.hasNext()) {
+        if (logs.next().value().iPath == aPath) {
+            logs.value().iStamp = stamp;
+        }
+    }
+
+    const QString directory = QFileInfo(aPath).absolutePath();
+    iOwnChanges.insert(directory, fileStamp(directory));
+}
+
+bool ProfileManagerPrivate::isOwnChange(const QString &aPath) const
+{
+    QHash<QString, QByteArray>::const_iterator i = iOwnChanges.constFind(aPath);
+    return i != iOwnChanges.constEnd() && !i->isEmpty() && *i == fileStamp(aPath);
+}
+
+void ProfileManagerPrivate::pathChanged(const QString &aPath)
+{
+    if (isOwnChange(aPath)) {
+        // Our own write, the cache is already up to date. A replaced file
+        // is no longer watched, start watching the new one.
+        watchPath(aPath);
+        return;
+    }
+
+    QFileInfo info(aPath);
+
+    if (info.isDir() || (iWatcher != 0 && iWatcher->directories().contains(aPath))) {
+        // Files are saved by renaming, so directories change on every
+        // write. Modified files are reported separately, here only entries
+        // whose file was removed or is now shadowed by another one are
+        // dropped.
+        QMutableHashIterator<QString, CacheEntry<SyncLog> > logs(iLogCache);
+        while (logs.hasNext()) {
+            logs.next();
+            if (!QFile::exists(logs.value().iPath) &&
+                    !iPendingWrites.contains(logs.value().iPath)) {
+                delete logs.value().iObject;
+                logs.remove();
+            }
+        }
+
+        QMutableHashIterator<QString, CacheEntry<Profile> > profiles(iProfileCache);
+        while (profiles.hasNext()) {
+            profiles.next();
+            const QString type = profiles.key().section(QDir::separator(), 0, 0);
+            const QString name = profiles.key().section(QDir::separator(), 1);
+            if (findProfileFile(name, type) != profiles.value().iPath) {
+                invalidateIndex(name, type);
+                delete profiles.value().iObject;
+                profiles.remove();
+            }
+        }
+
+        // Journals may have been replaced or removed. Record counts are kept
+        // only for journals whose cached log still matches the file, the
+        // others are counted again on the next load.
+        if (aPath == QFileInfo(logFilePath(QString())).absolutePath()) {
+            QMutableHashIterator<QString, int> records(iJournalRecords);
+            while (records.hasNext()) {
+                records.next();
+                QHash<QString, CacheEntry<SyncLog> >::const_iterator log =
+                    iLogCache.constFind(records.key());
+                if (log == iLogCache.constEnd() || !isCurrent(log->iPath, log->iStamp)) {
+                    records.remove();
+                }
+            }
+        }
+
+        iIndexNamesDirty = true;
+        return;
+    }
+
+    QMutableHashIterator<QString, CacheEntry<Profile> > profiles(iProfileCache);
+    while (profiles.hasNext()) {
+        profiles.next();
+        if (profiles.value().iPath == aPath) {
+            invalidateIndex(profiles.value().iObject->name(),
+                            profiles.value().iObject->type());
+            delete profiles.value().iObject;
+            profiles.remove();
+        }
+    }
+
+    QMutableHashIterator<QString, CacheEntry<SyncLog> > logs(iLogCache);
+    while (logs.hasNext()) {
+        logs.next();
+        if (logs.value().iPath == aPath) {
+            delete logs.value().iObject;
+            logs.remove();
+        }
+    }
+
+    QMutableHashIterator<QString, int> records(iJournalRecords);
+    while (records.hasNext()) {
+        records.next();
+        if (logFilePath(records.key()) == aPath) {
+            records.remove();
+        }
+    }
+}
+
+void ProfileManagerPrivate::ensureIndex(ProfileManager &aManager)
+{
+    if (!iIndexValid) {
+        iKeyIndex.clear();
+        iSubProfileIndex.clear();
+        iIndexedKeys.clear();
+        iIndexedSubProfiles.clear();
+        iIndexedStamps.clear();
+        iDirtyIndex.clear();
+        iIndexNamesDirty = false;
+
+        beginBatch();
+        // Taken before listing, a change in between is detected next time.
+        iIndexDirStamps = indexDirStamps();
+        QStringList names = aManager.profileNames(Profile::TYPE_SYNC);
+        foreach (const QString &name, names) {
+            reindex(aManager, name);
+        }
+        iIndexValid = true;
+        endBatch();
+    } else {
+        checkIndexStamps();
+
+        const QList<QByteArray> dirStamps = indexDirStamps();
+        if (dirStamps != iIndexDirStamps) {
+            // Profiles may have been added or removed, the watcher has not
+            // reported it yet.
+            iIndexNamesDirty = true;
+        }
+
+        if (iIndexNamesDirty) {
+            iIndexNamesDirty = false;
+            iIndexDirStamps = dirStamps;
+            QStringList names = aManager.profileNames(Profile::TYPE_SYNC);
+            QSet<QString> current;
+            foreach (const QString &name, names) {
+                current.insert(name);
+                if (!iIndexedStamps.contains(name)) {
+                    iDirtyIndex.insert(name);
+                }
+            }
+            foreach (const QString &name, iIndexedStamps.keys()) {
+                if (!current.contains(name)) {
+                    unindexProfile(name);
+                }
+            }
+        }
+
+        QSet<QString> dirty = iDirtyIndex;
+        iDirtyIndex.clear();
+        foreach (const QString &name, dirty) {
+            reindex(aManager, name);
+        }
     }
-    file.close();
+}
 
-    return new SyncLog(doc.documentElement());
+void ProfileManagerPrivate::checkIndexStamps()
+{
+    QHash<QString, QHash<QString, QByteArray> >::const_iterator i;
+    for (i = iIndexedStamps.constBegin(); i != iIndexedStamps.constEnd(); ++i) {
+        QHash<QString, QByteArray>::const_iterator file;
+        for (file = i->constBegin(); file != i->constEnd(); ++file) {
+            if (!iPendingWrites.contains(file.key()) &&
+                    file.value() != fileStamp(file.key())) {
+                iDirtyIndex.insert(i.key());
+                break;
+            }
+        }
+    }
+}
+
+QList<QByteArray> ProfileManagerPrivate::indexDirStamps() const
+{
+    return QList<QByteArray>()
+           << fileStamp(iConfigPath + QDir::separator() + Profile::TYPE_SYNC)
+           << fileStamp(iSystemConfigPath + QDir::separator() + Profile::TYPE_SYNC);
+}
+
+void ProfileManagerPrivate::reindex(ProfileManager &aManager, const QString &aName)
+{
+    unindexProfile(aName);
+
+    // Taken before reading, a write in between is detected on the next
+    // search.
+    const QString path = findProfileFile(aName, Profile::TYPE_SYNC);
+    QHash<QString, QByteArray> &stamps = iIndexedStamps[aName];
+    stamps.insert(path, fileStamp(path));
+
+    Profile *p = aManager.profile(aName, Profile::TYPE_SYNC);
+    if (p != 0) {
+        if (p->type() == Profile::TYPE_SYNC) {
+            aManager.expand(*p);
+            indexProfile(*p, aName);
+
+            foreach (const Profile *sub, p->allSubProfiles()) {
+                // The cached sub-profile is the one just merged, its stamp
+                // was taken before it was read.
+                const QString subPath = findProfileFile(sub->name(), sub->type());
+                QHash<QString, CacheEntry<Profile> >::const_iterator cached =
+                    iProfileCache.constFind(profileCacheKey(sub->name(), sub->type()));
+                stamps.insert(subPath, cached != iProfileCache.constEnd() &&
+                              cached->iPath == subPath ? cached->iStamp
+                                                       : fileStamp(subPath));
+            }
+        }
+        delete p;
+        p = 0;
+    }
+}
+
+void ProfileManagerPrivate::indexProfile(const Profile &aProfile, const QString &aName)
+{
+    QList<QPair<QString, QString> > &indexedKeys = iIndexedKeys[aName];
+    QStringList &indexedSubProfiles = iIndexedSubProfiles[aName];
+
+    QList<const Profile *> profiles = aProfile.allSubProfiles();
+    profiles.prepend(&aProfile);
+    foreach (const Profile *p, profiles) {
+        if (p != &aProfile) {
+            QString subProfileId = profileCacheKey(p->name(), p->type());
+            iSubProfileIndex[subProfileId].insert(aName);
+            indexedSubProfiles.append(subProfileId);
+        }
+
+        QStringList keyNames = p->keyNames();
+        keyNames.removeDuplicates();
+        foreach (const QString &keyName, keyNames) {
+            foreach (const QString &value, p->keyValues(keyName)) {
+                iKeyIndex[keyName][value].insert(aName);
+                indexedKeys.append(qMakePair(keyName, value));
+            }
+        }
+    }
+}
+
+void ProfileManagerPrivate::unindexProfile(const QString &aName)
+{
+    iIndexedStamps.remove(aName);
+
+    typedef QPair<QString, QString> KeyValue;
+    foreach (const KeyValue &keyValue, iIndexedKeys.take(aName)) {
+        QHash<QString, QHash<QString, QSet<QString> > >::iterator key =
+            iKeyIndex.find(keyValue.first);
+        if (key == iKeyIndex.end()) {
+            continue;
+        }
+        QHash<QString, QSet<QString> >::iterator value = key->find(keyValue.second);
+        if (value != key->end()) {
+            value->remove(aName);
+            if (value->isEmpty()) {
+                key->erase(value);
+            }
+        }
+        if (key->isEmpty()) {
+            iKeyIndex.erase(key);
+        }
+    }
+
+    foreach (const QString &subProfileId, iIndexedSubProfiles.take(aName)) {
+        QHash<QString, QSet<QString> >::iterator i = iSubProfileIndex.find(subProfileId);
+        if (i != iSubProfileIndex.end()) {
+            i->remove(aName);
+            if (i->isEmpty()) {
+                iSubProfileIndex.erase(i);
+            }
+        }
+    }
+}
+
+void ProfileManagerPrivate::invalidateIndex(const QString &aName, const QString &aType)
+{
+    if (aType == Profile::TYPE_SYNC) {
+        iDirtyIndex.insert(aName);
+    } else {
+        // Sub-profiles are merged into any number of sync profiles.
+        iIndexValid = false;
+    }
+}
+
+bool ProfileManagerPrivate::indexCandidates(const QList<ProfileManager::SearchCriteria> &aCriteria,
+                                            QSet<QString> &aCandidates) const
+{
+    bool narrowed = false;
+
+    foreach (const ProfileManager::SearchCriteria &criteria, aCriteria) {
+        QSet<QString> matches;
+
+        if (!criteria.iKey.isEmpty() &&
+                criteria.iType == ProfileManager::SearchCriteria::EQUAL) {
+            matches = iKeyIndex.value(criteria.iKey).value(criteria.iValue);
+        } else if (!criteria.iKey.isEmpty() &&
+                   criteria.iType == ProfileManager::SearchCriteria::EXISTS) {
+            foreach (const QSet<QString> &names, iKeyIndex.value(criteria.iKey)) {
+                matches.unite(names);
+            }
+        } else if (criteria.iKey.isEmpty() && !criteria.iSubProfileName.isEmpty() &&
+                   criteria.iType != ProfileManager::SearchCriteria::NOT_EXISTS) {
+            if (criteria.iSubProfileType.isEmpty()) {
+                QHash<QString, QSet<QString> >::const_iterator i;
+                for (i = iSubProfileIndex.constBegin(); i != iSubProfileIndex.constEnd(); ++i) {
+                    if (i.key().endsWith(QDir::separator() + criteria.iSubProfileName)) {
+                        matches.unite(i.value());
+                    }
+                }
+            } else {
+                matches = iSubProfileIndex.value(profileCacheKey(criteria.iSubProfileName,
+                                                                 criteria.iSubProfileType));
+            }
+        } else {
+            // Negative criteria cannot be answered from the index.
+            continue;
+        }
+
+        if (narrowed) {
+            aCandidates.intersect(matches);
+        } else {
+            aCandidates = matches;
+            narrowed = true;
+        }
+    }
+
+    return narrowed;
+}
+
+void ProfileManagerPrivate::watchPath(const QString &aPath)
+{
+    QFileInfo info(aPath);
+    if (!info.exists()) {
+        return;
+    }
+
+    if (iWatcher == 0) {
+        iWatcher = new QFileSystemWatcher();
+        QObject::connect(iWatcher, SIGNAL(fileChanged(QString)),
+                         iParent, SLOT(onProfilePathChanged(QString)));
+        QObject::connect(iWatcher, SIGNAL(directoryChanged(QString)),
+                         iParent, SLOT(onProfilePathChanged(QString)));
+    }
+
+    const QStringList watched = info.isDir() ? iWatcher->directories() : iWatcher->files();
+    if (!watched.contains(aPath)) {
+        iWatcher->addPath(aPath);
+    }
 }
 
 bool ProfileManagerPrivate::matchProfile(const Profile &aProfile,
@@ -278,9 +1374,11 @@ ProfileManager::SearchCriteria::SearchCriteria(const SearchCriteria &aSource)
 }
 
 ProfileManager::ProfileManager()
-    : d_ptr(new ProfileManagerPrivate)
+    : d_ptr(new ProfileManagerPrivate(this))
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    d_ptr->recoverBackups();
 }
 
 ProfileManager::~ProfileManager()
@@ -290,8 +1388,23 @@ ProfileManager::~ProfileManager()
     d_ptr = 0;
 }
 
+void ProfileManager::onProfilePathChanged(const QString &aPath)
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+    qCDebug(lcButeoCore) << "Profile path changed, invalidating cache:" << aPath;
+    d_ptr->pathChanged(aPath);
+}
+
 void ProfileManager::setPaths(const QString &configPath, const QString &systemConfigPath)
 {
+    d_ptr->commitWrites();
+    d_ptr->clearCache();
+    d_ptr->iJournalRecords.clear();
+    d_ptr->iOwnChanges.clear();
+    d_ptr->iIndexValid = false;
+    delete d_ptr->iWatcher;
+    d_ptr->iWatcher = 0;
+
     if (!configPath.isEmpty()) {
         d_ptr->iConfigPath = configPath;
         if (d_ptr->iConfigPath.endsWith(QDir::separator())) {
@@ -305,6 +1418,76 @@ void ProfileManager::setPaths(const QString &configPath, const QString &systemCo
             d_ptr->iSystemConfigPath.chop(1);
         }
     }
+
+    if (d_ptr->iStore != 0) {
+        delete d_ptr->iStore;
+        d_ptr->iStore = new ProfileStore(d_ptr->storeFilePath());
+    }
+
+    d_ptr->recoverBackups();
+}
+
+void ProfileManager::beginWriteGroup()
+{
+    ++d_ptr->iWriteGroupDepth;
+}
+
+bool ProfileManager::endWriteGroup()
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    if (d_ptr->iWriteGroupDepth > 0 && --d_ptr->iWriteGroupDepth > 0) {
+        return true;
+    }
+
+    QStringList failed;
+    bool success = d_ptr->commitWrites(&failed);
+    if (!success) {
+        // Cached copies may have contents that never reached the disk.
+        d_ptr->clearCache();
+        d_ptr->iJournalRecords.clear();
+        d_ptr->iIndexValid = false;
+    }
+
+    const QList<ProfileManagerPrivate::PendingSignal> pending = d_ptr->iPendingSignals;
+    d_ptr->iPendingSignals.clear();
+    foreach (const ProfileManagerPrivate::PendingSignal &change, pending) {
+        if (!change.iPath.isEmpty() && failed.contains(change.iPath)) {
+            qCWarning(lcButeoCore) << "Change was not saved, not notifying:" << change.iProfileName;
+            continue;
+        }
+        emit signalProfileChanged(change.iProfileName, change.iChangeType,
+                                  change.iProfileAsXml);
+    }
+
+    return success;
+}
+
+void ProfileManager::notifyProfileChanged(const QString &aProfileName, int aChangeType,
+                                          const QString &aProfileAsXml, const QString &aPath)
+{
+    if (d_ptr->iWriteGroupDepth > 0) {
+        ProfileManagerPrivate::PendingSignal change;
+        change.iProfileName = aProfileName;
+        change.iChangeType = aChangeType;
+        change.iProfileAsXml = aProfileAsXml;
+        change.iPath = aPath;
+        d_ptr->iPendingSignals.append(change);
+    } else {
+        emit signalProfileChanged(aProfileName, aChangeType, aProfileAsXml);
+    }
+}
+
+void ProfileManager::setProfileStoreEnabled(bool aEnabled)
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    if (aEnabled && d_ptr->iStore == 0) {
+        d_ptr->iStore = new ProfileStore(d_ptr->storeFilePath());
+    } else if (!aEnabled && d_ptr->iStore != 0) {
+        delete d_ptr->iStore;
+        d_ptr->iStore = 0;
+    }
 }
 
 Profile *ProfileManager::profile(const QString &aName, const QString &aType)
@@ -328,7 +1511,7 @@ SyncProfile *ProfileManager::syncProfile(const QString &aName)
 
         // Load sync log. If not found, create an empty log.
         if (syncProfile->log() == 0) {
-            SyncLog *log = d_ptr->loadLog(aName);
+            SyncLog *log = d_ptr->loadLog(aName, syncProfile->logRetention());
             if (0 == log) {
                 log = new SyncLog(aName);
             }
@@ -382,6 +1565,7 @@ QList<SyncProfile *> ProfileManager::allSyncProfiles()
 
     QList<SyncProfile *> profiles;
 
+    d_ptr->beginBatch();
     QStringList names = profileNames(Profile::TYPE_SYNC);
     foreach (const QString &name, names) {
         SyncProfile *p = syncProfile(name);
@@ -389,6 +1573,7 @@ QList<SyncProfile *> ProfileManager::allSyncProfiles()
             profiles.append(p);
         }
     }
+    d_ptr->endBatch();
 
     return profiles;
 }
@@ -417,10 +1602,26 @@ QList<SyncProfile *> ProfileManager::getSyncProfilesByData(
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
 
-    QList<SyncProfile *> allProfiles = allSyncProfiles();
+    // Narrow down the profiles to load with the search index. The index
+    // only gives candidates, the actual matching is done below.
+    SearchCriteria indexCriteria;
+    indexCriteria.iType = aValue.isEmpty() ? SearchCriteria::EXISTS : SearchCriteria::EQUAL;
+    if (aKey.isEmpty()) {
+        indexCriteria.iSubProfileName = aSubProfileName;
+        indexCriteria.iSubProfileType = aSubProfileType;
+    } else {
+        indexCriteria.iKey = aKey;
+        indexCriteria.iValue = aValue;
+    }
+
     QList<SyncProfile *> matchingProfiles;
 
-    foreach (SyncProfile *profile, allProfiles) {
+    foreach (const QString &name, indexedSyncProfileNames(QList<SearchCriteria>() << indexCriteria)) {
+        SyncProfile *profile = syncProfile(name);
+        if (0 == profile) {
+            continue;
+        }
+
         Profile *testProfile = profile;
         if (!aSubProfileName.isEmpty()) {
             // Sub-profile name was given, request a sub-profile with a
@@ -468,10 +1669,10 @@ QList<SyncProfile *> ProfileManager::getSyncProfilesByData(
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
 
-    QList<SyncProfile *> allProfiles = allSyncProfiles();
     QList<SyncProfile *> matchingProfiles;
 
-    foreach (SyncProfile *profile, allProfiles) {
+    foreach (const QString &name, indexedSyncProfileNames(aCriteria)) {
+        SyncProfile *profile = syncProfile(name);
         bool matched = true;
         if (profile == 0)
             continue;
@@ -494,6 +1695,26 @@ QList<SyncProfile *> ProfileManager::getSyncProfilesByData(
     return matchingProfiles;
 }
 
+QStringList ProfileManager::indexedSyncProfileNames(const QList<SearchCriteria> &aCriteria)
+{
+    QStringList names = profileNames(Profile::TYPE_SYNC);
+
+    d_ptr->ensureIndex(*this);
+    QSet<QString> candidates;
+    if (d_ptr->indexCandidates(aCriteria, candidates)) {
+        // Keep the directory order of the profiles.
+        QStringList candidateNames;
+        foreach (const QString &name, names) {
+            if (candidates.contains(name)) {
+                candidateNames.append(name);
+            }
+        }
+        names = candidateNames;
+    }
+
+    return names;
+}
+
 QList<SyncProfile *> ProfileManager::getSOCProfilesForStorage(
     const QString &aStorageName)
 {
@@ -617,22 +1838,16 @@ bool ProfileManagerPrivate::save(const Profile &aProfile)
     QString profilePath(iConfigPath + QDir::separator() +
                         aProfile.type() + QDir::separator() + aProfile.name() + FORMAT_EXT);
 
-    // Create a backup of the existing profile file.
-    QString oldProfilePath = findProfileFile(aProfile.type(), aProfile.name());
-    QString backupPath = profilePath + BACKUP_EXT;
-
-    if (QFile::exists(oldProfilePath) &&
-            !createBackup(oldProfilePath, backupPath)) {
-        qCWarning(lcButeoCore) << "Failed to create profile backup";
+    // Our own copy is stale from now on, regardless of the write result.
+    uncacheProfile(aProfile.name(), aProfile.type());
+    if (iStore != 0) {
+        iStore->remove(aProfile.name(), aProfile.type());
     }
+    invalidateIndex(aProfile.name(), aProfile.type());
 
-    bool profileWritten = false;
-    if (writeProfileFile(profilePath, doc)) {
-        QFile::remove(backupPath);
-        profileWritten = true;
-    } else {
+    bool profileWritten = writeFile(profilePath, doc.toByteArray(PROFILE_INDENT));
+    if (!profileWritten) {
         qCWarning(lcButeoCore) << "Failed to save profile:" << aProfile.name();
-        profileWritten = false;
     }
 
     return profileWritten;
@@ -679,11 +1894,17 @@ QString ProfileManager::updateProfile(const Profile &aProfile)
         profileId = aProfile.name();
     }
 
+    // Inside a write group the signal waits until the file is on disk.
+    const QString profilePath = d_ptr->iConfigPath + QDir::separator() + aProfile.type() +
+                                QDir::separator() + aProfile.name() + FORMAT_EXT;
+
     // Profile did not exist, it was a new one. Add it and emit signal with "added" value:
     if (!exists) {
-        emit signalProfileChanged(aProfile.name(), ProfileManager::PROFILE_ADDED, aProfile.toString());
+        notifyProfileChanged(aProfile.name(), ProfileManager::PROFILE_ADDED, aProfile.toString(),
+                             profilePath);
     } else {
-        emit signalProfileChanged(aProfile.name(), ProfileManager::PROFILE_MODIFIED, aProfile.toString());
+        notifyProfileChanged(aProfile.name(), ProfileManager::PROFILE_MODIFIED, aProfile.toString(),
+                             profilePath);
     }
 
     return profileId;
@@ -795,7 +2016,7 @@ bool ProfileManager::removeProfile(const QString &aProfileId)
     if (profile) {
         success = d_ptr->remove(aProfileId, profile->type());
         if (success) {
-            emit signalProfileChanged(aProfileId, ProfileManager::PROFILE_REMOVED, QString(""));
+            notifyProfileChanged(aProfileId, ProfileManager::PROFILE_REMOVED, QString(""), QString());
         }
         delete profile;
         profile = nullptr;
@@ -815,12 +2036,24 @@ bool ProfileManagerPrivate::remove(const QString &aName, const QString &aType)
     Profile *p = load(aName, aType);
     if (p) {
         if (!p->isProtected()) {
-            success = QFile::remove(filePath);
+            // Nothing queued for the profile may be written afterwards. A
+            // profile added in the current write group is only queued.
+            const bool pending = iPendingWrites.remove(filePath) > 0;
+            success = QFile::remove(filePath) || (pending && !QFile::exists(filePath));
             if (success) {
-                QString logFilePath = iConfigPath + QDir::separator() + aType + QDir::separator() +
-                                      LOG_DIRECTORY + QDir::separator() + aName + LOG_EXT + FORMAT_EXT;
+                uncacheProfile(aName, aType);
+                uncacheLog(aName);
+                invalidateIndex(aName, aType);
+                if (iStore != 0) {
+                    iStore->remove(aName, aType);
+                }
                 //Initial the will be no log this will fail.
-                QFile::remove(logFilePath);
+                const QString journalPath = logFilePath(aName);
+                iPendingWrites.remove(journalPath);
+                iUnsyncedAppends.remove(journalPath);
+                iJournalRecords.remove(aName);
+                QFile::remove(journalPath);
+                QFile::remove(legacyLogFilePath(aName));
             }
         } else {
             qCDebug(lcButeoCore) << "Cannot remove protected profile:" << aName ;
@@ -847,11 +2080,11 @@ void ProfileManager::expand(Profile &aProfile)
     while (subCount > prevSubCount) {
         foreach (Profile *sub, subProfiles) {
             if (!sub->isLoaded()) {
-                Profile *loadedProfile = profile(sub->name(), sub->type());
+                // Merge directly from the cache, each sub-profile file is
+                // parsed only once no matter how many profiles refer to it.
+                const Profile *loadedProfile = d_ptr->sharedProfile(sub->name(), sub->type());
                 if (loadedProfile != 0) {
                     aProfile.merge(*loadedProfile);
-                    delete loadedProfile;
-                    loadedProfile = 0;
                 } else {
                     // No separate profile file for the sub-profile.
                     qCDebug(lcButeoCore) << "Referenced sub-profile not found:" <<
@@ -877,38 +2110,14 @@ bool ProfileManager::saveLog(const SyncLog &aLog)
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
 
-    QDir dir;
-    QString fullPath = d_ptr->iConfigPath + QDir::separator() + Profile::TYPE_SYNC + QDir::separator() +
-                       LOG_DIRECTORY;
-    dir.mkpath(fullPath);
-    QFile file(fullPath + QDir::separator() + aLog.profileName() + LOG_EXT + FORMAT_EXT);
-
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-        qCWarning(lcButeoCore) << "Failed to open sync log file for writing:"
-                    << file.fileName();
-        return false;
-    }
-
-    QDomDocument doc;
-    QDomProcessingInstruction xmlHeading =
-        doc.createProcessingInstruction("xml",
-                                        "version=\"1.0\" encoding=\"UTF-8\"");
-    doc.appendChild(xmlHeading);
-
-    QDomElement root = aLog.toXml(doc);
-    if (root.isNull()) {
-        qCWarning(lcButeoCore) << "Failed to convert sync log to XML";
+    SyncLog log(aLog);
+    log.setMaxResults(d_ptr->logRetention(aLog.profileName()));
+    if (!d_ptr->writeJournal(log)) {
+        qCWarning(lcButeoCore) << "Failed to write sync log journal:"
+                    << d_ptr->logFilePath(aLog.profileName());
         return false;
     }
 
-    doc.appendChild(root);
-
-    QTextStream outputStream(&file);
-
-    outputStream << doc.toString(PROFILE_INDENT);
-
-    file.close();
-
     return true;
 }
 
@@ -928,6 +2137,15 @@ bool ProfileManager::rename(const QString &aName, const QString &aNewName)
     FUNCTION_CALL_TRACE(lcButeoTrace);
 
     bool ret = false;
+    // Files are renamed as they are on disk.
+    d_ptr->commitWrites();
+    d_ptr->uncacheProfile(aName, Profile::TYPE_SYNC);
+    d_ptr->uncacheProfile(aNewName, Profile::TYPE_SYNC);
+    d_ptr->uncacheLog(aName);
+    d_ptr->uncacheLog(aNewName);
+    d_ptr->invalidateIndex(aName, Profile::TYPE_SYNC);
+    d_ptr->invalidateIndex(aNewName, Profile::TYPE_SYNC);
+
     // Rename the sync profile
     QString source = d_ptr->iConfigPath + QDir::separator() +  Profile::TYPE_SYNC + QDir::separator() +
                      aName + FORMAT_EXT;
@@ -936,10 +2154,16 @@ bool ProfileManager::rename(const QString &aName, const QString &aNewName)
     ret = QFile::rename(source, destination);
     if (true == ret) {
         // Rename the sync log
-        QString sourceLog = d_ptr->iConfigPath + QDir::separator() +  Profile::TYPE_SYNC + QDir::separator() +
-                            LOG_DIRECTORY + QDir::separator() + aName + LOG_EXT  + FORMAT_EXT;
-        QString destinationLog = d_ptr->iConfigPath + QDir::separator() +  Profile::TYPE_SYNC + QDir::separator() +
-                                 LOG_DIRECTORY + QDir::separator() + aNewName + LOG_EXT  + FORMAT_EXT;
+        d_ptr->iJournalRecords.remove(aName);
+        d_ptr->iJournalRecords.remove(aNewName);
+        QString sourceLog = d_ptr->logFilePath(aName);
+        QString destinationLog = d_ptr->logFilePath(aNewName);
+        if (QFile::exists(sourceLog)) {
+            QFile::remove(d_ptr->legacyLogFilePath(aName));
+        } else {
+            sourceLog = d_ptr->legacyLogFilePath(aName);
+            destinationLog = d_ptr->legacyLogFilePath(aNewName);
+        }
         ret = QFile::rename(sourceLog, destinationLog);
         if (false == ret) {
             // Roll back the earlier rename
@@ -959,23 +2183,36 @@ bool ProfileManager::saveSyncResults(QString aProfileName,
     FUNCTION_CALL_TRACE(lcButeoTrace);
     bool success = false;
 
-    SyncProfile *profile = syncProfile(aProfileName);
-    if (profile) {
-        SyncLog *log = profile->log();
-        if (log) {
-            log->addResults(aResults);
-            success = saveLog(*log);
-            //Emitting signal
-            emit signalProfileChanged(aProfileName, ProfileManager::PROFILE_LOGS_MODIFIED, profile->toString());
-        }
-
-        delete profile;
-        profile = 0;
+    // The results are appended to the log journal, the log is not loaded.
+    // Neither is the profile copied or expanded, the cached one is enough.
+    const Profile *profile = d_ptr->sharedProfile(aProfileName, Profile::TYPE_SYNC);
+    if (profile != 0 && profile->type() == Profile::TYPE_SYNC) {
+        // RTTI is not allowed, use static_cast. Should be safe, because
+        // type is verified.
+        const SyncProfile *syncProfile = static_cast<const SyncProfile *>(profile);
+        const int retention = syncProfile->logRetention();
+        const QString profileAsXml = syncProfile->toString();
+        success = d_ptr->appendLog(aProfileName, aResults, retention);
+        //Emitting signal
+        notifyProfileChanged(aProfileName, ProfileManager::PROFILE_LOGS_MODIFIED, profileAsXml,
+                             d_ptr->logFilePath(aProfileName));
     }
 
     return success;
 }
 
+bool ProfileManager::saveSyncResults(const SyncProfile &aProfile, const SyncResults &aResults)
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    bool success = d_ptr->appendLog(aProfile.name(), aResults, aProfile.logRetention());
+    //Emitting signal
+    notifyProfileChanged(aProfile.name(), ProfileManager::PROFILE_LOGS_MODIFIED, aProfile.toString(),
+                         d_ptr->logFilePath(aProfile.name()));
+
+    return success;
+}
+
 bool ProfileManager::setSyncSchedule(QString aProfileId, QString aScheduleAsXml)
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
@@ -998,16 +2235,56 @@ bool ProfileManager::setSyncSchedule(QString aProfileId, QString aScheduleAsXml)
     return status;
 }
 
-bool ProfileManagerPrivate::parseFile(const QString &aPath, QDomDocument &aDoc)
+void ProfileManagerPrivate::recoverBackups()
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    QDir configDir(iConfigPath);
+    foreach (const QString &type, configDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        QDir typeDir(configDir.filePath(type));
+        const QStringList backups = typeDir.entryList(QStringList("*" + FORMAT_EXT + BACKUP_EXT),
+                                                      QDir::Files);
+        foreach (const QString &backup, backups) {
+            const QString backupPath = typeDir.filePath(backup);
+            const QString profilePath = backupPath.left(backupPath.length() - BACKUP_EXT.length());
+
+            // An intact profile is newer than its backup.
+            QDomDocument doc;
+            if (!parseFile(profilePath, doc) && parseFile(backupPath, doc)) {
+                qCWarning(lcButeoCore) << "Restoring profile from backup:" << profilePath;
+                QFile file(backupPath);
+                if (!file.open(QIODevice::ReadOnly) || !writeFile(profilePath, file.readAll())) {
+                    qCWarning(lcButeoCore) << "Failed to restore profile from backup:" << profilePath;
+                    continue;
+                }
+            }
+
+            QFile::remove(backupPath);
+        }
+    }
+}
+
+bool ProfileManagerPrivate::parseFile(const QString &aPath, QDomDocument &aDoc,
+                                      QByteArray *aContents)
 {
     bool parsingOk = false;
 
-    if (QFile::exists(aPath)) {
+    QMap<QString, QByteArray>::const_iterator pending = iPendingWrites.constFind(aPath);
+    if (pending != iPendingWrites.constEnd()) {
+        parsingOk = aDoc.setContent(*pending);
+        if (aContents != 0) {
+            *aContents = *pending;
+        }
+    } else if (QFile::exists(aPath)) {
         QFile file(aPath);
 
         if (file.open(QIODevice::ReadOnly)) {
-            parsingOk = aDoc.setContent(&file);
+            const QByteArray contents = file.readAll();
             file.close();
+            parsingOk = aDoc.setContent(contents);
+            if (aContents != 0) {
+                *aContents = contents;
+            }
 
             if (!parsingOk) {
                 qCWarning(lcButeoCore) << "Failed to parse profile XML: " << aPath;
@@ -1041,52 +2318,116 @@ QDomDocument ProfileManagerPrivate::constructProfileDocument(const Profile &aPro
     return doc;
 }
 
-bool ProfileManagerPrivate::writeProfileFile(const QString &aProfilePath,
-                                             const QDomDocument &aDoc)
+bool ProfileManagerPrivate::writeFile(const QString &aPath, const QByteArray &aData)
+{
+    iPendingWrites.insert(aPath, aData);
+
+    return iWriteGroupDepth > 0 || commitWrites();
+}
+
+bool ProfileManagerPrivate::commitWrites(QStringList *aFailed)
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
-    qCWarning(lcButeoCore) << "writeProfileFile() called, forcing disk write:" << aProfilePath;
 
-    QFile file(aProfilePath);
-    bool profileWritten = false;
+    foreach (const QString &path, iUnsyncedAppends) {
+        int fd = ::open(QFile::encodeName(path).constData(), O_WRONLY);
+        if (fd >= 0) {
+            ::fdatasync(fd);
+            ::close(fd);
+        }
+    }
+    iUnsyncedAppends.clear();
+
+    if (iPendingWrites.isEmpty()) {
+        removeObsoleteFiles();
+        return true;
+    }
 
-    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-        QTextStream outputStream(&file);
-        outputStream << aDoc.toString(PROFILE_INDENT);
-        file.close();
-        profileWritten = true;
+    const QMap<QString, QByteArray> writes = iPendingWrites;
+    iPendingWrites.clear();
+    bool success = true;
+
+    // Get all new contents on disk first. Renaming is safe only after that.
+    // Temporary files are unique, other processes may be saving the same
+    // files at the same time.
+    QMap<QString, QString> written;
+    QMap<QString, QByteArray>::const_iterator i;
+    for (i = writes.constBegin(); i != writes.constEnd(); ++i) {
+        QTemporaryFile file(i.key() + TEMP_EXT + ".XXXXXX");
+        file.setAutoRemove(false);
+        if (!file.open() ||
+                !file.setPermissions(QFile::ReadOwner | QFile::WriteOwner |
+                                     QFile::ReadGroup | QFile::ReadOther) ||
+                file.write(i.value()) != i.value().size() ||
+                !file.flush() ||
+                ::fdatasync(file.handle()) != 0) {
+            qCWarning(lcButeoCore) << "Failed to write file:" << i.key();
+            file.close();
+            file.remove();
+            success = false;
+            if (aFailed != 0) {
+                aFailed->append(i.key());
+            }
+        } else {
+            file.close();
+            written.insert(i.key(), file.fileName());
+        }
+    }
+
+    QSet<QString> directories;
+    QMap<QString, QString>::const_iterator w;
+    for (w = written.constBegin(); w != written.constEnd(); ++w) {
+        const QString &path = w.key();
+        if (::rename(QFile::encodeName(w.value()).constData(),
+                     QFile::encodeName(path).constData()) != 0) {
+            qCWarning(lcButeoCore) << "Failed to replace file:" << path;
+            QFile::remove(w.value());
+            success = false;
+            if (aFailed != 0) {
+                aFailed->append(path);
+            }
+        } else {
+            noteOwnChange(path);
+            directories.insert(QFileInfo(path).absolutePath());
+        }
+    }
+
+    // Make the renames durable, once per directory.
+    foreach (const QString &directory, directories) {
+        int fd = ::open(QFile::encodeName(directory).constData(), O_RDONLY | O_DIRECTORY);
+        if (fd >= 0) {
+            ::fsync(fd);
+            ::close(fd);
+        }
+    }
+
+    if (success) {
+        removeObsoleteFiles();
     } else {
-        qCWarning(lcButeoCore) << "Failed to open profile file for writing:" << aProfilePath;
-        profileWritten = false;
+        // The replacements may be missing, keep the old files.
+        iObsoleteFiles.clear();
     }
 
-    return profileWritten;
+    return success;
 }
 
-void ProfileManagerPrivate::restoreBackupIfFound(const QString &aProfilePath,
-                                                 const QString &aBackupPath)
+void ProfileManagerPrivate::removeObsoleteFile(const QString &aPath)
 {
-    if (QFile::exists(aBackupPath)) {
-        qCWarning(lcButeoCore) << "Profile backup file found. The actual profile may be corrupted.";
-
-        QDomDocument doc;
-        if (parseFile(aBackupPath, doc)) {
-            qCDebug(lcButeoCore) << "Restoring profile from backup";
-            QFile::remove(aProfilePath);
-            QFile::copy(aBackupPath, aProfilePath);
-        } else {
-            qCWarning(lcButeoCore) << "Failed to parse backup file";
-            qCDebug(lcButeoCore) << "Removing backup file";
-            QFile::remove(aBackupPath);
-        }
+    if (iWriteGroupDepth > 0) {
+        iObsoleteFiles.insert(aPath);
+    } else if (QFile::remove(aPath)) {
+        noteOwnChange(aPath);
     }
 }
 
-bool ProfileManagerPrivate::createBackup(const QString &aProfilePath,
-                                         const QString &aBackupPath)
+void ProfileManagerPrivate::removeObsoleteFiles()
 {
-    FUNCTION_CALL_TRACE(lcButeoTrace);
-    return QFile::copy(aProfilePath, aBackupPath);
+    foreach (const QString &path, iObsoleteFiles) {
+        if (QFile::remove(path)) {
+            noteOwnChange(path);
+        }
+    }
+    iObsoleteFiles.clear();
 }
 
 QString ProfileManagerPrivate::findProfileFile(const QString &aName, const QString &aType)
@@ -1095,7 +2436,7 @@ QString ProfileManagerPrivate::findProfileFile(const QString &aName, const QStri
     QString primaryPath = iConfigPath + QDir::separator() + fileName;
     QString secondaryPath = iSystemConfigPath + QDir::separator() + fileName;
 
-    if (QFile::exists(primaryPath)) {
+    if (QFile::exists(primaryPath) || iPendingWrites.contains(primaryPath)) {
         return primaryPath;
     } else if (!QFile::exists(secondaryPath)) {
         return primaryPath;
@@ -1132,7 +2473,7 @@ QDateTime ProfileManager::getNextRetryInterval(const SyncProfile *aProfile)
             d_ptr->iSyncRetriesInfo.contains(aProfile->name()) &&
             !d_ptr->iSyncRetriesInfo[aProfile->name()].isEmpty()) {
         quint32 mins = d_ptr->iSyncRetriesInfo[aProfile->name()].takeFirst();
-        nextRetryInterval = QDateTime::currentDateTime().addSecs(mins * 60);
+        nextRetryInterval = SyncClock::currentDateTime().addSecs(mins * 60);
         qCDebug(lcButeoCore) << "syncretries : retry for profile" << aProfile->name() << "in" << mins << "minutes";
         qCDebug(lcButeoCore) << "syncretries :" << d_ptr->iSyncRetriesInfo[aProfile->name()].count() << "attempts remain";
     }
@@ -207,6 +207,7 @@ public:
 
     /*! \brief Saves the given synchronization log.
      *
+     * Replaces the log journal of the profile with the results of the log.
      * \param aLog Log to save.
      * \return True if saving was successful.
      */
@@ -214,15 +215,28 @@ public:
 
     /*! \brief Saves the results of a sync session to the log.
      *
-     * This is a convenience function that loads the log associated with the
-     * given profile, appends the given results to the log and then saves the
-     * log.
+     * The results are appended to the log journal of the profile, without
+     * loading the log. The journal is compacted to the retained results
+     * once it holds twice the number of results the profile keeps, see
+     * SyncProfile::logRetention(). signalProfileChanged() carries the
+     * profile as stored, without merged sub-profiles.
      * \param aProfileName Name of the profile used in the sync session.
      * \param aResults Results.
      * \return True if saving was successful.
      */
     bool saveSyncResults(QString aProfileName, const SyncResults &aResults);
 
+    /*! \brief Saves the results of a sync session to the log.
+     *
+     * Like saveSyncResults(QString, const SyncResults &), but takes the log
+     * retention from the given profile and sends it with
+     * signalProfileChanged() as it is, so nothing is loaded.
+     * \param aProfile Profile used in the sync session.
+     * \param aResults Results.
+     * \return True if saving was successful.
+     */
+    bool saveSyncResults(const SyncProfile &aProfile, const SyncResults &aResults);
+
     /*! \brief Gets a profile.
      *
      * \param aName Name of the profile to get.
@@ -329,6 +343,41 @@ public:
      */
     void retriesDone(const QString &aProfileName);
 
+    /*! \brief Starts grouping profile and log writes.
+     *
+     * Until the matching endWriteGroup(), saved profiles and logs are kept
+     * in memory and written together, with one disk sync for the whole
+     * group. Saving the same file several times writes it only once.
+     * Profiles saved in the group are visible to this ProfileManager
+     * immediately, but not to other processes. Groups can be nested.
+     *
+     * Saving within a group succeeds as long as the data could be queued,
+     * write errors are reported by endWriteGroup(). signalProfileChanged()
+     * is held back until the changes are on disk.
+     */
+    void beginWriteGroup();
+
+    /*! \brief Ends a group started with beginWriteGroup().
+     *
+     * Writes the grouped files when the outermost group ends and emits the
+     * held back change signals. No signal is emitted for changes whose
+     * file could not be written.
+     *
+     * @return False if any of the grouped files could not be written.
+     */
+    bool endWriteGroup();
+
+    /*! \brief Enables or disables the compiled profile store.
+     *
+     * When enabled, parsed profiles are also kept in a binary file under the
+     * primary profile directory, so that later ProfileManager instances can
+     * skip XML parsing for profiles whose files have not changed. The XML
+     * files stay the source of truth. Disabled by default.
+     *
+     * @param aEnabled True to enable the store.
+     */
+    void setProfileStoreEnabled(bool aEnabled);
+
 #ifdef SYNCFW_UNIT_TESTS
     friend class ProfileManagerTest;
 #endif
@@ -358,7 +407,34 @@ signals:
     */
     void signalProfileChanged(QString aProfileName, int aChangeType, QString aProfileAsXml);
 
+private slots:
+    /*! \brief Invalidates cached profiles when their files change on disk.
+     *
+     * \param aPath Changed file or directory.
+     */
+    void onProfilePathChanged(const QString &aPath);
+
 private:
+    /*! \brief Emits signalProfileChanged(), or holds it back until the
+     * current write group has been written.
+     *
+     * \param aProfileName Name of the changed profile.
+     * \param aChangeType \see ProfileManager::ProfileChangeType
+     * \param aProfileAsXml Updated profile as xml.
+     * \param aPath File the change was queued to, empty if the change is
+     *  on disk already.
+     */
+    void notifyProfileChanged(const QString &aProfileName, int aChangeType,
+                              const QString &aProfileAsXml, const QString &aPath);
+
+    /*! \brief Gets the names of sync profiles that may match the criteria.
+     *
+     * Uses the key index to skip loading profiles that cannot match.
+     * \param aCriteria Search criteria.
+     * \return Candidate profile names, in the order of profileNames().
+     */
+    QStringList indexedSyncProfileNames(const QList<SearchCriteria> &aCriteria);
+
     ProfileManager &operator=(const ProfileManager &aRhs);
     ProfileManagerPrivate *d_ptr;
 };
@@ -0,0 +1,410 @@
+/*
+ * This file is part of buteo-syncfw package
+ *
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+#include "ProfileStore.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include "Profile.h"
+#include "Profile_p.h"
+#include "ProfileField_p.h"
+#include "ProfileFactory.h"
+#include "SyncProfile.h"
+#include "SyncProfile_p.h"
+#include "SyncSchedule_p.h"
+
+#include "LogMacros.h"
+
+using namespace Buteo;
+
+// "BTPS"
+static const quint32 STORE_MAGIC = 0x42545053;
+// Increase whenever the serialized form of any profile class changes.
+static const quint32 STORE_VERSION = 1;
+static const QDataStream::Version STREAM_VERSION = QDataStream::Qt_5_0;
+
+ProfileStore::ProfileStore(const QString &aPath)
+    :   iPath(aPath),
+        iMapped(0),
+        iMappedSize(0),
+        iOpened(false),
+        iDirty(false)
+{
+}
+
+ProfileStore::~ProfileStore()
+{
+    flush();
+    close();
+}
+
+Profile *ProfileStore::load(const QString &aName, const QString &aType,
+                            const QString &aSourcePath, const QByteArray &aSourceStamp)
+{
+    if (!iOpened) {
+        open();
+    }
+
+    QString key = aType + QDir::separator() + aName;
+    QHash<QString, Entry>::const_iterator i = iEntries.constFind(key);
+    if (i == iEntries.constEnd()) {
+        return 0;
+    }
+
+    if (!sourceMatches(*i, aSourcePath, aSourceStamp)) {
+        qCDebug(lcButeoCore) << "Compiled profile is out of date:" << key;
+        remove(aName, aType);
+        return 0;
+    }
+
+    QByteArray data = entryData(*i);
+    QDataStream in(data);
+    in.setVersion(STREAM_VERSION);
+    Profile *profile = readProfile(in);
+    if (profile == 0) {
+        qCWarning(lcButeoCore) << "Invalid compiled profile:" << key;
+        remove(aName, aType);
+    }
+
+    return profile;
+}
+
+void ProfileStore::update(const QString &aName, const QString &aType,
+                          const QString &aSourcePath, const QByteArray &aSourceStamp,
+                          const QByteArray &aSource, const Profile &aProfile)
+{
+    if (!iOpened) {
+        open();
+    }
+
+    if (aSourceStamp.isEmpty()) {
+        return;
+    }
+
+    // The stamp was taken before the file was read. If the file changed in
+    // between, the entry is out of date on the next load.
+    Entry entry;
+    entry.iSourcePath = aSourcePath;
+    entry.iStamp = aSourceStamp;
+    entry.iHash = QCryptographicHash::hash(aSource, QCryptographicHash::Sha1);
+    entry.iOffset = 0;
+    QDataStream out(&entry.iData, QIODevice::WriteOnly);
+    out.setVersion(STREAM_VERSION);
+    writeProfile(out, aProfile);
+    entry.iLength = entry.iData.size();
+
+    iEntries.insert(aType + QDir::separator() + aName, entry);
+    iDirty = true;
+}
+
+void ProfileStore::remove(const QString &aName, const QString &aType)
+{
+    if (!iOpened) {
+        open();
+    }
+
+    if (iEntries.remove(aType + QDir::separator() + aName) > 0) {
+        iDirty = true;
+    }
+}
+
+int ProfileStore::verify()
+{
+    if (!iOpened) {
+        open();
+    }
+
+    int removed = 0;
+    QMutableHashIterator<QString, Entry> i(iEntries);
+    while (i.hasNext()) {
+        i.next();
+        if (i.value().iHash.isEmpty() || sourceHash(i.value().iSourcePath) != i.value().iHash) {
+            qCDebug(lcButeoCore) << "Compiled profile does not match its source:" << i.key();
+            i.remove();
+            ++removed;
+        }
+    }
+
+    if (removed > 0) {
+        iDirty = true;
+    }
+
+    return removed;
+}
+
+bool ProfileStore::flush()
+{
+    if (!iDirty) {
+        return true;
+    }
+
+    // Index first, so that opening the store does not need to touch the
+    // serialized profiles at all.
+    QByteArray header;
+    QByteArray body;
+    QDataStream headerStream(&header, QIODevice::WriteOnly);
+    headerStream.setVersion(STREAM_VERSION);
+    headerStream << STORE_MAGIC << STORE_VERSION << quint32(iEntries.size());
+
+    QHash<QString, Entry>::const_iterator i;
+    for (i = iEntries.constBegin(); i != iEntries.constEnd(); ++i) {
+        QByteArray data = entryData(i.value());
+        headerStream << i.key() << i->iSourcePath << i->iStamp
+                     << i->iHash << qint64(data.size());
+        body.append(data);
+    }
+
+    QDir().mkpath(QFileInfo(iPath).absolutePath());
+    QSaveFile file(iPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(lcButeoCore) << "Failed to open compiled profile store for writing:" << iPath;
+        return false;
+    }
+    file.write(header);
+    file.write(body);
+    if (!file.commit()) {
+        qCWarning(lcButeoCore) << "Failed to write compiled profile store:" << iPath;
+        return false;
+    }
+
+    // Re-map the new file, pending entries are now part of it.
+    close();
+    open();
+
+    return true;
+}
+
+void ProfileStore::open()
+{
+    iOpened = true;
+    iDirty = false;
+    iEntries.clear();
+
+    iFile.setFileName(iPath);
+    if (!iFile.exists() || !iFile.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    iMappedSize = iFile.size();
+    iMapped = iFile.map(0, iMappedSize);
+    if (iMapped == 0) {
+        qCWarning(lcButeoCore) << "Failed to map compiled profile store:" << iPath;
+        close();
+        return;
+    }
+
+    QByteArray data = QByteArray::fromRawData(reinterpret_cast<const char *>(iMapped),
+                                              iMappedSize);
+    QDataStream in(data);
+    in.setVersion(STREAM_VERSION);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    quint32 count = 0;
+    in >> magic >> version >> count;
+    if (in.status() != QDataStream::Ok || magic != STORE_MAGIC || version != STORE_VERSION) {
+        qCDebug(lcButeoCore) << "Ignoring compiled profile store with unknown format:" << iPath;
+        close();
+        iDirty = true;
+        return;
+    }
+
+    QList<QString> keys;
+    QList<Entry> entries;
+    qint64 offset = 0;
+    for (quint32 n = 0; n < count && in.status() == QDataStream::Ok; ++n) {
+        QString key;
+        Entry entry;
+        in >> key >> entry.iSourcePath >> entry.iStamp >> entry.iHash
+           >> entry.iLength;
+        entry.iOffset = offset;
+        offset += entry.iLength;
+        keys.append(key);
+        entries.append(entry);
+    }
+
+    qint64 bodyStart = in.device()->pos();
+    if (in.status() != QDataStream::Ok || bodyStart + offset > iMappedSize) {
+        qCWarning(lcButeoCore) << "Compiled profile store is corrupted:" << iPath;
+        close();
+        iDirty = true;
+        return;
+    }
+
+    for (int n = 0; n < keys.size(); ++n) {
+        entries[n].iOffset += bodyStart;
+        iEntries.insert(keys.at(n), entries.at(n));
+    }
+}
+
+void ProfileStore::close()
+{
+    if (iMapped != 0) {
+        iFile.unmap(iMapped);
+        iMapped = 0;
+        iMappedSize = 0;
+    }
+    iFile.close();
+    iEntries.clear();
+}
+
+QByteArray ProfileStore::entryData(const Entry &aEntry) const
+{
+    if (!aEntry.iData.isEmpty() || iMapped == 0) {
+        return aEntry.iData;
+    }
+
+    return QByteArray::fromRawData(reinterpret_cast<const char *>(iMapped) + aEntry.iOffset,
+                                   aEntry.iLength);
+}
+
+bool ProfileStore::sourceMatches(const Entry &aEntry, const QString &aSourcePath,
+                                 const QByteArray &aSourceStamp)
+{
+    // Profiles are replaced by renaming a new file over the old one, which
+    // changes the inode even if time and size stay the same.
+    return aEntry.iSourcePath == aSourcePath &&
+           !aSourceStamp.isEmpty() && aSourceStamp == aEntry.iStamp;
+}
+
+QByteArray ProfileStore::sourceHash(const QString &aSourcePath)
+{
+    QFile file(aSourcePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    if (!hash.addData(&file)) {
+        return QByteArray();
+    }
+
+    return hash.result();
+}
+
+void ProfileStore::writeProfile(QDataStream &aStream, const Profile &aProfile)
+{
+    const ProfilePrivate *d = aProfile.d_ptr;
+    aStream << d->iType << d->iName << d->iLoaded << d->iMerged
+            << d->iLocalKeys << d->iMergedKeys;
+    writeFields(aStream, d->iLocalFields);
+    writeFields(aStream, d->iMergedFields);
+
+    if (d->iType == Profile::TYPE_SYNC) {
+        // Type is verified, profiles of sync type are always created as
+        // SyncProfile by the ProfileFactory.
+        const SyncProfilePrivate *sd = static_cast<const SyncProfile &>(aProfile).d_ptr;
+        const SyncSchedulePrivate *schedule = sd->iSchedule.d_ptr;
+        aStream << qint32(schedule->iDays) << schedule->iTime
+                << schedule->iScheduleConfiguredTime << quint32(schedule->iInterval)
+                << schedule->iEnabled << qint32(schedule->iRushDays)
+                << schedule->iRushBegin << schedule->iRushEnd
+                << quint32(schedule->iRushInterval) << schedule->iRushEnabled
+                << schedule->iExternalRushEnabled;
+        aStream << sd->iSyncRetriesInfo.iRetryIntervals;
+    }
+
+    aStream << quint32(d->iSubProfiles.size());
+    foreach (const Profile *sub, d->iSubProfiles) {
+        writeProfile(aStream, *sub);
+    }
+}
+
+Profile *ProfileStore::readProfile(QDataStream &aStream)
+{
+    QString type;
+    QString name;
+    aStream >> type >> name;
+    if (aStream.status() != QDataStream::Ok || type.isEmpty()) {
+        return 0;
+    }
+
+    ProfileFactory pf;
+    Profile *profile = pf.createProfile(name, type);
+    ProfilePrivate *d = profile->d_ptr;
+    aStream >> d->iLoaded >> d->iMerged >> d->iLocalKeys >> d->iMergedKeys;
+    readFields(aStream, d->iLocalFields);
+    readFields(aStream, d->iMergedFields);
+
+    if (type == Profile::TYPE_SYNC) {
+        SyncProfilePrivate *sd = static_cast<SyncProfile *>(profile)->d_ptr;
+        SyncSchedulePrivate *schedule = sd->iSchedule.d_ptr;
+        qint32 days = 0;
+        qint32 rushDays = 0;
+        quint32 interval = 0;
+        quint32 rushInterval = 0;
+        aStream >> days >> schedule->iTime >> schedule->iScheduleConfiguredTime
+                >> interval >> schedule->iEnabled >> rushDays
+                >> schedule->iRushBegin >> schedule->iRushEnd
+                >> rushInterval >> schedule->iRushEnabled
+                >> schedule->iExternalRushEnabled;
+        schedule->iDays = SyncSchedule::Days(QFlag(days));
+        schedule->iRushDays = SyncSchedule::Days(QFlag(rushDays));
+        schedule->iInterval = interval;
+        schedule->iRushInterval = rushInterval;
+        aStream >> sd->iSyncRetriesInfo.iRetryIntervals;
+        sd->iSyncRetriesInfo.init();
+    }
+
+    quint32 subCount = 0;
+    aStream >> subCount;
+    for (quint32 n = 0; n < subCount && aStream.status() == QDataStream::Ok; ++n) {
+        Profile *sub = readProfile(aStream);
+        if (sub == 0) {
+            delete profile;
+            return 0;
+        }
+        d->iSubProfiles.append(sub);
+    }
+
+    if (aStream.status() != QDataStream::Ok) {
+        delete profile;
+        profile = 0;
+    }
+
+    return profile;
+}
+
+void ProfileStore::writeFields(QDataStream &aStream, const QList<const ProfileField *> &aFields)
+{
+    aStream << quint32(aFields.size());
+    foreach (const ProfileField *field, aFields) {
+        const ProfileFieldPrivate *d = field->d_ptr;
+        aStream << d->iName << d->iType << d->iDefaultValue << d->iOptions
+                << d->iLabel << d->iVisible << d->iReadOnly;
+    }
+}
+
+void ProfileStore::readFields(QDataStream &aStream, QList<const ProfileField *> &aFields)
+{
+    quint32 count = 0;
+    aStream >> count;
+    for (quint32 n = 0; n < count && aStream.status() == QDataStream::Ok; ++n) {
+        ProfileField *field = new ProfileField();
+        ProfileFieldPrivate *d = field->d_ptr;
+        aStream >> d->iName >> d->iType >> d->iDefaultValue >> d->iOptions
+                >> d->iLabel >> d->iVisible >> d->iReadOnly;
+        aFields.append(field);
+    }
+}
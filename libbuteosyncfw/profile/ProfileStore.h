@@ -0,0 +1,159 @@
+/*
+ * This file is part of buteo-syncfw package
+ *
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+#ifndef PROFILESTORE_H
+#define PROFILESTORE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QString>
+
+class QDataStream;
+
+namespace Buteo {
+
+class Profile;
+class ProfileField;
+
+/*! \brief Compiled binary representation of the XML profiles.
+ *
+ * All parsed profiles are kept in one versioned binary file, which is
+ * memory-mapped when opened. Each entry remembers the XML file it was
+ * parsed from, together with its inode, modification time, size and a hash
+ * of its contents. An entry is only used while the inode, time and size of
+ * the XML file are unchanged, so the XML files stay the source of truth.
+ * verify() also compares the contents. Entries are replaced one by one as
+ * XML files change and the file is rewritten on flush().
+ */
+class ProfileStore
+{
+public:
+    /*! \brief Constructor.
+     *
+     * \param aPath Path of the binary store file.
+     */
+    explicit ProfileStore(const QString &aPath);
+
+    /*! \brief Destructor. Writes pending changes to disk.
+     */
+    ~ProfileStore();
+
+    /*! \brief Gets a profile from the store.
+     *
+     * \param aName Name of the profile.
+     * \param aType Type of the profile.
+     * \param aSourcePath Path of the XML file the profile would be parsed from.
+     * \param aSourceStamp Inode, modification time and size of the XML file.
+     * \return The profile, or NULL if the store has no up to date entry for
+     *  it. Caller becomes the owner of the returned object.
+     */
+    Profile *load(const QString &aName, const QString &aType, const QString &aSourcePath,
+                  const QByteArray &aSourceStamp);
+
+    /*! \brief Adds or replaces a profile in the store.
+     *
+     * \param aName Name of the profile.
+     * \param aType Type of the profile.
+     * \param aSourcePath Path of the XML file the profile was parsed from.
+     * \param aSourceStamp Inode, modification time and size of the XML file,
+     *  taken before it was read.
+     * \param aSource The XML the profile was parsed from.
+     * \param aProfile The parsed profile.
+     */
+    void update(const QString &aName, const QString &aType, const QString &aSourcePath,
+                const QByteArray &aSourceStamp, const QByteArray &aSource,
+                const Profile &aProfile);
+
+    /*! \brief Removes a profile from the store.
+     *
+     * \param aName Name of the profile.
+     * \param aType Type of the profile.
+     */
+    void remove(const QString &aName, const QString &aType);
+
+    /*! \brief Checks the contents of the XML files against the entries.
+     *
+     * Reads and hashes every XML file, so it is much slower than the
+     * checks done by load(). Catches rewrites that keep the inode, time
+     * and size. Entries whose file has changed are removed.
+     * \return Number of removed entries.
+     */
+    int verify();
+
+    /*! \brief Writes the store to disk if it has been modified.
+     *
+     * Unchanged entries are copied as such from the mapped file.
+     * \return True on success, or if there was nothing to write.
+     */
+    bool flush();
+
+    /*! \brief Serializes a profile and all its sub-profiles.
+     *
+     * \param aStream Stream to write to.
+     * \param aProfile Profile to write.
+     */
+    static void writeProfile(QDataStream &aStream, const Profile &aProfile);
+
+    /*! \brief Deserializes a profile written with writeProfile().
+     *
+     * \param aStream Stream to read from.
+     * \return The profile, or NULL if the data is not valid.
+     */
+    static Profile *readProfile(QDataStream &aStream);
+
+private:
+    struct Entry {
+        QString iSourcePath;
+        //! Inode, modification time and size of the XML file.
+        QByteArray iStamp;
+        //! Hash of the XML file, only compared by verify().
+        QByteArray iHash;
+        //! Position of the serialized profile in the mapped file, if
+        //! iData is empty.
+        qint64 iOffset;
+        qint64 iLength;
+        //! Serialized profile not yet written to disk.
+        QByteArray iData;
+    };
+
+    static void writeFields(QDataStream &aStream, const QList<const ProfileField *> &aFields);
+    static void readFields(QDataStream &aStream, QList<const ProfileField *> &aFields);
+
+    void open();
+    void close();
+    QByteArray entryData(const Entry &aEntry) const;
+    static bool sourceMatches(const Entry &aEntry, const QString &aSourcePath,
+                              const QByteArray &aSourceStamp);
+    static QByteArray sourceHash(const QString &aSourcePath);
+
+    QString iPath;
+    QFile iFile;
+    uchar *iMapped;
+    qint64 iMappedSize;
+    bool iOpened;
+    bool iDirty;
+    QHash<QString, Entry> iEntries;
+};
+
+}
+
+#endif // PROFILESTORE_H
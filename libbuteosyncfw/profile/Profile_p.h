@@ -25,13 +25,19 @@
 
 #include <QList>
 #include <QMap>
+#include <QSharedData>
 #include <QString>
 #include "ProfileField.h"
 
 namespace Buteo {
 
-//! Private implementation class for Profile class.
-class ProfilePrivate
+/*! \brief Private implementation class for Profile class.
+ *
+ * Shared between copies of a Profile until one of them is modified.
+ * Detaching copies the fields and the sub-profiles, so that the copy has
+ * nothing in common with the source.
+ */
+class ProfilePrivate : public QSharedData
 {
 public:
     //! \brief Constructor
@@ -69,25 +75,33 @@ public:
 
     //! List of sub-profiles.
     QList<Profile *> iSubProfiles;
+
+    //! Have sub-profile pointers been handed out. Such data is not shared
+    //! with new copies, so the pointers stay valid and modifying them does
+    //! not affect the copies.
+    bool iSubProfilesExposed;
 };
 }
 
 
 
 
-Buteo::ProfilePrivate::ProfilePrivate()
+inline Buteo::ProfilePrivate::ProfilePrivate()
     :   iLoaded(false),
-        iMerged(false)
+        iMerged(false),
+        iSubProfilesExposed(false)
 {
 }
 
-Buteo::ProfilePrivate::ProfilePrivate(const ProfilePrivate &aSource)
-    :   iName(aSource.iName),
+inline Buteo::ProfilePrivate::ProfilePrivate(const ProfilePrivate &aSource)
+    :   QSharedData(aSource),
+        iName(aSource.iName),
         iType(aSource.iType),
         iLoaded(aSource.iLoaded),
         iMerged(aSource.iMerged),
         iLocalKeys(aSource.iLocalKeys),
-        iMergedKeys(aSource.iMergedKeys)
+        iMergedKeys(aSource.iMergedKeys),
+        iSubProfilesExposed(false)
 {
     foreach (const ProfileField *localField, aSource.iLocalFields) {
         iLocalFields.append(new ProfileField(*localField));
@@ -96,12 +110,14 @@ Buteo::ProfilePrivate::ProfilePrivate(const ProfilePrivate &aSource)
         iMergedFields.append(new ProfileField(*mergedField));
     }
 
-    foreach (Profile *p, aSource.iSubProfiles) {
-        iSubProfiles.append(p->clone());
+    foreach (const Profile *p, aSource.iSubProfiles) {
+        Profile *copy = p->clone();
+        copy->d_ptr.detach();
+        iSubProfiles.append(copy);
     }
 }
 
-Buteo::ProfilePrivate::~ProfilePrivate()
+inline Buteo::ProfilePrivate::~ProfilePrivate()
 {
     qDeleteAll(iLocalFields);
     iLocalFields.clear();
@@ -23,6 +23,8 @@
 #include "SyncLog.h"
 #include "LogMacros.h"
 #include <QDomDocument>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
 #include <QtAlgorithms>
 
 #include "ProfileEngineDefs.h"
@@ -46,8 +48,8 @@ bool isSyncSuccessful(const SyncResults &aResults)
             && !aResults.syncTime().isNull());
 }
 
-// Private implementation class for SyncLog.
-class SyncLogPrivate
+// Private implementation class for SyncLog, shared until modified.
+class SyncLogPrivate : public QSharedData
 {
 public:
     SyncLogPrivate();
@@ -65,6 +67,9 @@ public:
     // Last successful sync result as stored in the log.
     SyncResults *iLastSuccessfulResults;
 
+    // Maximum number of results kept in iResults.
+    int iMaxResults;
+
     void updateLastSuccessfulResults(const SyncResults &aResults);
 };
 
@@ -73,12 +78,14 @@ public:
 using namespace Buteo;
 
 SyncLogPrivate::SyncLogPrivate()
-    :   iLastSuccessfulResults(0)
+    :   iLastSuccessfulResults(0),
+        iMaxResults(SyncLog::DEFAULT_MAX_RESULTS)
 {
 }
 
 SyncLogPrivate::SyncLogPrivate(const SyncLogPrivate &aSource)
-    :   iProfileName(aSource.iProfileName), iLastSuccessfulResults(0)
+    :   QSharedData(aSource), iProfileName(aSource.iProfileName),
+        iLastSuccessfulResults(0), iMaxResults(aSource.iMaxResults)
 {
     foreach (const SyncResults *results, aSource.iResults) {
         iResults.append(new SyncResults(*results));
@@ -103,6 +110,8 @@ void SyncLogPrivate::updateLastSuccessfulResults(const SyncResults &aResults)
     }
 }
 
+const int SyncLog::DEFAULT_MAX_RESULTS = 5;
+
 SyncLog::SyncLog(const QString &aProfileName)
     :   d_ptr(new SyncLogPrivate())
 {
@@ -124,15 +133,27 @@ SyncLog::SyncLog(const QDomElement &aRoot)
     //std::sort(d_ptr->iResults.begin(), d_ptr->iResults.end(), syncResultPointerLessThan);
 }
 
+SyncLog::SyncLog(QXmlStreamReader &aReader)
+    :   d_ptr(new SyncLogPrivate())
+{
+    d_ptr->iProfileName = aReader.attributes().value(ATTR_NAME).toString();
+
+    while (aReader.readNextStartElement()) {
+        if (aReader.name() == TAG_SYNC_RESULTS) {
+            addResults(SyncResults(aReader));
+        } else {
+            aReader.skipCurrentElement();
+        }
+    }
+}
+
 SyncLog::SyncLog(const SyncLog &aSource)
-    :   d_ptr(new SyncLogPrivate(*aSource.d_ptr))
+    :   d_ptr(aSource.d_ptr)
 {
 }
 
 SyncLog::~SyncLog()
 {
-    delete d_ptr;
-    d_ptr = 0;
 }
 
 void SyncLog::setProfileName(const QString &aProfileName)
@@ -163,6 +184,23 @@ QDomElement SyncLog::toXml(QDomDocument &aDoc) const
     return root;
 }
 
+void SyncLog::toXml(QXmlStreamWriter &aWriter) const
+{
+    aWriter.writeStartElement(TAG_SYNC_LOG);
+    aWriter.writeAttribute(ATTR_NAME, d_ptr->iProfileName);
+
+    if (d_ptr->iLastSuccessfulResults
+            && (d_ptr->iResults.isEmpty()
+                || *d_ptr->iLastSuccessfulResults < *d_ptr->iResults.first())) {
+        d_ptr->iLastSuccessfulResults->toXml(aWriter);
+    }
+
+    foreach (const SyncResults *results, d_ptr->iResults)
+        results->toXml(aWriter);
+
+    aWriter.writeEndElement();
+}
+
 const SyncResults *SyncLog::lastResults() const
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
@@ -187,10 +225,8 @@ void SyncLog::addResults(const SyncResults &aResults)
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
     // To prevent the log growing too much, the maximum number of entries in
-    //the log is defined
-    const int MAXLOGENTRIES = 5;
-
-    if (d_ptr->iResults.size() >= MAXLOGENTRIES) {
+    // the log is limited.
+    while (d_ptr->iResults.size() >= d_ptr->iMaxResults) {
         // The list is sorted so that the oldest item is in the beginning
         delete d_ptr->iResults.takeFirst();
     }
@@ -202,3 +238,16 @@ void SyncLog::addResults(const SyncResults &aResults)
 
     d_ptr->updateLastSuccessfulResults(aResults);
 }
+
+int SyncLog::maxResults() const
+{
+    return d_ptr->iMaxResults;
+}
+
+void SyncLog::setMaxResults(int aMaxResults)
+{
+    d_ptr->iMaxResults = qMax(aMaxResults, 1);
+    while (d_ptr->iResults.size() > d_ptr->iMaxResults) {
+        delete d_ptr->iResults.takeFirst();
+    }
+}
@@ -24,15 +24,19 @@
 #define SYNCLOG_H
 
 #include <QList>
+#include <QSharedDataPointer>
 #include <QString>
 #include "SyncResults.h"
 
 class QDomDocument;
 class QDomElement;
+class QXmlStreamReader;
+class QXmlStreamWriter;
 
 namespace Buteo {
 
 class SyncLogPrivate;
+class SyncProfilePrivate;
 class SyncLogTest;
 
 /*! \brief History of completed synchronization sessions and their results.
@@ -44,6 +48,9 @@ class SyncLogTest;
 class SyncLog
 {
 public:
+    //! Number of results kept in a log by default.
+    static const int DEFAULT_MAX_RESULTS;
+
     /*! \brief Constructs an empty log with the given profile name.
      *
      * \param aProfileName Name of the profile this log is related to.
@@ -56,8 +63,18 @@ public:
      */
     explicit SyncLog(const QDomElement &aRoot);
 
+    /*! \brief Constructs the log from an XML stream.
+     *
+     * The reader must be positioned at the start element of the log
+     * representation. It is left at the matching end element, so that
+     * reading the enclosing document can continue.
+     * \param aReader XML stream reader.
+     */
+    explicit SyncLog(QXmlStreamReader &aReader);
+
     /*! \brief Copy constructor.
      *
+     * The results are shared with the source until either log is modified.
      * \param aSource Copy source.
      */
     SyncLog(const SyncLog &aSource);
@@ -86,6 +103,14 @@ public:
      */
     QDomElement toXml(QDomDocument &aDoc) const;
 
+    /*! \brief Writes the log to an XML stream.
+     *
+     * Streaming alternative to the DOM based toXml(), used when no DOM
+     * tree is needed.
+     * \param aWriter XML stream writer.
+     */
+    void toXml(QXmlStreamWriter &aWriter) const;
+
     /*! \brief Gets the most recent results in the sync log.
      *
      * \return The results. NULL if the log is empty.
@@ -113,10 +138,26 @@ public:
      */
     void addResults(const SyncResults &aResults);
 
+    /*! \brief Gets the maximum number of results kept in the log.
+     *
+     * \return Maximum number of results. DEFAULT_MAX_RESULTS unless set.
+     */
+    int maxResults() const;
+
+    /*! \brief Sets the maximum number of results kept in the log.
+     *
+     * The oldest results are dropped if the log has more results than
+     * the new maximum. The last successful results are kept regardless.
+     * \param aMaxResults Maximum number of results, at least 1.
+     */
+    void setMaxResults(int aMaxResults);
+
 private:
     SyncLog &operator=(const SyncLog &aRhs);
 
-    SyncLogPrivate *d_ptr;
+    QSharedDataPointer<SyncLogPrivate> d_ptr;
+
+    friend class SyncProfilePrivate;
 };
 
 }
@@ -23,88 +23,35 @@
  */
 
 #include "SyncProfile.h"
+#include "SyncProfile_p.h"
 #include "ProfileEngineDefs.h"
 #include "LogMacros.h"
 #include <QDomDocument>
 
-namespace Buteo {
-
-
-// Private implementation class for SyncProfile.
-class SyncProfilePrivate
-{
-public:
-    SyncProfilePrivate();
-    SyncProfilePrivate(const SyncProfilePrivate &aSource);
-    ~SyncProfilePrivate();
-
-    SyncLog *iLog;
-
-    SyncSchedule iSchedule;
-
-    struct SyncRetriesInfo {
-        QList<quint32> iRetryIntervals;
-        quint32 iIntervalIndex;
-
-        void init()
-        {
-            iIntervalIndex = 0;
-        }
-
-        void addInterval(quint32 interval)
-        {
-            iRetryIntervals.append(interval);
-        }
-
-        quint32 retries()
-        {
-            return iRetryIntervals.count();
-        }
-
-        qint32 nextInterval()
-        {
-            qint32 next = -1;
-            if (iIntervalIndex < retries()) {
-                next = iRetryIntervals.at(iIntervalIndex);
-                ++iIntervalIndex;
-            }
-            return next;
-        }
-
-        QList<quint32> intervals()
-        {
-            return iRetryIntervals;
-        }
-
-        SyncRetriesInfo &operator=(const SyncRetriesInfo &rhs)
-        {
-            if (this != &rhs) {
-                iIntervalIndex = rhs.iIntervalIndex;
-                iRetryIntervals = rhs.iRetryIntervals;
-            }
-            return *this;
-        }
-    } iSyncRetriesInfo;
-};
-
-}
-
 using namespace Buteo;
 
 const quint32 DEFAULT_SOC_AFTER_TIME(5 * 60);
+const quint32 DEFAULT_SOC_MIN_GAP(0);
 
 SyncProfilePrivate::SyncProfilePrivate()
-    :   iLog(0)
+    :   iLog(0),
+        iLogExposed(false)
 {
     iSyncRetriesInfo.init();
 }
 
 SyncProfilePrivate::SyncProfilePrivate(const SyncProfilePrivate &aSource)
-    :   iLog(0),
-        iSchedule(aSource.iSchedule)
+    :   QSharedData(aSource),
+        iLog(0),
+        iLogExposed(false),
+        iSchedule(aSource.iSchedule),
+        iChangeSet(aSource.iChangeSet)
 {
     if (aSource.iLog != 0) {
         iLog = new SyncLog(*aSource.iLog);
+        if (aSource.iLogExposed) {
+            iLog->d_ptr.detach();
+        }
     }
     iSyncRetriesInfo = aSource.iSyncRetriesInfo;
 }
@@ -115,6 +62,26 @@ SyncProfilePrivate::~SyncProfilePrivate()
     iLog = 0;
 }
 
+void SyncProfilePrivate::exposeLog()
+{
+    iLogExposed = true;
+    if (iLog != 0) {
+        iLog->d_ptr.detach();
+    }
+}
+
+// Stops sharing the log before the const accessors hand out pointers into
+// it. Otherwise the pointers would dangle once this profile is modified
+// and the copies it shared its data with are deleted.
+static SyncLog *exposedLog(const QSharedDataPointer<SyncProfilePrivate> &aData)
+{
+    if (!aData->iLogExposed) {
+        QSharedDataPointer<SyncProfilePrivate> &data = const_cast<QSharedDataPointer<SyncProfilePrivate> &>(aData);
+        data->exposeLog();
+    }
+    return aData->iLog;
+}
+
 SyncProfile::SyncProfile(const QString &aName)
     :   Profile(aName, Profile::TYPE_SYNC),
         d_ptr(new SyncProfilePrivate())
@@ -145,14 +112,15 @@ SyncProfile::SyncProfile(const QDomElement &aRoot)
 
 SyncProfile::SyncProfile(const SyncProfile &aSource)
     :   Profile(aSource),
-        d_ptr(new SyncProfilePrivate(*aSource.d_ptr))
+        d_ptr(aSource.d_ptr)
 {
+    if (aSource.d_ptr->iLogExposed) {
+        d_ptr.detach();
+    }
 }
 
 SyncProfile::~SyncProfile()
 {
-    delete d_ptr;
-    d_ptr = 0;
 }
 
 SyncProfile *SyncProfile::clone() const
@@ -168,17 +136,15 @@ QDomElement SyncProfile::toXml(QDomDocument &aDoc, bool aLocalOnly) const
         root.appendChild(schedule);
     }
     if (d_ptr->iSyncRetriesInfo.retries()) {
+        // Read the intervals directly, writing out a profile must not step
+        // the retry cursor.
         QDomElement retries = aDoc.createElement(TAG_ERROR_ATTEMPTS);
-        for (quint32 i = 0;  i < d_ptr->iSyncRetriesInfo.retries(); ++i) {
+        foreach (quint32 interval, d_ptr->iSyncRetriesInfo.iRetryIntervals) {
             QDomElement retryInterval = aDoc.createElement(TAG_ATTEMPT_DELAY);
-            qint32 nextInt = d_ptr->iSyncRetriesInfo.nextInterval();
-            if (-1 != nextInt) {
-                retryInterval.setAttribute(ATTR_VALUE, nextInt);
-                retries.appendChild(retryInterval);
-            }
+            retryInterval.setAttribute(ATTR_VALUE, interval);
+            retries.appendChild(retryInterval);
         }
         root.appendChild(retries);
-        d_ptr->iSyncRetriesInfo.init();
     }
     return root;
 }
@@ -273,10 +239,26 @@ QDateTime SyncProfile::nextRushSwitchTime(const QDateTime &aFromTime) const
     return nextSwitch;
 }
 
+QHash<QString, QDateTime> SyncProfile::nextSyncTimes(const QList<SyncProfile *> &aProfiles)
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    const QDateTime now = SyncClock::currentDateTime();
+    QHash<QString, QDateTime> times;
+    times.reserve(aProfiles.size());
+    foreach (const SyncProfile *profile, aProfiles) {
+        if (profile && profile->syncType() == SYNC_SCHEDULED) {
+            times.insert(profile->name(), profile->d_ptr->iSchedule.nextSyncTime(profile->lastSyncTime(), now));
+        }
+    }
+    return times;
+}
+
 const SyncResults *SyncProfile::lastResults() const
 {
-    if (d_ptr->iLog != 0) {
-        return d_ptr->iLog->lastResults();
+    const SyncLog *syncLog = exposedLog(d_ptr);
+    if (syncLog != 0) {
+        return syncLog->lastResults();
     } else {
         return 0;
     }
@@ -284,6 +266,12 @@ const SyncResults *SyncProfile::lastResults() const
 
 SyncLog *SyncProfile::log() const
 {
+    return exposedLog(d_ptr);
+}
+
+SyncLog *SyncProfile::log()
+{
+    d_ptr->exposeLog();
     return d_ptr->iLog;
 }
 
@@ -291,6 +279,9 @@ void SyncProfile::setLog(SyncLog *aLog)
 {
     delete d_ptr->iLog;
     d_ptr->iLog = aLog;
+    if (d_ptr->iLogExposed) {
+        d_ptr->exposeLog();
+    }
 }
 
 void SyncProfile::addResults(const SyncResults &aResults)
@@ -325,6 +316,16 @@ void SyncProfile::setSyncSchedule(const SyncSchedule &aSchedule)
     d_ptr->iSchedule = aSchedule;
 }
 
+StorageChangeSet SyncProfile::changeSet() const
+{
+    return d_ptr->iChangeSet;
+}
+
+void SyncProfile::setChangeSet(const StorageChangeSet &aChanges)
+{
+    d_ptr->iChangeSet = aChanges;
+}
+
 QList<Sync::InternetConnectionType> SyncProfile::internetConnectionTypes() const
 {
     QSet<Sync::InternetConnectionType> types;
@@ -355,7 +356,7 @@ QStringList SyncProfile::storageBackendNames() const
     QStringList storageNames = subProfileNames(Profile::TYPE_STORAGE);
 
     foreach (QString storage, storageNames) {
-        const Profile *p = subProfile(storage, Profile::TYPE_STORAGE);
+        const Profile *p = findSubProfile(storage, Profile::TYPE_STORAGE);
         if (p->isEnabled()) {
             // Get backend name from the storage profile. If the backend name
             // is not defined, use profile name as the backend name.
@@ -502,7 +503,8 @@ SyncProfile::SyncDirection SyncProfile::syncDirection() const
     SyncDirection dir = SYNC_DIRECTION_UNDEFINED;
     QString dirStr;
 
-    const Profile *client = clientProfile();
+    const Profile *client = findSubProfile(subProfileNames(Profile::TYPE_CLIENT).value(0),
+                                           Profile::TYPE_CLIENT);
     if (client) {
         dirStr = client->key(KEY_SYNC_DIRECTION);
     }
@@ -547,6 +549,23 @@ quint32 SyncProfile::syncOnChangeAfter() const
     return syncOnChangeAfterTime;
 }
 
+quint32 SyncProfile::syncOnChangeMinGap() const
+{
+    bool ok = false;
+    quint32 minGap = key(KEY_SOC_MIN_GAP).toUInt(&ok);
+    return ok ? minGap : DEFAULT_SOC_MIN_GAP;
+}
+
+int SyncProfile::logRetention() const
+{
+    bool ok = false;
+    int retention = key(KEY_LOG_RETENTION).toInt(&ok);
+    if (!ok || retention < 1) {
+        retention = SyncLog::DEFAULT_MAX_RESULTS;
+    }
+    return retention;
+}
+
 void SyncProfile::setSyncDirection(SyncDirection aDirection)
 {
     QString dirStr;
@@ -584,7 +603,8 @@ SyncProfile::ConflictResolutionPolicy SyncProfile::conflictResolutionPolicy() co
     ConflictResolutionPolicy policy = CR_POLICY_UNDEFINED;
     QString policyStr;
 
-    const Profile *client = clientProfile();
+    const Profile *client = findSubProfile(subProfileNames(Profile::TYPE_CLIENT).value(0),
+                                           Profile::TYPE_CLIENT);
     if (client) {
         policyStr = client->key(KEY_CONFLICT_RESOLUTION_POLICY);
     }
@@ -641,7 +661,7 @@ QList<quint32> SyncProfile::retryIntervals() const
 SyncProfile::CurrentSyncStatus SyncProfile::currentSyncStatus() const
 {
     //Fetch the last sync result
-    const SyncResults *syncResult = lastResults();
+    const SyncResults *syncResult = d_ptr->iLog != 0 ? d_ptr->iLog->lastResults() : 0;
     SyncProfile::CurrentSyncStatus syncStatus = SyncProfile::SYNC_NEVER_HAPPENED;
 
     if (syncResult) {
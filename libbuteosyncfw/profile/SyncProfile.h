@@ -26,10 +26,14 @@
 #ifndef SYNCPROFILE_H
 #define SYNCPROFILE_H
 
+#include <QHash>
+#include <QSharedDataPointer>
 #include "Profile.h"
 #include "SyncLog.h"
 #include "SyncSchedule.h"
 #include "SyncCommonDefs.h"
+#include "SyncClock.h"
+#include "StorageChangeSet.h"
 
 namespace Buteo {
 
@@ -178,7 +182,7 @@ public:
      *
      * \param aDateTime DateTime to check, current DateTime used by default.
      */
-    virtual bool inExternalSyncRushPeriod(QDateTime aDateTime = QDateTime::currentDateTime()) const;
+    virtual bool inExternalSyncRushPeriod(QDateTime aDateTime = SyncClock::currentDateTime()) const;
 
     /*! \brief Gets the time of last completed sync session with this profile.
      *
@@ -198,7 +202,7 @@ public:
      * \return Next sync time. Null object if the sync type is manual or the
      *  time could not be determined for some other reason.
      */
-    virtual QDateTime nextSyncTime(QDateTime aDateTime = QDateTime::currentDateTime()) const;
+    virtual QDateTime nextSyncTime(QDateTime aDateTime = SyncClock::currentDateTime()) const;
 
     /*! \brief Gets next time to switch rush/off-rush schedule intervals.
      *
@@ -208,18 +212,40 @@ public:
      */
     QDateTime nextRushSwitchTime(const QDateTime &aFromTime) const;
 
+    /*! \brief Gets the next scheduled sync times of several profiles.
+     *
+     * The clock is read once, and the same current time is used for all
+     * profiles. The previous sync time of each profile is taken from its
+     * sync log.
+     * \param aProfiles Profiles to calculate the times for.
+     * \return Next sync times by profile name. Profiles that are not
+     *  scheduled are left out.
+     */
+    static QHash<QString, QDateTime> nextSyncTimes(const QList<SyncProfile *> &aProfiles);
+
     /*! \brief Gets the results of the last sync from the sync log.
      *
+     * The profile stops sharing its log with its copies, so the returned
+     * results stay valid until the log is modified.
      * \return The results. NULL if not available.
      */
     const SyncResults *lastResults() const;
 
     /*! \brief Gets the synchronization log associated with this profile.
      *
+     * The profile stops sharing its log with its copies, so the returned
+     * log belongs to this profile alone.
      * \return The sync log. NULL if no log is set.
      */
     SyncLog *log() const;
 
+    /*! \brief Gets the synchronization log associated with this profile.
+     *
+     * \see SyncProfile::log() const
+     * \return The sync log. NULL if no log is set.
+     */
+    SyncLog *log();
+
     /*! \brief Sets the synchronization log for this profile.
      *
      * The ownership of the given log object is transferred to this object.
@@ -265,6 +291,23 @@ public:
      */
     void setSyncSchedule(const SyncSchedule &aSchedule);
 
+    /*! \brief Gets the storage changes that triggered this sync.
+     *
+     * Set by msyncd when a sync on change starts. A client plug-in can
+     * sync only the changed items of the storages whose changes are
+     * complete. The change set is not saved with the profile; out-of-process
+     * client plug-ins receive it over D-Bus before init().
+     *
+     * \return Changes, empty if the sync was not triggered by changes.
+     */
+    StorageChangeSet changeSet() const;
+
+    /*! \brief Sets the storage changes that triggered this sync.
+     *
+     * \param aChanges Changes.
+     */
+    void setChangeSet(const StorageChangeSet &aChanges);
+
     /*! \brief Gets allowed connection types.
      *
      * \return List of allowed connection types.
@@ -372,6 +415,25 @@ public:
      */
     quint32 syncOnChangeAfter() const;
 
+    /*! \brief Gets the minimum time between two syncs on change of this
+     * profile, in seconds.
+     *
+     * Changes that arrive sooner after a sync on change are synced once
+     * the gap has passed.
+     *
+     * @return Minimum gap, 0 (no gap) if none is specified
+     */
+    quint32 syncOnChangeMinGap() const;
+
+    /*! \brief Gets the number of sync results kept in the log of this
+     * profile.
+     *
+     * Read from the "log_retention" key of the sync profile itself, so
+     * that it is known without expanding the profile.
+     * \return Number of results, SyncLog::DEFAULT_MAX_RESULTS if not set.
+     */
+    int logRetention() const;
+
     /*! \brief checks if a profile has SOC enabled
      *
      * @return true if SOC enabled for this profile, false otherwise
@@ -393,7 +455,9 @@ public:
 private:
     SyncProfile &operator=(const SyncProfile &aRhs);
 
-    SyncProfilePrivate *d_ptr;
+    QSharedDataPointer<SyncProfilePrivate> d_ptr;
+
+    friend class ProfileStore;
 };
 
 }
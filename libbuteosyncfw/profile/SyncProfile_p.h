@@ -0,0 +1,107 @@
+/*
+ * This file is part of buteo-syncfw package
+ *
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+#ifndef SYNCPROFILE_P_H
+#define SYNCPROFILE_P_H
+
+#include <QList>
+#include <QSharedData>
+#include "SyncLog.h"
+#include "SyncSchedule.h"
+#include "StorageChangeSet.h"
+
+namespace Buteo {
+
+/*! \brief Private implementation class for SyncProfile, shared until
+ * modified.
+ *
+ * A copy gets a separate SyncLog, which shares its results with the source
+ * until either one is modified.
+ */
+class SyncProfilePrivate : public QSharedData
+{
+public:
+    SyncProfilePrivate();
+    SyncProfilePrivate(const SyncProfilePrivate &aSource);
+    ~SyncProfilePrivate();
+
+    //! Stops sharing the log and its results, before pointers into it are
+    //! handed out.
+    void exposeLog();
+
+    SyncLog *iLog;
+
+    //! Have pointers into the log been handed out. Such data is not shared
+    //! with new copies, so the pointers stay valid and modifying the log
+    //! does not affect the copies.
+    bool iLogExposed;
+
+    SyncSchedule iSchedule;
+
+    StorageChangeSet iChangeSet;
+
+    struct SyncRetriesInfo {
+        QList<quint32> iRetryIntervals;
+        quint32 iIntervalIndex;
+
+        void init()
+        {
+            iIntervalIndex = 0;
+        }
+
+        void addInterval(quint32 interval)
+        {
+            iRetryIntervals.append(interval);
+        }
+
+        quint32 retries() const
+        {
+            return iRetryIntervals.count();
+        }
+
+        qint32 nextInterval()
+        {
+            qint32 next = -1;
+            if (iIntervalIndex < retries()) {
+                next = iRetryIntervals.at(iIntervalIndex);
+                ++iIntervalIndex;
+            }
+            return next;
+        }
+
+        QList<quint32> intervals() const
+        {
+            return iRetryIntervals;
+        }
+
+        SyncRetriesInfo &operator=(const SyncRetriesInfo &rhs)
+        {
+            if (this != &rhs) {
+                iIntervalIndex = rhs.iIntervalIndex;
+                iRetryIntervals = rhs.iRetryIntervals;
+            }
+            return *this;
+        }
+    } iSyncRetriesInfo;
+};
+
+}
+
+#endif // SYNCPROFILE_P_H
@@ -23,14 +23,16 @@
 #include "SyncResults.h"
 #include "LogMacros.h"
 #include <QDomDocument>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
 
 #include "ProfileEngineDefs.h"
 
 
 namespace Buteo {
 
-//! Private implementation class for SyncResults.
-class SyncResultsPrivate
+//! Private implementation class for SyncResults, shared until modified.
+class SyncResultsPrivate : public QSharedData
 {
 public:
     //! Default Constructors
@@ -65,7 +67,8 @@ SyncResultsPrivate::SyncResultsPrivate()
 }
 
 SyncResultsPrivate::SyncResultsPrivate(const SyncResultsPrivate &aSource)
-    :   iTargetResults(aSource.iTargetResults),
+    :   QSharedData(aSource),
+        iTargetResults(aSource.iTargetResults),
         iTime(aSource.iTime),
         iMajorCode(aSource.iMajorCode),
         iMinorCode(aSource.iMinorCode),
@@ -85,7 +88,7 @@ SyncResults::SyncResults()
 }
 
 SyncResults::SyncResults(const SyncResults &aSource)
-    :   d_ptr(new SyncResultsPrivate(*aSource.d_ptr))
+    :   d_ptr(aSource.d_ptr)
 {
 }
 
@@ -112,6 +115,24 @@ SyncResults::SyncResults(const QDomElement &aRoot)
     }
 }
 
+SyncResults::SyncResults(QXmlStreamReader &aReader)
+    :   d_ptr(new SyncResultsPrivate())
+{
+    const QXmlStreamAttributes attributes = aReader.attributes();
+    d_ptr->iTime = QDateTime::fromString(attributes.value(ATTR_TIME).toString(), Qt::ISODate);
+    d_ptr->iMajorCode = static_cast<SyncResults::MajorCode>(attributes.value(ATTR_MAJOR_CODE).toInt());
+    d_ptr->iMinorCode = static_cast<SyncResults::MinorCode>(attributes.value(ATTR_MINOR_CODE).toInt());
+    d_ptr->iScheduled = (attributes.value(KEY_SYNC_SCHEDULED) == BOOLEAN_TRUE);
+
+    while (aReader.readNextStartElement()) {
+        if (aReader.name() == TAG_TARGET_RESULTS) {
+            d_ptr->iTargetResults.append(TargetResults(aReader));
+        } else {
+            aReader.skipCurrentElement();
+        }
+    }
+}
+
 SyncResults::~SyncResults()
 {
 }
@@ -141,17 +162,33 @@ QDomElement SyncResults::toXml(QDomDocument &aDoc) const
     return root;
 }
 
-QString SyncResults::toString() const
+void SyncResults::toXml(QXmlStreamWriter &aWriter) const
 {
-    QDomDocument doc;
-    QDomProcessingInstruction xmlHeading =
-        doc.createProcessingInstruction("xml",
-                                        "version=\"1.0\" encoding=\"UTF-8\"");
-    doc.appendChild(xmlHeading);
-    QDomElement root = toXml(doc);
-    doc.appendChild(root);
+    aWriter.writeStartElement(TAG_SYNC_RESULTS);
+    aWriter.writeAttribute(ATTR_TIME, d_ptr->iTime.toString(Qt::ISODate));
+    aWriter.writeAttribute(ATTR_MAJOR_CODE, QString::number(d_ptr->iMajorCode));
+    aWriter.writeAttribute(ATTR_MINOR_CODE, QString::number(d_ptr->iMinorCode));
+    aWriter.writeAttribute(KEY_SYNC_SCHEDULED, d_ptr->iScheduled ? BOOLEAN_TRUE :
+                           BOOLEAN_FALSE);
+
+    for (const TargetResults &tr : d_ptr->iTargetResults) {
+        tr.toXml(aWriter);
+    }
+
+    aWriter.writeEndElement();
+}
 
-    return doc.toString(PROFILE_INDENT);
+QString SyncResults::toString() const
+{
+    QString xml;
+    QXmlStreamWriter writer(&xml);
+    writer.setAutoFormatting(true);
+    writer.setAutoFormattingIndent(PROFILE_INDENT);
+    writer.writeStartDocument();
+    toXml(writer);
+    writer.writeEndDocument();
+
+    return xml;
 }
 
 
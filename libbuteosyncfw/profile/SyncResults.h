@@ -25,13 +25,15 @@
 
 #include <QDateTime>
 #include <QList>
-#include <QSharedPointer>
+#include <QSharedDataPointer>
 #include <QObject>
 #include <QVariantList>
 #include "TargetResults.h"
 
 class QDomDocument;
 class QDomElement;
+class QXmlStreamReader;
+class QXmlStreamWriter;
 
 namespace Buteo {
 
@@ -142,6 +144,15 @@ public:
      */
     explicit SyncResults(const QDomElement &aRoot);
 
+    /*! \brief Constructs the sync results from an XML stream.
+     *
+     * The reader must be positioned at the start element of the sync results
+     * representation. It is left at the matching end element, so that
+     * reading the enclosing document can continue.
+     * \param aReader XML stream reader.
+     */
+    explicit SyncResults(QXmlStreamReader &aReader);
+
     /*! \brief Destructor.
      */
     ~SyncResults();
@@ -161,6 +172,14 @@ public:
      */
     QDomElement toXml(QDomDocument &aDoc) const;
 
+    /*! \brief Writes the sync results to an XML stream.
+     *
+     * Streaming alternative to the DOM based toXml(), used when no DOM
+     * tree is needed.
+     * \param aWriter XML stream writer.
+     */
+    void toXml(QXmlStreamWriter &aWriter) const;
+
     /*! \brief Exports the sync results to QString.
      *
      * \return return the Results as xml formatted string
@@ -241,7 +260,7 @@ public:
 
 private:
     QVariantList variantTargetResults() const;
-    QSharedPointer<SyncResultsPrivate> d_ptr;
+    QSharedDataPointer<SyncResultsPrivate> d_ptr;
 
 #ifdef SYNCFW_UNIT_TESTS
     friend class ClientThreadTest;
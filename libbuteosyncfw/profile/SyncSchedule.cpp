@@ -26,6 +26,7 @@
 #include "SyncSchedule_p.h"
 #include "ProfileEngineDefs.h"
 #include "SyncCommonDefs.h"
+#include "SyncClock.h"
 #include "LogMacros.h"
 #include <QDomDocument>
 #include <QStringList>
@@ -290,212 +291,19 @@ bool SyncSchedule::inExternalSyncRushPeriod(const QDateTime &aDateTime) const
 
 QDateTime SyncSchedule::nextSyncTime(const QDateTime &aPrevSync) const
 {
-    FUNCTION_CALL_TRACE(lcButeoTrace);
-
-    QDateTime nextSync;
-    QDateTime scheduleConfiguredTime = d_ptr->iScheduleConfiguredTime;
-    QDateTime now = QDateTime::currentDateTime();
-
-    qCDebug(lcButeoCore) << "aPrevSync" << aPrevSync.toString() << "Last Configured Time " << scheduleConfiguredTime.toString()
-              << "CurrentDateTime" << now;
-
-    if (d_ptr->iTime.isValid() && d_ptr->iDays != SyncSchedule::NoDays) {
-        // The sync time is defined explicitly (for ex. every Mon, Wed, at
-        // 5:30PM). So choose the next applicable day from now.
-        qCDebug(lcButeoCore) << "Explicit sync time defined.";
-        nextSync.setTime(d_ptr->iTime);
-        nextSync.setDate(now.date());
-        if (now.time() > d_ptr->iTime) {
-            nextSync = nextSync.addDays(1);
-        }
-        d_ptr->adjustDate(nextSync, d_ptr->iDays);
-    } else if (d_ptr->iInterval > 0 && d_ptr->iEnabled) {
-        // Sync time is defined in terms of interval (for ex. every 15 minutes)
-        qCDebug(lcButeoCore) << "Sync interval defined as" << d_ptr->iInterval;
-
-        // Last sync time is not available/valid (Could happen if the device
-        // is shut down for an extended period before the first sync can be
-        // performed). Hence use the time the
-        // sync was last scheduled as the reference
-        // Figure out the number of intervals passed
-        QDateTime reference;
-        reference = (aPrevSync.isValid()) ? aPrevSync : scheduleConfiguredTime;
-        if (reference > now) {
-            // If the clock was rolled back...
-            qCDebug(lcButeoCore) << "Setting reference to now";
-            reference = now;
-        } else if (!reference.isValid()) {
-            //It means configuring first time account. Need to sync now only.
-            qCDebug(lcButeoCore) << "Reference is not valid returning current date time";
-            return QDateTime::currentDateTime();
-        }
-
-        if (d_ptr->iInterval == Sync::SYNC_INTERVAL_MONTHLY) {
-            nextSync.setDate(reference.date().addMonths(1));
-            nextSync.setTime(d_ptr->iTime);
-
-            if (QDateTime::currentDateTime().secsTo(nextSync) < 0) {
-                qCDebug(lcButeoCore) << "Named interval is in the past, so sync now";
-                // The next sync time has passed, so schedule it to happen shortly.
-                return QDateTime::currentDateTime();
-            }
-        } else if (d_ptr->iInterval == Sync::SYNC_INTERVAL_FIRST_DAY_OF_MONTH
-                   || d_ptr->iInterval == Sync::SYNC_INTERVAL_LAST_DAY_OF_MONTH) {
-            QDate date = reference.date();
-            date.setDate(date.year(), date.month(),
-                         d_ptr->iInterval == Sync::SYNC_INTERVAL_FIRST_DAY_OF_MONTH ? 1 : date.daysInMonth());
-            nextSync.setDate(date);
-            nextSync.setTime(d_ptr->iTime);
-            if (now.secsTo(nextSync) < 0) {
-                qCDebug(lcButeoCore) << "Named interval to" << nextSync
-                          << "is in the past, so use date for next month instead";
-                // The next sync time has passed, so schedule it in the month following the
-                // current date.
-                while (nextSync < now) {
-                    nextSync = nextSync.addMonths(1);
-                }
-            }
-
-        } else {
-            const int secs = reference.secsTo(now) + 1;
-            const int numberOfIntervals = (secs / (d_ptr->iInterval * 60))
-                                          + (((secs % (d_ptr->iInterval * 60)) != 0) ? 1 : 0);
-            qCDebug(lcButeoCore) << "numberOfInterval:" << numberOfIntervals << "interval time" << d_ptr->iInterval;
-            nextSync = reference.addSecs(numberOfIntervals * d_ptr->iInterval * 60);
-        }
-    }
-
-    qCDebug(lcButeoCore) << "next non rush hour sync is at:: " << nextSync;
-
-    // Rush is controlled by a external process(e.g always-up-to-date), buteo controls the switch between rush and offRush
-    if (d_ptr->iRushEnabled && d_ptr->iExternalRushEnabled) {
-        qCDebug(lcButeoCore) << "Rush Interval is controlled by a external process.";
-        // Set next sync to rush end
-        const bool isRush(d_ptr->isRush(now));
-        QDateTime nextSyncRush;
-        nextSyncRush.setTime(isRush ? d_ptr->iRushEnd : d_ptr->iRushBegin);
-        nextSyncRush.setDate(now.date());
-        if (now.time() > d_ptr->iRushEnd) {
-            nextSyncRush = nextSyncRush.addDays(1);
-        }
-        d_ptr->adjustDate(nextSyncRush, d_ptr->iRushDays);
-        qCDebug(lcButeoCore) << "Rush controlled by external process, next scheduled sync at rush " << (isRush ? "end" : "begin") <<
-                  nextSyncRush.toString();
-        // Use next sync time calculated with rush settings if necessary.
-        if (nextSyncRush.isValid()) {
-            // check to see if we should use it, or instead use the next non-rush sync time.
-            if (nextSync.isValid()
-                    && nextSync > now
-                    && nextSync < nextSyncRush
-                    && (!d_ptr->isRush(nextSync))) {
-                // the next non-rush sync time occurs after now
-                // but before the next rush sync time, and either it
-                // doesn't fall within the rush period itself or the
-                // next rush sync time is in the next rush period.
-                // we should use the non-rush schedule.
-                qCDebug(lcButeoCore) << "Using non-rush time as the next sync time";
-            } else {
-                nextSync = nextSyncRush;
-            }
-        }
-    } else if (d_ptr->iRushEnabled && d_ptr->iRushInterval > 0 && !d_ptr->iExternalRushEnabled) {
-        qCDebug(lcButeoCore) << "Calculating next sync time with rush settings. Rush Interval is " << d_ptr->iRushInterval;
-        // Calculate next sync time with rush settings.
-        QDateTime nextSyncRush;
-        bool nextSyncRushInNextRushPeriod = false;
-        if (d_ptr->isRush(now)) {
-            qCDebug(lcButeoCore) << "Current time is in rush";
-            // We are in rush hour
-            if (aPrevSync.isValid()) {
-                qCDebug(lcButeoCore) << "PrevSync is valid and isRush true.. ";
-                nextSyncRush = aPrevSync.addSecs(d_ptr->iRushInterval * 60);
-                if ((nextSyncRush < now) || (aPrevSync > now)) {
-                    // Use current time if the previous sync time is too old, or
-                    // the clock has been rolled back
-                    nextSyncRush = now.addSecs(d_ptr->iRushInterval * 60);
-                    qCDebug(lcButeoCore) << "nextsyncRush based on aPrevSync" << nextSyncRush;
-                }
-            } else {
-                nextSyncRush = now.addSecs(d_ptr->iRushInterval * 60);
-            }
-
-            if (!d_ptr->isRush(nextSyncRush)) {
-                // If the calculated rush time does not lie in the rush
-                // interval, choose the next available rush time as the begin
-                // time for the rush interval
-                qCDebug(lcButeoCore) << "isRush False";
-                nextSyncRushInNextRushPeriod = true;
-                nextSyncRush.setTime(d_ptr->iRushBegin);
-                if (nextSyncRush < now) {
-                    nextSyncRush = nextSyncRush.addDays(1);
-                }
-                d_ptr->adjustDate(nextSyncRush, d_ptr->iRushDays);
-            }
-        } else {
-            qCDebug(lcButeoCore) << "Current Time is Not Rush";
-            nextSyncRush.setTime(d_ptr->iRushBegin);
-            nextSyncRush.setDate(now.date());
-            if (now.time() > d_ptr->iRushBegin) {
-                nextSyncRush = nextSyncRush.addDays(1);
-            }
-            d_ptr->adjustDate(nextSyncRush, d_ptr->iRushDays);
-        }
-
-        qCDebug(lcButeoCore) << "nextSyncRush" << nextSyncRush.toString();
-        // Use next sync time calculated with rush settings if necessary.
-        if (nextSyncRush.isValid()) {
-            // check to see if we should use it, or instead use the next non-rush sync time.
-            if (nextSync.isValid()
-                    && nextSync > now
-                    && nextSync < nextSyncRush
-                    && (!d_ptr->isRush(nextSync) || nextSyncRushInNextRushPeriod)) {
-                // the next non-rush sync time occurs after now
-                // but before the next rush sync time, and either it
-                // doesn't fall within the rush period itself or the
-                // next rush sync time is in the next rush period.
-                // we should use the non-rush schedule.
-                qCDebug(lcButeoCore) << "Using non-rush time as the next sync time";
-            } else {
-                // we should use the rush schedule.
-                qCDebug(lcButeoCore) << "Using rush time as the next sync time";
-                nextSync = nextSyncRush;
-            }
-        }
-    }
+    return nextSyncTime(aPrevSync, SyncClock::currentDateTime());
+}
 
-    //For safer side checking nextSyncTime should not be behind currentDateTime.
-    if (QDateTime::currentDateTime().secsTo(nextSync) < 0) {
-        //If it is the case making it to currentTime.
-        qCWarning(lcButeoCore) << "Something went wrong in nextSyncTime calculation resetting to current time";
-        nextSync = QDateTime::currentDateTime();
-    }
+QDateTime SyncSchedule::nextSyncTime(const QDateTime &aPrevSync, const QDateTime &aNow) const
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
 
-    qCDebug(lcButeoCore) << "nextSync" << nextSync.toString();
-    return nextSync;
+    return d_ptr->computeNextSyncTime(aPrevSync, aNow);
 }
 
 QDateTime SyncSchedule::nextRushSwitchTime(const QDateTime &aFromTime) const
 {
-    if (rushEnabled() && scheduleEnabled()) {
-        if (d_ptr->iRushInterval == d_ptr->iInterval && !d_ptr->iExternalRushEnabled) {
-            qCDebug(lcButeoCore) << "Rush interval is the same as normal interval no need to switch";
-            return QDateTime();
-        }
-        if (d_ptr->isRush(aFromTime)) {
-            return QDateTime(aFromTime.date(), d_ptr->iRushEnd);
-        } else {
-            // If rush day and before rush end next switch is at rush begin
-            if (SyncSchedulePrivate::daysMatch(d_ptr->iRushDays, aFromTime.date().dayOfWeek()) && aFromTime.time() < d_ptr->iRushBegin) {
-                return QDateTime(aFromTime.date(), d_ptr->iRushBegin);
-            } else {
-                // Not a rush day or the rush period has ended, attemp switch at next day rush begin,
-                // we can only schedule for 24h
-                return QDateTime(aFromTime.date().addDays(1), d_ptr->iRushBegin);
-            }
-        }
-    } else {
-        return QDateTime();
-    }
+    return d_ptr->computeRushSwitchTime(aFromTime);
 }
 
 bool SyncSchedule::isSyncScheduled(const QDateTime &aActualDateTime, const QDateTime &aPreviousSyncTime) const
@@ -658,3 +466,211 @@ bool SyncSchedulePrivate::isRush(const QDateTime &aTime) const
     return (daysMatch(iRushDays, aTime.date().dayOfWeek()) &&
             aTime.time() >= iRushBegin && aTime.time() < iRushEnd);
 }
+
+QDateTime SyncSchedulePrivate::computeNextSyncTime(const QDateTime &aPrevSync, const QDateTime &aNow) const
+{
+    QDateTime nextSync;
+    QDateTime scheduleConfiguredTime = iScheduleConfiguredTime;
+    const QDateTime &now = aNow;
+
+    qCDebug(lcButeoCore) << "aPrevSync" << aPrevSync.toString() << "Last Configured Time " << scheduleConfiguredTime.toString()
+              << "CurrentDateTime" << now;
+
+    if (iTime.isValid() && iDays != SyncSchedule::NoDays) {
+        // The sync time is defined explicitly (for ex. every Mon, Wed, at
+        // 5:30PM). So choose the next applicable day from now.
+        qCDebug(lcButeoCore) << "Explicit sync time defined.";
+        nextSync.setTime(iTime);
+        nextSync.setDate(now.date());
+        if (now.time() > iTime) {
+            nextSync = nextSync.addDays(1);
+        }
+        adjustDate(nextSync, iDays);
+    } else if (iInterval > 0 && iEnabled) {
+        // Sync time is defined in terms of interval (for ex. every 15 minutes)
+        qCDebug(lcButeoCore) << "Sync interval defined as" << iInterval;
+
+        // Last sync time is not available/valid (Could happen if the device
+        // is shut down for an extended period before the first sync can be
+        // performed). Hence use the time the
+        // sync was last scheduled as the reference
+        // Figure out the number of intervals passed
+        QDateTime reference;
+        reference = (aPrevSync.isValid()) ? aPrevSync : scheduleConfiguredTime;
+        if (reference > now) {
+            // If the clock was rolled back...
+            qCDebug(lcButeoCore) << "Setting reference to now";
+            reference = now;
+        } else if (!reference.isValid()) {
+            //It means configuring first time account. Need to sync now only.
+            qCDebug(lcButeoCore) << "Reference is not valid returning current date time";
+            return now;
+        }
+
+        if (iInterval == Sync::SYNC_INTERVAL_MONTHLY) {
+            nextSync.setDate(reference.date().addMonths(1));
+            nextSync.setTime(iTime);
+
+            if (now.secsTo(nextSync) < 0) {
+                qCDebug(lcButeoCore) << "Named interval is in the past, so sync now";
+                // The next sync time has passed, so schedule it to happen shortly.
+                return now;
+            }
+        } else if (iInterval == Sync::SYNC_INTERVAL_FIRST_DAY_OF_MONTH
+                   || iInterval == Sync::SYNC_INTERVAL_LAST_DAY_OF_MONTH) {
+            QDate date = reference.date();
+            date.setDate(date.year(), date.month(),
+                         iInterval == Sync::SYNC_INTERVAL_FIRST_DAY_OF_MONTH ? 1 : date.daysInMonth());
+            nextSync.setDate(date);
+            nextSync.setTime(iTime);
+            if (now.secsTo(nextSync) < 0) {
+                qCDebug(lcButeoCore) << "Named interval to" << nextSync
+                          << "is in the past, so use date for next month instead";
+                // The next sync time has passed, so schedule it in the month following the
+                // current date.
+                while (nextSync < now) {
+                    nextSync = nextSync.addMonths(1);
+                }
+            }
+
+        } else {
+            const int secs = reference.secsTo(now) + 1;
+            const int numberOfIntervals = (secs / (iInterval * 60))
+                                          + (((secs % (iInterval * 60)) != 0) ? 1 : 0);
+            qCDebug(lcButeoCore) << "numberOfInterval:" << numberOfIntervals << "interval time" << iInterval;
+            nextSync = reference.addSecs(numberOfIntervals * iInterval * 60);
+        }
+    }
+
+    qCDebug(lcButeoCore) << "next non rush hour sync is at:: " << nextSync;
+
+    // Rush is controlled by a external process(e.g always-up-to-date), buteo controls the switch between rush and offRush
+    if (iRushEnabled && iExternalRushEnabled) {
+        qCDebug(lcButeoCore) << "Rush Interval is controlled by a external process.";
+        // Set next sync to rush end
+        const bool inRush(isRush(now));
+        QDateTime nextSyncRush;
+        nextSyncRush.setTime(inRush ? iRushEnd : iRushBegin);
+        nextSyncRush.setDate(now.date());
+        if (now.time() > iRushEnd) {
+            nextSyncRush = nextSyncRush.addDays(1);
+        }
+        adjustDate(nextSyncRush, iRushDays);
+        qCDebug(lcButeoCore) << "Rush controlled by external process, next scheduled sync at rush " << (inRush ? "end" : "begin") <<
+                  nextSyncRush.toString();
+        // Use next sync time calculated with rush settings if necessary.
+        if (nextSyncRush.isValid()) {
+            // check to see if we should use it, or instead use the next non-rush sync time.
+            if (nextSync.isValid()
+                    && nextSync > now
+                    && nextSync < nextSyncRush
+                    && (!isRush(nextSync))) {
+                // the next non-rush sync time occurs after now
+                // but before the next rush sync time, and either it
+                // doesn't fall within the rush period itself or the
+                // next rush sync time is in the next rush period.
+                // we should use the non-rush schedule.
+                qCDebug(lcButeoCore) << "Using non-rush time as the next sync time";
+            } else {
+                nextSync = nextSyncRush;
+            }
+        }
+    } else if (iRushEnabled && iRushInterval > 0 && !iExternalRushEnabled) {
+        qCDebug(lcButeoCore) << "Calculating next sync time with rush settings. Rush Interval is " << iRushInterval;
+        // Calculate next sync time with rush settings.
+        QDateTime nextSyncRush;
+        bool nextSyncRushInNextRushPeriod = false;
+        if (isRush(now)) {
+            qCDebug(lcButeoCore) << "Current time is in rush";
+            // We are in rush hour
+            if (aPrevSync.isValid()) {
+                qCDebug(lcButeoCore) << "PrevSync is valid and isRush true.. ";
+                nextSyncRush = aPrevSync.addSecs(iRushInterval * 60);
+                if ((nextSyncRush < now) || (aPrevSync > now)) {
+                    // Use current time if the previous sync time is too old, or
+                    // the clock has been rolled back
+                    nextSyncRush = now.addSecs(iRushInterval * 60);
+                    qCDebug(lcButeoCore) << "nextsyncRush based on aPrevSync" << nextSyncRush;
+                }
+            } else {
+                nextSyncRush = now.addSecs(iRushInterval * 60);
+            }
+
+            if (!isRush(nextSyncRush)) {
+                // If the calculated rush time does not lie in the rush
+                // interval, choose the next available rush time as the begin
+                // time for the rush interval
+                qCDebug(lcButeoCore) << "isRush False";
+                nextSyncRushInNextRushPeriod = true;
+                nextSyncRush.setTime(iRushBegin);
+                if (nextSyncRush < now) {
+                    nextSyncRush = nextSyncRush.addDays(1);
+                }
+                adjustDate(nextSyncRush, iRushDays);
+            }
+        } else {
+            qCDebug(lcButeoCore) << "Current Time is Not Rush";
+            nextSyncRush.setTime(iRushBegin);
+            nextSyncRush.setDate(now.date());
+            if (now.time() > iRushBegin) {
+                nextSyncRush = nextSyncRush.addDays(1);
+            }
+            adjustDate(nextSyncRush, iRushDays);
+        }
+
+        qCDebug(lcButeoCore) << "nextSyncRush" << nextSyncRush.toString();
+        // Use next sync time calculated with rush settings if necessary.
+        if (nextSyncRush.isValid()) {
+            // check to see if we should use it, or instead use the next non-rush sync time.
+            if (nextSync.isValid()
+                    && nextSync > now
+                    && nextSync < nextSyncRush
+                    && (!isRush(nextSync) || nextSyncRushInNextRushPeriod)) {
+                // the next non-rush sync time occurs after now
+                // but before the next rush sync time, and either it
+                // doesn't fall within the rush period itself or the
+                // next rush sync time is in the next rush period.
+                // we should use the non-rush schedule.
+                qCDebug(lcButeoCore) << "Using non-rush time as the next sync time";
+            } else {
+                // we should use the rush schedule.
+                qCDebug(lcButeoCore) << "Using rush time as the next sync time";
+                nextSync = nextSyncRush;
+            }
+        }
+    }
+
+    //For safer side checking nextSyncTime should not be behind currentDateTime.
+    if (now.secsTo(nextSync) < 0) {
+        //If it is the case making it to currentTime.
+        qCWarning(lcButeoCore) << "Something went wrong in nextSyncTime calculation resetting to current time";
+        nextSync = now;
+    }
+
+    qCDebug(lcButeoCore) << "nextSync" << nextSync.toString();
+    return nextSync;
+}
+
+QDateTime SyncSchedulePrivate::computeRushSwitchTime(const QDateTime &aFromTime) const
+{
+    if (iRushEnabled && iEnabled) {
+        if (iRushInterval == iInterval && !iExternalRushEnabled) {
+            qCDebug(lcButeoCore) << "Rush interval is the same as normal interval no need to switch";
+            return QDateTime();
+        }
+        if (isRush(aFromTime)) {
+            return QDateTime(aFromTime.date(), iRushEnd);
+        } else {
+            // If rush day and before rush end next switch is at rush begin
+            if (daysMatch(iRushDays, aFromTime.date().dayOfWeek()) && aFromTime.time() < iRushBegin) {
+                return QDateTime(aFromTime.date(), iRushBegin);
+            } else {
+                // Not a rush day or the rush period has ended, attemp switch at next day rush begin,
+                // we can only schedule for 24h
+                return QDateTime(aFromTime.date().addDays(1), iRushBegin);
+            }
+        }
+    } else {
+        return QDateTime();
+    }
+}
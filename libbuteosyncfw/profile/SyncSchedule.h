@@ -269,6 +269,16 @@ public:
      */
     QDateTime nextSyncTime(const QDateTime &aPrevSync) const;
 
+    /*! \brief Gets next sync time relative to the given current time.
+     *
+     * Use this to calculate several schedules against the same reading of
+     * the clock.
+     * \param aPrevSync Previous sync time.
+     * \param aNow Current time.
+     * \return Next sync time. Null object if schedule is not defined.
+     */
+    QDateTime nextSyncTime(const QDateTime &aPrevSync, const QDateTime &aNow) const;
+
     /*! \brief Gets next time to switch rush/off-rush schedule intervals.
      *
      * \param aFromTime From time to calculate next switch, usually current time.
@@ -289,6 +299,8 @@ private:
 
     SyncSchedulePrivate *d_ptr;
 
+    friend class ProfileStore;
+
 #ifdef SYNCFW_UNIT_TESTS
     friend class SyncScheduleTest;
 #endif
@@ -87,6 +87,21 @@ public:
      */
     bool isRush(const QDateTime &aTime) const;
 
+    /*! \brief Calculates the next sync time.
+     *
+     * \param aPrevSync Previous sync time.
+     * \param aNow Current time.
+     * \return Next sync time.
+     */
+    QDateTime computeNextSyncTime(const QDateTime &aPrevSync, const QDateTime &aNow) const;
+
+    /*! \brief Calculates the next rush/off-rush switch time.
+     *
+     * \param aFromTime Time to calculate from.
+     * \return Next switch time, invalid if there are no switches.
+     */
+    QDateTime computeRushSwitchTime(const QDateTime &aFromTime) const;
+
     //! Days for the sync
     SyncSchedule::Days iDays;
 
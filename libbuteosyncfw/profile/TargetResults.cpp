@@ -24,6 +24,8 @@
 #include "ProfileEngineDefs.h"
 #include "LogMacros.h"
 #include <QDomDocument>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
 
 namespace Buteo {
 
@@ -45,6 +47,14 @@ struct ItemDetails {
         , message(aRoot.text())
     {
     }
+    ItemDetails(QXmlStreamReader &aReader)
+        : uid(aReader.attributes().value(ATTR_UID).toString())
+        , status(aReader.attributes().value(ATTR_STATUS).compare(QLatin1String("failed"),
+                                                                 Qt::CaseInsensitive) ? TargetResults::ITEM_OPERATION_SUCCEEDED
+                                                                                      : TargetResults::ITEM_OPERATION_FAILED)
+        , message(aReader.readElementText(QXmlStreamReader::SkipChildElements))
+    {
+    }
 
     QDomElement toXml(QDomDocument &aDoc, const QString &aTag) const
     {
@@ -59,6 +69,19 @@ struct ItemDetails {
         return item;
     };
 
+    void toXml(QXmlStreamWriter &aWriter, const QString &aTag) const
+    {
+        aWriter.writeStartElement(aTag);
+        aWriter.writeAttribute(ATTR_UID, uid);
+        if (status == TargetResults::ITEM_OPERATION_FAILED) {
+            aWriter.writeAttribute(ATTR_STATUS, QLatin1String("failed"));
+        }
+        if (!message.isEmpty()) {
+            aWriter.writeCDATA(message);
+        }
+        aWriter.writeEndElement();
+    }
+
     static QList<ItemDetails> fromXml(const QDomElement &aRoot, const QString &aTag)
     {
         QList<ItemDetails> out;
@@ -73,6 +96,38 @@ struct ItemDetails {
         return out;
     };
 
+    // Reads the item counts and item details of a <local> or <remote>
+    // element, leaving the reader at its end element.
+    static void fromXml(QXmlStreamReader &aReader, ItemCounts &aCounts,
+                        QList<ItemDetails> &aAdditions,
+                        QList<ItemDetails> &aDeletions,
+                        QList<ItemDetails> &aModifications)
+    {
+        const QXmlStreamAttributes attributes = aReader.attributes();
+        aCounts.added = attributes.value(ATTR_ADDED).toUInt();
+        aCounts.deleted = attributes.value(ATTR_DELETED).toUInt();
+        aCounts.modified = attributes.value(ATTR_MODIFIED).toUInt();
+
+        while (aReader.readNextStartElement()) {
+            QList<ItemDetails> *list = 0;
+            if (aReader.name() == TAG_ADDED_ITEM) {
+                list = &aAdditions;
+            } else if (aReader.name() == TAG_DELETED_ITEM) {
+                list = &aDeletions;
+            } else if (aReader.name() == TAG_MODIFIED_ITEM) {
+                list = &aModifications;
+            } else {
+                aReader.skipCurrentElement();
+                continue;
+            }
+
+            ItemDetails details(aReader);
+            if (!details.uid.isEmpty()) {
+                list->append(details);
+            }
+        }
+    }
+
     static QList<QString> filterStatus(const QList<ItemDetails> &aList,
                                        TargetResults::ItemOperationStatus aStatus)
     {
@@ -97,8 +152,8 @@ struct ItemDetails {
     }
 };
 
-// Private implementation class for TargetResults
-class TargetResultsPrivate
+// Private implementation class for TargetResults, shared until modified.
+class TargetResultsPrivate : public QSharedData
 {
 public:
     TargetResultsPrivate();
@@ -128,7 +183,8 @@ TargetResultsPrivate::TargetResultsPrivate()
 }
 
 TargetResultsPrivate::TargetResultsPrivate(const TargetResultsPrivate &aSource)
-    :   iTargetName(aSource.iTargetName),
+    :   QSharedData(aSource),
+        iTargetName(aSource.iTargetName),
         iLocalItems(aSource.iLocalItems),
         iLocalAdditions(aSource.iLocalAdditions),
         iLocalDeletions(aSource.iLocalDeletions),
@@ -146,7 +202,7 @@ TargetResults::TargetResults()
 }
 
 TargetResults::TargetResults(const TargetResults &aSource)
-    :   d_ptr(new TargetResultsPrivate(*aSource.d_ptr))
+    :   d_ptr(aSource.d_ptr)
 {
 }
 
@@ -185,17 +241,37 @@ TargetResults::TargetResults(const QDomElement &aRoot)
     }
 }
 
+TargetResults::TargetResults(QXmlStreamReader &aReader)
+    :   d_ptr(new TargetResultsPrivate())
+{
+    d_ptr->iTargetName = aReader.attributes().value(ATTR_NAME).toString();
+
+    bool localFound = false;
+    bool remoteFound = false;
+    while (aReader.readNextStartElement()) {
+        // Only the first local and remote elements count, as with DOM.
+        if (aReader.name() == TAG_LOCAL && !localFound) {
+            localFound = true;
+            ItemDetails::fromXml(aReader, d_ptr->iLocalItems, d_ptr->iLocalAdditions,
+                                 d_ptr->iLocalDeletions, d_ptr->iLocalModifications);
+        } else if (aReader.name() == TAG_REMOTE && !remoteFound) {
+            remoteFound = true;
+            ItemDetails::fromXml(aReader, d_ptr->iRemoteItems, d_ptr->iRemoteAdditions,
+                                 d_ptr->iRemoteDeletions, d_ptr->iRemoteModifications);
+        } else {
+            aReader.skipCurrentElement();
+        }
+    }
+}
+
 TargetResults::~TargetResults()
 {
-    delete d_ptr;
-    d_ptr = 0;
 }
 
 TargetResults &TargetResults::operator=(const TargetResults &aRhs)
 {
     if (&aRhs != this) {
-        delete d_ptr;
-        d_ptr = new TargetResultsPrivate(*aRhs.d_ptr);
+        d_ptr = aRhs.d_ptr;
     }
 
     return *this;
@@ -239,6 +315,44 @@ QDomElement TargetResults::toXml(QDomDocument &aDoc) const
     return root;
 }
 
+void TargetResults::toXml(QXmlStreamWriter &aWriter) const
+{
+    aWriter.writeStartElement(TAG_TARGET_RESULTS);
+    aWriter.writeAttribute(ATTR_NAME, d_ptr->iTargetName);
+
+    aWriter.writeStartElement(TAG_LOCAL);
+    aWriter.writeAttribute(ATTR_ADDED, QString::number(d_ptr->iLocalItems.added));
+    aWriter.writeAttribute(ATTR_DELETED, QString::number(d_ptr->iLocalItems.deleted));
+    aWriter.writeAttribute(ATTR_MODIFIED, QString::number(d_ptr->iLocalItems.modified));
+    for (const ItemDetails &details : d_ptr->iLocalAdditions) {
+        details.toXml(aWriter, TAG_ADDED_ITEM);
+    }
+    for (const ItemDetails &details : d_ptr->iLocalDeletions) {
+        details.toXml(aWriter, TAG_DELETED_ITEM);
+    }
+    for (const ItemDetails &details : d_ptr->iLocalModifications) {
+        details.toXml(aWriter, TAG_MODIFIED_ITEM);
+    }
+    aWriter.writeEndElement();
+
+    aWriter.writeStartElement(TAG_REMOTE);
+    aWriter.writeAttribute(ATTR_ADDED, QString::number(d_ptr->iRemoteItems.added));
+    aWriter.writeAttribute(ATTR_DELETED, QString::number(d_ptr->iRemoteItems.deleted));
+    aWriter.writeAttribute(ATTR_MODIFIED, QString::number(d_ptr->iRemoteItems.modified));
+    for (const ItemDetails &details : d_ptr->iRemoteAdditions) {
+        details.toXml(aWriter, TAG_ADDED_ITEM);
+    }
+    for (const ItemDetails &details : d_ptr->iRemoteDeletions) {
+        details.toXml(aWriter, TAG_DELETED_ITEM);
+    }
+    for (const ItemDetails &details : d_ptr->iRemoteModifications) {
+        details.toXml(aWriter, TAG_MODIFIED_ITEM);
+    }
+    aWriter.writeEndElement();
+
+    aWriter.writeEndElement();
+}
+
 QString TargetResults::targetName() const
 {
     return d_ptr->iTargetName;
@@ -25,10 +25,13 @@
 
 #include <QString>
 #include <QList>
+#include <QSharedDataPointer>
 #include <QObject>
 
 class QDomDocument;
 class QDomElement;
+class QXmlStreamReader;
+class QXmlStreamWriter;
 
 namespace Buteo {
 
@@ -114,6 +117,15 @@ public:
      */
     explicit TargetResults(const QDomElement &aRoot);
 
+    /*! \brief Constructs the target results from an XML stream.
+     *
+     * The reader must be positioned at the start element of the target results
+     * representation. It is left at the matching end element, so that
+     * reading the enclosing document can continue.
+     * \param aReader XML stream reader.
+     */
+    explicit TargetResults(QXmlStreamReader &aReader);
+
     /*! \brief Destructor.
      */
     ~TargetResults();
@@ -133,6 +145,14 @@ public:
      */
     QDomElement toXml(QDomDocument &aDoc) const;
 
+    /*! \brief Writes the target results to an XML stream.
+     *
+     * Streaming alternative to the DOM based toXml(), used when no DOM
+     * tree is needed.
+     * \param aWriter XML stream writer.
+     */
+    void toXml(QXmlStreamWriter &aWriter) const;
+
     /*! \brief Gets the target name.
      *
      * \return Target name.
@@ -235,7 +255,7 @@ private:
     QStringList remoteModifications() const { return remoteDetails(ITEM_MODIFIED, ITEM_OPERATION_SUCCEEDED); }
     QStringList remoteFailures() const { return remoteDetails(ITEM_ADDED, ITEM_OPERATION_FAILED) + remoteDetails(ITEM_MODIFIED, ITEM_OPERATION_FAILED) + remoteDetails(ITEM_DELETED, ITEM_OPERATION_FAILED); }
 
-    TargetResultsPrivate *d_ptr;
+    QSharedDataPointer<TargetResultsPrivate> d_ptr;
 };
 
 }
@@ -0,0 +1,200 @@
+/*
+ * This file is part of buteo-syncfw package
+ *
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include "OnlineSyncRamp.h"
+#include "LogMacros.h"
+#include <QPair>
+#include <algorithm>
+#include <limits>
+
+using namespace Buteo;
+
+const int OnlineSyncRamp::DEFAULT_BURST = 2;
+const int OnlineSyncRamp::DEFAULT_STARTS_PER_SECOND = 1;
+const int OnlineSyncRamp::DEFAULT_MAX_JITTER = 2000;
+
+OnlineSyncRamp::OnlineSyncRamp()
+    : iBurst(DEFAULT_BURST),
+      iStartsPerSecond(DEFAULT_STARTS_PER_SECOND),
+      iMaxJitter(DEFAULT_MAX_JITTER),
+      iRandom(quint32(QDateTime::currentMSecsSinceEpoch())),
+      iTokens(DEFAULT_BURST),
+      iRefilledAt(0),
+      iRampStart(0),
+      iLastRampDuration(-1),
+      iRamps(0),
+      iReleased(0),
+      iPeakRunning(0),
+      iLastRampPeak(0)
+{
+}
+
+void OnlineSyncRamp::setPolicy(int aBurst, int aStartsPerSecond, int aMaxJitter)
+{
+    iBurst = qMax(aBurst, 1);
+    iStartsPerSecond = qMax(aStartsPerSecond, 0);
+    iMaxJitter = qMax(aMaxJitter, 0);
+    iTokens = qMin(iTokens, double(iBurst));
+    qCDebug(lcButeoMsyncd) << "Online sync ramp: burst" << iBurst << "starts per second"
+                           << iStartsPerSecond << "jitter" << iMaxJitter << "ms";
+}
+
+void OnlineSyncRamp::setSeed(quint32 aSeed)
+{
+    iRandom.seed(aSeed);
+}
+
+void OnlineSyncRamp::add(const QString &aProfileName, const QDateTime &aLastSuccess, qint64 aNow)
+{
+    if (iWaiting.contains(aProfileName)) {
+        return;
+    }
+
+    if (iWaiting.isEmpty() && iRunning.isEmpty()) {
+        iRampStart = aNow;
+        iLastRampPeak = 0;
+        ++iRamps;
+    }
+
+    Entry entry;
+    entry.iReadyAt = aNow;
+    if (iMaxJitter > 0) {
+        entry.iReadyAt += std::uniform_int_distribution<int>(0, iMaxJitter)(iRandom);
+    }
+    entry.iLastSuccess = aLastSuccess.isValid() ? aLastSuccess.toMSecsSinceEpoch()
+                                                : std::numeric_limits<qint64>::min();
+    iWaiting.insert(aProfileName, entry);
+}
+
+void OnlineSyncRamp::remove(const QString &aProfileName)
+{
+    iWaiting.remove(aProfileName);
+}
+
+void OnlineSyncRamp::clear()
+{
+    iWaiting.clear();
+}
+
+bool OnlineSyncRamp::isEmpty() const
+{
+    return iWaiting.isEmpty();
+}
+
+QStringList OnlineSyncRamp::takeDue(qint64 aNow)
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    refill(aNow);
+
+    QList<QPair<qint64, QString> > ready;
+    for (QHash<QString, Entry>::const_iterator it = iWaiting.constBegin(); it != iWaiting.constEnd(); ++it) {
+        if (it.value().iReadyAt <= aNow) {
+            ready.append(qMakePair(it.value().iLastSuccess, it.key()));
+        }
+    }
+    std::sort(ready.begin(), ready.end());
+
+    QStringList due;
+    for (int i = 0; i < ready.size(); ++i) {
+        if (iStartsPerSecond > 0) {
+            if (iTokens < 1.0) {
+                break;
+            }
+            iTokens -= 1.0;
+        }
+        const QString &profileName = ready.at(i).second;
+        iWaiting.remove(profileName);
+        iRunning.insert(profileName);
+        due.append(profileName);
+    }
+
+    iReleased += due.size();
+    iLastRampPeak = qMax(iLastRampPeak, iRunning.size());
+    iPeakRunning = qMax(iPeakRunning, iRunning.size());
+
+    if (!due.isEmpty()) {
+        qCDebug(lcButeoMsyncd) << "Online sync ramp releases" << due << "," << iWaiting.size() << "waiting";
+    }
+    return due;
+}
+
+qint64 OnlineSyncRamp::msecsToNext(qint64 aNow) const
+{
+    if (iWaiting.isEmpty()) {
+        return -1;
+    }
+
+    qint64 readyAt = std::numeric_limits<qint64>::max();
+    foreach (const Entry &entry, iWaiting) {
+        readyAt = qMin(readyAt, entry.iReadyAt);
+    }
+    qint64 wait = qMax(readyAt - aNow, qint64(0));
+
+    if (iStartsPerSecond > 0) {
+        const double tokens = qMin(double(iBurst),
+                                   iTokens + (aNow - iRefilledAt) * iStartsPerSecond / 1000.0);
+        if (tokens < 1.0) {
+            const qint64 tokenWait = qint64((1.0 - tokens) * 1000.0 / iStartsPerSecond) + 1;
+            wait = qMax(wait, tokenWait);
+        }
+    }
+    return wait;
+}
+
+void OnlineSyncRamp::finished(const QString &aProfileName, qint64 aNow)
+{
+    if (!iRunning.remove(aProfileName)) {
+        return;
+    }
+
+    if (iRunning.isEmpty() && iWaiting.isEmpty()) {
+        iLastRampDuration = aNow - iRampStart;
+        qCDebug(lcButeoMsyncd) << "Online sync ramp done in" << iLastRampDuration << "ms with at most"
+                               << iLastRampPeak << "syncs at once";
+    }
+}
+
+QVariantMap OnlineSyncRamp::statistics() const
+{
+    QVariantMap stats;
+    stats.insert("onlineRampBurst", iBurst);
+    stats.insert("onlineRampStartsPerSecond", iStartsPerSecond);
+    stats.insert("onlineRampMaxJitterMs", iMaxJitter);
+    stats.insert("onlineRamps", iRamps);
+    stats.insert("onlineRampReleasedSyncs", iReleased);
+    stats.insert("onlineRampPendingSyncs", iWaiting.size());
+    stats.insert("onlineRampRunningSyncs", iRunning.size());
+    stats.insert("onlineRampPeakRunning", iPeakRunning);
+    stats.insert("onlineRampLastPeakRunning", iLastRampPeak);
+    // Time from the return of connectivity until all syncs of the last
+    // completed ramp had finished.
+    stats.insert("onlineRampLastDurationMs", iLastRampDuration);
+    return stats;
+}
+
+void OnlineSyncRamp::refill(qint64 aNow)
+{
+    if (aNow > iRefilledAt) {
+        iTokens = qMin(double(iBurst), iTokens + (aNow - iRefilledAt) * iStartsPerSecond / 1000.0);
+        iRefilledAt = aNow;
+    }
+}
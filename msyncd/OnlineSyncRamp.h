@@ -0,0 +1,167 @@
+/*
+ * This file is part of buteo-syncfw package
+ *
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+#ifndef ONLINESYNCRAMP_H
+#define ONLINESYNCRAMP_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+#include <random>
+
+namespace Buteo {
+
+/*! \brief Releases syncs waiting for connectivity gradually.
+ *
+ * When the device gets online, the profiles waiting for a connection are
+ * not started all at once. Each profile gets a random start delay of up to
+ * the jitter, and starts are limited by a token bucket that allows a burst
+ * of starts and then a fixed number of starts per second. Among the
+ * profiles that may start, the one with the oldest successful sync goes
+ * first.
+ *
+ * The ramp does not own a timer. Times are monotonic milliseconds passed
+ * in by the caller, which releases the profiles returned by takeDue() and
+ * calls it again after msecsToNext().
+ */
+class OnlineSyncRamp
+{
+public:
+    //! Default number of syncs started at once.
+    static const int DEFAULT_BURST;
+
+    //! Default number of syncs started per second after the burst.
+    static const int DEFAULT_STARTS_PER_SECOND;
+
+    //! Default maximum random delay of a start in milliseconds.
+    static const int DEFAULT_MAX_JITTER;
+
+    //! \brief Constructor
+    OnlineSyncRamp();
+
+    /*! \brief Sets the release policy.
+     *
+     * \param aBurst Number of syncs that can start at once. At least one.
+     * \param aStartsPerSecond Syncs started per second once the burst is
+     *  used. Zero or less means no limit.
+     * \param aMaxJitter Maximum random start delay in milliseconds. Zero
+     *  or less disables the jitter.
+     */
+    void setPolicy(int aBurst, int aStartsPerSecond, int aMaxJitter);
+
+    /*! \brief Seeds the jitter generator.
+     *
+     * \param aSeed Seed, used by tests to get reproducible delays.
+     */
+    void setSeed(quint32 aSeed);
+
+    /*! \brief Adds a profile to the ramp.
+     *
+     * A profile already in the ramp keeps its place.
+     * \param aProfileName Name of the profile.
+     * \param aLastSuccess Time of the last successful sync of the profile.
+     *  Invalid if the profile has never been synced successfully.
+     * \param aNow Current time in milliseconds.
+     */
+    void add(const QString &aProfileName, const QDateTime &aLastSuccess, qint64 aNow);
+
+    /*! \brief Removes a profile from the ramp without releasing it.
+     *
+     * \param aProfileName Name of the profile.
+     */
+    void remove(const QString &aProfileName);
+
+    /*! \brief Drops all waiting profiles, for example when the device goes
+     *  offline again.
+     */
+    void clear();
+
+    /*! \brief Checks if the ramp has waiting profiles.
+     *
+     * \return True if no profile is waiting.
+     */
+    bool isEmpty() const;
+
+    /*! \brief Takes the profiles that may start now.
+     *
+     * \param aNow Current time in milliseconds.
+     * \return Profiles to start, stalest first.
+     */
+    QStringList takeDue(qint64 aNow);
+
+    /*! \brief Gets the time until the next profile may start.
+     *
+     * \param aNow Current time in milliseconds.
+     * \return Milliseconds until the next call to takeDue() can release a
+     *  profile, -1 if no profile is waiting.
+     */
+    qint64 msecsToNext(qint64 aNow) const;
+
+    /*! \brief Records that the sync of a released profile finished.
+     *
+     * \param aProfileName Name of the profile.
+     * \param aNow Current time in milliseconds.
+     */
+    void finished(const QString &aProfileName, qint64 aNow);
+
+    /*! \brief Gets the ramp statistics.
+     *
+     * The statistics contain the policy, the number of released syncs,
+     * the peak number of released syncs running at once and the time from
+     * the start of the last ramp until all its syncs had finished.
+     * \return Statistics by name.
+     */
+    QVariantMap statistics() const;
+
+private:
+    struct Entry {
+        qint64 iReadyAt;
+        qint64 iLastSuccess;
+    };
+
+    void refill(qint64 aNow);
+
+    int iBurst;
+    int iStartsPerSecond;
+    int iMaxJitter;
+    std::minstd_rand iRandom;
+
+    QHash<QString, Entry> iWaiting;
+
+    // Released profiles whose sync has not finished yet.
+    QSet<QString> iRunning;
+
+    double iTokens;
+    qint64 iRefilledAt;
+
+    qint64 iRampStart;
+    qint64 iLastRampDuration;
+    int iRamps;
+    int iReleased;
+    int iPeakRunning;
+    int iLastRampPeak;
+};
+
+}
+
+#endif // ONLINESYNCRAMP_H
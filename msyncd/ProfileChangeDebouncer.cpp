@@ -0,0 +1,154 @@
+/*
+ * This file is part of buteo-syncfw package
+ *
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include "ProfileChangeDebouncer.h"
+#include "LogMacros.h"
+#include <algorithm>
+#include <functional>
+
+using namespace Buteo;
+
+typedef QPair<qint64, QString> HeapEntry;
+
+const int ProfileChangeDebouncer::DEFAULT_QUIET_PERIOD = 30000;
+const int ProfileChangeDebouncer::DEFAULT_MAX_WAIT = 300000;
+
+ProfileChangeDebouncer::ProfileChangeDebouncer()
+    : iQuietPeriod(DEFAULT_QUIET_PERIOD),
+      iMaxWait(DEFAULT_MAX_WAIT),
+      iChanges(0),
+      iCollapsed(0),
+      iDue(0),
+      iCapped(0)
+{
+}
+
+void ProfileChangeDebouncer::setDelays(int aQuietPeriod, int aMaxWait)
+{
+    iQuietPeriod = qMax(aQuietPeriod, 0);
+    iMaxWait = qMax(aMaxWait, iQuietPeriod);
+    qCDebug(lcButeoMsyncd) << "Profile change quiet period" << iQuietPeriod << "ms, max wait" << iMaxWait << "ms";
+}
+
+void ProfileChangeDebouncer::changed(const QString &aProfileName, ProfileManager::ProfileChangeType aType,
+                                     qint64 aNow)
+{
+    ++iChanges;
+
+    QHash<QString, Pending>::iterator it = iPending.find(aProfileName);
+    if (it == iPending.end()) {
+        Pending pending;
+        pending.iType = aType;
+        pending.iFirstChange = aNow;
+        pending.iDeadline = aNow + iQuietPeriod;
+        it = iPending.insert(aProfileName, pending);
+    } else {
+        ++iCollapsed;
+        if (aType == ProfileManager::PROFILE_ADDED) {
+            it->iType = aType;
+        }
+        const qint64 deadline = qMin(aNow + iQuietPeriod, it->iFirstChange + iMaxWait);
+        if (deadline == it->iDeadline) {
+            return;
+        }
+        it->iDeadline = deadline;
+    }
+
+    iHeap.append(HeapEntry(it->iDeadline, aProfileName));
+    std::push_heap(iHeap.begin(), iHeap.end(), std::greater<HeapEntry>());
+
+    // Rebuild the heap when most of it is stale.
+    if (iHeap.size() > 2 * iPending.size() + 16) {
+        iHeap.clear();
+        for (QHash<QString, Pending>::const_iterator i = iPending.constBegin(); i != iPending.constEnd(); ++i) {
+            iHeap.append(HeapEntry(i->iDeadline, i.key()));
+        }
+        std::make_heap(iHeap.begin(), iHeap.end(), std::greater<HeapEntry>());
+    }
+}
+
+bool ProfileChangeDebouncer::remove(const QString &aProfileName)
+{
+    // The heap entry goes stale and is dropped later.
+    return iPending.remove(aProfileName) > 0;
+}
+
+bool ProfileChangeDebouncer::contains(const QString &aProfileName) const
+{
+    return iPending.contains(aProfileName);
+}
+
+QList<ProfileChangeDebouncer::Change> ProfileChangeDebouncer::takeDue(qint64 aNow)
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    QList<Change> due;
+    dropStale();
+    while (!iHeap.isEmpty() && iHeap.first().first <= aNow) {
+        const QString profileName = iHeap.first().second;
+        std::pop_heap(iHeap.begin(), iHeap.end(), std::greater<HeapEntry>());
+        iHeap.removeLast();
+
+        const Pending pending = iPending.take(profileName);
+        if (pending.iDeadline == pending.iFirstChange + iMaxWait && iMaxWait > iQuietPeriod) {
+            ++iCapped;
+        }
+        due.append(Change(profileName, pending.iType));
+        dropStale();
+    }
+
+    iDue += due.size();
+    return due;
+}
+
+qint64 ProfileChangeDebouncer::msecsToNext(qint64 aNow)
+{
+    dropStale();
+    if (iHeap.isEmpty()) {
+        return -1;
+    }
+    return qMax(iHeap.first().first - aNow, qint64(0));
+}
+
+QVariantMap ProfileChangeDebouncer::statistics() const
+{
+    QVariantMap stats;
+    stats.insert("profileChangeQuietPeriodMs", iQuietPeriod);
+    stats.insert("profileChangeMaxWaitMs", iMaxWait);
+    stats.insert("profileChanges", iChanges);
+    stats.insert("profileChangesCollapsed", iCollapsed);
+    stats.insert("profileChangesTriggered", iDue);
+    stats.insert("profileChangesCapped", iCapped);
+    stats.insert("profileChangesPending", iPending.size());
+    return stats;
+}
+
+void ProfileChangeDebouncer::dropStale()
+{
+    while (!iHeap.isEmpty()) {
+        QHash<QString, Pending>::const_iterator it = iPending.constFind(iHeap.first().second);
+        if (it != iPending.constEnd() && it->iDeadline == iHeap.first().first) {
+            break;
+        }
+        std::pop_heap(iHeap.begin(), iHeap.end(), std::greater<HeapEntry>());
+        iHeap.removeLast();
+    }
+}
@@ -0,0 +1,146 @@
+/*
+ * This file is part of buteo-syncfw package
+ *
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+#ifndef PROFILECHANGEDEBOUNCER_H
+#define PROFILECHANGEDEBOUNCER_H
+
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QVariantMap>
+#include <QVector>
+#include "ProfileManager.h"
+
+namespace Buteo {
+
+/*! \brief Delays the syncs triggered by profile changes until the profile
+ *  has been quiet for a while.
+ *
+ * Each changed profile has its own deadline. Another change to the profile
+ * moves the deadline to a quiet period after the change, but never beyond
+ * the maximum wait after the first pending change, so that a steady stream
+ * of edits can not postpone the sync forever. Repeated changes collapse to
+ * one pending change; an addition followed by modifications stays an
+ * addition.
+ *
+ * The debouncer does not own a timer. Times are monotonic milliseconds
+ * passed in by the caller, which handles the changes returned by takeDue()
+ * and calls it again after msecsToNext().
+ */
+class ProfileChangeDebouncer
+{
+public:
+    //! A due change, the profile name and the change type.
+    typedef QPair<QString, ProfileManager::ProfileChangeType> Change;
+
+    //! Default quiet period in milliseconds.
+    static const int DEFAULT_QUIET_PERIOD;
+
+    //! Default maximum wait in milliseconds.
+    static const int DEFAULT_MAX_WAIT;
+
+    //! \brief Constructor
+    ProfileChangeDebouncer();
+
+    /*! \brief Sets the delays.
+     *
+     * Pending changes keep their deadlines.
+     * \param aQuietPeriod Time a profile must stay unchanged before its
+     *  change is due, in milliseconds.
+     * \param aMaxWait Maximum time from the first pending change of a
+     *  profile until the change is due, in milliseconds. Not less than the
+     *  quiet period.
+     */
+    void setDelays(int aQuietPeriod, int aMaxWait);
+
+    /*! \brief Records a change to a profile.
+     *
+     * \param aProfileName Name of the profile.
+     * \param aType Type of the change, PROFILE_ADDED or PROFILE_MODIFIED.
+     * \param aNow Current time in milliseconds.
+     */
+    void changed(const QString &aProfileName, ProfileManager::ProfileChangeType aType, qint64 aNow);
+
+    /*! \brief Drops the pending change of a profile.
+     *
+     * \param aProfileName Name of the profile.
+     * \return True if the profile had a pending change.
+     */
+    bool remove(const QString &aProfileName);
+
+    /*! \brief Checks if a profile has a pending change.
+     *
+     * \param aProfileName Name of the profile.
+     * \return True if a change is pending.
+     */
+    bool contains(const QString &aProfileName) const;
+
+    /*! \brief Takes the changes that are due.
+     *
+     * \param aNow Current time in milliseconds.
+     * \return Due changes, earliest deadline first.
+     */
+    QList<Change> takeDue(qint64 aNow);
+
+    /*! \brief Gets the time until the next change is due.
+     *
+     * \param aNow Current time in milliseconds.
+     * \return Milliseconds until the next deadline, -1 if no change is
+     *  pending.
+     */
+    qint64 msecsToNext(qint64 aNow);
+
+    /*! \brief Gets the debouncer statistics.
+     *
+     * The statistics contain the delays, the number of recorded and
+     * collapsed changes, the number of changes that were due, and how many
+     * of them were cut short by the maximum wait.
+     * \return Statistics by name.
+     */
+    QVariantMap statistics() const;
+
+private:
+    struct Pending {
+        ProfileManager::ProfileChangeType iType;
+        qint64 iFirstChange;
+        qint64 iDeadline;
+    };
+
+    void dropStale();
+
+    int iQuietPeriod;
+    int iMaxWait;
+
+    QHash<QString, Pending> iPending;
+
+    // Min-heap of (deadline, profile). Entries whose deadline no longer
+    // matches iPending are stale and skipped.
+    QVector<QPair<qint64, QString> > iHeap;
+
+    int iChanges;
+    int iCollapsed;
+    int iDue;
+    int iCapped;
+};
+
+}
+
+#endif // PROFILECHANGEDEBOUNCER_H
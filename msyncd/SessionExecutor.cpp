@@ -0,0 +1,252 @@
+/*
+ * This file is part of buteo-syncfw package
+ *
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include "SessionExecutor.h"
+#include "SyncSession.h"
+#include "SyncProfile.h"
+#include "ProfileEngineDefs.h"
+#include "LogMacros.h"
+
+using namespace Buteo;
+
+const int SessionExecutor::DEFAULT_MAX_SESSIONS = 0;
+const int SessionExecutor::DEFAULT_MAX_SESSIONS_PER_CLIENT = 1;
+const int SessionExecutor::DEFAULT_MAX_SESSIONS_PER_HOST = 0;
+const QString SessionExecutor::GLOBAL_SLOTS("sessions");
+
+static const QString CLIENT_SLOTS_PREFIX("client:");
+static const QString HOST_SLOTS_PREFIX("host:");
+
+SessionExecutor::SessionExecutor()
+    : iMaxSessions(DEFAULT_MAX_SESSIONS),
+      iMaxPerClient(DEFAULT_MAX_SESSIONS_PER_CLIENT),
+      iMaxPerHost(DEFAULT_MAX_SESSIONS_PER_HOST),
+      iLastChange(0),
+      iBusyTime(0),
+      iPeakRunning(0),
+      iAdmitted(0),
+      iTotalWait(0),
+      iMaxWait(0),
+      iGlobalDeferrals(0),
+      iClientDeferrals(0),
+      iHostDeferrals(0)
+{
+    iClock.start();
+}
+
+void SessionExecutor::setLimits(int aMaxSessions, int aMaxPerClient, int aMaxPerHost)
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    updateBusyTime();
+    iMaxSessions = aMaxSessions;
+    iMaxPerClient = aMaxPerClient;
+    iMaxPerHost = aMaxPerHost;
+    qCDebug(lcButeoMsyncd) << "Session limits: total" << iMaxSessions << "per client" << iMaxPerClient
+                           << "per host" << iMaxPerHost;
+}
+
+bool SessionExecutor::canStart(const SyncSession *aSession, QString *aBlockedOn)
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    if (iMaxSessions > 0 && iRunning.size() >= iMaxSessions) {
+        qCDebug(lcButeoMsyncd) << "All" << iMaxSessions << "session slots in use";
+        deferred(aSession->profileName(), GLOBAL_SLOTS, iGlobalDeferrals);
+        if (aBlockedOn) {
+            *aBlockedOn = GLOBAL_SLOTS;
+        }
+        return false;
+    }
+
+    Slots pools = slotsFor(aSession);
+    if (iMaxPerClient > 0 && !pools.iClient.isEmpty()
+            && iClientCount.value(pools.iClient) >= iMaxPerClient) {
+        qCDebug(lcButeoMsyncd) << "All session slots of client" << pools.iClient << "in use";
+        deferred(aSession->profileName(), CLIENT_SLOTS_PREFIX + pools.iClient, iClientDeferrals);
+        if (aBlockedOn) {
+            *aBlockedOn = CLIENT_SLOTS_PREFIX + pools.iClient;
+        }
+        return false;
+    }
+    if (iMaxPerHost > 0 && !pools.iHost.isEmpty()
+            && iHostCount.value(pools.iHost) >= iMaxPerHost) {
+        qCDebug(lcButeoMsyncd) << "All session slots of host" << pools.iHost << "in use";
+        deferred(aSession->profileName(), HOST_SLOTS_PREFIX + pools.iHost, iHostDeferrals);
+        if (aBlockedOn) {
+            *aBlockedOn = HOST_SLOTS_PREFIX + pools.iHost;
+        }
+        return false;
+    }
+
+    return true;
+}
+
+void SessionExecutor::queued(const QString &aProfileName)
+{
+    if (!iQueuedAt.contains(aProfileName)) {
+        iQueuedAt.insert(aProfileName, iClock.elapsed());
+    }
+}
+
+void SessionExecutor::unqueued(const QString &aProfileName)
+{
+    iQueuedAt.remove(aProfileName);
+    iDeferredBy.remove(aProfileName);
+}
+
+void SessionExecutor::started(const SyncSession *aSession)
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    const QString profileName = aSession->profileName();
+    if (iRunning.contains(profileName)) {
+        return;
+    }
+
+    updateBusyTime();
+
+    Slots pools = slotsFor(aSession);
+    iRunning.insert(profileName, pools);
+    if (!pools.iClient.isEmpty()) {
+        ++iClientCount[pools.iClient];
+    }
+    if (!pools.iHost.isEmpty()) {
+        ++iHostCount[pools.iHost];
+    }
+    iPeakRunning = qMax(iPeakRunning, iRunning.size());
+    iDeferredBy.remove(profileName);
+
+    ++iAdmitted;
+    QHash<QString, qint64>::iterator queuedAt = iQueuedAt.find(profileName);
+    if (queuedAt != iQueuedAt.end()) {
+        qint64 wait = iClock.elapsed() - queuedAt.value();
+        iTotalWait += wait;
+        iMaxWait = qMax(iMaxWait, wait);
+        iQueuedAt.erase(queuedAt);
+        qCDebug(lcButeoMsyncd) << "Session" << profileName << "waited" << wait << "ms in queue";
+    }
+}
+
+QStringList SessionExecutor::finished(const QString &aProfileName)
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    QStringList freed;
+    QHash<QString, Slots>::iterator i = iRunning.find(aProfileName);
+    if (i == iRunning.end()) {
+        return freed;
+    }
+
+    updateBusyTime();
+
+    const Slots &pools = i.value();
+    freed << GLOBAL_SLOTS;
+    if (!pools.iClient.isEmpty()) {
+        freed << CLIENT_SLOTS_PREFIX + pools.iClient;
+        if (--iClientCount[pools.iClient] <= 0) {
+            iClientCount.remove(pools.iClient);
+        }
+    }
+    if (!pools.iHost.isEmpty()) {
+        freed << HOST_SLOTS_PREFIX + pools.iHost;
+        if (--iHostCount[pools.iHost] <= 0) {
+            iHostCount.remove(pools.iHost);
+        }
+    }
+    iRunning.erase(i);
+    return freed;
+}
+
+int SessionExecutor::runningCount() const
+{
+    return iRunning.size();
+}
+
+QVariantMap SessionExecutor::statistics() const
+{
+    const qint64 now = iClock.elapsed();
+    const qint64 busyTime = iBusyTime + iRunning.size() * (now - iLastChange);
+
+    QVariantMap stats;
+    stats.insert("maxSessions", iMaxSessions);
+    stats.insert("maxSessionsPerClient", iMaxPerClient);
+    stats.insert("maxSessionsPerHost", iMaxPerHost);
+    stats.insert("runningSessions", iRunning.size());
+    stats.insert("queuedSessions", iQueuedAt.size());
+    stats.insert("peakRunningSessions", iPeakRunning);
+    stats.insert("startedSessions", iAdmitted);
+    stats.insert("globalLimitDeferrals", iGlobalDeferrals);
+    stats.insert("clientLimitDeferrals", iClientDeferrals);
+    stats.insert("hostLimitDeferrals", iHostDeferrals);
+    stats.insert("totalQueueWaitMs", iTotalWait);
+    stats.insert("maxQueueWaitMs", iMaxWait);
+    stats.insert("averageQueueWaitMs", iAdmitted > 0 ? iTotalWait / iAdmitted : 0);
+    stats.insert("averageRunningSessions", now > 0 ? double(busyTime) / now : 0.0);
+    if (iMaxSessions > 0) {
+        stats.insert("slotUtilization", now > 0 ? double(busyTime) / (double(now) * iMaxSessions) : 0.0);
+    }
+    return stats;
+}
+
+SessionExecutor::Slots SessionExecutor::slotsFor(const SyncSession *aSession)
+{
+    Slots pools;
+    const SyncProfile *profile = aSession->profile();
+    if (profile == 0) {
+        return pools;
+    }
+
+    const Profile *client = profile->clientProfile();
+    if (client) {
+        pools.iClient = client->name();
+    }
+
+    pools.iHost = profile->key(KEY_REMOTE_HOST);
+    if (pools.iHost.isEmpty()) {
+        pools.iHost = profile->key(KEY_BT_ADDRESS);
+    }
+    if (pools.iHost.isEmpty()) {
+        const QString accountId = profile->key(KEY_ACCOUNT_ID);
+        if (!accountId.isEmpty()) {
+            pools.iHost = QStringLiteral("account:") + accountId;
+        }
+    }
+    return pools;
+}
+
+void SessionExecutor::deferred(const QString &aProfileName, const QString &aPool, int &aDeferrals)
+{
+    // The queue is scanned on every freed slot, count each waiting session
+    // only once per pool.
+    QSet<QString> &pools = iDeferredBy[aProfileName];
+    if (!pools.contains(aPool)) {
+        pools.insert(aPool);
+        ++aDeferrals;
+    }
+}
+
+void SessionExecutor::updateBusyTime()
+{
+    const qint64 now = iClock.elapsed();
+    iBusyTime += iRunning.size() * (now - iLastChange);
+    iLastChange = now;
+}
@@ -0,0 +1,174 @@
+/*
+ * This file is part of buteo-syncfw package
+ *
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+#ifndef SESSIONEXECUTOR_H
+#define SESSIONEXECUTOR_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+
+namespace Buteo {
+
+class SyncSession;
+
+/*! \brief Limits the number of sync sessions running in parallel.
+ *
+ * A session needs a free slot in each of three pools before it can start:
+ * the global pool, the pool of its client plugin and the pool of its remote
+ * host. The remote host of a profile is the value of its remote_host key,
+ * or its Bluetooth address, or its account, in this order of preference.
+ * Sessions that can not start wait in the sync queue and are admitted in
+ * priority order as slots are freed.
+ *
+ * The executor also collects statistics about how long sessions wait in
+ * the queue and how much of the global slot capacity is in use.
+ */
+class SessionExecutor
+{
+public:
+    //! Default limit for the number of sessions running at once, no limit.
+    static const int DEFAULT_MAX_SESSIONS;
+
+    //! Default limit for the sessions of one client plugin, one session as
+    //! a client plugin has always been limited to.
+    static const int DEFAULT_MAX_SESSIONS_PER_CLIENT;
+
+    //! Default limit for the sessions with one remote host, no limit.
+    static const int DEFAULT_MAX_SESSIONS_PER_HOST;
+
+    //! \brief Constructor
+    SessionExecutor();
+
+    /*! \brief Sets the concurrency limits.
+     *
+     * Running sessions are not affected, the limits apply to sessions
+     * started after this call.
+     * \param aMaxSessions Maximum number of sessions. Zero or less means
+     *  no limit.
+     * \param aMaxPerClient Maximum number of sessions per client plugin.
+     *  Zero or less means no limit.
+     * \param aMaxPerHost Maximum number of sessions per remote host. Zero
+     *  or less means no limit.
+     */
+    void setLimits(int aMaxSessions, int aMaxPerClient, int aMaxPerHost);
+
+    //! Slot pool key of the global session limit.
+    static const QString GLOBAL_SLOTS;
+
+    /*! \brief Checks if there are free slots for the session.
+     *
+     * \param aSession The session to check.
+     * \param aBlockedOn If the session can not start, set to the key of the
+     *  slot pool that is full. The key is one of those returned by
+     *  finished() when a slot in the pool becomes free.
+     * \return True if the session can be started now.
+     */
+    bool canStart(const SyncSession *aSession, QString *aBlockedOn = 0);
+
+    /*! \brief Records that a session was put to the sync queue.
+     *
+     * \param aProfileName Name of the session profile.
+     */
+    void queued(const QString &aProfileName);
+
+    /*! \brief Records that a queued session was removed from the queue
+     *  without starting it.
+     *
+     * \param aProfileName Name of the session profile.
+     */
+    void unqueued(const QString &aProfileName);
+
+    /*! \brief Takes slots for a session that was started.
+     *
+     * Sessions started by remote parties are also recorded, although they
+     * are not checked against the limits.
+     * \param aSession The started session.
+     */
+    void started(const SyncSession *aSession);
+
+    /*! \brief Frees the slots of a finished session.
+     *
+     * \param aProfileName Name of the session profile.
+     * \return Keys of the slot pools that got a free slot.
+     */
+    QStringList finished(const QString &aProfileName);
+
+    /*! \brief Number of sessions holding slots.
+     *
+     * \return Number of running sessions.
+     */
+    int runningCount() const;
+
+    /*! \brief Gets the executor statistics.
+     *
+     * The statistics contain the limits, the number of running and peak
+     * sessions, the number of sessions each limit has deferred, the
+     * total, maximum and average queue wait in milliseconds, and the
+     * average utilisation of the global slots since start-up.
+     * \return Statistics by name.
+     */
+    QVariantMap statistics() const;
+
+private:
+    struct Slots {
+        QString iClient;
+        QString iHost;
+    };
+
+    static Slots slotsFor(const SyncSession *aSession);
+
+    void deferred(const QString &aProfileName, const QString &aPool, int &aDeferrals);
+
+    void updateBusyTime();
+
+    int iMaxSessions;
+    int iMaxPerClient;
+    int iMaxPerHost;
+
+    // Slots held by each running session.
+    QHash<QString, Slots> iRunning;
+    QHash<QString, int> iClientCount;
+    QHash<QString, int> iHostCount;
+
+    // Queueing time of each waiting session.
+    QHash<QString, qint64> iQueuedAt;
+
+    // Pools each waiting session has been counted as deferred by.
+    QHash<QString, QSet<QString> > iDeferredBy;
+
+    QElapsedTimer iClock;
+    qint64 iLastChange;
+    qint64 iBusyTime;
+    int iPeakRunning;
+    int iAdmitted;
+    qint64 iTotalWait;
+    qint64 iMaxWait;
+    int iGlobalDeferrals;
+    int iClientDeferrals;
+    int iHostDeferrals;
+};
+
+}
+
+#endif // SESSIONEXECUTOR_H
@@ -38,56 +38,94 @@ StorageBooker::~StorageBooker()
 }
 
 bool StorageBooker::reserveStorage(const QString &aStorageName,
-                                   const QString &aClientId)
+                                   const QString &aClientId,
+                                   ReservationMode aMode)
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
 
     QMutexLocker locker(&iMutex);
 
-    bool success = false;
+    if (!isStorageAvailable(aStorageName, aClientId, aMode)) {
+        // Reserved for a different client, or readers are held back for a
+        // waiting writer.
+        if (aMode == Exclusive) {
+            addWaitingWriter(aStorageName, aClientId);
+        }
+        return false;
+    }
 
-    if (iStorageMap.contains(aStorageName)) {
-        StorageMapItem item = iStorageMap[aStorageName];
-        if (aClientId.isEmpty() || aClientId != item.iClientId) {
-            // Already reserved for different client.
-            success = false;
+    StorageMapItem &item = iStorageMap[aStorageName];
+    if (item.iRefCount == 0) {
+        // No reservations for the storage yet.
+        if (aMode == Exclusive) {
+            item.iClientId = aClientId;
         } else {
-            // Already reserved for the same client. Increase ref count.
-            item.iRefCount++;
-            iStorageMap[aStorageName] = item;
-            success = true;
+            item.iReaders.insert(aClientId, 1);
+        }
+    } else if (!item.iReaders.isEmpty()) {
+        if (aMode == Exclusive) {
+            // Upgrade by the only reader, other readers are refused from
+            // now on.
+            item.iClientId = aClientId;
+            item.iReaders.clear();
+        } else {
+            // Shared by readers, add a shared reference for this one.
+            item.iReaders[aClientId]++;
         }
-    } else {
-        // No reservations for the storage. Add a new entry to the storage
-        // reservation map.
-        iStorageMap.insert(aStorageName, aClientId);
-        success = true;
     }
+    // Otherwise already reserved exclusively for the same client.
+    item.iRefCount++;
 
-    return success;
+    if (aMode == Exclusive) {
+        removeWaitingWriter(aStorageName, aClientId);
+    }
+
+    return true;
 }
 
 bool StorageBooker::reserveStorages(const QStringList &aStorageNames,
-                                    const QString &aClientId)
+                                    const QString &aClientId,
+                                    ReservationMode aMode)
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
 
     QMutexLocker locker(&iMutex);
 
     bool success = false;
-    if (storagesAvailable(aStorageNames, aClientId)) {
+    if (storagesAvailable(aStorageNames, aClientId, aMode)) {
         foreach (QString storage, aStorageNames) {
-            reserveStorage(storage, aClientId);
+            reserveStorage(storage, aClientId, aMode);
+        }
+        if (!aClientId.isEmpty()) {
+            iClientModes.insert(aClientId, aMode);
         }
         success = true;
     } else {
+        if (aMode == Exclusive) {
+            foreach (QString storage, aStorageNames) {
+                if (!isStorageAvailable(storage, aClientId, aMode))
+                    addWaitingWriter(storage, aClientId);
+            }
+        }
         success = false;
     }
 
     return success;
 }
 
-unsigned StorageBooker::releaseStorage(const QString &aStorageName)
+bool StorageBooker::reserveClientStorage(const QString &aStorageName,
+                                         const QString &aClientId)
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    QMutexLocker locker(&iMutex);
+
+    return reserveStorage(aStorageName, aClientId,
+                          iClientModes.value(aClientId, Exclusive));
+}
+
+unsigned StorageBooker::releaseStorage(const QString &aStorageName,
+                                       const QString &aClientId)
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
 
@@ -95,56 +133,140 @@ unsigned StorageBooker::releaseStorage(const QString &aStorageName)
 
     unsigned remainingRefCount = 0;
 
-    if (iStorageMap.contains(aStorageName)) {
-        StorageMapItem item = iStorageMap[aStorageName];
+    QMap<QString, StorageMapItem>::iterator i = iStorageMap.find(aStorageName);
+    if (i != iStorageMap.end()) {
+        StorageMapItem &item = i.value();
+        if (!item.iReaders.isEmpty()) {
+            QHash<QString, unsigned>::iterator reader = item.iReaders.find(aClientId);
+            if (reader == item.iReaders.end() && aClientId.isEmpty()) {
+                // Caller does not know the client, release any reader.
+                reader = item.iReaders.begin();
+            }
+            if (reader == item.iReaders.end()) {
+                qCWarning(lcButeoMsyncd) << "Storage" << aStorageName
+                                         << "is not shared by" << aClientId;
+                return item.iRefCount;
+            }
+            if (--reader.value() == 0) {
+                item.iReaders.erase(reader);
+            }
+        }
         item.iRefCount--;
         remainingRefCount = item.iRefCount;
 
         if (remainingRefCount == 0) {
-            iStorageMap.remove(aStorageName);
-        } else {
-            iStorageMap[aStorageName] = item;
+            iStorageMap.erase(i);
+            emit storageReleased(aStorageName);
         }
     }
 
     return remainingRefCount;
 }
 
-void StorageBooker::releaseStorages(const QStringList &aStorageNames)
+void StorageBooker::releaseStorages(const QStringList &aStorageNames,
+                                    const QString &aClientId)
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
 
     QMutexLocker locker(&iMutex);
 
     foreach (QString storage, aStorageNames) {
-        releaseStorage(storage);
+        releaseStorage(storage, aClientId);
     }
 }
 
+void StorageBooker::withdraw(const QString &aClientId)
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    QMutexLocker locker(&iMutex);
+
+    foreach (const QString &storage, iWaitingWriters.keys()) {
+        if (removeWaitingWriter(storage, aClientId)) {
+            // Readers held back for the writers can now be let in, also
+            // when the storage was released while the writers waited.
+            emit storageReleased(storage);
+        }
+    }
+    iClientModes.remove(aClientId);
+}
+
 bool StorageBooker::isStorageAvailable(const QString &aStorageName,
-                                       const QString &aClientId) const
+                                       const QString &aClientId,
+                                       ReservationMode aMode) const
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
 
     QMutexLocker locker(&iMutex);
 
-    return (!iStorageMap.contains(aStorageName) ||
-            (!aClientId.isEmpty() &&
-             (aClientId == iStorageMap[aStorageName].iClientId)));
+    QMap<QString, StorageMapItem>::const_iterator i = iStorageMap.constFind(aStorageName);
+    if (i == iStorageMap.constEnd()) {
+        return aMode == Exclusive || !writerWaiting(aStorageName, aClientId);
+    }
+
+    const StorageMapItem &item = i.value();
+    if (item.iReaders.isEmpty()) {
+        // Reserved exclusively.
+        return !aClientId.isEmpty() && aClientId == item.iClientId;
+    }
 
+    // Shared by readers. An exclusive reservation is an upgrade, only
+    // possible for the only reader. An existing reader may always add
+    // shared references, so that readers can not deadlock against a writer
+    // waiting for them.
+    if (aMode == Exclusive) {
+        return !aClientId.isEmpty() && item.iReaders.size() == 1 &&
+               item.iReaders.contains(aClientId);
+    }
+    return item.iReaders.contains(aClientId) || !writerWaiting(aStorageName, aClientId);
 }
 
 bool StorageBooker::storagesAvailable(const QStringList &aStorageNames,
-                                      const QString &aClientId) const
+                                      const QString &aClientId,
+                                      ReservationMode aMode) const
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
 
     QMutexLocker locker(&iMutex);
 
     foreach (QString storage, aStorageNames) {
-        if (!isStorageAvailable(storage, aClientId))
+        if (!isStorageAvailable(storage, aClientId, aMode))
             return false;
     }
 
     return true;
 }
+
+bool StorageBooker::writerWaiting(const QString &aStorageName,
+                                  const QString &aClientId) const
+{
+    QMap<QString, QSet<QString> >::const_iterator i = iWaitingWriters.constFind(aStorageName);
+    if (i == iWaitingWriters.constEnd()) {
+        return false;
+    }
+    return i.value().size() > (i.value().contains(aClientId) ? 1 : 0);
+}
+
+void StorageBooker::addWaitingWriter(const QString &aStorageName,
+                                     const QString &aClientId)
+{
+    // Anonymous clients can not withdraw, so they never hold readers back.
+    if (!aClientId.isEmpty()) {
+        iWaitingWriters[aStorageName].insert(aClientId);
+    }
+}
+
+bool StorageBooker::removeWaitingWriter(const QString &aStorageName,
+                                        const QString &aClientId)
+{
+    QMap<QString, QSet<QString> >::iterator i = iWaitingWriters.find(aStorageName);
+    if (i == iWaitingWriters.end() || !i.value().remove(aClientId)) {
+        return false;
+    }
+
+    if (i.value().isEmpty()) {
+        iWaitingWriters.erase(i);
+        return true;
+    }
+    return false;
+}
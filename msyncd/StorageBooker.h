@@ -23,19 +23,40 @@
 #ifndef STORAGEBOOKER_H
 #define STORAGEBOOKER_H
 
+#include <QObject>
 #include <QString>
 #include <QStringList>
 #include <QMap>
+#include <QHash>
+#include <QSet>
 #include <QMutex>
 
 namespace Buteo {
 
 /*! \brief A helper class for managing storage reservations.
  *
+ * A storage can be reserved either exclusively for one client, or shared
+ * by any number of clients that only read from it. A client that fails to
+ * get an exclusive reservation is remembered as a waiting writer, and new
+ * shared reservations by other clients are refused until it has got the
+ * storage or withdrawn, so that a steady flow of readers can not starve it.
+ *
+ * Reservations can be made from plugin threads, so anything connected to
+ * the storageReleased signal should use a queued connection.
  */
-class StorageBooker
+class StorageBooker : public QObject
 {
+    Q_OBJECT
+
 public:
+    //! Reservation modes.
+    enum ReservationMode {
+        //! The client may modify the storage, no other client can use it.
+        Exclusive,
+        //! The client only reads the storage, other readers can share it.
+        Shared
+    };
+
     //! \brief Constructor
     StorageBooker();
 
@@ -49,13 +70,20 @@ public:
      * The same client can call reserve multiple times. Internal reference
      * counter is increased in that case. For each reserve there must be a
      * release call later. Other clients calling reserve for the same storage
-     * will fail, while the storage is reserved to some other client.
+     * will fail, while the storage is reserved to some other client, unless
+     * both reserve it in Shared mode and no writer is waiting for it.
+     * A client already holding the storage can always add shared references
+     * to it. An exclusive reservation by a client that shares the storage
+     * upgrades the reservation, which is only possible if no other client
+     * shares it. Until then the client waits like any writer.
      * \param aStorageName Name of the requested storage.
      * \param aClientId ID of the requesting client.
+     * \param aMode Reservation mode.
      * \return Success indicator.
      */
     bool reserveStorage(const QString &aStorageName,
-                        const QString &aClientId = "");
+                        const QString &aClientId = "",
+                        ReservationMode aMode = Exclusive);
 
     /*! \brief Tries to reserve multiple storages for the given client.
      *
@@ -65,58 +93,123 @@ public:
      * If the reserve fails, no storages are reserved.
      * \param aStorageNames Names of the storages to reserve.
      * \param aClientId ID of the requesting client.
+     * \param aMode Reservation mode.
      * \return Success indicator.
      */
     bool reserveStorages(const QStringList &aStorageNames,
-                         const QString &aClientId = "");
+                         const QString &aClientId = "",
+                         ReservationMode aMode = Exclusive);
+
+    /*! \brief Tries to reserve one more storage for the given client.
+     *
+     * Uses the mode of the client's last successful reserveStorages call,
+     * or Exclusive if it has not reserved storages with it. This lets
+     * plugins running in their own threads follow the mode of their
+     * session without looking the session up.
+     * \param aStorageName Name of the requested storage.
+     * \param aClientId ID of the requesting client.
+     * \return Success indicator.
+     */
+    bool reserveClientStorage(const QString &aStorageName,
+                              const QString &aClientId);
 
     /*! \brief Releases the given storage.
      *
      * \param aStorageName Name of the storage to release.
+     * \param aClientId ID of the client holding the reservation. Needed to
+     *  release shared reservations.
      * \return Number of remaining references to the storage. If this is zero,
      *  other clients can now reserve the storage.
      */
-    unsigned releaseStorage(const QString &aStorageName);
+    unsigned releaseStorage(const QString &aStorageName,
+                            const QString &aClientId = "");
 
     /*! \brief Releases the given storages.
      *
      * \param aStorageNames Names of the storages to release.
+     * \param aClientId ID of the client holding the reservations.
      */
-    void releaseStorages(const QStringList &aStorageNames);
+    void releaseStorages(const QStringList &aStorageNames,
+                         const QString &aClientId = "");
+
+    /*! \brief Stops the given client from waiting for exclusive reservations.
+     *
+     * Must be called when a client that failed to reserve a storage
+     * exclusively gives up, so that readers are no longer held back for it.
+     * Also forgets the reservation mode recorded for the client.
+     * \param aClientId ID of the client.
+     */
+    void withdraw(const QString &aClientId);
 
     /*! \brief Checks if the given storage is available for the given client.
      *
      * The storage is available if there are no reservations for it or if the
-     * storage is already reserved for the same client. If the storage is
-     * available, it can be reserved for the client by calling reserve.
+     * storage is already reserved for the same client. In Shared mode the
+     * storage is also available if it is only shared by other readers and
+     * no other client waits for an exclusive reservation of it. In Exclusive
+     * mode a shared storage is only available to its only reader. If the
+     * storage is available, it can be reserved for the client by calling
+     * reserve.
      * \param aStorageName Name of the requested storage.
      * \param aClientId ID of the requesting client.
+     * \param aMode Reservation mode.
      * \return Is the storage available.
      */
     bool isStorageAvailable(const QString &aStorageName,
-                            const QString &aClientId = "") const;
+                            const QString &aClientId = "",
+                            ReservationMode aMode = Exclusive) const;
 
     /*! \brief Checks if the given storages are available for the given client.
      *
      * \param aStorageNames Names of the requested storages.
      * \param aClientId ID of the requesting client.
+     * \param aMode Reservation mode.
      * \return Are the storages available.
      */
     bool storagesAvailable(const QStringList &aStorageNames,
-                           const QString &aClientId = "") const;
+                           const QString &aClientId = "",
+                           ReservationMode aMode = Exclusive) const;
+
+signals:
+    /*! \brief Emitted when the last reservation of a storage is released.
+     *
+     * Also emitted when the last waiting writer of a storage withdraws,
+     * as new readers can then reserve it.
+     * \param aStorageName Name of the storage that became available.
+     */
+    void storageReleased(const QString &aStorageName);
 
 private:
+    bool writerWaiting(const QString &aStorageName,
+                       const QString &aClientId) const;
+
+    void addWaitingWriter(const QString &aStorageName,
+                          const QString &aClientId);
+
+    // Returns true if the client was the last writer waiting for the storage.
+    bool removeWaitingWriter(const QString &aStorageName,
+                             const QString &aClientId);
+
     struct StorageMapItem {
+        // Owner of an exclusive reservation.
         QString iClientId;
+        // Total number of references, exclusive or shared.
         unsigned iRefCount;
+        // Reference counts of shared reservations per client. Empty if the
+        // storage is reserved exclusively.
+        QHash<QString, unsigned> iReaders;
 
         StorageMapItem() : iRefCount(0) { };
-
-        StorageMapItem(const QString &aClientId) :
-            iClientId(aClientId), iRefCount(1) { };
     };
 
     QMap<QString, StorageMapItem> iStorageMap;
+
+    // Clients waiting for an exclusive reservation, per storage.
+    QMap<QString, QSet<QString> > iWaitingWriters;
+
+    // Modes of the clients' reserveStorages calls, for reserveClientStorage.
+    QHash<QString, ReservationMode> iClientModes;
+
     mutable QMutex iMutex;
 };
 
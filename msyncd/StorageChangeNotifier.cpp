@@ -58,6 +58,8 @@ bool StorageChangeNotifier::startListen(QStringList &aFailedStorages)
         if (plugin) {
             QObject::connect(plugin, SIGNAL(storageChange()),
                              this, SLOT(storageChanged()));
+            QObject::connect(plugin, SIGNAL(itemsChanged(QStringList, Buteo::StorageChangeSet::ChangeKind)),
+                             this, SLOT(storageItemsChanged(QStringList, Buteo::StorageChangeSet::ChangeKind)));
             plugin->enable();
         } else {
             aFailedStorages << storageNameItr.key();
@@ -77,6 +79,8 @@ void StorageChangeNotifier::stopListen(bool disableAfterNextChange)
         if (plugin) {
             QObject::disconnect(plugin, SIGNAL(storageChange()),
                                 this, SLOT(storageChanged()));
+            QObject::disconnect(plugin, SIGNAL(itemsChanged(QStringList, Buteo::StorageChangeSet::ChangeKind)),
+                                this, SLOT(storageItemsChanged(QStringList, Buteo::StorageChangeSet::ChangeKind)));
             plugin->disable(disableAfterNextChange);
         }
     }
@@ -88,11 +92,30 @@ void StorageChangeNotifier::storageChanged()
     StorageChangeNotifierPlugin *plugin = qobject_cast<StorageChangeNotifierPlugin *>(sender());
     if (plugin) {
         qCDebug(lcButeoMsyncd) << "Change in storage" << plugin->name();
+        if (!iItemStorages.contains(plugin->name())) {
+            iChanges.setIncomplete(plugin->name());
+        }
         plugin->changesReceived();
         emit storageChange(plugin->name());
     }
 }
 
+void StorageChangeNotifier::storageItemsChanged(const QStringList &aItemIds,
+                                                Buteo::StorageChangeSet::ChangeKind aKind)
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+    StorageChangeNotifierPlugin *plugin = qobject_cast<StorageChangeNotifierPlugin *>(sender());
+    if (plugin) {
+        iItemStorages.insert(plugin->name());
+        iChanges.addChanges(plugin->name(), aItemIds, aKind);
+    }
+}
+
+StorageChangeSet StorageChangeNotifier::takeChanges(const QString &aStorageName)
+{
+    return iChanges.take(aStorageName);
+}
+
 void StorageChangeNotifier::checkForChanges()
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
@@ -101,6 +124,8 @@ void StorageChangeNotifier::checkForChanges()
             storageNameItr != iNotifierMap.end(); ++storageNameItr) {
         plugin = storageNameItr.value();
         if (plugin && plugin->hasChanges()) {
+            // Changes made while not listening were not reported item by item.
+            iChanges.setIncomplete(plugin->name());
             plugin->changesReceived();
             emit storageChange(plugin->name());
         }
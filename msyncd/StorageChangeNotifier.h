@@ -3,6 +3,9 @@
 
 #include <QObject>
 #include <QHash>
+#include <QSet>
+#include <QStringList>
+#include "StorageChangeSet.h"
 
 namespace Buteo {
 
@@ -59,11 +62,26 @@ public:
      */
     void checkForChanges();
 
+    /*! \brief Takes the changes recorded for a storage since the last
+     * call.
+     *
+     * The changes of a storage whose plug-in does not report its items
+     * are incomplete.
+     *
+     * @param aStorageName name of the storage
+     * @return the changes
+     */
+    StorageChangeSet takeChanges(const QString &aStorageName);
+
 private Q_SLOTS:
     /*! \brief process a storage change notification
      */
     void storageChanged();
 
+    /*! \brief record the items a storage reported as changed
+     */
+    void storageItemsChanged(const QStringList &aItemIds, Buteo::StorageChangeSet::ChangeKind aKind);
+
 Q_SIGNALS:
     /*! emit this signal if a storage changed
      *
@@ -74,6 +92,12 @@ Q_SIGNALS:
 private:
     QHash<QString, StorageChangeNotifierPlugin *> iNotifierMap;
     PluginManager *iPluginManager;
+
+    // Changes not yet taken, by storage.
+    StorageChangeSet iChanges;
+
+    // Storages whose plug-ins report changed items.
+    QSet<QString> iItemStorages;
 };
 
 }
@@ -26,18 +26,25 @@
 
 #include <QTimer>
 #include <QObject>
-#include <QSettings>
+#include <QSocketNotifier>
 #include <QDebug>
 #include <LogMacros.h>
 
-const QString ALARM_CONNECTION_NAME("alarms");
+#include <algorithm>
+#include <functional>
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
 
-const int TRIGGER_COUNT = 1;
+typedef QPair<qint64, int> HeapEntry;
 
 SyncAlarmInventory::SyncAlarmInventory()
-    : iTimer(0)
-    , currentAlarm(0)
-    , triggerCount(TRIGGER_COUNT)
+    : iNextAlarmId(1)
+    , iTimerFd(-1)
+    , iTimerNotifier(0)
+    , iTimer(0)
 {
     // empty.explicitly call init
 }
@@ -46,39 +53,19 @@ bool SyncAlarmInventory::init()
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
 
-    static unsigned connectionNumber = 0;
-    iConnectionName = ALARM_CONNECTION_NAME + QString::number(connectionNumber++);
-    iDbHandle = QSqlDatabase::addDatabase("QSQLITE", iConnectionName);
-
-    QString path(Sync::syncConfigDir());
-    path.append(QDir::separator()).append("alarms.db.sqlite");
-    path = QDir::toNativeSeparators(path);
-
-    iDbHandle.setDatabaseName(path);
-
-    if (!iDbHandle.open()) {
-        qCCritical(lcButeoMsyncd) << "Failed to OPEN DB. SCHEDULING WILL NOT WORK";
-        return false;
+    // Create the timer. The realtime clock is used as alarms are wall clock
+    // times, and the timer is cancelled if the clock is set so that it can
+    // be re-armed.
+    iTimerFd = timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (iTimerFd >= 0) {
+        iTimerNotifier = new QSocketNotifier(iTimerFd, QSocketNotifier::Read, this);
+        connect(iTimerNotifier, SIGNAL(activated(int)), this, SLOT(timerTriggered()));
     } else {
-        qCDebug(lcButeoMsyncd) << "DB Opened Successfully";
+        qCWarning(lcButeoMsyncd) << "Failed to create alarm timerfd:" << strerror(errno);
+        iTimer = new QTimer(this);
+        iTimer->setSingleShot(true);
+        connect(iTimer, SIGNAL(timeout()), this, SLOT(timerTriggered()));
     }
-
-    // Create the alarms table
-    const QString createTableQuery("CREATE TABLE IF NOT EXISTS alarms(alarmid INTEGER PRIMARY KEY AUTOINCREMENT, synctime DATETIME)");
-    QSqlQuery query(createTableQuery, iDbHandle);
-    qCDebug(lcButeoMsyncd) << "SQL Query::" << query.lastQuery();
-    if (!query.exec()) {
-        qCWarning(lcButeoMsyncd) << "Failed to execute the createTableQuery";
-        return false;
-    }
-
-    // Clear any old alarms that may have lingered
-    removeAllAlarms();
-
-    // Create the iTimer object
-    iTimer = new QTimer(this);
-    connect(iTimer, SIGNAL(timeout()), this, SLOT(timerTriggered()));
-    currentAlarm = 0;
     return true;
 }
 
@@ -86,9 +73,12 @@ SyncAlarmInventory::~SyncAlarmInventory()
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
 
-    iDbHandle.close();
-    iDbHandle = QSqlDatabase();
-    QSqlDatabase::removeDatabase(iConnectionName);
+    delete iTimerNotifier;
+    iTimerNotifier = 0;
+    if (iTimerFd >= 0) {
+        close(iTimerFd);
+        iTimerFd = -1;
+    }
 
     delete iTimer;
     iTimer = 0;
@@ -105,47 +95,17 @@ int SyncAlarmInventory::addAlarm(QDateTime alarmDate)
         alarmDate = QDateTime::currentDateTime();
     }
 
-    // Store the alarm
-    int alarmId = 0;
-    if ((alarmId = addAlarmToDb(alarmDate)) == 0) {
-        // Note: Even incase of an already existing profile, false is returned by the query
-        // There is no way to detect a record insertion from an already existing alarm
-
-        // If unable to add an alarm to db, set the iTimers
-        // for already existing alarms
-        qCWarning(lcButeoMsyncd) << "(alarmId = addAlarmToDb(alarmDate)) == 0";
-    }
+    int alarmId = iNextAlarmId++;
+    qint64 alarmTime = alarmDate.toMSecsSinceEpoch();
+    iAlarms.insert(alarmId, alarmTime);
+    iHeap.append(HeapEntry(alarmTime, alarmId));
+    std::push_heap(iHeap.begin(), iHeap.end(), std::greater<HeapEntry>());
 
-    // Select all the alarms from the db sorted by alarm time
-    QSqlQuery selectQuery(iDbHandle);
-    if (selectQuery.exec("SELECT alarmid,synctime FROM alarms ORDER BY synctime ASC")) {
-        qCDebug(lcButeoMsyncd) << "SQL Query::" << selectQuery.lastQuery();
-        if (selectQuery.first()) {
-            int newAlarm = selectQuery.value(0).toInt();
-            QDateTime alarmTime = selectQuery.value(1).toDateTime();
-
-            // If the newAlarm != currentAlarm that is fetched from DB, stop the
-            // previous iTimer
-            if ((currentAlarm != 0) && (newAlarm != currentAlarm)) {
-                if (!iTimer->isActive())
-                    iTimer->stop();
-            }
-
-            // This is a new alarm. Set the iTimer for the alarm
-            currentAlarm = newAlarm;
-            QDateTime now = QDateTime::currentDateTime();
-            int iTimerInterval = 0;
-            if (now < alarmTime) {
-                iTimerInterval = (now.secsTo(alarmTime) / TRIGGER_COUNT) * 1000;  // time interval in millisec
-            }
-            qCDebug(lcButeoMsyncd) << "currentAlarm" << currentAlarm << "alarmTime" << alarmTime << "iTimerInterval" << iTimerInterval;
-            triggerCount = TRIGGER_COUNT;
-            iTimer->setInterval(iTimerInterval);
-            iTimer->start();
-        }
-    } else {
-        qCWarning(lcButeoMsyncd) << "Select Query Execution Failed";
+    // Only a new earliest alarm needs the timer to be re-armed.
+    if (iHeap.first().second == alarmId) {
+        armTimer();
     }
+    qCDebug(lcButeoMsyncd) << "Added alarm" << alarmId << "at" << alarmDate;
 
     return alarmId;
 }
@@ -156,7 +116,14 @@ bool SyncAlarmInventory::removeAlarm(int alarmId)
 
     if (alarmId <= 0)
         return false;
-    deleteAlarmFromDb(alarmId);
+
+    if (iAlarms.remove(alarmId) > 0) {
+        // The heap entry is dropped once it reaches the top. If it is there
+        // already, the timer must move to the next alarm.
+        if (!iHeap.isEmpty() && iHeap.first().second == alarmId) {
+            armTimer();
+        }
+    }
     return true;
 }
 
@@ -164,82 +131,73 @@ void SyncAlarmInventory::removeAllAlarms()
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
 
-    QSqlQuery deleteAllQuery(QString("DELETE FROM alarms"), iDbHandle);
-    qCDebug(lcButeoMsyncd) << "SQL Query::" << deleteAllQuery.lastQuery();
-    if (!deleteAllQuery.exec()) {
-        qCWarning(lcButeoMsyncd) << "Failed query to delete all alarms";
-    }
+    iHeap.clear();
+    iAlarms.clear();
+    armTimer();
 }
 
 void SyncAlarmInventory::timerTriggered()
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
 
-    // Decrement the alarm counter
-    triggerCount--;
+    if (iTimerFd >= 0) {
+        quint64 expirations = 0;
+        if (read(iTimerFd, &expirations, sizeof(expirations)) < 0 && errno == ECANCELED) {
+            qCDebug(lcButeoMsyncd) << "System time changed, re-arming alarm timer";
+        }
+    }
 
-    // Alarm expired. Trigger the alarm and delete it from DB and set the alarm for the next one
-    if (triggerCount == 0) {
-        qCDebug(lcButeoMsyncd) << "Triggering the alarm " << currentAlarm;
-        emit triggerAlarm(currentAlarm);
+    // Collect all expired alarms first, so that the slots connected to
+    // triggerAlarm can add and remove alarms freely.
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QList<int> expired;
+    dropRemovedAlarms();
+    while (!iHeap.isEmpty() && iHeap.first().first <= now) {
+        int alarmId = iHeap.first().second;
+        std::pop_heap(iHeap.begin(), iHeap.end(), std::greater<HeapEntry>());
+        iHeap.removeLast();
+        iAlarms.remove(alarmId);
+        expired.append(alarmId);
+        dropRemovedAlarms();
+    }
+    armTimer();
 
-        // Delete the alarm from DB
-        if (!deleteAlarmFromDb(currentAlarm)) {
-        }
-        iTimer->stop();
-        currentAlarm = 0;
-
-        // Set the new alarm iTimer
-        // Select all the alarms from the db sorted by alarm time
-        QSqlQuery selectQuery(iDbHandle);
-        if (selectQuery.exec("SELECT alarmid,synctime FROM alarms ORDER BY synctime ASC")) {
-            qCDebug(lcButeoMsyncd) << "SQL Query::" << selectQuery.lastQuery();
-            if (selectQuery.first()) {
-                currentAlarm = selectQuery.value(0).toInt();
-                QDateTime alarmTime = selectQuery.value(1).toDateTime();
-
-                // Set the iTimer for the alarm
-                QDateTime now = QDateTime::currentDateTime();
-                int iTimerInterval = 0;
-                if (now < alarmTime) {
-                    iTimerInterval = (now.secsTo(alarmTime) / TRIGGER_COUNT) * 1000;  // time interval in millisec
-                }
-                triggerCount = TRIGGER_COUNT;
-                qCDebug(lcButeoMsyncd) << "Starting timer with interval::" << iTimerInterval;
-                iTimer->setInterval(iTimerInterval);
-                iTimer->start();
-            }
-        }
+    foreach (int alarmId, expired) {
+        qCDebug(lcButeoMsyncd) << "Triggering the alarm " << alarmId;
+        emit triggerAlarm(alarmId);
     }
 }
 
-bool SyncAlarmInventory::deleteAlarmFromDb(int alarmId)
+void SyncAlarmInventory::armTimer()
 {
-    FUNCTION_CALL_TRACE(lcButeoTrace);
-
-    QSqlQuery removeQuery (iDbHandle);
-    removeQuery.prepare("DELETE FROM alarms WHERE alarmid=:alarmid");
-    removeQuery.bindValue(":alarmid", alarmId);
-
-    qCDebug(lcButeoMsyncd) << "SQL Query::" << removeQuery.lastQuery();
-    if (!removeQuery.exec())
-        return false;
-    else
-        return true;
+    dropRemovedAlarms();
+
+    if (iTimerFd >= 0) {
+        // A zero time disarms the timer.
+        struct itimerspec spec;
+        memset(&spec, 0, sizeof(spec));
+        if (!iHeap.isEmpty()) {
+            qint64 alarmTime = qMax(iHeap.first().first, qint64(1));
+            spec.it_value.tv_sec = alarmTime / 1000;
+            spec.it_value.tv_nsec = (alarmTime % 1000) * 1000000;
+        }
+        if (timerfd_settime(iTimerFd, TFD_TIMER_ABSTIME | TFD_TIMER_CANCEL_ON_SET, &spec, 0) < 0) {
+            qCWarning(lcButeoMsyncd) << "Failed to arm alarm timer:" << strerror(errno);
+        }
+    } else if (iTimer) {
+        if (iHeap.isEmpty()) {
+            iTimer->stop();
+        } else {
+            qint64 interval = iHeap.first().first - QDateTime::currentMSecsSinceEpoch();
+            iTimer->start(int(qBound(qint64(0), interval, qint64(INT_MAX))));
+        }
+    }
 }
 
-int SyncAlarmInventory::addAlarmToDb(QDateTime timeStamp)
+void SyncAlarmInventory::dropRemovedAlarms()
 {
-    FUNCTION_CALL_TRACE(lcButeoTrace);
-
-    QSqlQuery insertQuery(iDbHandle);
-    insertQuery.prepare("INSERT INTO alarms(synctime) VALUES(:synctime)");
-    insertQuery.bindValue(":synctime", timeStamp);
-
-    qCDebug(lcButeoMsyncd) << "SQL Query::" << insertQuery.lastQuery();
-    if (insertQuery.exec())
-        return insertQuery.lastInsertId().toInt();
-    else
-        return 0;
+    while (!iHeap.isEmpty() && !iAlarms.contains(iHeap.first().second)) {
+        std::pop_heap(iHeap.begin(), iHeap.end(), std::greater<HeapEntry>());
+        iHeap.removeLast();
+    }
 }
-
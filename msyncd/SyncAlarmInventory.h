@@ -27,12 +27,23 @@
 
 #include <QObject>
 #include <QDateTime>
-#include <QtSql>
+#include <QHash>
+#include <QPair>
+#include <QTimer>
+#include <QVector>
+
+class QSocketNotifier;
 
 /*! \brief Class for storing alarms
  *
  * This class stores alarms for scheduled synchronizations. The main elements
  * are the sync time and the alarm id
+ *
+ * Alarms are kept in memory in a min-heap ordered by alarm time, and a single
+ * kernel timer is armed for the earliest alarm. The timer is a timerfd on the
+ * realtime clock, so it follows wall clock time and is re-armed if the clock
+ * is set. Alarms are not persisted: the scheduler adds them again for all
+ * profiles when msyncd starts.
  */
 class SyncAlarmInventory : public QObject
 {
@@ -46,8 +57,8 @@ public:
     /*! The alarm inventory destructor */
     ~SyncAlarmInventory();
 
-    /*! \brief Creates and Initialize the alarms database. also Creates the timers
-     * Please call this function to make sure the database is initialised properly
+    /*! \brief Creates the timers and removes the alarm database of older
+     * versions. Please call this function before using the other methods
      * @return - status of the initialisation
      */
     bool init();
@@ -78,29 +89,30 @@ signals:
     void triggerAlarm(int alarmId);
 
 private:
-    /* Deletes the alarm from DB */
-    bool deleteAlarmFromDb(int alarmName);
+    /* Arms the timer for the earliest alarm, or disarms it if there are none */
+    void armTimer();
 
-    /* Method to add an alarm to the database */
-    int addAlarmToDb(QDateTime timeStamp);
+    /* Drops removed alarms from the top of the heap */
+    void dropRemovedAlarms();
 
-    /* Method to fetch the database handle */
-    QSqlDatabase *getDbHandle();
+    /* Heap of alarm times in msecs since epoch and alarm ids, earliest first.
+     * Removed alarms stay in the heap until they reach the top. */
+    QVector<QPair<qint64, int> > iHeap;
 
-    /* Timer object to keep tracke of alarm timers */
-    QTimer *iTimer;
+    /* Alarm times of the active alarms by alarm id */
+    QHash<int, qint64> iAlarms;
 
-    /* Current alarm that is under work */
-    int currentAlarm;
+    /* Id of the next added alarm */
+    int iNextAlarmId;
 
-    /* Number of times that the alarm triggers */
-    int triggerCount;
+    /* Kernel timer for the earliest alarm, -1 if not available */
+    int iTimerFd;
 
-    /* Database handle */
-    QSqlDatabase iDbHandle;
+    /* Notifier for the kernel timer */
+    QSocketNotifier *iTimerNotifier;
 
-    /* Database connection name */
-    QString iConnectionName;
+    /* Timer used instead of the kernel timer if that can not be created */
+    QTimer *iTimer;
 
 private slots:
     /*! Slot used whenever the timer object expires */
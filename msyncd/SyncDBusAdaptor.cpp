@@ -162,6 +162,35 @@ void SyncDBusAdaptor::stop(uint aAccountId)
     QMetaObject::invokeMethod(parent(), "stop", Q_ARG(uint, aAccountId));
 }
 
+QVariantMap SyncDBusAdaptor::sessionStatistics()
+{
+    // handle method call com.meego.msyncd.sessionStatistics
+    QVariantMap out0;
+    QMetaObject::invokeMethod(parent(), "sessionStatistics", Q_RETURN_ARG(QVariantMap, out0));
+    return out0;
+}
+
+QStringList SyncDBusAdaptor::syncHistory(const QString &aProfileId, qlonglong aFrom, qlonglong aTo, int aLimit,
+                                         int aOffset)
+{
+    // handle method call com.meego.msyncd.syncHistory
+    QStringList out0;
+    QMetaObject::invokeMethod(parent(), "syncHistory", Q_RETURN_ARG(QStringList, out0), Q_ARG(QString, aProfileId),
+                              Q_ARG(qlonglong, aFrom), Q_ARG(qlonglong, aTo), Q_ARG(int, aLimit), Q_ARG(int, aOffset));
+    return out0;
+}
+
+QStringList SyncDBusAdaptor::syncHistoryByResult(int aMajorCode, int aMinorCode, qlonglong aFrom, qlonglong aTo,
+                                                 int aLimit, int aOffset)
+{
+    // handle method call com.meego.msyncd.syncHistoryByResult
+    QStringList out0;
+    QMetaObject::invokeMethod(parent(), "syncHistoryByResult", Q_RETURN_ARG(QStringList, out0),
+                              Q_ARG(int, aMajorCode), Q_ARG(int, aMinorCode), Q_ARG(qlonglong, aFrom),
+                              Q_ARG(qlonglong, aTo), Q_ARG(int, aLimit), Q_ARG(int, aOffset));
+    return out0;
+}
+
 QString SyncDBusAdaptor::syncProfile(const QString &aProfileId)
 {
     // handle method call com.meego.msyncd.syncProfile
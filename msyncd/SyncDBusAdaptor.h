@@ -129,6 +129,27 @@ class SyncDBusAdaptor: public QDBusAbstractAdaptor
                 "      <arg direction=\"out\" type=\"s\"/>\n"
                 "      <arg direction=\"in\" type=\"s\" name=\"aProfileId\"/>\n"
                 "    </method>\n"
+                "    <method name=\"syncHistory\">\n"
+                "      <arg direction=\"out\" type=\"as\"/>\n"
+                "      <arg direction=\"in\" type=\"s\" name=\"aProfileId\"/>\n"
+                "      <arg direction=\"in\" type=\"x\" name=\"aFrom\"/>\n"
+                "      <arg direction=\"in\" type=\"x\" name=\"aTo\"/>\n"
+                "      <arg direction=\"in\" type=\"i\" name=\"aLimit\"/>\n"
+                "      <arg direction=\"in\" type=\"i\" name=\"aOffset\"/>\n"
+                "    </method>\n"
+                "    <method name=\"syncHistoryByResult\">\n"
+                "      <arg direction=\"out\" type=\"as\"/>\n"
+                "      <arg direction=\"in\" type=\"i\" name=\"aMajorCode\"/>\n"
+                "      <arg direction=\"in\" type=\"i\" name=\"aMinorCode\"/>\n"
+                "      <arg direction=\"in\" type=\"x\" name=\"aFrom\"/>\n"
+                "      <arg direction=\"in\" type=\"x\" name=\"aTo\"/>\n"
+                "      <arg direction=\"in\" type=\"i\" name=\"aLimit\"/>\n"
+                "      <arg direction=\"in\" type=\"i\" name=\"aOffset\"/>\n"
+                "    </method>\n"
+                "    <method name=\"sessionStatistics\">\n"
+                "      <arg direction=\"out\" type=\"a{sv}\"/>\n"
+                "      <annotation value=\"QVariantMap\" name=\"com.trolltech.QtDBus.QtTypeName.Out0\"/>\n"
+                "    </method>\n"
                 "    <method name=\"allVisibleSyncProfiles\">\n"
                 "      <arg direction=\"out\" type=\"as\"/>\n"
                 "    </method>\n"
@@ -200,6 +221,10 @@ public Q_SLOTS: // METHODS
     bool startSync(const QString &aProfileId);
     int status(uint aAccountId, int &aFailedReason, qlonglong &aPrevSyncTime, qlonglong &aNextSyncTime);
     Q_NOREPLY void stop(uint aAccountId);
+    QVariantMap sessionStatistics();
+    QStringList syncHistory(const QString &aProfileId, qlonglong aFrom, qlonglong aTo, int aLimit, int aOffset);
+    QStringList syncHistoryByResult(int aMajorCode, int aMinorCode, qlonglong aFrom, qlonglong aTo, int aLimit,
+                                    int aOffset);
     QString syncProfile(const QString &aProfileId);
     QStringList syncProfilesByKey(const QString &aKey, const QString &aValue);
     QStringList syncProfilesByType(const QString &aType);
@@ -292,6 +292,51 @@ public slots:
      */
     virtual QString getLastSyncResult(const QString &aProfileId) = 0;
 
+    /*! \brief Gets a page of sync history, newest results first.
+     *
+     * Unlike the profile logs, the history keeps the results of all sync
+     * sessions, up to a large limit.
+     * \param aProfileId Name of the profile. Empty matches all profiles.
+     * \param aFrom Earliest sync time in milliseconds since the epoch.
+     * \param aTo Latest sync time in milliseconds since the epoch. Zero or
+     *  less means no upper limit.
+     * \param aLimit Maximum number of results, at most 500. Zero or less
+     *  means the maximum.
+     * \param aOffset Number of matching results to skip.
+     * \return Sync log XML strings, each containing one SyncResults entry.
+     */
+    virtual QStringList syncHistory(const QString &aProfileId, qlonglong aFrom, qlonglong aTo,
+                                    int aLimit, int aOffset) = 0;
+
+    /*! \brief Gets a page of sync history with the given result codes,
+     *  newest results first.
+     *
+     * \param aMajorCode Major code of the results.
+     * \param aMinorCode Minor code of the results. Negative matches any
+     *  minor code.
+     * \param aFrom Earliest sync time in milliseconds since the epoch.
+     * \param aTo Latest sync time in milliseconds since the epoch. Zero or
+     *  less means no upper limit.
+     * \param aLimit Maximum number of results, at most 500. Zero or less
+     *  means the maximum.
+     * \param aOffset Number of matching results to skip.
+     * \return Sync log XML strings, each containing one SyncResults entry.
+     */
+    virtual QStringList syncHistoryByResult(int aMajorCode, int aMinorCode, qlonglong aFrom,
+                                            qlonglong aTo, int aLimit, int aOffset) = 0;
+
+    /*! \brief Gets statistics about parallel sync sessions.
+     *
+     * Contains the configured session limits, the number of running and
+     * queued sessions, how often each limit made a session wait, the
+     * queue wait times in milliseconds and the session slot utilisation.
+     * Also contains the scheduled sync wake-up statistics: the alignment
+     * window, the number of wake-ups and scheduled syncs, and the achieved
+     * wake-ups per hour.
+     * \return Statistics by name.
+     */
+    virtual QVariantMap sessionStatistics() = 0;
+
     /*! \brief Gets all visible sync profiles.
      *
      * Returns all sync profiles that should be visible in sync ui. A profile
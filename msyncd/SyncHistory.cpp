@@ -0,0 +1,267 @@
+/*
+ * This file is part of buteo-syncfw package
+ *
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include "SyncHistory.h"
+#include "SyncLog.h"
+#include "SyncResults.h"
+#include "SyncCommonDefs.h"
+#include "ProfileEngineDefs.h"
+#include "LogMacros.h"
+
+#include <QDir>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QXmlStreamWriter>
+
+using namespace Buteo;
+
+const QString HISTORY_CONNECTION_NAME("synchistory");
+
+// Key of the state row recording that the sync logs have been imported.
+const QString STATE_IMPORTED("imported");
+
+// The history is pruned after this many inserts.
+const int PRUNE_INTERVAL = 100;
+
+const int SyncHistory::MAX_ENTRIES = 10000;
+const int SyncHistory::MAX_PAGE_SIZE = 500;
+
+SyncHistory::SyncHistory()
+    : iInserts(0)
+{
+    // empty. explicitly call init
+}
+
+SyncHistory::~SyncHistory()
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    if (!iConnectionName.isEmpty()) {
+        iDbHandle.close();
+        iDbHandle = QSqlDatabase();
+        QSqlDatabase::removeDatabase(iConnectionName);
+    }
+}
+
+bool SyncHistory::init(const QString &aPath)
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    static unsigned connectionNumber = 0;
+    iConnectionName = HISTORY_CONNECTION_NAME + QString::number(connectionNumber++);
+    iDbHandle = QSqlDatabase::addDatabase("QSQLITE", iConnectionName);
+
+    QString path(aPath);
+    if (path.isEmpty()) {
+        path = Sync::syncConfigDir();
+        path.append(QDir::separator()).append("synchistory.db.sqlite");
+        path = QDir::toNativeSeparators(path);
+    }
+    iDbHandle.setDatabaseName(path);
+
+    if (!iDbHandle.open()) {
+        qCCritical(lcButeoMsyncd) << "Failed to open sync history DB" << path << iDbHandle.lastError().text();
+        return false;
+    }
+
+    const QStringList schema = QStringList()
+                               << "CREATE TABLE IF NOT EXISTS results(id INTEGER PRIMARY KEY AUTOINCREMENT, "
+                               "profile TEXT NOT NULL, synctime INTEGER NOT NULL, majorcode INTEGER NOT NULL, "
+                               "minorcode INTEGER NOT NULL, log TEXT NOT NULL)"
+                               << "CREATE INDEX IF NOT EXISTS results_profile_time ON results(profile, synctime)"
+                               << "CREATE INDEX IF NOT EXISTS results_code ON results(majorcode, minorcode, synctime)"
+                               << "CREATE INDEX IF NOT EXISTS results_time ON results(synctime)"
+                               << "CREATE TABLE IF NOT EXISTS state(key TEXT PRIMARY KEY, value TEXT)";
+    QSqlQuery query(iDbHandle);
+    foreach (const QString &statement, schema) {
+        if (!query.exec(statement)) {
+            qCWarning(lcButeoMsyncd) << "Failed to create sync history table:" << query.lastError().text();
+            return false;
+        }
+    }
+
+    prune();
+    return true;
+}
+
+bool SyncHistory::isEmpty() const
+{
+    QSqlQuery query(iDbHandle);
+    return !query.exec("SELECT id FROM results LIMIT 1") || !query.next();
+}
+
+bool SyncHistory::isImported() const
+{
+    QSqlQuery query(iDbHandle);
+    query.prepare("SELECT value FROM state WHERE key = ?");
+    query.addBindValue(STATE_IMPORTED);
+    return query.exec() && query.next();
+}
+
+bool SyncHistory::setImported()
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    QSqlQuery query(iDbHandle);
+    query.prepare("INSERT OR REPLACE INTO state(key, value) VALUES(?, ?)");
+    query.addBindValue(STATE_IMPORTED);
+    query.addBindValue(QString("1"));
+    if (!query.exec()) {
+        qCWarning(lcButeoMsyncd) << "Failed to update sync history state:" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+bool SyncHistory::addResults(const QString &aProfileName, const SyncResults &aResults)
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    if (!insert(aProfileName, aResults)) {
+        return false;
+    }
+
+    if (++iInserts >= PRUNE_INTERVAL) {
+        prune();
+    }
+    return true;
+}
+
+bool SyncHistory::addLog(const SyncLog &aLog)
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    QList<const SyncResults *> results = aLog.allResults();
+    const SyncResults *lastSuccessful = aLog.lastSuccessfulResults();
+    if (lastSuccessful && !results.isEmpty() && *lastSuccessful < *results.first()) {
+        results.prepend(lastSuccessful);
+    }
+
+    iDbHandle.transaction();
+    foreach (const SyncResults *entry, results) {
+        if (!insert(aLog.profileName(), *entry)) {
+            iDbHandle.rollback();
+            return false;
+        }
+    }
+    return iDbHandle.commit();
+}
+
+QStringList SyncHistory::results(const QString &aProfileName, qint64 aFrom, qint64 aTo,
+                                 int aLimit, int aOffset) const
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    QStringList conditions;
+    QVariantList values;
+    if (!aProfileName.isEmpty()) {
+        conditions << "profile = ?";
+        values << aProfileName;
+    }
+    return select(conditions, values, aFrom, aTo, aLimit, aOffset);
+}
+
+QStringList SyncHistory::resultsByCode(int aMajorCode, int aMinorCode, qint64 aFrom, qint64 aTo,
+                                       int aLimit, int aOffset) const
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    QStringList conditions;
+    QVariantList values;
+    conditions << "majorcode = ?";
+    values << aMajorCode;
+    if (aMinorCode >= 0) {
+        conditions << "minorcode = ?";
+        values << aMinorCode;
+    }
+    return select(conditions, values, aFrom, aTo, aLimit, aOffset);
+}
+
+bool SyncHistory::insert(const QString &aProfileName, const SyncResults &aResults)
+{
+    // Each entry is stored as a complete single-entry log, so that queries
+    // can return the stored text as is.
+    SyncLog log(aProfileName);
+    log.addResults(aResults);
+    QString logXml;
+    QXmlStreamWriter writer(&logXml);
+    log.toXml(writer);
+
+    QSqlQuery query(iDbHandle);
+    query.prepare("INSERT INTO results(profile, synctime, majorcode, minorcode, log) VALUES(?, ?, ?, ?, ?)");
+    query.addBindValue(aProfileName);
+    query.addBindValue(aResults.syncTime().toMSecsSinceEpoch());
+    query.addBindValue(static_cast<int>(aResults.majorCode()));
+    query.addBindValue(static_cast<int>(aResults.minorCode()));
+    query.addBindValue(logXml);
+    if (!query.exec()) {
+        qCWarning(lcButeoMsyncd) << "Failed to add results to sync history:" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+QStringList SyncHistory::select(const QStringList &aConditions, const QVariantList &aValues,
+                                qint64 aFrom, qint64 aTo, int aLimit, int aOffset) const
+{
+    QStringList conditions(aConditions);
+    QVariantList values(aValues);
+    conditions << "synctime >= ?";
+    values << aFrom;
+    if (aTo > 0) {
+        conditions << "synctime <= ?";
+        values << aTo;
+    }
+    values << ((aLimit > 0 && aLimit < MAX_PAGE_SIZE) ? aLimit : MAX_PAGE_SIZE);
+    values << qMax(aOffset, 0);
+
+    QSqlQuery query(iDbHandle);
+    query.setForwardOnly(true);
+    query.prepare("SELECT log FROM results WHERE " + conditions.join(" AND ")
+                  + " ORDER BY synctime DESC, id DESC LIMIT ? OFFSET ?");
+    foreach (const QVariant &value, values) {
+        query.addBindValue(value);
+    }
+
+    QStringList logs;
+    if (!query.exec()) {
+        qCWarning(lcButeoMsyncd) << "Failed to query sync history:" << query.lastError().text();
+        return logs;
+    }
+    while (query.next()) {
+        logs.append(query.value(0).toString());
+    }
+    return logs;
+}
+
+void SyncHistory::prune()
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    iInserts = 0;
+    QSqlQuery query(iDbHandle);
+    query.prepare("DELETE FROM results WHERE id <= "
+                  "(SELECT id FROM results ORDER BY id DESC LIMIT 1 OFFSET ?)");
+    query.addBindValue(MAX_ENTRIES);
+    if (!query.exec()) {
+        qCWarning(lcButeoMsyncd) << "Failed to prune sync history:" << query.lastError().text();
+    }
+}
@@ -0,0 +1,155 @@
+/*
+ * This file is part of buteo-syncfw package
+ *
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+#ifndef SYNCHISTORY_H
+#define SYNCHISTORY_H
+
+#include <QSqlDatabase>
+#include <QString>
+#include <QStringList>
+#include <QVariantList>
+
+namespace Buteo {
+
+class SyncLog;
+class SyncResults;
+
+/*! \brief Indexed store for the results of completed sync sessions.
+ *
+ * The per-profile sync logs only keep the latest few results. The history
+ * keeps every result of every profile in an SQLite database, indexed by
+ * profile and time and by result code, so that large amounts of history can
+ * be browsed page by page without loading the profiles or their logs.
+ * The database is synchistory.db.sqlite in Sync::syncConfigDir(), unless
+ * another path is given to init().
+ *
+ * Query results are returned as sync log XML, each entry containing the
+ * name of the profile and a single results element, so that clients can
+ * parse them with SyncLog.
+ */
+class SyncHistory
+{
+public:
+    //! Maximum number of results kept in the history.
+    static const int MAX_ENTRIES;
+
+    //! Maximum number of results returned by a single query.
+    static const int MAX_PAGE_SIZE;
+
+    /*! \brief Constructor. Call init() before using the other functions.
+     */
+    SyncHistory();
+
+    /*! \brief Destructor.
+     */
+    ~SyncHistory();
+
+    /*! \brief Opens the history database, creating it if needed.
+     *
+     * \param aPath Path of the database file. The default is
+     *  synchistory.db.sqlite in the sync configuration directory.
+     * \return True on success.
+     */
+    bool init(const QString &aPath = QString());
+
+    /*! \brief Checks if there are no results in the history.
+     *
+     * \return True if the history is empty or it is not open.
+     */
+    bool isEmpty() const;
+
+    /*! \brief Checks if the existing sync logs have been imported.
+     *
+     * \return True if setImported() has been called for this database.
+     */
+    bool isImported() const;
+
+    /*! \brief Records that the existing sync logs have been imported.
+     *
+     * \return True on success.
+     */
+    bool setImported();
+
+    /*! \brief Adds results of a completed sync session to the history.
+     *
+     * \param aProfileName Name of the synced profile.
+     * \param aResults Results of the session.
+     * \return True on success.
+     */
+    bool addResults(const QString &aProfileName, const SyncResults &aResults);
+
+    /*! \brief Adds all results of a sync log to the history.
+     *
+     * Used for importing the existing logs when the history is created,
+     * see setImported().
+     * \param aLog The log to import.
+     * \return True on success.
+     */
+    bool addLog(const SyncLog &aLog);
+
+    /*! \brief Gets results of a profile, newest first.
+     *
+     * \param aProfileName Name of the profile. Empty matches all profiles.
+     * \param aFrom Earliest sync time in milliseconds since the epoch.
+     * \param aTo Latest sync time in milliseconds since the epoch. Zero or
+     *  less means no upper limit.
+     * \param aLimit Maximum number of results, at most MAX_PAGE_SIZE. Zero
+     *  or less means MAX_PAGE_SIZE.
+     * \param aOffset Number of matching results to skip.
+     * \return Matching results as sync log XML strings.
+     */
+    QStringList results(const QString &aProfileName, qint64 aFrom, qint64 aTo,
+                        int aLimit, int aOffset) const;
+
+    /*! \brief Gets results with the given result codes, newest first.
+     *
+     * \param aMajorCode Major code of the results.
+     * \param aMinorCode Minor code of the results. Negative matches any
+     *  minor code.
+     * \param aFrom Earliest sync time in milliseconds since the epoch.
+     * \param aTo Latest sync time in milliseconds since the epoch. Zero or
+     *  less means no upper limit.
+     * \param aLimit Maximum number of results, at most MAX_PAGE_SIZE. Zero
+     *  or less means MAX_PAGE_SIZE.
+     * \param aOffset Number of matching results to skip.
+     * \return Matching results as sync log XML strings.
+     */
+    QStringList resultsByCode(int aMajorCode, int aMinorCode, qint64 aFrom, qint64 aTo,
+                              int aLimit, int aOffset) const;
+
+private:
+    bool insert(const QString &aProfileName, const SyncResults &aResults);
+
+    QStringList select(const QStringList &aConditions, const QVariantList &aValues,
+                       qint64 aFrom, qint64 aTo, int aLimit, int aOffset) const;
+
+    void prune();
+
+    QSqlDatabase iDbHandle;
+
+    QString iConnectionName;
+
+    // Inserts since the history was last pruned.
+    int iInserts;
+};
+
+}
+
+#endif // SYNCHISTORY_H
@@ -115,9 +115,10 @@ void SyncOnChange::sync(QString aStorageName)
     if (iSOCStorageMap.contains(aStorageName)) {
         profilesList = iSOCStorageMap.value(aStorageName);
     }
+    const StorageChangeSet changes = iStorageChangeNotifier->takeChanges(aStorageName);
     for (QList<SyncProfile *>::iterator profileItr = profilesList.begin();
             profileItr != profilesList.end(); ++profileItr) {
-        iSOCScheduler->addProfile(*profileItr);
+        iSOCScheduler->addProfile(*profileItr, changes);
     }
 }
 
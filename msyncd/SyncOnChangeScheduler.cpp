@@ -1,4 +1,6 @@
 #include <QTimer>
+#include <algorithm>
+#include <functional>
 
 #include "SyncOnChangeScheduler.h"
 #include "SyncProfile.h"
@@ -6,82 +8,148 @@
 
 using namespace Buteo;
 
+typedef QPair<qint64, QString> HeapEntry;
+
 SyncOnChangeScheduler::SyncOnChangeScheduler()
+    : iChanges(0),
+      iMerged(0),
+      iSyncs(0),
+      iGapDelayed(0)
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
+    iClock.start();
+    iTimer.setSingleShot(true);
+    connect(&iTimer, SIGNAL(timeout()), this, SLOT(timeout()));
 }
 
 SyncOnChangeScheduler::~SyncOnChangeScheduler()
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
-    foreach (QObject *o, iSOCTimers.values()) {
-        delete o;
-    }
-    iSOCTimers.clear();
-    iSOCProfileNames.clear();
+    iTimer.stop();
+    iPending.clear();
+    iHeap.clear();
 }
 
-bool SyncOnChangeScheduler::addProfile(const SyncProfile *aProfile)
+bool SyncOnChangeScheduler::addProfile(const SyncProfile *aProfile, const StorageChangeSet &aChanges)
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
-    bool scheduled = false;
-    if (aProfile && !iSOCProfileNames.contains(aProfile->name())) {
-        qint32 time = aProfile->syncOnChangeAfter();
-        iSOCProfileNames << aProfile->name();
-        SyncOnChangeTimer *SOCtimer = new SyncOnChangeTimer(aProfile, time);
-        QObject::connect(SOCtimer, SIGNAL(timeout(const SyncProfile *)),
-                         this, SLOT(sync(const SyncProfile *)),
-                         Qt::QueuedConnection);
-        SOCtimer->fire();
-        scheduled = true;
-        iSOCTimers.insert(aProfile->name(), SOCtimer);
-        qCDebug(lcButeoMsyncd) << "Sync on change scheduled for profile" << aProfile->name();
-    } else if (aProfile) {
-        qCDebug(lcButeoMsyncd) << "Sync on change already scheduled for profile" << aProfile->name();
+    if (!aProfile) {
+        return false;
+    }
+
+    iChangeSets[aProfile->name()].merge(aChanges);
+
+    const bool scheduled = schedule(aProfile->name(), qint64(aProfile->syncOnChangeAfter()) * 1000,
+                                    qint64(aProfile->syncOnChangeMinGap()) * 1000, iClock.elapsed());
+    if (scheduled) {
+        armTimer();
     }
     return scheduled;
 }
 
-void SyncOnChangeScheduler::removeProfile(const QString &aProfileName)
+void SyncOnChangeScheduler::cancelSync(const QString &aProfileName)
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
-    iSOCProfileNames.removeAll(aProfileName);
-    // cancel timer
-    delete iSOCTimers.take(aProfileName);
+    // The heap entry is skipped when it reaches the top.
+    iPending.remove(aProfileName);
+    iChangeSets.remove(aProfileName);
+    iDueChangeSets.remove(aProfileName);
 }
 
-void SyncOnChangeScheduler::sync(const SyncProfile *aProfile)
+void SyncOnChangeScheduler::removeProfile(const QString &aProfileName)
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
-    iSOCProfileNames.removeAll(aProfile->name());
-    iSOCTimers.remove(aProfile->name());
-    SyncOnChangeTimer *SOCtimer = qobject_cast<SyncOnChangeTimer *>(sender());
-    if (SOCtimer) {
-        qCDebug(lcButeoMsyncd) << "Sync on change for profile" << aProfile->name();
-        delete SOCtimer;
-        emit syncNow(aProfile->name());
-    }
+    cancelSync(aProfileName);
+    iLastSync.remove(aProfileName);
 }
 
-SyncOnChangeTimer::SyncOnChangeTimer(const SyncProfile *profile, const quint32 &aTimeout) :
-    iSyncProfile(profile), iTimeout(aTimeout)
+StorageChangeSet SyncOnChangeScheduler::takeChangeSet(const QString &aProfileName)
 {
-    FUNCTION_CALL_TRACE(lcButeoTrace);
+    return iDueChangeSets.take(aProfileName);
 }
 
-SyncOnChangeTimer::~SyncOnChangeTimer()
+QVariantMap SyncOnChangeScheduler::changeStatistics() const
 {
-    FUNCTION_CALL_TRACE(lcButeoTrace);
+    QVariantMap stats;
+    stats.insert("syncOnChangeNotifications", iChanges);
+    stats.insert("syncOnChangeMerged", iMerged);
+    stats.insert("syncOnChangeSyncs", iSyncs);
+    stats.insert("syncOnChangeGapDelayed", iGapDelayed);
+    stats.insert("syncOnChangePending", iPending.size());
+    return stats;
 }
 
-void SyncOnChangeTimer::fire()
+void SyncOnChangeScheduler::timeout()
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
-    QTimer::singleShot(iTimeout * 1000, this, SLOT(onTimeout()));
+    foreach (const QString &profileName, takeDue(iClock.elapsed())) {
+        qCDebug(lcButeoMsyncd) << "Sync on change for profile" << profileName;
+        emit syncNow(profileName);
+    }
+    armTimer();
 }
 
-void SyncOnChangeTimer::onTimeout()
+bool SyncOnChangeScheduler::schedule(const QString &aProfileName, qint64 aDelay, qint64 aMinGap, qint64 aNow)
 {
-    FUNCTION_CALL_TRACE(lcButeoTrace);
-    emit timeout(iSyncProfile);
+    ++iChanges;
+    if (iPending.contains(aProfileName)) {
+        ++iMerged;
+        qCDebug(lcButeoMsyncd) << "Sync on change already scheduled for profile" << aProfileName;
+        return false;
+    }
+
+    qint64 deadline = aNow + aDelay;
+    QHash<QString, qint64>::const_iterator last = iLastSync.constFind(aProfileName);
+    if (last != iLastSync.constEnd() && last.value() + aMinGap > deadline) {
+        deadline = last.value() + aMinGap;
+        ++iGapDelayed;
+    }
+
+    iPending.insert(aProfileName, deadline);
+    iHeap.append(HeapEntry(deadline, aProfileName));
+    std::push_heap(iHeap.begin(), iHeap.end(), std::greater<HeapEntry>());
+    qCDebug(lcButeoMsyncd) << "Sync on change scheduled for profile" << aProfileName << "in"
+                           << deadline - aNow << "ms";
+    return true;
+}
+
+QStringList SyncOnChangeScheduler::takeDue(qint64 aNow)
+{
+    QStringList due;
+    while (!iHeap.isEmpty() && iHeap.first().first <= aNow) {
+        const HeapEntry entry = iHeap.first();
+        std::pop_heap(iHeap.begin(), iHeap.end(), std::greater<HeapEntry>());
+        iHeap.removeLast();
+
+        QHash<QString, qint64>::iterator it = iPending.find(entry.second);
+        if (it == iPending.end() || it.value() != entry.first) {
+            // Removed, or removed and scheduled again.
+            continue;
+        }
+        iPending.erase(it);
+        iDueChangeSets[entry.second].merge(iChangeSets.take(entry.second));
+        iLastSync.insert(entry.second, aNow);
+        ++iSyncs;
+        due.append(entry.second);
+    }
+    return due;
+}
+
+void SyncOnChangeScheduler::armTimer()
+{
+    // Drop removed profiles so that the timer is not armed for them.
+    while (!iHeap.isEmpty()) {
+        QHash<QString, qint64>::const_iterator it = iPending.constFind(iHeap.first().second);
+        if (it != iPending.constEnd() && it.value() == iHeap.first().first) {
+            break;
+        }
+        std::pop_heap(iHeap.begin(), iHeap.end(), std::greater<HeapEntry>());
+        iHeap.removeLast();
+    }
+
+    if (iHeap.isEmpty()) {
+        iTimer.stop();
+    } else {
+        iTimer.start(int(qMax(iHeap.first().first - iClock.elapsed(), qint64(0))));
+    }
 }
@@ -2,15 +2,32 @@
 #define SYNCONCHANGESCHEDULER_H
 
 #include <QObject>
+#include <QElapsedTimer>
 #include <QHash>
+#include <QPair>
 #include <QStringList>
+#include <QTimer>
+#include <QVariantMap>
+#include <QVector>
 
 #include "SyncScheduler.h"
+#include "StorageChangeSet.h"
 
 namespace Buteo {
 
 class SyncProfile;
 
+/*! \brief Schedules syncs triggered by storage changes.
+ *
+ * Each profile with a pending sync on change has a deadline. All deadlines
+ * are kept in one min-heap, and a single timer is armed for the earliest
+ * one. Changes that arrive while a sync is pending for the profile, from
+ * the same or from other storages, are merged into the pending sync. A
+ * profile is not synced again before its minimum gap since its previous
+ * sync on change has passed, so that a long burst of changes, such as a
+ * large contact import, results in one sync and a follow-up sync instead
+ * of repeated ones.
+ */
 class SyncOnChangeScheduler : public SyncScheduler
 {
     Q_OBJECT
@@ -26,77 +43,113 @@ public:
 
     /*! \brief Call this method to schedule SOC for a profile
      *
-     * There are 3 scheduling criteria - SOC after info from the
-     * profile, default SOC after and sync now.
-     *
-     * The profile is first checked for sync on change after time, which
-     * should be specified in seconds (0 means sync now). If none is specified
-     * then we use a default of DEFAULT_SOC_AFTER_TIME
+     * The sync is scheduled after the SOC after time of the profile, in
+     * seconds (0 means sync now), but not before the minimum gap of the
+     * profile since its previous sync on change.
      *
      * If the profile has already been added and if it's SOC is scheduled,
      * calling this method again will just use the previous schedule, and in
      * this case the method will return false.
      *
      * Once the SOC is initiated (by sending a syncNow signal), the profile is
-     * removed automatically
+     * removed automatically. The profile object is not referenced after
+     * this call returns.
+     *
+     * The changes are collected until the sync is initiated, also when
+     * they are merged into an already scheduled sync.
      *
      * @param aProfile pointer to sync profile
+     * @param aChanges the changes that triggered the sync
      * @return true if SOC could be scheduled, false otherwise
      */
-    bool addProfile(const SyncProfile *aProfile);
+    bool addProfile(const SyncProfile *aProfile, const StorageChangeSet &aChanges = StorageChangeSet());
 
-    /*! \brief call this method to disable SOC that has been scheduled
-     * for a certain profile
+    /*! \brief Takes the changes collected for a profile whose sync on
+     * change has been initiated.
      *
      * @param aProfileName name of the profile
+     * @return the changes, empty if no sync on change was initiated
      */
-    void removeProfile(const QString &aProfileName);
+    StorageChangeSet takeChangeSet(const QString &aProfileName);
 
-private Q_SLOTS:
-    /*! \brief slot to initiate sync when timeout criterion is being used
-     * and the timeout occurs
+    /*! \brief call this method to disable SOC that has been scheduled
+     * for a certain profile. The changes collected for it are dropped.
+     *
+     * The time of the previous sync on change is kept, so that the
+     * minimum gap still applies to the next one.
      *
-     * @param aProfile sync profile
+     * @param aProfileName name of the profile
      */
-    void sync(const SyncProfile *aProfile);
-
-private:
-    QStringList iSOCProfileNames;
-    QMap<QString, QObject *> iSOCTimers;
-};
-
-class SyncOnChangeTimer : public QObject
-{
-    Q_OBJECT
+    void cancelSync(const QString &aProfileName);
 
-public:
-    /*! \brief constructor
+    /*! \brief call this method when a profile is removed. Disables SOC
+     * for it like cancelSync() and forgets its previous sync on change.
+     *
+     * @param aProfileName name of the profile
      */
-    SyncOnChangeTimer(const SyncProfile *aProfile, const quint32 &aTimeout);
+    void removeProfile(const QString &aProfileName);
 
-    /*! \brief destructor
+    /*! \brief Gets statistics about syncs on change.
+     *
+     * The statistics contain the number of change notifications, how many
+     * of them were merged into an already pending sync, the number of
+     * syncs started and how many were delayed by the minimum gap.
+     *
+     * @return Statistics by name.
      */
-    ~SyncOnChangeTimer();
+    QVariantMap changeStatistics() const;
 
-    /*! \brief fire the timer
+private Q_SLOTS:
+    /*! \brief slot to initiate the syncs whose deadline has passed
      */
-    void fire();
+    void timeout();
 
-Q_SIGNALS:
-    /*! \brief emit this signal when the timeout occurs
+private:
+    /*! \brief Schedules a sync for a profile.
      *
-     * @param aProfile sync profile
+     * @param aProfileName name of the profile
+     * @param aDelay delay from now in milliseconds
+     * @param aMinGap minimum time since the previous sync in milliseconds
+     * @param aNow current time in milliseconds
+     * @return true if a new sync was scheduled
      */
-    void timeout(const SyncProfile *aProfile);
+    bool schedule(const QString &aProfileName, qint64 aDelay, qint64 aMinGap, qint64 aNow);
 
-private Q_SLOTS:
-    /*! \brief slot corresponding to timeout
+    /*! \brief Takes the profiles whose sync is due and records the sync
+     *
+     * @param aNow current time in milliseconds
+     * @return names of the profiles, earliest deadline first
      */
-    void onTimeout();
+    QStringList takeDue(qint64 aNow);
 
-private:
-    const SyncProfile *iSyncProfile;
-    quint32 iTimeout;
+    void armTimer();
+
+    // Deadline of each profile with a pending sync.
+    QHash<QString, qint64> iPending;
+
+    // Changes collected for pending syncs, and for initiated syncs that
+    // have not been started yet.
+    QHash<QString, StorageChangeSet> iChangeSets;
+    QHash<QString, StorageChangeSet> iDueChangeSets;
+
+    // Time of the previous sync on change of each profile.
+    QHash<QString, qint64> iLastSync;
+
+    // Min-heap of (deadline, profile). Entries of removed profiles are
+    // skipped when they reach the top.
+    QVector<QPair<qint64, QString> > iHeap;
+
+    QTimer iTimer;
+    QElapsedTimer iClock;
+
+    int iChanges;
+    int iMerged;
+    int iSyncs;
+    int iGapDelayed;
+
+#ifdef SYNCFW_UNIT_TESTS
+    friend class SyncOnChangeSchedulerTest;
+#endif
 };
 
 }
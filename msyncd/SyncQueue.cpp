@@ -27,12 +27,34 @@
 
 using namespace Buteo;
 
-void SyncQueue::enqueue(SyncSession *aSession)
+SyncQueue::SyncQueue()
+    : iSequence(0),
+      iOrderedValid(true)
+{
+}
+
+bool SyncQueue::enqueue(SyncSession *aSession)
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
 
-    iItems.enqueue(aSession);
-    sort();
+    if (aSession == 0) {
+        qCWarning(lcButeoMsyncd) << "Null session can not be queued";
+        return false;
+    }
+
+    const QString profileName = aSession->profileName();
+    if (iIndex.contains(profileName)) {
+        qCWarning(lcButeoMsyncd) << "Profile" << profileName << "is already queued";
+        return false;
+    }
+
+    Position position;
+    position.iPriority = priority(aSession);
+    position.iSequence = iSequence++;
+    iQueues[position.iPriority].insert(position.iSequence, aSession);
+    iIndex.insert(profileName, position);
+    iOrderedValid = false;
+    return true;
 }
 
 SyncSession *SyncQueue::dequeue()
@@ -41,8 +63,13 @@ SyncSession *SyncQueue::dequeue()
 
     SyncSession *p = nullptr;
 
-    if (!iItems.isEmpty()) {
-        p = iItems.dequeue();
+    for (int i = 0; i < PRIORITY_COUNT; ++i) {
+        if (!iQueues[i].isEmpty()) {
+            p = iQueues[i].take(iQueues[i].firstKey());
+            iIndex.remove(p->profileName());
+            iOrderedValid = false;
+            break;
+        }
     }
 
     return p;
@@ -51,16 +78,16 @@ SyncSession *SyncQueue::dequeue()
 SyncSession *SyncQueue::dequeue(const QString &aProfileName)
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
-    SyncSession *ret = 0;
-    QQueue<SyncSession *>::iterator i;
-    for (i = iItems.begin(); i != iItems.end(); ++i) {
-        if ((*i)->profileName() == aProfileName) {
-            ret = *i;
-            iItems.erase(i);
-            break;
-        }
+
+    QHash<QString, Position>::iterator i = iIndex.find(aProfileName);
+    if (i == iIndex.end()) {
+        return 0;
     }
-    return ret;
+
+    SyncSession *session = iQueues[i->iPriority].take(i->iSequence);
+    iIndex.erase(i);
+    iOrderedValid = false;
+    return session;
 }
 
 SyncSession *SyncQueue::head()
@@ -68,8 +95,11 @@ SyncSession *SyncQueue::head()
     FUNCTION_CALL_TRACE(lcButeoTrace);
 
     SyncSession *p = nullptr;
-    if (!iItems.isEmpty()) {
-        p = iItems.head();
+    for (int i = 0; i < PRIORITY_COUNT; ++i) {
+        if (!iQueues[i].isEmpty()) {
+            p = iQueues[i].first();
+            break;
+        }
     }
 
     return p;
@@ -79,61 +109,62 @@ bool SyncQueue::isEmpty() const
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
 
-    return iItems.isEmpty();
+    return iIndex.isEmpty();
 }
 
 int SyncQueue::size() const
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
 
-    return iItems.size();
+    return iIndex.size();
 }
 
 bool SyncQueue::contains(const QString &aProfileName) const
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
 
-    QQueue<SyncSession *>::const_iterator i;
-    for (i = iItems.begin(); i != iItems.end(); ++i) {
-        if ((*i)->profileName() == aProfileName)
-            return true;
-    }
-
-    return false;
+    return iIndex.contains(aProfileName);
 }
 
-bool syncSessionPointerLessThan(SyncSession *&aLhs, SyncSession *&aRhs)
+const QList<SyncSession *> &SyncQueue::getQueuedSyncSessions() const
 {
-    if (aLhs && aRhs) {
-        // Manual sync has higher priority than scheduled sync.
-        if (aLhs->isScheduled() != aRhs->isScheduled())
-            return !aLhs->isScheduled();
-
-        SyncProfile *lhsProfile = aLhs->profile();
-        SyncProfile *rhsProfile = aRhs->profile();
-        if (lhsProfile == 0 || rhsProfile == 0)
-            return false;
-
-        // Device sync has higher priority than online sync.
-        SyncProfile::DestinationType lhsDestType = lhsProfile->destinationType();
-        SyncProfile::DestinationType rhsDestType = rhsProfile->destinationType();
-        if (lhsDestType != rhsDestType)
-            return (lhsDestType == SyncProfile::DESTINATION_TYPE_DEVICE);
-    }
+    FUNCTION_CALL_TRACE(lcButeoTrace);
 
-    return false;
+    if (!iOrderedValid) {
+        iOrdered.clear();
+        iOrdered.reserve(iIndex.size());
+        for (int i = 0; i < PRIORITY_COUNT; ++i) {
+            iOrdered.append(iQueues[i].values());
+        }
+        iOrderedValid = true;
+    }
+    return iOrdered;
 }
 
-void SyncQueue::sort()
+int SyncQueue::priority(const SyncSession *aSession)
 {
-    FUNCTION_CALL_TRACE(lcButeoTrace);
+    const SyncProfile *profile = aSession->profile();
+
+    // Manual sync has higher priority than sync on change, which has
+    // higher priority than retries of failed syncs and then other
+    // scheduled syncs. Only sessions started by a change count as sync on
+    // change, not every sync of a profile that supports it.
+    int priority = 0;
+    if (aSession->isScheduled()) {
+        if (aSession->isSyncOnChange()) {
+            priority = 1;
+        } else if (aSession->isRetry()) {
+            priority = 2;
+        } else {
+            priority = 3;
+        }
+    }
 
-    // @todo: Sort queued profiles using some criteria.
-}
+    // Device sync has higher priority than online sync.
+    priority *= 2;
+    if (!profile || profile->destinationType() != SyncProfile::DESTINATION_TYPE_DEVICE) {
+        priority += 1;
+    }
 
-const QList<SyncSession *> &SyncQueue::getQueuedSyncSessions() const
-{
-    FUNCTION_CALL_TRACE(lcButeoTrace);
-    return iItems;
+    return priority;
 }
-
@@ -23,7 +23,10 @@
 #ifndef SYNCQUEUE_H
 #define SYNCQUEUE_H
 
-#include <QQueue>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QString>
 
 namespace Buteo {
 
@@ -31,17 +34,30 @@ class SyncSession;
 
 /*! \brief Class for queuing sync sessions.
  *
- * The queue is sorted every time when new items are added to it, so that
- * the sync sessions with highest priority will be at the front of the queue.
+ * The queue keeps one first in first out list per priority class, so that
+ * the sync sessions with highest priority will be at the front of the
+ * queue. Manual syncs go before sync on change syncs, which go before
+ * retries of failed syncs, which go before other scheduled syncs. Within
+ * each of these, device syncs go before online syncs. Sessions with equal
+ * priority are kept in the order they were queued. Sessions are also
+ * hashed by profile name, so that checking for a profile does not need to
+ * scan the queue.
+ *
+ * A profile can be in the queue only once.
  */
 class SyncQueue
 {
 public:
+    //! Constructor.
+    SyncQueue();
+
     /*! \brief Adds a new profile to the queue. Queue is sorted automatically.
      *
      * \param aSession Session to add to queue
+     * \return False if a session for the same profile is already queued.
+     *  The new session is then not added, and stays owned by the caller.
      */
-    void enqueue(SyncSession *aSession);
+    bool enqueue(SyncSession *aSession);
 
     /*! \brief Removes the sync session corresponding to the profile name and returns it.
      *
@@ -82,14 +98,36 @@ public:
     /*! \brief Returns as a const reference, the list of all SyncSessions
      * currently queued.
      *
-     * \return Is the profile in the queue.
+     * The priority lists are already in dequeue order, so the list is only
+     * concatenated from them, without sorting.
+     * \return The queued sessions, in the order they will be dequeued.
      */
     const QList<SyncSession *> &getQueuedSyncSessions() const;
 
 private:
-    void sort();
+    // Number of priority classes, see priority().
+    static const int PRIORITY_COUNT = 8;
+
+    struct Position {
+        int iPriority;
+        quint64 iSequence;
+    };
+
+    static int priority(const SyncSession *aSession);
+
+    // Queued sessions of each priority class by enqueue order, smaller
+    // class goes first.
+    QMap<quint64, SyncSession *> iQueues[PRIORITY_COUNT];
+
+    // Position of each queued profile.
+    QHash<QString, Position> iIndex;
+
+    quint64 iSequence;
+
+    // Sessions in dequeue order, built on demand.
+    mutable QList<SyncSession *> iOrdered;
 
-    QQueue<SyncSession *> iItems;
+    mutable bool iOrderedValid;
 };
 
 }
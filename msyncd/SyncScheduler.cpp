@@ -29,6 +29,7 @@
 #include "SyncScheduler.h"
 #include "SyncProfile.h"
 #include "SyncCommonDefs.h"
+#include "SyncClock.h"
 #include "LogMacros.h"
 #include <QtDBus/QtDBus>
 
@@ -43,7 +44,7 @@ SyncScheduler::SyncScheduler(QObject *aParent)
 #if defined(USE_KEEPALIVE)
     iBackgroundActivity = new BackgroundSync(this);
 
-    connect(iBackgroundActivity, SIGNAL(onBackgroundSyncRunning(QString)), this, SLOT(doIPHeartbeatActions(QString)));
+    connect(iBackgroundActivity, SIGNAL(onBackgroundSyncRunning(QString)), this, SLOT(doBackgroundSyncActions(QString)));
     connect(iBackgroundActivity, SIGNAL(onBackgroundSwitchRunning(QString)), this,
             SLOT(rescheduleBackgroundActivity(QString)));
 #elif defined(USE_IPHB)
@@ -95,7 +96,7 @@ void SyncScheduler::addProfileForSyncRetry(const SyncProfile *aProfile, QDateTim
     }
 }
 
-bool SyncScheduler::addProfile(const SyncProfile *aProfile)
+bool SyncScheduler::addProfile(const SyncProfile *aProfile, const QDateTime &aNextSyncTime)
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
 
@@ -107,7 +108,7 @@ bool SyncScheduler::addProfile(const SyncProfile *aProfile)
 #if defined(USE_KEEPALIVE)
     if (aProfile->isEnabled() &&
             aProfile->syncType() == SyncProfile::SYNC_SCHEDULED) {
-        setNextAlarm(aProfile);
+        setNextAlarm(aProfile, aNextSyncTime);
         return true;
     } else {
         removeProfile(aProfile->name());
@@ -122,7 +123,7 @@ bool SyncScheduler::addProfile(const SyncProfile *aProfile)
 
     if (aProfile->isEnabled() &&
             aProfile->syncType() == SyncProfile::SYNC_SCHEDULED) {
-        int alarmId = setNextAlarm(aProfile);
+        int alarmId = setNextAlarm(aProfile, aNextSyncTime);
         if (alarmId > 0) {
             iSyncScheduleProfiles.insert(aProfile->name(), alarmId);
             profileAdded = true;
@@ -137,23 +138,50 @@ bool SyncScheduler::addProfile(const SyncProfile *aProfile)
 #endif
 }
 
+int SyncScheduler::addProfiles(const QList<SyncProfile *> &aProfiles)
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    const QHash<QString, QDateTime> nextSyncTimes = SyncProfile::nextSyncTimes(aProfiles);
+    int added = 0;
+    foreach (const SyncProfile *profile, aProfiles) {
+        if (profile && addProfile(profile, nextSyncTimes.value(profile->name()))) {
+            ++added;
+        }
+    }
+    return added;
+}
+
 void SyncScheduler::removeProfile(const QString &aProfileName)
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
 #if defined(USE_KEEPALIVE)
+    iWakeupCoalescer.remove(aProfileName);
     if (iBackgroundActivity->remove(aProfileName)) {
         qCDebug(lcButeoMsyncd) << "Scheduled sync removed: profile =" << aProfileName;
     }
 #elif defined(USE_IPHB)
+    iWakeupCoalescer.remove(aProfileName);
     if (iSyncScheduleProfiles.contains(aProfileName)) {
-        int alarmEventID = iSyncScheduleProfiles.value(aProfileName);
-        removeAlarmEvent(alarmEventID);
-        iSyncScheduleProfiles.remove(aProfileName);
+        int alarmEventID = iSyncScheduleProfiles.take(aProfileName);
+        releaseAlarm(alarmEventID);
         qCDebug(lcButeoMsyncd) << "Scheduled sync removed: profile =" << aProfileName;
     }
 #endif
 }
 
+void SyncScheduler::setAlignmentWindow(int aSeconds)
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    iWakeupCoalescer.setWindow(aSeconds);
+}
+
+QVariantMap SyncScheduler::statistics() const
+{
+    return iWakeupCoalescer.statistics();
+}
+
 void SyncScheduler::doIPHeartbeatActions(QString aProfileName)
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
@@ -184,6 +212,19 @@ void SyncScheduler::syncStatusChanged(const QString &aProfileName, int aStatus,
 }
 
 #if defined(USE_KEEPALIVE)
+void SyncScheduler::doBackgroundSyncActions(QString aProfileName)
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    // The device is awake anyway, so start the other profiles due in the
+    // same wake-up slot too. Their background activities are stopped when
+    // their syncs complete.
+    const QStringList batch = iWakeupCoalescer.wakeUp(SyncClock::currentDateTime(), aProfileName);
+    foreach (const QString &profileName, batch) {
+        doIPHeartbeatActions(profileName);
+    }
+}
+
 void SyncScheduler::rescheduleBackgroundActivity(const QString &aProfileName)
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
@@ -219,15 +260,14 @@ int SyncScheduler::setNextAlarm(const SyncProfile *aProfile, QDateTime aNextSync
     }
 
     if (nextSyncTime.isValid()) {
-        // The existing event object can be used by just updating the alarm time
-        // and enqueuing it again.
+        nextSyncTime = iWakeupCoalescer.schedule(aProfile->name(), nextSyncTime);
 
 #if defined(USE_KEEPALIVE)
         alarmEventID = 1;
-        iBackgroundActivity->set(aProfile->name(), QDateTime::currentDateTime().secsTo(nextSyncTime) + 1);
+        iBackgroundActivity->set(aProfile->name(), SyncClock::currentDateTime().secsTo(nextSyncTime) + 1);
 
         if (aProfile->rushEnabled()) {
-            QDateTime nextSyncSwitch = aProfile->nextRushSwitchTime(QDateTime::currentDateTime());
+            QDateTime nextSyncSwitch = aProfile->nextRushSwitchTime(SyncClock::currentDateTime());
             if (nextSyncSwitch.isValid()) {
                 iBackgroundActivity->setSwitch(aProfile->name(), nextSyncSwitch);
             } else {
@@ -239,19 +279,20 @@ int SyncScheduler::setNextAlarm(const SyncProfile *aProfile, QDateTime aNextSync
             iBackgroundActivity->removeSwitch(aProfile->name());
         }
 #elif defined(USE_IPHB)
-        iAlarmInventory->addAlarm(nextSyncTime);
+        alarmEventID = alarmForSlot(nextSyncTime);
 #endif
         if (alarmEventID == 0) {
             qCWarning(lcButeoMsyncd) << "Failed to add alarm for scheduled sync of profile"
                         << aProfile->name();
         }
     } else {
+        iWakeupCoalescer.remove(aProfile->name());
 #if defined(USE_KEEPALIVE)
         // no valid next scheduled sync time for background sync.
         // stop the background activity to allow device suspend.
         iBackgroundActivity->remove(aProfile->name());
         if (aProfile->rushEnabled()) {
-            QDateTime nextSyncSwitch = aProfile->nextRushSwitchTime(QDateTime::currentDateTime());
+            QDateTime nextSyncSwitch = aProfile->nextRushSwitchTime(SyncClock::currentDateTime());
             if (nextSyncSwitch.isValid()) {
                 iBackgroundActivity->setSwitch(aProfile->name(), nextSyncSwitch);
             } else {
@@ -273,19 +314,59 @@ void SyncScheduler::doAlarmActions(int aAlarmEventID)
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
 
-    const QString syncProfileName
-        = iSyncScheduleProfiles.key(aAlarmEventID);
+    // The alarm is gone from the inventory once triggered.
+    const qint64 slotTime = iSlotAlarms.key(aAlarmEventID, -1);
+    if (slotTime >= 0) {
+        iSlotAlarms.remove(slotTime);
+    }
+
+    // Dispatch all profiles of this wake-up slot as one batch.
+    QStringList batch = iSyncScheduleProfiles.keys(aAlarmEventID);
+    foreach (const QString &profileName, iWakeupCoalescer.wakeUp(SyncClock::currentDateTime())) {
+        if (!batch.contains(profileName)) {
+            batch.append(profileName);
+        }
+    }
 
-    if (!syncProfileName.isEmpty()) {
-        iSyncScheduleProfiles.remove(syncProfileName);
+    foreach (const QString &syncProfileName, batch) {
+        if (!iSyncScheduleProfiles.contains(syncProfileName)) {
+            continue;
+        }
+        int alarmEventID = iSyncScheduleProfiles.take(syncProfileName);
+        if (alarmEventID != aAlarmEventID) {
+            releaseAlarm(alarmEventID);
+        }
         // Use global slots (min time == max time) for scheduling heart beats.
         if (iIPHeartBeatMan->setHeartBeat(syncProfileName, IPHB_GS_WAIT_2_5_MINS, IPHB_GS_WAIT_2_5_MINS)) {
             //Do nothing, sync will be triggered on getting heart beat
         } else {
             emit syncNow(syncProfileName);
         }
-    } // no else, in error cases simply ignore
+    }
+}
+
+int SyncScheduler::alarmForSlot(const QDateTime &aSlot)
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    const qint64 slotTime = aSlot.toMSecsSinceEpoch();
+    int alarmEventID = iSlotAlarms.value(slotTime, 0);
+    if (alarmEventID <= 0) {
+        alarmEventID = iAlarmInventory->addAlarm(aSlot);
+        if (alarmEventID > 0) {
+            iSlotAlarms.insert(slotTime, alarmEventID);
+        }
+    }
+    return alarmEventID;
+}
 
+void SyncScheduler::releaseAlarm(int aAlarmEventID)
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    if (aAlarmEventID > 0 && iSyncScheduleProfiles.key(aAlarmEventID).isEmpty()) {
+        removeAlarmEvent(aAlarmEventID);
+    }
 }
 
 void SyncScheduler::removeAlarmEvent(int aAlarmEventID)
@@ -294,6 +375,11 @@ void SyncScheduler::removeAlarmEvent(int aAlarmEventID)
 
     bool err = iAlarmInventory->removeAlarm(aAlarmEventID);
 
+    const qint64 slotTime = iSlotAlarms.key(aAlarmEventID, -1);
+    if (slotTime >= 0) {
+        iSlotAlarms.remove(slotTime);
+    }
+
     if (err < false) {
         qCWarning(lcButeoMsyncd) << "No alarm found for ID " << aAlarmEventID;
     } else {
@@ -306,5 +392,6 @@ void SyncScheduler::removeAllAlarms()
     FUNCTION_CALL_TRACE(lcButeoTrace);
 
     iAlarmInventory->removeAllAlarms();
+    iSlotAlarms.clear();
 }
 #endif
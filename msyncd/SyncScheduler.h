@@ -30,11 +30,13 @@
 #include "SyncAlarmInventory.h"
 #include "IPHeartBeat.h"
 #endif
+#include "WakeupCoalescer.h"
 #include <QObject>
 #include <QMap>
 #include <QSet>
 #include <QString>
 #include <QDateTime>
+#include <QVariantMap>
 #include <ctime>
 
 class QDateTime;
@@ -74,9 +76,20 @@ public:
      * this function again after the sync has finished to continue scheduling
      * syncs for the profile.
      * \param aProfile Profile to add to scheduler.
+     * \param aNextSyncTime Next sync time of the profile if already known,
+     *  otherwise it is calculated from the profile.
      * \return Success indicator.
      */
-    bool addProfile(const SyncProfile *aProfile);
+    bool addProfile(const SyncProfile *aProfile, const QDateTime &aNextSyncTime = QDateTime());
+
+    /*! \brief Adds several profiles to the scheduler.
+     *
+     * The next sync times of all profiles are calculated in one pass.
+     * \see addProfile
+     * \param aProfiles Profiles to add to scheduler.
+     * \return Number of profiles added.
+     */
+    int addProfiles(const QList<SyncProfile *> &aProfiles);
 
     /* Schedule a retry for a failed sync if the profile has retries enabled
      *
@@ -94,6 +107,21 @@ public:
      */
     void removeProfile(const QString &aProfileName);
 
+    /*! \brief Sets the window for aligning scheduled syncs to shared
+     *  wake-ups.
+     *
+     * \see WakeupCoalescer::setWindow
+     * \param aSeconds Window length in seconds, zero to disable alignment.
+     */
+    void setAlignmentWindow(int aSeconds);
+
+    /*! \brief Gets statistics about scheduled wake-ups.
+     *
+     * \see WakeupCoalescer::statistics
+     * \return Statistics by name.
+     */
+    QVariantMap statistics() const;
+
 public slots:
     /*! \brief Handles the sync status change signal from the synchronizer
      *
@@ -127,6 +155,13 @@ private slots:
     void doIPHeartbeatActions(QString aProfileName);
 
 #if defined(USE_KEEPALIVE)
+    /**
+     * \brief Starts the syncs due when a background activity wakes up
+     *
+     * @param aProfileName Name of the profile of the background activity
+     */
+    void doBackgroundSyncActions(QString aProfileName);
+
     /**
      * \brief Reschedule backgroundActivity for a profile
      *
@@ -176,18 +211,38 @@ private: // functions
      * \brief A convenience method that removes all alarms from alarmd queue
      */
     void removeAllAlarms();
+
+    /**
+     * \brief Gets the alarm of a wake-up slot, adding it if needed
+     * @param aSlot Time of the wake-up slot
+     * @return Alarm event ID or 0 in failure case.
+     */
+    int alarmForSlot(const QDateTime &aSlot);
+
+    /**
+     * \brief Removes an alarm if no scheduled profile uses it any more
+     * @param aAlarmEventID ID of the alarm
+     */
+    void releaseAlarm(int aAlarmEventID);
 #endif
 
 private: // data
     QSet<QString> iActiveBackgroundSyncProfiles;
+
+    /// Wake-up slots of the scheduled profiles
+    WakeupCoalescer iWakeupCoalescer;
 #if defined(USE_KEEPALIVE)
     /// BackgroundSync management object
     BackgroundSync *iBackgroundActivity;
     ProfileManager iProfileManager;
 #elif defined(USE_IPHB)
-    /// A list of sync schedule profiles
+    /// A list of sync schedule profiles. Profiles in the same wake-up slot
+    /// share an alarm.
     QMap<QString, int> iSyncScheduleProfiles;
 
+    /// Alarm IDs by wake-up slot time in msecs since epoch
+    QMap<qint64, int> iSlotAlarms;
+
     /// Alarm factory object
     SyncAlarmInventory *iAlarmInventory;
 
@@ -38,6 +38,8 @@ SyncSession::SyncSession(SyncProfile *aProfile, QObject *aParent)
     , iErrorCode(SyncResults::NO_ERROR)
     , iPluginRunnerOwned(false)
     , iScheduled(false)
+    , iRetry(false)
+    , iSyncOnChange(false)
     , iAborted(false)
     , iStarted(false)
     , iFinished(false)
@@ -265,6 +267,34 @@ bool SyncSession::isScheduled() const
     return iScheduled;
 }
 
+void SyncSession::setRetry(bool aRetry)
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    iRetry = aRetry;
+}
+
+bool SyncSession::isRetry() const
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    return iRetry;
+}
+
+void SyncSession::setSyncOnChange(bool aSyncOnChange)
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    iSyncOnChange = aSyncOnChange;
+}
+
+bool SyncSession::isSyncOnChange() const
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    return iSyncOnChange;
+}
+
 void SyncSession::onSuccess(const QString &aProfileName, const QString &aMessage)
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
@@ -392,7 +422,8 @@ bool SyncSession::reserveStorages(StorageBooker *aStorageBooker)
     bool success = false;
     if (aStorageBooker != 0 && iProfile != 0 &&
             aStorageBooker->reserveStorages(iProfile->storageBackendNames(),
-                                            iProfile->name())) {
+                                            iProfile->name(),
+                                            storageReservationMode())) {
         success = true;
         iStorageBooker = aStorageBooker;
     }
@@ -400,11 +431,22 @@ bool SyncSession::reserveStorages(StorageBooker *aStorageBooker)
     return success;
 }
 
+StorageBooker::ReservationMode SyncSession::storageReservationMode() const
+{
+    const SyncProfile *profile = iProfile;
+    if (profile != 0 && profile->clientProfile() != 0 &&
+            profile->syncDirection() == SyncProfile::SYNC_DIRECTION_TO_REMOTE) {
+        return StorageBooker::Shared;
+    }
+    return StorageBooker::Exclusive;
+}
+
 void SyncSession::releaseStorages()
 {
     // Release storages that were reserved earlier.
     if (iStorageBooker != 0 && iProfile != 0) {
-        iStorageBooker->releaseStorages(iProfile->storageBackendNames());
+        iStorageBooker->releaseStorages(iProfile->storageBackendNames(),
+                                        iProfile->name());
     }
 
     // Set storage booker to nullptr. This indicates that we don't hold any
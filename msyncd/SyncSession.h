@@ -26,6 +26,7 @@
 
 #include "SyncCommonDefs.h"
 #include "SyncResults.h"
+#include "StorageBooker.h"
 #include <QObject>
 #include <QMap>
 
@@ -33,7 +34,6 @@ namespace Buteo {
 
 class SyncProfile;
 class PluginRunner;
-class StorageBooker;
 class NetworkManager;
 
 /*! \brief Class representing a single sync session
@@ -131,6 +131,30 @@ public:
      */
     bool isScheduled() const;
 
+    /*! \brief Sets if the session retries a failed scheduled sync
+     *
+     * @param aRetry True if a retry, false otherwise
+     */
+    void setRetry(bool aRetry);
+
+    /*! \brief Checks if the session retries a failed scheduled sync
+     *
+     * @return True if a retry, false otherwise
+     */
+    bool isRetry() const;
+
+    /*! \brief Sets if the session was started by sync on change
+     *
+     * @param aSyncOnChange True if started by sync on change, false otherwise
+     */
+    void setSyncOnChange(bool aSyncOnChange);
+
+    /*! \brief Checks if the session was started by sync on change
+     *
+     * @return True if started by sync on change, false otherwise
+     */
+    bool isSyncOnChange() const;
+
     /*! \brief Sets the results for this session
      *
      * This function can be used in error situations to set the results to this
@@ -162,6 +186,15 @@ public:
      */
     bool reserveStorages(StorageBooker *aStorageBooker);
 
+    /*! \brief Gets the mode in which the session reserves its storages.
+     *
+     * Client profiles that only sync to the remote side just read the local
+     * storages, so they can share them with other such sessions. All other
+     * sessions reserve their storages exclusively.
+     * @return Reservation mode.
+     */
+    StorageBooker::ReservationMode storageReservationMode() const;
+
     //! \brief Releases storages that were reserved earlier with reserveStorages
     void releaseStorages();
 
@@ -238,6 +271,8 @@ private:
     SyncResults::MinorCode iErrorCode;
     bool iPluginRunnerOwned;
     bool iScheduled;
+    bool iRetry;
+    bool iSyncOnChange;
     bool iAborted;
     bool iStarted;
     bool iFinished;
@@ -0,0 +1,154 @@
+/*
+ * This file is part of buteo-syncfw package
+ *
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+
+#include "WakeupCoalescer.h"
+#include "LogMacros.h"
+
+using namespace Buteo;
+
+WakeupCoalescer::WakeupCoalescer()
+    : iWindow(0),
+      iFirstWakeup(0),
+      iLastWakeup(0),
+      iWakeups(0),
+      iDispatched(0),
+      iScheduled(0),
+      iTotalDelay(0)
+{
+}
+
+void WakeupCoalescer::setWindow(int aSeconds)
+{
+    iWindow = qMax(aSeconds, 0);
+    qCDebug(lcButeoMsyncd) << "Scheduled sync alignment window" << iWindow << "seconds";
+}
+
+int WakeupCoalescer::window() const
+{
+    return iWindow;
+}
+
+QDateTime WakeupCoalescer::schedule(const QString &aProfileName, const QDateTime &aDeadline)
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    takeFromSlot(aProfileName);
+
+    const qint64 deadline = aDeadline.toMSecsSinceEpoch();
+    qint64 slotTime = deadline;
+    if (iWindow > 0) {
+        // Round up to the window grid, so that profiles with close
+        // deadlines end up in the same slot whatever order they come in.
+        const qint64 window = qint64(iWindow) * 1000;
+        slotTime = ((deadline + window - 1) / window) * window;
+    }
+
+    iSlots[slotTime].append(aProfileName);
+    iProfileSlots.insert(aProfileName, slotTime);
+    ++iScheduled;
+    iTotalDelay += slotTime - deadline;
+
+    qCDebug(lcButeoMsyncd) << "Profile" << aProfileName << "aligned to slot"
+                           << QDateTime::fromMSecsSinceEpoch(slotTime) << "with"
+                           << iSlots.value(slotTime).size() << "profiles";
+    return QDateTime::fromMSecsSinceEpoch(slotTime);
+}
+
+void WakeupCoalescer::remove(const QString &aProfileName)
+{
+    takeFromSlot(aProfileName);
+}
+
+QDateTime WakeupCoalescer::slot(const QString &aProfileName) const
+{
+    if (!iProfileSlots.contains(aProfileName)) {
+        return QDateTime();
+    }
+    return QDateTime::fromMSecsSinceEpoch(iProfileSlots.value(aProfileName));
+}
+
+QStringList WakeupCoalescer::wakeUp(const QDateTime &aNow, const QString &aProfileName)
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    QStringList batch;
+    if (!aProfileName.isEmpty()) {
+        takeFromSlot(aProfileName);
+        batch.append(aProfileName);
+    }
+
+    // Only half a window ahead, so that a wake-up at one grid slot does not
+    // take the next one as well.
+    const qint64 limit = aNow.toMSecsSinceEpoch() + qint64(iWindow) * 500;
+    while (!iSlots.isEmpty() && iSlots.firstKey() <= limit) {
+        foreach (const QString &profileName, iSlots.first()) {
+            iProfileSlots.remove(profileName);
+            if (!batch.contains(profileName)) {
+                batch.append(profileName);
+            }
+        }
+        iSlots.erase(iSlots.begin());
+    }
+
+    if (!batch.isEmpty()) {
+        if (iWakeups == 0) {
+            iFirstWakeup = aNow.toMSecsSinceEpoch();
+        }
+        iLastWakeup = aNow.toMSecsSinceEpoch();
+        ++iWakeups;
+        iDispatched += batch.size();
+        qCDebug(lcButeoMsyncd) << "Wake-up dispatches" << batch;
+    }
+    return batch;
+}
+
+QVariantMap WakeupCoalescer::statistics() const
+{
+    const qint64 elapsed = iLastWakeup - iFirstWakeup;
+
+    QVariantMap stats;
+    stats.insert("alignmentWindow", iWindow);
+    stats.insert("scheduledWakeups", iWakeups);
+    stats.insert("scheduledSyncs", iDispatched);
+    stats.insert("pendingWakeSlots", iSlots.size());
+    // The rate is measured between the first and the last wake-up.
+    stats.insert("wakeupsPerHour", elapsed > 0 ? (iWakeups - 1) * 3600000.0 / elapsed : 0.0);
+    stats.insert("syncsPerWakeup", iWakeups > 0 ? double(iDispatched) / iWakeups : 0.0);
+    stats.insert("averageAlignmentDelayMs", iScheduled > 0 ? iTotalDelay / iScheduled : 0);
+    return stats;
+}
+
+void WakeupCoalescer::takeFromSlot(const QString &aProfileName)
+{
+    QHash<QString, qint64>::iterator it = iProfileSlots.find(aProfileName);
+    if (it == iProfileSlots.end()) {
+        return;
+    }
+
+    QMap<qint64, QStringList>::iterator slotIt = iSlots.find(it.value());
+    if (slotIt != iSlots.end()) {
+        slotIt.value().removeAll(aProfileName);
+        if (slotIt.value().isEmpty()) {
+            iSlots.erase(slotIt);
+        }
+    }
+    iProfileSlots.erase(it);
+}
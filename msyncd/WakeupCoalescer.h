@@ -0,0 +1,127 @@
+/*
+ * This file is part of buteo-syncfw package
+ *
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+#ifndef WAKEUPCOALESCER_H
+#define WAKEUPCOALESCER_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+
+namespace Buteo {
+
+/*! \brief Aligns scheduled sync deadlines to shared wake-up slots.
+ *
+ * Without alignment every scheduled profile wakes the device at its own
+ * deadline. With an alignment window of W seconds, deadlines are delayed to
+ * the next multiple of W since the epoch, so profiles with deadlines close
+ * to each other share one wake-up. When the device wakes up, all profiles
+ * whose slot is due, or at most half a window ahead, are dispatched
+ * together.
+ *
+ * The coalescer does not own any timers. The scheduler arms its backend
+ * timer for the returned slot and reports wake-ups with wakeUp(). Times are
+ * passed in by the caller.
+ */
+class WakeupCoalescer
+{
+public:
+    //! \brief Constructor. Alignment is disabled until a window is set.
+    WakeupCoalescer();
+
+    /*! \brief Sets the alignment window.
+     *
+     * Already scheduled profiles keep their slots.
+     * \param aSeconds Window length in seconds. Zero or less disables
+     *  alignment.
+     */
+    void setWindow(int aSeconds);
+
+    /*! \brief Gets the alignment window.
+     *
+     * \return Window length in seconds, zero if alignment is disabled.
+     */
+    int window() const;
+
+    /*! \brief Schedules a profile for a deadline.
+     *
+     * A previous slot of the profile is replaced.
+     * \param aProfileName Name of the profile.
+     * \param aDeadline Time the profile should be synced.
+     * \return Wake-up slot of the profile, never earlier than the deadline.
+     */
+    QDateTime schedule(const QString &aProfileName, const QDateTime &aDeadline);
+
+    /*! \brief Removes a profile from its slot.
+     *
+     * \param aProfileName Name of the profile.
+     */
+    void remove(const QString &aProfileName);
+
+    /*! \brief Gets the slot of a profile.
+     *
+     * \param aProfileName Name of the profile.
+     * \return Wake-up slot, invalid if the profile is not scheduled.
+     */
+    QDateTime slot(const QString &aProfileName) const;
+
+    /*! \brief Records a wake-up and takes the profiles to dispatch.
+     *
+     * \param aNow Time of the wake-up.
+     * \param aProfileName Profile that caused the wake-up, if known. It is
+     *  always part of the batch.
+     * \return Profiles to sync now. They are removed from their slots.
+     */
+    QStringList wakeUp(const QDateTime &aNow, const QString &aProfileName = QString());
+
+    /*! \brief Gets the alignment statistics.
+     *
+     * The statistics contain the window, the number of wake-ups and synced
+     * profiles, the achieved wake-ups per hour between the first and the
+     * last wake-up, and the average delay added by alignment.
+     * \return Statistics by name.
+     */
+    QVariantMap statistics() const;
+
+private:
+    void takeFromSlot(const QString &aProfileName);
+
+    int iWindow;
+
+    // Profiles by slot time in msecs since epoch.
+    QMap<qint64, QStringList> iSlots;
+
+    // Slot time of each scheduled profile.
+    QHash<QString, qint64> iProfileSlots;
+
+    qint64 iFirstWakeup;
+    qint64 iLastWakeup;
+    int iWakeups;
+    int iDispatched;
+    int iScheduled;
+    qint64 iTotalDelay;
+};
+
+}
+
+#endif // WAKEUPCOALESCER_H
@@ -49,6 +49,11 @@ HEADERS += ServerActivator.h \
     ServerThread.h \
     StorageBooker.h \
     SyncQueue.h \
+    SyncHistory.h \
+    SessionExecutor.h \
+    WakeupCoalescer.h \
+    OnlineSyncRamp.h \
+    ProfileChangeDebouncer.h \
     SyncScheduler.h \
     SyncBackup.h \
     AccountsHelper.h \
@@ -69,6 +74,11 @@ SOURCES += ServerActivator.cpp \
     ServerThread.cpp \
     StorageBooker.cpp \
     SyncQueue.cpp \
+    SyncHistory.cpp \
+    SessionExecutor.cpp \
+    WakeupCoalescer.cpp \
+    OnlineSyncRamp.cpp \
+    ProfileChangeDebouncer.cpp \
     SyncScheduler.cpp \
     SyncBackup.cpp \
     AccountsHelper.cpp \
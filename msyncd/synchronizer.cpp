@@ -48,6 +48,9 @@
 #include <qmcepowersavemode.h>
 #endif
 #include <QtDebug>
+#include <QDir>
+#include <QFile>
+#include <QXmlStreamReader>
 #include <fcntl.h>
 #include <termios.h>
 
@@ -56,6 +59,7 @@ using namespace Buteo;
 static const QString SYNC_DBUS_OBJECT = "/synchronizer";
 static const QString SYNC_DBUS_SERVICE = "com.meego.msyncd";
 static const QString BT_PROPERTIES_NAME = "Name";
+static const QString STORAGE_WAIT_PREFIX = "storage:";
 
 class Buteo::BatteryInfo
 {
@@ -106,6 +110,12 @@ Synchronizer::Synchronizer(QCoreApplication *aApplication)
     iProfileChangeTriggerTimer.setSingleShot(true);
     connect(&iProfileChangeTriggerTimer, &QTimer::timeout,
             this, &Synchronizer::profileChangeTriggerTimeout);
+    iProfileChangeClock.start();
+
+    iOnlineSyncRampClock.start();
+    iOnlineSyncRampTimer.setSingleShot(true);
+    connect(&iOnlineSyncRampTimer, &QTimer::timeout,
+            this, &Synchronizer::releaseOnlineSyncs);
 }
 
 Synchronizer::~Synchronizer()
@@ -123,6 +133,27 @@ bool Synchronizer::initialize()
 
     qCDebug(lcButeoMsyncd) << "Starting msyncd";
 
+    iProfileManager.setProfileStoreEnabled(
+        g_settings_get_boolean(iSettings, "compiled-profile-store"));
+
+    // The logs are imported once. Databases created before the import was
+    // recorded were imported already if they have any results.
+    if (iSyncHistory.init() && !iSyncHistory.isImported()) {
+        if (iSyncHistory.isEmpty()) {
+            importSyncHistory();
+        }
+        iSyncHistory.setImported();
+    }
+
+    iSessionExecutor.setLimits(g_settings_get_int(iSettings, "max-parallel-syncs"),
+                               g_settings_get_int(iSettings, "max-parallel-syncs-per-client"),
+                               g_settings_get_int(iSettings, "max-parallel-syncs-per-host"));
+    iOnlineSyncRamp.setPolicy(g_settings_get_int(iSettings, "online-sync-burst"),
+                              g_settings_get_int(iSettings, "online-syncs-per-second"),
+                              g_settings_get_int(iSettings, "online-sync-jitter"));
+    iProfileChangeDebouncer.setDelays(g_settings_get_int(iSettings, "profile-change-sync-delay"),
+                                      g_settings_get_int(iSettings, "profile-change-sync-max-delay"));
+
     // Create a D-Bus adaptor. It will get deleted when the Synchronizer is
     // deleted.
     new SyncDBusAdaptor(this);
@@ -137,6 +168,14 @@ bool Synchronizer::initialize()
         qCDebug(lcButeoMsyncd) << "Registered to D-Bus";
     } // else ok
 
+    // Older versions kept the alarms in a database that was cleared on
+    // every start and never read. Alarms are added again by the scheduler.
+    QString alarmDb(Sync::syncConfigDir());
+    alarmDb.append(QDir::separator()).append("alarms.db.sqlite");
+    if (QFile::exists(alarmDb) && !QFile::remove(alarmDb)) {
+        qCWarning(lcButeoMsyncd) << "Failed to remove the old alarm database" << alarmDb;
+    }
+
     connect(this, SIGNAL(syncStatus(QString, int, QString, int)),
             this, SLOT(slotSyncStatus(QString, int, QString, int)),
             Qt::QueuedConnection);
@@ -169,8 +208,8 @@ bool Synchronizer::initialize()
     connect(iAccounts, SIGNAL(removeScheduledSync(QString)),
             this, SLOT(removeScheduledSync(QString)),
             Qt::QueuedConnection);
-    connect(this, SIGNAL(storageReleased()),
-            this, SLOT(onStorageReleased()), Qt::QueuedConnection);
+    connect(&iStorageBooker, SIGNAL(storageReleased(QString)),
+            this, SLOT(onStorageReleased(QString)), Qt::QueuedConnection);
 
     startServers();
 
@@ -205,7 +244,7 @@ bool Synchronizer::initialize()
             }
         } else {
             QObject::connect(&iSyncOnChangeScheduler, SIGNAL(syncNow(QString)),
-                             this, SLOT(startScheduledSync(QString)),
+                             this, SLOT(startSyncOnChange(QString)),
                              Qt::QueuedConnection);
             iSOCEnabled = true;
         }
@@ -218,28 +257,33 @@ bool Synchronizer::initialize()
 void Synchronizer::enableSOCSlot(const QString &aProfileName)
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
-    SyncProfile *profile = iProfileManager.syncProfile(aProfileName);
-    if (profile && profile->isSOCProfile()) {
+    enableSOC(iProfileManager.syncProfile(aProfileName));
+}
+
+void Synchronizer::enableSOC(SyncProfile *aProfile)
+{
+    if (aProfile && aProfile->isSOCProfile()) {
+        const QString profileName = aProfile->name();
         if (iSOCEnabled) {
-            iSyncOnChange.addProfile("hcontacts", profile);
+            iSyncOnChange.addProfile("hcontacts", aProfile);
         } else {
             QHash<QString, QList<SyncProfile *> > aSOCStorageMap;
             QList<SyncProfile *> SOCProfiles;
-            SOCProfiles.append(profile);
+            SOCProfiles.append(aProfile);
             aSOCStorageMap["hcontacts"] = SOCProfiles;
             QStringList aFailedStorages;
             if (iSyncOnChange.enable(aSOCStorageMap, &iSyncOnChangeScheduler, &iPluginManager, aFailedStorages)) {
                 QObject::connect(&iSyncOnChangeScheduler, SIGNAL(syncNow(const QString &)),
-                                 this, SLOT(startScheduledSync(const QString &)),
+                                 this, SLOT(startSyncOnChange(const QString &)),
                                  Qt::QueuedConnection);
                 iSOCEnabled = true;
-                qCDebug(lcButeoMsyncd) << "Sync on change enabled for profile" << aProfileName;
+                qCDebug(lcButeoMsyncd) << "Sync on change enabled for profile" << profileName;
             } else {
-                qCCritical(lcButeoMsyncd) << "Sync on change couldn't be enabled for profile" << aProfileName;
+                qCCritical(lcButeoMsyncd) << "Sync on change couldn't be enabled for profile" << profileName;
             }
         }
     } else {
-        delete profile;
+        delete aProfile;
     }
 }
 
@@ -295,7 +339,31 @@ bool Synchronizer::startScheduledSync(QString aProfileName)
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
 
-    SyncProfile *profile = iProfileManager.syncProfile(aProfileName);
+    return startScheduledSync(aProfileName, false);
+}
+
+void Synchronizer::startSyncOnChange(const QString &aProfileName)
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    startScheduledSync(aProfileName, true);
+}
+
+bool Synchronizer::startScheduledSync(const QString &aProfileName, bool aSyncOnChange,
+                                      SyncProfile *aProfile)
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    // A sync on change carries the changes collected for it. They are taken
+    // now, so that they are dropped rather than attached to the next
+    // scheduled sync if this one is not started. A sync started later
+    // without them syncs everything.
+    StorageChangeSet changes;
+    if (aSyncOnChange) {
+        changes = iSyncOnChangeScheduler.takeChangeSet(aProfileName);
+    }
+
+    SyncProfile *profile = aProfile ? aProfile : iProfileManager.syncProfile(aProfileName);
 
     // All scheduled syncs are online syncs
     // Add this to the waiting online syncs and it will be started when we
@@ -305,7 +373,7 @@ bool Synchronizer::startScheduledSync(QString aProfileName)
         /* Ensure that current time is compatible with sync schedule.
            The Background process may have started a sync in a period
            where sync is disabled due to delayed interval wake up. */
-        bool wrongTime = (profile && !profile->syncSchedule().isSyncScheduled(QDateTime::currentDateTime(),
+        bool wrongTime = (profile && !profile->syncSchedule().isSyncScheduled(SyncClock::currentDateTime(),
                                                                               profile->lastSuccessfulSyncTime()));
         if (wrongTime) {
             qCDebug(lcButeoMsyncd) << "Woken up of" << aProfileName << "in a disabled period, not starting sync.";
@@ -319,7 +387,8 @@ bool Synchronizer::startScheduledSync(QString aProfileName)
         } else {
             qCDebug(lcButeoMsyncd) << "Scheduled sync of" << aProfileName << "accepted with current connection type" <<
                       iNetworkManager->connectionType();
-            startSync(aProfileName, true);
+            startSync(aProfileName, profile, true, aSyncOnChange, changes);
+            profile = 0;
         }
     } else {
         qCInfo(lcButeoMsyncd) << "Wait for internet connection:" << aProfileName;
@@ -360,16 +429,46 @@ bool Synchronizer::setSyncSchedule(QString aProfileId, QString aScheduleAsXml)
 
 bool Synchronizer::saveSyncResults(QString aProfileId, QString aSyncResults)
 {
-    QDomDocument doc;
-    bool status = false;
-    if (doc.setContent(aSyncResults, true)) {
-        Buteo::SyncResults results(doc.documentElement());
-        status = iProfileManager.saveSyncResults(aProfileId, results);
-    } else {
-        qCCritical(lcButeoMsyncd) << "Invalid Profile Xml Received from msyncd";
+    QXmlStreamReader reader(aSyncResults);
+    if (reader.readNextStartElement()) {
+        Buteo::SyncResults results(reader);
+        if (!reader.hasError()) {
+            return recordSyncResults(aProfileId, results);
+        }
     }
 
-    return status;
+    qCCritical(lcButeoMsyncd) << "Invalid Profile Xml Received from msyncd";
+    return false;
+}
+
+bool Synchronizer::recordSyncResults(const QString &aProfileName, const SyncResults &aResults)
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    iSyncHistory.addResults(aProfileName, aResults);
+    return iProfileManager.saveSyncResults(aProfileName, aResults);
+}
+
+bool Synchronizer::recordSyncResults(const SyncProfile &aProfile, const SyncResults &aResults)
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    iSyncHistory.addResults(aProfile.name(), aResults);
+    return iProfileManager.saveSyncResults(aProfile, aResults);
+}
+
+void Synchronizer::importSyncHistory()
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    QList<SyncProfile *> profiles = iProfileManager.allSyncProfiles();
+    foreach (SyncProfile *profile, profiles) {
+        const SyncLog *log = profile->log();
+        if (log) {
+            iSyncHistory.addLog(*log);
+        }
+    }
+    qDeleteAll(profiles);
 }
 
 QString Synchronizer::createSyncProfileForAccount(uint aAccountId)
@@ -380,7 +479,16 @@ QString Synchronizer::createSyncProfileForAccount(uint aAccountId)
     return QString();
 }
 
-bool Synchronizer::startSync(const QString &aProfileName, bool aScheduled)
+bool Synchronizer::startSync(const QString &aProfileName, bool aScheduled,
+                             bool aSyncOnChange, const StorageChangeSet &aChanges)
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    return startSync(aProfileName, 0, aScheduled, aSyncOnChange, aChanges);
+}
+
+bool Synchronizer::startSync(const QString &aProfileName, SyncProfile *aProfile, bool aScheduled,
+                             bool aSyncOnChange, const StorageChangeSet &aChanges)
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
 
@@ -389,9 +497,10 @@ bool Synchronizer::startSync(const QString &aProfileName, bool aScheduled)
     if (isBackupRestoreInProgress()) {
         SyncResults syncResults(QDateTime::currentDateTime(), SyncResults::SYNC_RESULT_FAILED,
                                 Buteo::SyncResults::BACKUP_IN_PROGRESS);
-        iProfileManager.saveSyncResults(aProfileName, syncResults);
+        recordSyncResults(aProfileName, syncResults);
         emit syncStatus(aProfileName, Sync::SYNC_NOTPOSSIBLE, "Backup in progress, cannot start sync",
                         Buteo::SyncResults::BACKUP_IN_PROGRESS);
+        delete aProfile;
         return success;
     }
 
@@ -401,21 +510,28 @@ bool Synchronizer::startSync(const QString &aProfileName, bool aScheduled)
     // If we receive a manual sync to a profile that is peding to sync due a
     // data change we can remove it from the iSyncOnChangeScheduler, to avoid a
     // second sync.
-    iSyncOnChangeScheduler.removeProfile(aProfileName);
+    iSyncOnChangeScheduler.cancelSync(aProfileName);
 
     // Do the same if the profile is pending sync due to a profile change.
-    for (int i = iProfileChangeTriggerQueue.size() - 1; i >= 0; --i) {
-        if (iProfileChangeTriggerQueue[i].first == aProfileName) {
-            qCDebug(lcButeoMsyncd) << "Removing queued profile change sync due to sync trigger:" << aProfileName;
-            iProfileChangeTriggerQueue.removeAt(i);
-        }
+    if (iProfileChangeDebouncer.remove(aProfileName)) {
+        qCDebug(lcButeoMsyncd) << "Removing queued profile change sync due to sync trigger:" << aProfileName;
     }
 
     if (iActiveSessions.contains(aProfileName)) {
         qCDebug(lcButeoMsyncd) << "Sync already in progress";
+        const SyncProfile *activeProfile = iActiveSessions.value(aProfileName)->profile();
+        if (!aChanges.isEmpty() ||
+                (activeProfile != 0 && !activeProfile->changeSet().isEmpty())) {
+            // The session may have read the storages already, and a
+            // partial session does not cover a full sync request.
+            addChangesAfterSession(aProfileName, aChanges);
+        }
+        delete aProfile;
         return true;
     } else if (iSyncQueue.contains(aProfileName)) {
         qCDebug(lcButeoMsyncd) << "Sync request already in queue";
+        mergeQueuedChanges(aProfileName, aChanges);
+        delete aProfile;
         emit syncStatus(aProfileName, Sync::SYNC_QUEUED, "", 0);
         return true;
     } else if (!aScheduled && iWaitingOnlineSyncs.contains(aProfileName)) {
@@ -423,34 +539,50 @@ bool Synchronizer::startSync(const QString &aProfileName, bool aScheduled)
         // if sync is not scheduled remove it from iWaitingOnlineSyncs to avoid
         // sync it twice later
         iWaitingOnlineSyncs.removeOne(aProfileName);
+        iOnlineSyncRamp.remove(aProfileName);
         qCDebug(lcButeoMsyncd) << "Removing" << aProfileName << "from online waiting list.";
     }
 
-    SyncProfile *profile = iProfileManager.syncProfile(aProfileName);
+    SyncProfile *profile = aProfile ? aProfile : iProfileManager.syncProfile(aProfileName);
     if (!profile) {
         qCWarning(lcButeoMsyncd) << "Profile not found";
         SyncResults syncResults(QDateTime::currentDateTime(), SyncResults::SYNC_RESULT_FAILED,
                                 Buteo::SyncResults::INTERNAL_ERROR);
-        iProfileManager.saveSyncResults(aProfileName, syncResults);
+        recordSyncResults(aProfileName, syncResults);
         emit syncStatus(aProfileName, Sync::SYNC_ERROR, "Internal Error", Buteo::SyncResults::INTERNAL_ERROR);
         return false;
     } else if (false == profile->isEnabled()) {
         qCWarning(lcButeoMsyncd) << "Profile is disabled, not starting sync";
         SyncResults syncResults(QDateTime::currentDateTime(), SyncResults::SYNC_RESULT_FAILED,
                                 Buteo::SyncResults::INTERNAL_ERROR);
-        iProfileManager.saveSyncResults(aProfileName, syncResults);
+        recordSyncResults(*profile, syncResults);
         emit syncStatus(aProfileName, Sync::SYNC_ERROR, "Internal Error", Buteo::SyncResults::INTERNAL_ERROR);
         delete profile;
         return false;
     }
 
+    if (!aChanges.isEmpty()) {
+        qCDebug(lcButeoMsyncd) << "Sync triggered by" << aChanges.itemCount() << "changed items in"
+                               << aChanges.storages();
+        profile->setChangeSet(aChanges);
+    }
+
     SyncSession *session = new SyncSession(profile, this);
     session->setScheduled(aScheduled);
-
-    if (profile->clientProfile()
-            && clientProfileActive(profile->clientProfile()->name())) {
-        qCDebug(lcButeoMsyncd) << "Sync request of the same type in progress, adding request to the sync queue";
-        iSyncQueue.enqueue(session);
+    session->setRetry(aScheduled && iRetryingProfiles.contains(aProfileName));
+    session->setSyncOnChange(aScheduled && aSyncOnChange);
+
+    QString blockedOn;
+    if (!iSessionExecutor.canStart(session, &blockedOn)) {
+        qCDebug(lcButeoMsyncd) << "No free session slots, adding request to the sync queue";
+        if (iSyncQueue.enqueue(session)) {
+            iSessionExecutor.queued(aProfileName);
+            addWaiter(aProfileName, blockedOn);
+        } else {
+            // Not queued, drop the deferral canStart() recorded for it.
+            iSessionExecutor.unqueued(aProfileName);
+            delete session;
+        }
         emit syncStatus(aProfileName, Sync::SYNC_QUEUED, "", 0);
         return false;
     }
@@ -472,7 +604,16 @@ bool Synchronizer::startSync(const QString &aProfileName, bool aScheduled)
         emit syncStatus(aProfileName, Sync::SYNC_ERROR, "Power Save Mode active", Buteo::SyncResults::POWER_SAVING_MODE);
     } else if (!session->reserveStorages(&iStorageBooker)) {
         qCDebug(lcButeoMsyncd) << "Needed storage(s) already in use, queuing sync request";
-        iSyncQueue.enqueue(session);
+        if (iSyncQueue.enqueue(session)) {
+            iSessionExecutor.queued(aProfileName);
+            blockedOn = busyStorage(*session);
+            if (!blockedOn.isEmpty()) {
+                addWaiter(aProfileName, blockedOn);
+            }
+        } else {
+            // The queued session covers this request.
+            delete session;
+        }
         emit syncStatus(aProfileName, Sync::SYNC_QUEUED, "", 0);
         success = true;
     } else {
@@ -583,6 +724,7 @@ bool Synchronizer::startSyncNow(SyncSession *aSession)
 
         qCDebug(lcButeoMsyncd) << "Sync session started";
         iActiveSessions.insert(aSession->profileName(), aSession);
+        iSessionExecutor.started(aSession);
     } else {
         qCWarning(lcButeoMsyncd) << "Failed to start sync session";
         return false;
@@ -601,6 +743,8 @@ void Synchronizer::onSessionFinished(const QString &aProfileName,
     if (iActiveSessions.contains(aProfileName)) {
         SyncSession *session = iActiveSessions[aProfileName];
         if (session) {
+            // Profile and log updates below are written to disk together.
+            iProfileManager.beginWriteGroup();
             switch (aStatus) {
             case Sync::SYNC_DONE: {
                 bool enabledUpdated = false, visibleUpdated = false;
@@ -618,6 +762,7 @@ void Synchronizer::onSessionFinished(const QString &aProfileName,
                     iProfileManager.updateProfile(*sessionProf);
                 }
                 iProfileManager.retriesDone(sessionProf->name());
+                iRetryingProfiles.remove(sessionProf->name());
                 break;
             }
 
@@ -640,9 +785,11 @@ void Synchronizer::onSessionFinished(const QString &aProfileName,
                     if (iSyncScheduler) {
                         // can be null if in backup/restore state.
                         iSyncScheduler->addProfileForSyncRetry(session->profile(), nextRetryInterval);
+                        iRetryingProfiles.insert(session->profileName());
                     }
                 } else {
                     iProfileManager.retriesDone(session->profile()->name());
+                    iRetryingProfiles.remove(session->profileName());
                 }
                 break;
             }
@@ -653,6 +800,9 @@ void Synchronizer::onSessionFinished(const QString &aProfileName,
             }
 
             iActiveSessions.remove(aProfileName);
+            foreach (const QString &pool, iSessionExecutor.finished(aProfileName)) {
+                wakeWaiters(pool);
+            }
             if (session->isScheduled()) {
                 // Calling this multiple times has no effect, even if the
                 // session was not actually opened
@@ -663,6 +813,7 @@ void Synchronizer::onSessionFinished(const QString &aProfileName,
                 cleanupProfile(aProfileName);
                 iProfilesToRemove.removeAll(aProfileName);
             }
+            iProfileManager.endWriteGroup();
             if (session->isAborted() && (iActiveSessions.size() == 0) && isBackupRestoreInProgress()) {
                 stopServers();
                 iSyncBackup->sendReply(0);
@@ -703,54 +854,142 @@ bool Synchronizer::startNextSync()
         return false;
     }
 
-    bool tryNext = true;
+    // Sessions are tried in priority order. A session that waits for a busy
+    // storage or a full session slot pool is skipped until that resource is
+    // freed, so it does not hold back the sessions queued after it.
+    const QList<SyncSession *> queuedSessions = iSyncQueue.getQueuedSyncSessions();
+    foreach (SyncSession *session, queuedSessions) {
+        QString profileName = session->profileName();
+        if (iWaitingFor.contains(profileName)) {
+            continue;
+        }
 
-    SyncSession *session = iSyncQueue.head();
-    if (session == 0) {
-        qCWarning(lcButeoMsyncd) << "Null session found from queue";
-        iSyncQueue.dequeue();
-        return true;
+        SyncProfile *profile = session->profile();
+        if (profile == 0) {
+            qCWarning(lcButeoMsyncd) << "Null profile found from queued session";
+            iSyncQueue.dequeue(profileName);
+            iSessionExecutor.unqueued(profileName);
+            cleanupSession(session, Sync::SYNC_ERROR);
+            return true;
+        }
+
+        qCDebug(lcButeoMsyncd) << "Trying to start queued sync. Profile:" << profileName << session->isScheduled();
+
+        QString blockedOn;
+        if (session->isScheduled() && iBatteryInfo->isLowPower()) {
+            qCWarning(lcButeoMsyncd) << "Low power, scheduled sync aborted";
+            iSyncQueue.dequeue(profileName);
+            iSessionExecutor.unqueued(profileName);
+            session->setFailureResult(SyncResults::SYNC_RESULT_FAILED, Buteo::SyncResults::LOW_BATTERY_POWER);
+            cleanupSession(session, Sync::SYNC_ERROR);
+            emit syncStatus(profileName, Sync::SYNC_ERROR, "Low Battery", Buteo::SyncResults::LOW_BATTERY_POWER);
+            return true;
+        } else if (!iSessionExecutor.canStart(session, &blockedOn)) {
+            qCDebug(lcButeoMsyncd) << "No free session slots, waiting for" << blockedOn;
+            addWaiter(profileName, blockedOn);
+        } else if (!session->reserveStorages(&iStorageBooker)) {
+            blockedOn = busyStorage(*session);
+            qCDebug(lcButeoMsyncd) << "Needed storage(s) already in use, waiting for" << blockedOn;
+            if (!blockedOn.isEmpty()) {
+                addWaiter(profileName, blockedOn);
+            }
+        } else {
+            // Sync can be started now.
+            iSyncQueue.dequeue(profileName);
+            if (startSyncNow(session)) {
+                emit syncStatus(profileName, Sync::SYNC_STARTED, "", 0);
+            } else {
+                qCWarning(lcButeoMsyncd) << "unable to start sync with session:" << profileName;
+                iSessionExecutor.unqueued(profileName);
+                session->setFailureResult(SyncResults::SYNC_RESULT_FAILED, Buteo::SyncResults::INTERNAL_ERROR);
+                cleanupSession(session, Sync::SYNC_ERROR);
+                emit syncStatus(profileName, Sync::SYNC_ERROR, "Internal Error", Buteo::SyncResults::INTERNAL_ERROR);
+            }
+            return true;
+        }
     }
 
-    SyncProfile *profile = session->profile();
+    return false;
+}
+
+QString Synchronizer::busyStorage(const SyncSession &aSession) const
+{
+    const SyncProfile *profile = aSession.profile();
     if (profile == 0) {
-        qCWarning(lcButeoMsyncd) << "Null profile found from queued session";
-        cleanupSession(session, Sync::SYNC_ERROR);
-        iSyncQueue.dequeue();
-        return true;
+        return QString();
     }
+    foreach (const QString &storage, profile->storageBackendNames()) {
+        if (!iStorageBooker.isStorageAvailable(storage, aSession.profileName(),
+                                               aSession.storageReservationMode())) {
+            return STORAGE_WAIT_PREFIX + storage;
+        }
+    }
+    return QString();
+}
 
-    QString profileName = session->profileName();
-    qCDebug(lcButeoMsyncd) << "Trying to start next sync in queue. Profile:" << profileName << session->isScheduled();
+void Synchronizer::addWaiter(const QString &aProfileName, const QString &aResource)
+{
+    removeWaiter(aProfileName);
+    iWaitingFor.insert(aProfileName, aResource);
+    iWaiters.insert(aResource, aProfileName);
+}
 
-    if (session->isScheduled() && iBatteryInfo->isLowPower()) {
-        qCWarning(lcButeoMsyncd) << "Low power, scheduled sync aborted";
-        iSyncQueue.dequeue();
-        session->setFailureResult(SyncResults::SYNC_RESULT_FAILED, Buteo::SyncResults::LOW_BATTERY_POWER);
-        cleanupSession(session, Sync::SYNC_ERROR);
-        emit syncStatus(profileName, Sync::SYNC_ERROR, "Low Battery", Buteo::SyncResults::LOW_BATTERY_POWER);
-        tryNext = true;
-    } else if (!session->reserveStorages(&iStorageBooker)) {
-        qCDebug(lcButeoMsyncd) << "Needed storage(s) already in use";
-        tryNext = false;
-    } else if (clientProfileActive(profile->clientProfile()->name())) {
-        qCDebug(lcButeoMsyncd) << "Client profile active, wait for finish";
-        return false;
-    } else {
-        // Sync can be started now.
-        iSyncQueue.dequeue();
-        if (startSyncNow(session)) {
-            emit syncStatus(profileName, Sync::SYNC_STARTED, "", 0);
-        } else {
-            qCWarning(lcButeoMsyncd) << "unable to start sync with session:" << session->profileName();
-            session->setFailureResult(SyncResults::SYNC_RESULT_FAILED, Buteo::SyncResults::INTERNAL_ERROR);
-            cleanupSession(session, Sync::SYNC_ERROR);
-            emit syncStatus(profileName, Sync::SYNC_ERROR, "Internal Error", Buteo::SyncResults::INTERNAL_ERROR);
+void Synchronizer::removeWaiter(const QString &aProfileName)
+{
+    QHash<QString, QString>::iterator i = iWaitingFor.find(aProfileName);
+    if (i != iWaitingFor.end()) {
+        iWaiters.remove(i.value(), aProfileName);
+        iWaitingFor.erase(i);
+    }
+}
+
+void Synchronizer::wakeWaiters(const QString &aResource)
+{
+    QList<QString> profileNames = iWaiters.values(aResource);
+    iWaiters.remove(aResource);
+    foreach (const QString &profileName, profileNames) {
+        iWaitingFor.remove(profileName);
+    }
+}
+
+void Synchronizer::mergeQueuedChanges(const QString &aProfileName, const StorageChangeSet &aChanges)
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    const QList<SyncSession *> queuedSessions = iSyncQueue.getQueuedSyncSessions();
+    foreach (SyncSession *session, queuedSessions) {
+        SyncProfile *profile = session->profile();
+        if (session->profileName() != aProfileName || profile == 0) {
+            continue;
+        }
+        // An empty change set means a full sync, which covers the changes.
+        // A full sync request turns a queued partial sync into a full one.
+        StorageChangeSet changes = profile->changeSet();
+        if (aChanges.isEmpty()) {
+            if (!changes.isEmpty()) {
+                qCDebug(lcButeoMsyncd) << "Queued sync of" << aProfileName << "is now a full sync";
+                profile->setChangeSet(StorageChangeSet());
+            }
+        } else if (!changes.isEmpty()) {
+            changes.merge(aChanges);
+            profile->setChangeSet(changes);
         }
-        tryNext = true;
+        break;
     }
+}
 
-    return tryNext;
+void Synchronizer::addChangesAfterSession(const QString &aProfileName, const StorageChangeSet &aChanges)
+{
+    // An empty change set records that a full sync is needed, which covers
+    // any other changes.
+    QHash<QString, StorageChangeSet>::iterator pending = iChangesAfterSession.find(aProfileName);
+    if (pending == iChangesAfterSession.end()) {
+        iChangesAfterSession.insert(aProfileName, aChanges);
+    } else if (aChanges.isEmpty()) {
+        *pending = StorageChangeSet();
+    } else if (!pending->isEmpty()) {
+        pending->merge(aChanges);
+    }
 }
 
 void Synchronizer::cleanupSession(SyncSession *aSession, Sync::SyncStatus aStatus)
@@ -765,7 +1004,7 @@ void Synchronizer::cleanupSession(SyncSession *aSession, Sync::SyncStatus aStatu
             if ((profile->lastResults() == 0) && (aStatus == Sync::SYNC_DONE)) {
                 iProfileManager.saveRemoteTargetId(*profile, aSession->results().getTargetId());
             }
-            iProfileManager.saveSyncResults(profileName, aSession->results());
+            recordSyncResults(*profile, aSession->results());
 
             // UI needs to know that Sync Log has been updated.
             emit resultsAvailable(profileName, aSession->results().toString());
@@ -774,9 +1013,27 @@ void Synchronizer::cleanupSession(SyncSession *aSession, Sync::SyncStatus aStatu
                 reschedule(profileName);
                 emit signalProfileChanged(profileName, 1, QString());
             }
+
+            if (iChangesAfterSession.contains(profileName)) {
+                const StorageChangeSet changes = iChangesAfterSession.take(profileName);
+                if (changes.isEmpty()) {
+                    // A full sync was requested during a partial one. It is
+                    // started once this session has released its storages.
+                    qCDebug(lcButeoMsyncd) << "Starting full sync requested during the sync of" << profileName;
+                    QMetaObject::invokeMethod(this, "startScheduledSync", Qt::QueuedConnection,
+                                              Q_ARG(QString, profileName));
+                } else {
+                    qCDebug(lcButeoMsyncd) << "Scheduling sync on change for changes during the sync of" << profileName;
+                    iSyncOnChangeScheduler.addProfile(profile, changes);
+                }
+            }
         }
         aSession->setProfileCreated(false);
         aSession->releaseStorages();
+        iStorageBooker.withdraw(profileName);
+        // Every session ends here, whether it ran, failed to start or was
+        // dropped from the queue.
+        iOnlineSyncRamp.finished(profileName, iOnlineSyncRampClock.elapsed());
         aSession->deleteLater();
         aSession = 0;
     }
@@ -795,10 +1052,14 @@ void Synchronizer::abortSync(QString aProfileName)
         SyncSession *queuedSession = iSyncQueue.dequeue(aProfileName);
         if (queuedSession) {
             qCDebug(lcButeoMsyncd) << "Removed queued sync" << aProfileName;
+            iSessionExecutor.unqueued(aProfileName);
+            removeWaiter(aProfileName);
+            iStorageBooker.withdraw(aProfileName);
+            iOnlineSyncRamp.finished(aProfileName, iOnlineSyncRampClock.elapsed());
             delete queuedSession;
         }
         SyncResults syncResults(QDateTime::currentDateTime(), SyncResults::SYNC_RESULT_CANCELLED, Buteo::SyncResults::ABORTED);
-        iProfileManager.saveSyncResults(aProfileName, syncResults);
+        recordSyncResults(aProfileName, syncResults);
         emit syncStatus(aProfileName, Sync::SYNC_CANCELLED, "", Buteo::SyncResults::ABORTED);
     }
 }
@@ -859,20 +1120,6 @@ bool Synchronizer::cleanupProfile(const QString &aProfileId)
     return status;
 }
 
-bool Synchronizer::clientProfileActive(const QString &clientProfileName)
-{
-    QList<SyncSession *> activeSessions = iActiveSessions.values();
-    foreach (SyncSession *session, activeSessions) {
-        if (session->profile()) {
-            SyncProfile *profile = session->profile();
-            if (profile->clientProfile()->name() == clientProfileName) {
-                return true;
-            }
-        }
-    }
-    return false;
-}
-
 bool Synchronizer::removeProfile(QString aProfileId)
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
@@ -953,7 +1200,6 @@ void Synchronizer::releaseStorages(QStringList aStorageNames)
     FUNCTION_CALL_TRACE(lcButeoTrace);
 
     iStorageBooker.releaseStorages(aStorageNames);
-    emit storageReleased();
 }
 
 QStringList Synchronizer::runningSyncs()
@@ -963,11 +1209,12 @@ QStringList Synchronizer::runningSyncs()
     return iActiveSessions.keys();
 }
 
-void Synchronizer::onStorageReleased()
+void Synchronizer::onStorageReleased(const QString &aStorageName)
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
 
-    qCDebug(lcButeoMsyncd) << "Storage released";
+    qCDebug(lcButeoMsyncd) << "Storage released:" << aStorageName;
+    wakeWaiters(STORAGE_WAIT_PREFIX + aStorageName);
     while (startNextSync()) {
         // Intentionally empty.
     }
@@ -1026,17 +1273,20 @@ bool Synchronizer::requestStorage(const QString &aStorageName,
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
 
-    return iStorageBooker.reserveStorage(aStorageName,
-                                         aCaller->getProfileName());
+    // Called from plugin threads. Plugins of read-only sessions keep sharing
+    // the storages, an exclusive request would be an upgrade, so the booker
+    // uses the mode the session reserved its storages with.
+    return iStorageBooker.reserveClientStorage(aStorageName,
+                                               aCaller->getProfileName());
 }
 
 void Synchronizer::releaseStorage(const QString &aStorageName,
-                                  const SyncPluginBase */*aCaller*/)
+                                  const SyncPluginBase *aCaller)
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
 
-    iStorageBooker.releaseStorage(aStorageName);
-    emit storageReleased();
+    iStorageBooker.releaseStorage(aStorageName,
+                                  aCaller ? aCaller->getProfileName() : QString());
 }
 
 StoragePlugin *Synchronizer::createStorage(const QString &aPluginName)
@@ -1056,15 +1306,20 @@ void Synchronizer::initializeScheduler()
     FUNCTION_CALL_TRACE(lcButeoTrace);
     if (!iSyncScheduler) {
         iSyncScheduler = new SyncScheduler(this);
+        iSyncScheduler->setAlignmentWindow(g_settings_get_int(iSettings, "scheduled-sync-alignment-window"));
         connect(iSyncScheduler, SIGNAL(syncNow(QString)),
                 this, SLOT(startScheduledSync(QString)), Qt::QueuedConnection);
         connect(iSyncScheduler, SIGNAL(externalSyncChanged(QString, bool)),
                 this, SLOT(reportExternalSyncStatus(QString, bool)), Qt::QueuedConnection);
         QList<SyncProfile *> profiles = iProfileManager.allSyncProfiles();
+        QList<SyncProfile *> scheduledProfiles;
         foreach (SyncProfile *profile, profiles) {
             if (profile->syncType() == SyncProfile::SYNC_SCHEDULED) {
-                iSyncScheduler->addProfile(profile);
+                scheduledProfiles.append(profile);
             }
+        }
+        iSyncScheduler->addProfiles(scheduledProfiles);
+        foreach (SyncProfile *profile, profiles) {
             // Emit external sync status for all profiles
             // on startup, in case of a crash/abort of this
             // process, we should update pontential listeners with
@@ -1351,6 +1606,7 @@ void Synchronizer::onNewSession(const QString &aDestination)
         session->setStorageMap(storageMap);
 
         iActiveSessions.insert(profile->name(), session);
+        iSessionExecutor.started(session);
 
         // Connect signals from sync session.
         connect(session, SIGNAL(transferProgress(const QString &,
@@ -1381,66 +1637,101 @@ void Synchronizer::slotProfileChanged(QString aProfileName, int aChangeType, QSt
     // on change, to avoid thrash during backup/restore and races if the client wishes
     // to trigger manually.  Temporary until we can improve Buteo's SyncOnChange handler.
     switch (aChangeType) {
-    case ProfileManager::PROFILE_ADDED: {
-        iProfileChangeTriggerQueue.append(qMakePair(aProfileName, ProfileManager::PROFILE_ADDED));
-        iProfileChangeTriggerTimer.start(30000); // 30 seconds.
-    }
-    break;
+    case ProfileManager::PROFILE_ADDED:
+    case ProfileManager::PROFILE_MODIFIED:
+        iProfileChangeDebouncer.changed(aProfileName, ProfileManager::ProfileChangeType(aChangeType),
+                                        iProfileChangeClock.elapsed());
+        armProfileChangeTrigger();
+        break;
 
     case ProfileManager::PROFILE_REMOVED:
         iSyncOnChangeScheduler.removeProfile(aProfileName);
+        iChangesAfterSession.remove(aProfileName);
+        iRetryingProfiles.remove(aProfileName);
         iWaitingOnlineSyncs.removeAll(aProfileName);
-        for (int i = iProfileChangeTriggerQueue.size() - 1; i >= 0; --i) {
-            if (iProfileChangeTriggerQueue[i].first == aProfileName) {
-                qCDebug(lcButeoMsyncd) << "Removing queued profile change sync due to profile removal:" << aProfileName;
-                iProfileChangeTriggerQueue.removeAt(i);
-            }
+        iOnlineSyncRamp.remove(aProfileName);
+        if (iProfileChangeDebouncer.remove(aProfileName)) {
+            qCDebug(lcButeoMsyncd) << "Removing queued profile change sync due to profile removal:" << aProfileName;
         }
         break;
+    }
 
-    case ProfileManager::PROFILE_MODIFIED: {
-        bool alreadyQueued = false;
-        for (int i = 0; i < iProfileChangeTriggerQueue.size(); ++i) {
-            if (iProfileChangeTriggerQueue.at(i).first == aProfileName) {
-                alreadyQueued = true;
-                break;
+    emit signalProfileChanged(aProfileName, aChangeType, aProfileAsXml);
+}
+
+void Synchronizer::releaseOnlineSyncs()
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    const qint64 now = iOnlineSyncRampClock.elapsed();
+    foreach (const QString &profileName, iOnlineSyncRamp.takeDue(now)) {
+        SyncProfile *profile = iProfileManager.syncProfile(profileName);
+        // The connection may have changed while the profile was waiting.
+        if (iWaitingOnlineSyncs.contains(profileName)
+                && acceptScheduledSync(iNetworkManager->isOnline(), iNetworkManager->connectionType(), profile)) {
+            // start sync now, we do not need to call 'startScheduledSync' since that function
+            // only checks for internet connection
+            iWaitingOnlineSyncs.removeOne(profileName);
+            startSync(profileName, profile, true, false, StorageChangeSet());
+            profile = 0;
+            // Sessions report to the ramp when they end, see
+            // cleanupSession(). Requests refused before a session was
+            // created end here.
+            if (!iActiveSessions.contains(profileName) && !iSyncQueue.contains(profileName)) {
+                iOnlineSyncRamp.finished(profileName, now);
             }
+        } else {
+            iOnlineSyncRamp.finished(profileName, now);
         }
-        if (!alreadyQueued) {
-            iProfileChangeTriggerQueue.append(qMakePair(aProfileName, ProfileManager::PROFILE_MODIFIED));
-        }
-        iProfileChangeTriggerTimer.start(30000); // 30 seconds.
-    }
-    break;
+        delete profile;
     }
 
-    emit signalProfileChanged(aProfileName, aChangeType, aProfileAsXml);
+    const qint64 next = iOnlineSyncRamp.msecsToNext(now);
+    if (next >= 0) {
+        iOnlineSyncRampTimer.start(int(next));
+    }
 }
 
 void Synchronizer::profileChangeTriggerTimeout()
 {
-    if (iProfileChangeTriggerQueue.isEmpty()) {
-        return;
-    }
+    FUNCTION_CALL_TRACE(lcButeoTrace);
 
-    QPair<QString, ProfileManager::ProfileChangeType> queuedChange = iProfileChangeTriggerQueue.takeFirst();
-    SyncProfile *profile = iProfileManager.syncProfile(queuedChange.first);
-    if (profile) {
-        if (queuedChange.second == ProfileManager::PROFILE_ADDED) {
-            enableSOCSlot(queuedChange.first);
-            if (profile->isEnabled()) {
-                qCDebug(lcButeoMsyncd) << "Triggering queued profile addition sync for:" << queuedChange.first;
-                startSync(queuedChange.first);
+    // Handle all due changes in one go, each profile is loaded once.
+    QList<ProfileChangeDebouncer::Change> due = iProfileChangeDebouncer.takeDue(iProfileChangeClock.elapsed());
+    foreach (const ProfileChangeDebouncer::Change &change, due) {
+        SyncProfile *profile = iProfileManager.syncProfile(change.first);
+        if (!profile) {
+            continue;
+        }
+
+        const bool enabled = profile->isEnabled();
+        if (change.second == ProfileManager::PROFILE_ADDED) {
+            // Sync on change keeps the profile, the sync gets a copy.
+            SyncProfile *addedProfile = enabled ? profile->clone() : 0;
+            enableSOC(profile);
+            if (enabled) {
+                qCDebug(lcButeoMsyncd) << "Triggering queued profile addition sync for:" << change.first;
+                startSync(change.first, addedProfile, false, false, StorageChangeSet());
             }
-        } else if (profile->isEnabled()) {
-            qCDebug(lcButeoMsyncd) << "Triggering queued profile modification sync for:" << queuedChange.first;
-            startScheduledSync(queuedChange.first);
+        } else if (enabled) {
+            qCDebug(lcButeoMsyncd) << "Triggering queued profile modification sync for:" << change.first;
+            startScheduledSync(change.first, false, profile);
+        } else {
+            delete profile;
         }
-        delete profile;
     }
 
-    // continue triggering profiles until we have emptied the queue.
-    QMetaObject::invokeMethod(this, "profileChangeTriggerTimeout", Qt::QueuedConnection);
+    armProfileChangeTrigger();
+}
+
+void Synchronizer::armProfileChangeTrigger()
+{
+    const qint64 next = iProfileChangeDebouncer.msecsToNext(iProfileChangeClock.elapsed());
+    if (next < 0) {
+        iProfileChangeTriggerTimer.stop();
+    } else {
+        iProfileChangeTriggerTimer.start(int(next));
+    }
 }
 
 void Synchronizer::reschedule(const QString &aProfileName)
@@ -1739,6 +2030,41 @@ QString Synchronizer::getLastSyncResult(const QString &aProfileId)
     return lastSyncResult;
 }
 
+QStringList Synchronizer::syncHistory(const QString &aProfileId, qlonglong aFrom, qlonglong aTo,
+                                      int aLimit, int aOffset)
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+    return iSyncHistory.results(aProfileId, aFrom, aTo, aLimit, aOffset);
+}
+
+QStringList Synchronizer::syncHistoryByResult(int aMajorCode, int aMinorCode, qlonglong aFrom,
+                                              qlonglong aTo, int aLimit, int aOffset)
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+    return iSyncHistory.resultsByCode(aMajorCode, aMinorCode, aFrom, aTo, aLimit, aOffset);
+}
+
+// Adds the statistics of one component to the combined statistics.
+static void mergeStats(QVariantMap &aStats, const QVariantMap &aMore)
+{
+    for (QVariantMap::const_iterator it = aMore.constBegin(); it != aMore.constEnd(); ++it) {
+        aStats.insert(it.key(), it.value());
+    }
+}
+
+QVariantMap Synchronizer::sessionStatistics()
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+    QVariantMap stats = iSessionExecutor.statistics();
+    mergeStats(stats, iProfileChangeDebouncer.statistics());
+    mergeStats(stats, iSyncOnChangeScheduler.changeStatistics());
+    mergeStats(stats, iOnlineSyncRamp.statistics());
+    if (iSyncScheduler) {
+        mergeStats(stats, iSyncScheduler->statistics());
+    }
+    return stats;
+}
+
 QStringList Synchronizer::allVisibleSyncProfiles()
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
@@ -1839,18 +2165,21 @@ void Synchronizer::onNetworkStateChanged(bool aState, Sync::InternetConnectionTy
 
     if (aState) {
         qCDebug(lcButeoMsyncd) << "Restart sync for profiles that need network, checking profiles:" << iWaitingOnlineSyncs;
-        QStringList profiles(iWaitingOnlineSyncs);
-        foreach (QString profileName, profiles) {
+        // Do not start all of them at once, the online sync ramp spreads the
+        // starts out and lets the stalest profiles go first.
+        const qint64 now = iOnlineSyncRampClock.elapsed();
+        foreach (const QString &profileName, iWaitingOnlineSyncs) {
             SyncProfile *profile = iProfileManager.syncProfile(profileName);
             if (acceptScheduledSync(aState, type, profile)) {
-                // start sync now, we do not need to call 'startScheduledSync' since that function
-                // only checks for internet connection
-                iWaitingOnlineSyncs.removeOne(profileName);
-                startSync(profileName, true);
+                iOnlineSyncRamp.add(profileName, profile->lastSuccessfulSyncTime(), now);
             }
             delete profile;
         }
+        releaseOnlineSyncs();
     } else if (!aState) {
+        // Profiles not released yet stay in iWaitingOnlineSyncs.
+        iOnlineSyncRamp.clear();
+        iOnlineSyncRampTimer.stop();
         QList<QString> profiles = iActiveSessions.keys();
         foreach (QString profileId, profiles) {
             //Getting profile
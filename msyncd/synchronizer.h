@@ -27,6 +27,10 @@
 
 #include "SyncDBusInterface.h"
 #include "SyncQueue.h"
+#include "SyncHistory.h"
+#include "SessionExecutor.h"
+#include "OnlineSyncRamp.h"
+#include "ProfileChangeDebouncer.h"
 #include "StorageBooker.h"
 #include "SyncScheduler.h"
 #include "SyncBackup.h"
@@ -47,6 +51,8 @@
 #include <QDBusInterface>
 #include <QScopedPointer>
 #include <QTimer>
+#include <QElapsedTimer>
+#include <QSet>
 
 struct _GSettings;
 
@@ -150,6 +156,17 @@ public slots:
      */
     virtual QString getLastSyncResult(const QString &aProfileId);
 
+    //! \see SyncDBusInterface::syncHistory
+    virtual QStringList syncHistory(const QString &aProfileId, qlonglong aFrom, qlonglong aTo,
+                                    int aLimit, int aOffset);
+
+    //! \see SyncDBusInterface::syncHistoryByResult
+    virtual QStringList syncHistoryByResult(int aMajorCode, int aMinorCode, qlonglong aFrom,
+                                            qlonglong aTo, int aLimit, int aOffset);
+
+    //! \see SyncDBusInterface::sessionStatistics
+    virtual QVariantMap sessionStatistics();
+
     /*! \brief Gets all visible sync profiles.
      *
      * Returns all sync profiles that should be visible in sync ui. A profile
@@ -230,9 +247,6 @@ public slots:
     void isSyncedExternally(unsigned int aAccountId, const QString aClientProfileName);
 
 signals:
-    //! emitted by releaseStorages call
-    void storageReleased();
-
     /*! \brief emit this signal when the sync session is completed,
      *  this is useful when the session status is not important.
      *
@@ -243,10 +257,11 @@ signals:
 private slots:
     /*! \brief Handler for storage released signal.
      *
-     * Tries to start the next sync in queue, which may have been blocked
-     * earlier by storage reservations.
+     * Wakes the queued syncs waiting for the storage and tries to start
+     * them.
+     * \param aStorageName Name of the released storage.
      */
-    void onStorageReleased();
+    void onStorageReleased(const QString &aStorageName);
 
     void onTransferProgress(const QString &aProfileName,
                             Sync::TransferDatabase aDatabase, Sync::TransferType aType,
@@ -280,6 +295,14 @@ private slots:
 
     void onNetworkStateChanged(bool aState, Sync::InternetConnectionType type);
 
+    /*! \brief Starts a sync requested by sync on change.
+     *
+     * Like startScheduledSync, but the session is marked as started by
+     * a change.
+     * @param aProfileName Name of the profile to sync
+     */
+    void startSyncOnChange(const QString &aProfileName);
+
     /*! \brief call this to request the sync daemon to enable soc
      * for a profile. The sync daemon decides as of now for which storages
      * soc should be enabled
@@ -317,11 +340,45 @@ private slots:
      */
     void reportExternalSyncStatus(const QString &aProfileName, bool force);
 
-    /*! \brief Triggers sync for profiles which were queued for sync due to profile changes. */
+    /*! \brief Triggers sync for profiles whose queued profile changes are due. */
     void profileChangeTriggerTimeout();
 
+    /*! \brief Starts the syncs waiting for connectivity that the online
+     *  sync ramp lets go now.
+     */
+    void releaseOnlineSyncs();
+
 private:
-    bool startSync(const QString &aProfileName, bool aScheduled);
+    /*! \brief Starts a scheduled sync if the connection and schedule allow.
+     *
+     * \param aProfileName Name of the profile to sync.
+     * \param aSyncOnChange Is the sync started by sync on change.
+     * \param aProfile The profile if already loaded, else 0. Ownership is
+     *  transferred.
+     */
+    bool startScheduledSync(const QString &aProfileName, bool aSyncOnChange,
+                            SyncProfile *aProfile = 0);
+
+    /*! \brief Starts or queues a sync with the given profile.
+     *
+     * \param aProfileName Name of the profile to sync.
+     * \param aScheduled Is the sync started by a scheduler.
+     * \param aSyncOnChange Is the sync started by sync on change.
+     * \param aChanges Changes collected for a sync on change, dropped if
+     *  the sync is not started or queued.
+     */
+    bool startSync(const QString &aProfileName, bool aScheduled,
+                   bool aSyncOnChange = false,
+                   const StorageChangeSet &aChanges = StorageChangeSet());
+
+    /*! \brief Starts or queues a sync with an already loaded profile.
+     *
+     * \param aProfile The profile if already loaded, else 0. Ownership is
+     *  transferred.
+     * \see startSync(const QString &, bool, bool, const StorageChangeSet &)
+     */
+    bool startSync(const QString &aProfileName, SyncProfile *aProfile, bool aScheduled,
+                   bool aSyncOnChange, const StorageChangeSet &aChanges);
 
     /*! \brief Starts a sync with the given profile.
      *
@@ -330,14 +387,61 @@ private:
      */
     bool startSyncNow(SyncSession *aSession);
 
-    /*! \brief Tries to starts next sync request from the sync queue.
+    /*! \brief Tries to start the first startable sync request from the sync queue.
      *
+     * Requests are tried in queue order, skipping the ones waiting for a
+     * busy storage or session slot. A request that turns out to be blocked
+     * is recorded as waiting for the blocking resource.
      * \return Is it possible to try starting more syncs by calling this
-     *  function again. Will be true if the first sync request in the queue
-     *  is not blocked by already reserved storages.
+     *  function again. Will be true if a queued request was started or
+     *  removed from the queue.
      */
     bool startNextSync();
 
+    /*! \brief Gets the first storage of a session not available to it.
+     *
+     * \param aSession The session.
+     * \return Wait key of the storage, empty if all storages are available.
+     */
+    QString busyStorage(const SyncSession &aSession) const;
+
+    /*! \brief Records that a queued sync waits for a resource.
+     *
+     * \param aProfileName Name of the queued profile.
+     * \param aResource Storage or session slot pool the sync waits for.
+     */
+    void addWaiter(const QString &aProfileName, const QString &aResource);
+
+    /*! \brief Removes a queued sync from the waiters.
+     *
+     * \param aProfileName Name of the queued profile.
+     */
+    void removeWaiter(const QString &aProfileName);
+
+    /*! \brief Makes the syncs waiting for a resource startable again.
+     *
+     * \param aResource The freed storage or session slot pool.
+     */
+    void wakeWaiters(const QString &aResource);
+
+    /*! \brief Merges changes into the change set of a queued session
+     *
+     * Nothing is merged if the queued session syncs all items anyway. An
+     * empty change set is a full sync request and makes the queued session
+     * a full sync.
+     *
+     *  \param aProfileName Name of the queued profile
+     *  \param aChanges Changes to merge
+     */
+    void mergeQueuedChanges(const QString &aProfileName, const StorageChangeSet &aChanges);
+
+    /*! \brief Records changes to sync once the active session has ended
+     *
+     *  \param aProfileName Name of the syncing profile
+     *  \param aChanges Changes to sync, empty for a full sync
+     */
+    void addChangesAfterSession(const QString &aProfileName, const StorageChangeSet &aChanges);
+
     /*! \brief To clean up session
      *  \param aSession
      *  \param aStatus of sync
@@ -381,8 +485,6 @@ private:
      */
     bool cleanupProfile(const QString &profileId);
 
-    bool clientProfileActive(const QString &clientProfileName);
-
     /*! \brief Removes the external sync status for a given profile, if status changes
      * 'syncedExternallyStatus' dbus signal will be emitted to notify possible clients.
      *
@@ -405,16 +507,48 @@ private:
      */
     void reportExternalSyncStatus(const SyncProfile *aProfile, bool force = false);
 
+    /*! \brief Saves results to the profile log and to the sync history.
+     *
+     * @param aProfileName name of the synced profile
+     * @param aResults results to save
+     * @return true if the results were saved to the profile log
+     */
+    bool recordSyncResults(const QString &aProfileName, const SyncResults &aResults);
+
+    /*! \brief Saves results to the log and history of a loaded profile.
+     *
+     * @param aProfile the synced profile
+     * @param aResults results to save
+     * @return true if the results were saved to the profile log
+     */
+    bool recordSyncResults(const SyncProfile &aProfile, const SyncResults &aResults);
+
+    /*! \brief Imports the existing profile logs to an empty sync history.
+     */
+    void importSyncHistory();
+
     QMap<QString, SyncSession *> iActiveSessions;
     QMap<QString, bool> iExternalSyncProfileStatus;
     QList<QString> iProfilesToRemove;
     QMap<QString, ServerPluginRunner *> iServers;
     QList<QString> iWaitingOnlineSyncs;
+
+    // Releases iWaitingOnlineSyncs gradually when connectivity returns.
+    OnlineSyncRamp iOnlineSyncRamp;
+    QTimer iOnlineSyncRampTimer;
+    QElapsedTimer iOnlineSyncRampClock;
     NetworkManager *iNetworkManager;
     QMap<QString, int> iCountersStorage;
     PluginManager iPluginManager;
     ProfileManager iProfileManager;
     SyncQueue iSyncQueue;
+    SyncHistory iSyncHistory;
+    SessionExecutor iSessionExecutor;
+
+    // Queued syncs that can not start yet, by the resource they wait for.
+    QMultiHash<QString, QString> iWaiters;
+    // The resource each waiting sync waits for.
+    QHash<QString, QString> iWaitingFor;
     StorageBooker iStorageBooker;
     SyncScheduler *iSyncScheduler;
     SyncBackup *iSyncBackup;
@@ -425,6 +559,15 @@ private:
     SyncOnChange iSyncOnChange;
     SyncOnChangeScheduler iSyncOnChangeScheduler;
 
+    // Changes that triggered a sync on change while the profile was
+    // already syncing. Scheduled again when that session ends. An empty
+    // set means a full sync was requested during a partial one.
+    QHash<QString, StorageChangeSet> iChangesAfterSession;
+
+    // Profiles with a retry of a failed sync scheduled. Their next
+    // scheduled sync is queued as a retry.
+    QSet<QString> iRetryingProfiles;
+
     /*! \brief Save the counter for given profile
      *
      * @param aProfile profile to save counter
@@ -447,8 +590,18 @@ private:
      * in a sane manner (also taking into account BackupRestore status).
      * However, that change will be far more invasive, so for now this is much simpler.
      */
-    QList<QPair<QString, ProfileManager::ProfileChangeType> > iProfileChangeTriggerQueue;
+    ProfileChangeDebouncer iProfileChangeDebouncer;
     QTimer iProfileChangeTriggerTimer;
+    QElapsedTimer iProfileChangeClock;
+
+    /*! \brief Arms iProfileChangeTriggerTimer for the next due profile change. */
+    void armProfileChangeTrigger();
+
+    /*! \brief Enables sync on change for a profile.
+     *
+     * @param aProfile The profile, ownership is taken.
+     */
+    void enableSOC(SyncProfile *aProfile);
 
 #ifdef SYNCFW_UNIT_TESTS
     friend class SynchronizerTest;
@@ -75,6 +75,12 @@ void ButeoPluginIfaceAdaptor::resume()
     QMetaObject::invokeMethod(parent(), "resume");
 }
 
+void ButeoPluginIfaceAdaptor::setChangeSet(const QString &aChangeSet)
+{
+    // handle method call com.buteo.msyncd.baseplugin.setChangeSet
+    QMetaObject::invokeMethod(parent(), "setChangeSet", Q_ARG(QString, aChangeSet));
+}
+
 bool ButeoPluginIfaceAdaptor::startListen()
 {
     // handle method call com.buteo.msyncd.baseplugin.startListen
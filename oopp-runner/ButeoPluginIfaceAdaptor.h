@@ -74,6 +74,9 @@ class ButeoPluginIfaceAdaptor: public QDBusAbstractAdaptor
                 "      <arg direction=\"in\" type=\"i\" name=\"aType\"/>\n"
                 "      <arg direction=\"in\" type=\"b\" name=\"aState\"/>\n"
                 "    </method>\n"
+                "    <method name=\"setChangeSet\">\n"
+                "      <arg direction=\"in\" type=\"s\" name=\"aChangeSet\"/>\n"
+                "    </method>\n"
                 "    <method name=\"startSync\">\n"
                 "      <arg direction=\"out\" type=\"b\"/>\n"
                 "    </method>\n"
@@ -100,6 +103,7 @@ public Q_SLOTS: // METHODS
     QString getSyncResults();
     bool init();
     void resume();
+    void setChangeSet(const QString &aChangeSet);
     bool startListen();
     bool startSync();
     void stopListen();
@@ -30,6 +30,7 @@
 
 #include <QPluginLoader>
 #include <QFileInfo>
+#include <QXmlStreamReader>
 
 using namespace Buteo;
 
@@ -75,6 +76,7 @@ SyncPluginBase *PluginServiceObj::initializePlugin()
             qCWarning(lcButeoPlugin) << "Profile " << iProfileName << " does not exist";
             return nullptr;
         }
+        syncProfile->setChangeSet(iChangeSet);
 
         // Create the plugin (client)
         return iSyncPluginLoader->createClientPlugin(iPluginName, *syncProfile, iPluginCb);
@@ -195,6 +197,23 @@ QString PluginServiceObj::getSyncResults()
     return iPlugin->getSyncResults().toString();
 }
 
+void PluginServiceObj::setChangeSet(const QString &aChangeSetAsXml)
+{
+    FUNCTION_CALL_TRACE(lcButeoTrace);
+
+    QXmlStreamReader reader(aChangeSetAsXml);
+    if (reader.readNextStartElement()) {
+        StorageChangeSet changeSet(reader);
+        if (!reader.hasError()) {
+            iChangeSet = changeSet;
+            return;
+        }
+    }
+
+    qCWarning(lcButeoPlugin) << "PluginServiceObj::setChangeSet(): invalid change set" ;
+    iChangeSet.clear();
+}
+
 bool PluginServiceObj::startSync()
 {
     FUNCTION_CALL_TRACE(lcButeoTrace);
@@ -52,6 +52,7 @@ public Q_SLOTS:
     bool uninit();
 
     // client functions
+    void setChangeSet(const QString &aChangeSetAsXml);
     bool startSync();
 
     // server functions
@@ -79,6 +80,7 @@ private:
     QString iPluginName;
     QString iProfileName;
     QString iPluginFilePath;
+    StorageChangeSet iChangeSet;
 };
 
 #endif // PLUGINSERVICEOBJ_H
@@ -0,0 +1,168 @@
+/*
+ * This file is part of buteo-syncfw package
+ *
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+#include "OnlineSyncRampTest.h"
+#include "OnlineSyncRamp.h"
+
+using namespace Buteo;
+
+static QDateTime lastSuccess(int aHoursAgo)
+{
+    return QDateTime::fromMSecsSinceEpoch(qint64(1700000000) * 1000).addSecs(-aHoursAgo * 3600);
+}
+
+void OnlineSyncRampTest::testStalestFirst()
+{
+    OnlineSyncRamp ramp;
+    ramp.setPolicy(10, 0, 0);
+
+    ramp.add("fresh", lastSuccess(1), 0);
+    ramp.add("never", QDateTime(), 0);
+    ramp.add("stale", lastSuccess(48), 0);
+    ramp.add("older", lastSuccess(5), 0);
+
+    QCOMPARE(ramp.takeDue(0), QStringList() << "never" << "stale" << "older" << "fresh");
+    QVERIFY(ramp.isEmpty());
+    QCOMPARE(ramp.msecsToNext(0), qint64(-1));
+}
+
+void OnlineSyncRampTest::testTokenBucket()
+{
+    OnlineSyncRamp ramp;
+    ramp.setPolicy(2, 1, 0);
+
+    for (int i = 0; i < 5; ++i) {
+        ramp.add(QString("p%1").arg(i), lastSuccess(i), 0);
+    }
+
+    // The burst goes at once, the stalest profiles first.
+    QCOMPARE(ramp.takeDue(0), QStringList() << "p4" << "p3");
+    QVERIFY(ramp.takeDue(500).isEmpty());
+
+    const qint64 next = ramp.msecsToNext(500);
+    QVERIFY(next > 0 && next <= 501);
+    QCOMPARE(ramp.takeDue(500 + next), QStringList() << "p2");
+    QVERIFY(ramp.takeDue(1500).isEmpty());
+    QCOMPARE(ramp.takeDue(2100), QStringList() << "p1");
+    QCOMPARE(ramp.takeDue(3100), QStringList() << "p0");
+    QVERIFY(ramp.isEmpty());
+
+    QVariantMap stats = ramp.statistics();
+    QCOMPARE(stats.value("onlineRampReleasedSyncs").toInt(), 5);
+    QCOMPARE(stats.value("onlineRampRunningSyncs").toInt(), 5);
+}
+
+void OnlineSyncRampTest::testJitter()
+{
+    OnlineSyncRamp ramp;
+    ramp.setPolicy(100, 0, 1000);
+    ramp.setSeed(1);
+
+    for (int i = 0; i < 20; ++i) {
+        ramp.add(QString("p%1").arg(i), lastSuccess(i), 0);
+    }
+
+    // The starts are spread over the jitter.
+    const int early = ramp.takeDue(500).size();
+    QVERIFY(early > 0);
+    QVERIFY(early < 20);
+
+    const qint64 next = ramp.msecsToNext(500);
+    QVERIFY(next >= 0 && next <= 500);
+    QCOMPARE(ramp.takeDue(1000).size(), 20 - early);
+    QVERIFY(ramp.isEmpty());
+}
+
+void OnlineSyncRampTest::testRemove()
+{
+    OnlineSyncRamp ramp;
+    ramp.setPolicy(1, 1, 0);
+
+    ramp.add("p1", lastSuccess(2), 0);
+    ramp.add("p2", lastSuccess(1), 0);
+    ramp.add("p3", lastSuccess(0), 0);
+    ramp.remove("p2");
+
+    QCOMPARE(ramp.takeDue(0), QStringList() << "p1");
+    QCOMPARE(ramp.takeDue(1000), QStringList() << "p3");
+
+    ramp.add("p4", lastSuccess(0), 1000);
+    ramp.clear();
+    QVERIFY(ramp.isEmpty());
+    QVERIFY(ramp.takeDue(5000).isEmpty());
+}
+
+void OnlineSyncRampTest::testRampDuration()
+{
+    // Twenty profiles waiting for connectivity, each sync takes three
+    // seconds. Compare starting all of them at once to the default ramp.
+    const int PROFILES = 20;
+    const qint64 SYNC_DURATION = 3000;
+
+    int peak[2];
+    qint64 duration[2];
+    for (int ramped = 0; ramped < 2; ++ramped) {
+        OnlineSyncRamp ramp;
+        if (ramped) {
+            ramp.setPolicy(OnlineSyncRamp::DEFAULT_BURST, OnlineSyncRamp::DEFAULT_STARTS_PER_SECOND,
+                           OnlineSyncRamp::DEFAULT_MAX_JITTER);
+        } else {
+            ramp.setPolicy(PROFILES, 0, 0);
+        }
+        ramp.setSeed(7);
+
+        for (int i = 0; i < PROFILES; ++i) {
+            ramp.add(QString("p%1").arg(i), lastSuccess(i), 0);
+        }
+
+        QMap<qint64, QStringList> finishing;
+        qint64 now = 0;
+        while (!ramp.isEmpty() || !finishing.isEmpty()) {
+            foreach (const QString &name, ramp.takeDue(now)) {
+                finishing[now + SYNC_DURATION].append(name);
+            }
+
+            qint64 next = ramp.msecsToNext(now);
+            next = next >= 0 ? now + next : finishing.firstKey();
+            if (!finishing.isEmpty() && finishing.firstKey() <= next) {
+                now = finishing.firstKey();
+                foreach (const QString &name, finishing.take(now)) {
+                    ramp.finished(name, now);
+                }
+            } else {
+                now = next;
+            }
+        }
+
+        const QVariantMap stats = ramp.statistics();
+        QCOMPARE(stats.value("onlineRampReleasedSyncs").toInt(), PROFILES);
+        peak[ramped] = stats.value("onlineRampLastPeakRunning").toInt();
+        duration[ramped] = stats.value("onlineRampLastDurationMs").toLongLong();
+        qDebug() << (ramped ? "Ramped:" : "All at once:") << "peak sessions" << peak[ramped]
+                 << "time to all synced" << duration[ramped] << "ms";
+    }
+
+    QCOMPARE(peak[0], PROFILES);
+    QCOMPARE(duration[0], SYNC_DURATION);
+    QVERIFY(peak[1] * 2 < peak[0]);
+    QVERIFY(duration[1] > duration[0]);
+}
+
+QTEST_MAIN(Buteo::OnlineSyncRampTest)
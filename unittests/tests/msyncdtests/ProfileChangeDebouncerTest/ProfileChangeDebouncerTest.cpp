@@ -0,0 +1,126 @@
+/*
+ * This file is part of buteo-syncfw package
+ *
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+#include "ProfileChangeDebouncerTest.h"
+#include "ProfileChangeDebouncer.h"
+
+using namespace Buteo;
+
+typedef ProfileChangeDebouncer::Change Change;
+
+void ProfileChangeDebouncerTest::testQuietPeriod()
+{
+    ProfileChangeDebouncer debouncer;
+    debouncer.setDelays(1000, 10000);
+    QCOMPARE(debouncer.msecsToNext(0), qint64(-1));
+
+    debouncer.changed("p1", ProfileManager::PROFILE_MODIFIED, 0);
+    QCOMPARE(debouncer.msecsToNext(0), qint64(1000));
+    QVERIFY(debouncer.takeDue(999).isEmpty());
+
+    // Another change restarts the quiet period.
+    debouncer.changed("p1", ProfileManager::PROFILE_MODIFIED, 500);
+    QVERIFY(debouncer.takeDue(1000).isEmpty());
+    QCOMPARE(debouncer.msecsToNext(1000), qint64(500));
+
+    QCOMPARE(debouncer.takeDue(1500), QList<Change>() << Change("p1", ProfileManager::PROFILE_MODIFIED));
+    QVERIFY(!debouncer.contains("p1"));
+    QCOMPARE(debouncer.msecsToNext(1500), qint64(-1));
+}
+
+void ProfileChangeDebouncerTest::testMaxWait()
+{
+    ProfileChangeDebouncer debouncer;
+    debouncer.setDelays(1000, 5000);
+
+    // A change every half a second never leaves a quiet second, but the
+    // change is due after the maximum wait anyway.
+    QList<Change> due;
+    qint64 now = 0;
+    for (; due.isEmpty() && now < 20000; now += 500) {
+        due = debouncer.takeDue(now);
+        debouncer.changed("p1", ProfileManager::PROFILE_MODIFIED, now);
+    }
+    QCOMPARE(due.size(), 1);
+    QCOMPARE(now - 500, qint64(5000));
+
+    QVariantMap stats = debouncer.statistics();
+    QCOMPARE(stats.value("profileChangesTriggered").toInt(), 1);
+    QCOMPARE(stats.value("profileChangesCapped").toInt(), 1);
+    QCOMPARE(stats.value("profileChangesCollapsed").toInt(), 9);
+}
+
+void ProfileChangeDebouncerTest::testCollapse()
+{
+    ProfileChangeDebouncer debouncer;
+    debouncer.setDelays(1000, 10000);
+
+    // An addition followed by modifications stays an addition.
+    debouncer.changed("p1", ProfileManager::PROFILE_ADDED, 0);
+    debouncer.changed("p1", ProfileManager::PROFILE_MODIFIED, 100);
+    debouncer.changed("p1", ProfileManager::PROFILE_MODIFIED, 200);
+    debouncer.changed("p2", ProfileManager::PROFILE_MODIFIED, 200);
+    debouncer.changed("p2", ProfileManager::PROFILE_ADDED, 300);
+
+    QCOMPARE(debouncer.takeDue(2000), QList<Change>()
+             << Change("p1", ProfileManager::PROFILE_ADDED)
+             << Change("p2", ProfileManager::PROFILE_ADDED));
+}
+
+void ProfileChangeDebouncerTest::testRemove()
+{
+    ProfileChangeDebouncer debouncer;
+    debouncer.setDelays(1000, 10000);
+
+    debouncer.changed("p1", ProfileManager::PROFILE_MODIFIED, 0);
+    debouncer.changed("p2", ProfileManager::PROFILE_MODIFIED, 100);
+    QVERIFY(debouncer.remove("p1"));
+    QVERIFY(!debouncer.remove("p1"));
+
+    QCOMPARE(debouncer.msecsToNext(0), qint64(1100));
+    QCOMPARE(debouncer.takeDue(2000), QList<Change>() << Change("p2", ProfileManager::PROFILE_MODIFIED));
+
+    // A profile changed again after removal starts over.
+    debouncer.changed("p1", ProfileManager::PROFILE_ADDED, 2000);
+    QVERIFY(debouncer.takeDue(2999).isEmpty());
+    QCOMPARE(debouncer.takeDue(3000).size(), 1);
+}
+
+void ProfileChangeDebouncerTest::testOrder()
+{
+    ProfileChangeDebouncer debouncer;
+    debouncer.setDelays(1000, 3000);
+
+    // Many changes to many profiles, the due order follows the deadlines.
+    for (int round = 0; round < 50; ++round) {
+        for (int i = 0; i < 10; ++i) {
+            debouncer.changed(QString("p%1").arg(i), ProfileManager::PROFILE_MODIFIED, round * 10 + i);
+        }
+    }
+
+    const QList<Change> due = debouncer.takeDue(100000);
+    QCOMPARE(due.size(), 10);
+    for (int i = 0; i < 10; ++i) {
+        QCOMPARE(due.at(i).first, QString("p%1").arg(i));
+    }
+    QCOMPARE(debouncer.statistics().value("profileChangesPending").toInt(), 0);
+}
+
+QTEST_MAIN(Buteo::ProfileChangeDebouncerTest)
@@ -0,0 +1,204 @@
+/*
+ * This file is part of buteo-syncfw package
+ *
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+#include "ScheduleSimulatorTest.h"
+#include "SyncSchedule.h"
+#include "WakeupCoalescer.h"
+
+#include <time.h>
+
+using namespace Buteo;
+
+static const qint64 MINUTE = 60 * 1000;
+
+// Monday, so that rush days line up with the simulated week.
+static const QDateTime SIMULATION_START(QDate(2024, 1, 1), QTime(0, 0));
+
+static qint64 threadCpuTime()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return qint64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// Deterministic pseudo random numbers, so that runs can be compared.
+static quint32 nextRandom(quint32 &aSeed)
+{
+    aSeed = aSeed * 1103515245 + 12345;
+    return (aSeed >> 16) & 0x7fff;
+}
+
+static SyncSchedule createSchedule(quint32 &aSeed)
+{
+    static const unsigned intervals[] = { 15, 30, 60, 120, 240 };
+    static const unsigned rushIntervals[] = { 10, 15, 30 };
+
+    SyncSchedule schedule;
+    schedule.setScheduleEnabled(true);
+    schedule.setInterval(intervals[nextRandom(aSeed) % 5]);
+    schedule.setScheduleConfiguredTime(SIMULATION_START.addSecs(-60 * int(nextRandom(aSeed) % 240)));
+
+    // Half of the profiles sync more often during working hours.
+    if (nextRandom(aSeed) % 2) {
+        const int begin = 6 + nextRandom(aSeed) % 4;
+        const int end = begin + 2 + nextRandom(aSeed) % 9;
+        schedule.setRushEnabled(true);
+        schedule.setRushInterval(rushIntervals[nextRandom(aSeed) % 3]);
+        schedule.setRushTime(QTime(begin, 0), QTime(end, 0));
+        schedule.setRushDays(SyncSchedule::Monday | SyncSchedule::Tuesday | SyncSchedule::Wednesday
+                             | SyncSchedule::Thursday | SyncSchedule::Friday);
+    }
+    return schedule;
+}
+
+// Scheduling state of the simulated profiles.
+struct Simulation {
+    Simulation(const VirtualClock &aClock, int aProfiles, int aWindow)
+        : iClock(aClock), iDecisions(0), iCpuTime(0), iImmediate(0)
+    {
+        quint32 seed = 1;
+        for (int i = 0; i < aProfiles; ++i) {
+            iSchedules.append(createSchedule(seed));
+            iNames.append(QString("profile%1").arg(i));
+            iIndexOf.insert(iNames.last(), i);
+        }
+        iDeadlines.resize(aProfiles);
+        iCoalescer.setWindow(aWindow);
+    }
+
+    // Computes the next sync of a profile and puts it in a wake-up slot.
+    void decide(int aIndex, const QDateTime &aPrevSync)
+    {
+        const qint64 begin = threadCpuTime();
+        QDateTime deadline = iSchedules.at(aIndex).nextSyncTime(aPrevSync);
+        if (deadline <= iClock.iNow) {
+            // Would sync again right away; move on a minute to keep the
+            // simulation going.
+            ++iImmediate;
+            deadline = iClock.iNow.addMSecs(MINUTE);
+        }
+        const QDateTime slot = iCoalescer.schedule(iNames.at(aIndex), deadline);
+        iCpuTime += threadCpuTime() - begin;
+        ++iDecisions;
+        iDeadlines[aIndex] = deadline;
+        iWakeTimes.insert(slot.toMSecsSinceEpoch(), true);
+    }
+
+    const VirtualClock &iClock;
+    QVector<SyncSchedule> iSchedules;
+    QVector<QDateTime> iDeadlines;
+    QStringList iNames;
+    QHash<QString, int> iIndexOf;
+    WakeupCoalescer iCoalescer;
+    QMap<qint64, bool> iWakeTimes;
+    qint64 iDecisions;
+    qint64 iCpuTime;
+    int iImmediate;
+};
+
+void ScheduleSimulatorTest::initTestCase()
+{
+    SyncClock::setClock(&iClock);
+}
+
+void ScheduleSimulatorTest::cleanupTestCase()
+{
+    SyncClock::setClock(0);
+}
+
+void ScheduleSimulatorTest::testVirtualClock()
+{
+    iClock.iNow = SIMULATION_START.addSecs(45 * 60);
+    QCOMPARE(SyncClock::currentDateTime(), iClock.iNow);
+
+    SyncSchedule schedule;
+    schedule.setScheduleEnabled(true);
+    schedule.setInterval(30);
+    QCOMPARE(schedule.nextSyncTime(SIMULATION_START), SIMULATION_START.addSecs(60 * 60));
+
+    iClock.iNow = SIMULATION_START.addDays(1);
+    QCOMPARE(schedule.nextSyncTime(SIMULATION_START), SIMULATION_START.addDays(1).addSecs(30 * 60));
+}
+
+void ScheduleSimulatorTest::simulate_data()
+{
+    QTest::addColumn<int>("days");
+    QTest::addColumn<int>("profiles");
+    QTest::addColumn<int>("window");
+
+    QTest::newRow("day, 2000 profiles, no alignment") << 1 << 2000 << 0;
+    QTest::newRow("day, 2000 profiles, 5 min alignment") << 1 << 2000 << 300;
+    QTest::newRow("week, 1000 profiles, 5 min alignment") << 7 << 1000 << 300;
+}
+
+void ScheduleSimulatorTest::simulate()
+{
+    QFETCH(int, days);
+    QFETCH(int, profiles);
+    QFETCH(int, window);
+
+    Simulation simulation(iClock, profiles, window);
+    iClock.iNow = SIMULATION_START;
+    for (int i = 0; i < profiles; ++i) {
+        simulation.decide(i, QDateTime());
+    }
+
+    const qint64 end = SIMULATION_START.addDays(days).toMSecsSinceEpoch();
+    int syncs = 0;
+    qint64 totalDrift = 0;
+    qint64 maxLate = 0;
+    qint64 maxEarly = 0;
+    while (!simulation.iWakeTimes.isEmpty() && simulation.iWakeTimes.firstKey() < end) {
+        const qint64 now = simulation.iWakeTimes.firstKey();
+        simulation.iWakeTimes.erase(simulation.iWakeTimes.begin());
+        iClock.iNow = QDateTime::fromMSecsSinceEpoch(now);
+
+        foreach (const QString &name, simulation.iCoalescer.wakeUp(iClock.iNow)) {
+            const int index = simulation.iIndexOf.value(name);
+            const qint64 drift = now - simulation.iDeadlines.at(index).toMSecsSinceEpoch();
+            totalDrift += qAbs(drift);
+            maxLate = qMax(maxLate, drift);
+            maxEarly = qMax(maxEarly, -drift);
+            ++syncs;
+            simulation.decide(index, iClock.iNow);
+        }
+    }
+
+    const QVariantMap stats = simulation.iCoalescer.statistics();
+    const qint64 decisions = simulation.iDecisions;
+    qDebug() << "Simulated" << days << "days of" << profiles << "profiles with" << window << "s alignment:";
+    qDebug() << "  wake-ups" << stats.value("scheduledWakeups").toInt()
+             << "per hour" << stats.value("wakeupsPerHour").toDouble();
+    qDebug() << "  syncs" << syncs << "per wake-up" << stats.value("syncsPerWakeup").toDouble()
+             << "immediate reschedules" << simulation.iImmediate;
+    qDebug() << "  drift average" << (syncs > 0 ? totalDrift / syncs : 0) << "ms, max late"
+             << maxLate << "ms, max early" << maxEarly << "ms";
+    qDebug() << "  CPU per decision" << (decisions > 0 ? simulation.iCpuTime / decisions : 0) << "ns over"
+             << decisions << "decisions";
+
+    QVERIFY(syncs >= profiles);
+    QVERIFY(maxLate <= window * 1000);
+    QVERIFY(maxEarly <= window * 500);
+    if (window == 0) {
+        QCOMPARE(totalDrift, qint64(0));
+    }
+}
+
+QTEST_MAIN(Buteo::ScheduleSimulatorTest)
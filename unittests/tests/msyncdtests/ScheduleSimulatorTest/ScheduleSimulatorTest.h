@@ -0,0 +1,63 @@
+/*
+ * This file is part of buteo-syncfw package
+ *
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+#ifndef SCHEDULESIMULATORTEST_H
+#define SCHEDULESIMULATORTEST_H
+
+#include <QtTest/QtTest>
+#include "SyncClock.h"
+
+namespace Buteo {
+
+// Clock that only moves when told to.
+class VirtualClock : public SyncClock
+{
+public:
+    QDateTime now() const
+    {
+        return iNow;
+    }
+
+    QDateTime iNow;
+};
+
+// Replays days of virtual time over synthetic scheduled profiles, and
+// reports the number of wake-ups and syncs, how far syncs drift from their
+// schedule and the CPU time used per scheduling decision.
+class ScheduleSimulatorTest: public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testVirtualClock();
+    void simulate_data();
+    void simulate();
+
+private:
+    VirtualClock iClock;
+};
+
+}
+
+#endif // SCHEDULESIMULATORTEST_H
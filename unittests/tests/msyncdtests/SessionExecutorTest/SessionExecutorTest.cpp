@@ -0,0 +1,121 @@
+/*
+ * This file is part of buteo-syncfw package
+ *
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+#include "SessionExecutorTest.h"
+#include "SessionExecutor.h"
+#include "SyncSession.h"
+#include <SyncProfile.h>
+#include <ProfileEngineDefs.h>
+
+using namespace Buteo;
+
+static SyncSession *createSession(const QString &aName, const QString &aClient, const QString &aAccount)
+{
+    SyncProfile *profile = new SyncProfile(aName);
+    profile->setKey(KEY_ACCOUNT_ID, aAccount);
+    profile->merge(Profile(aClient, Profile::TYPE_CLIENT));
+    return new SyncSession(profile);
+}
+
+void SessionExecutorTest::testGlobalLimit()
+{
+    QScopedPointer<SyncSession> s1(createSession("p1", "client1", "1"));
+    QScopedPointer<SyncSession> s2(createSession("p2", "client2", "2"));
+    QScopedPointer<SyncSession> s3(createSession("p3", "client3", "3"));
+
+    SessionExecutor executor;
+    executor.setLimits(2, 0, 0);
+    QVERIFY(executor.canStart(s1.data()));
+    executor.started(s1.data());
+    QVERIFY(executor.canStart(s2.data()));
+    executor.started(s2.data());
+    QCOMPARE(executor.runningCount(), 2);
+    QVERIFY(!executor.canStart(s3.data()));
+
+    executor.finished("p1");
+    QCOMPARE(executor.runningCount(), 1);
+    QVERIFY(executor.canStart(s3.data()));
+
+    // Finishing an unknown session changes nothing.
+    executor.finished("p1");
+    QCOMPARE(executor.runningCount(), 1);
+
+    // No limits at all.
+    executor.setLimits(0, 0, 0);
+    executor.started(s1.data());
+    executor.started(s3.data());
+    QCOMPARE(executor.runningCount(), 3);
+}
+
+void SessionExecutorTest::testClientAndHostLimits()
+{
+    QScopedPointer<SyncSession> contacts1(createSession("contacts1", "carddav", "1"));
+    QScopedPointer<SyncSession> contacts2(createSession("contacts2", "carddav", "2"));
+    QScopedPointer<SyncSession> calendar1(createSession("calendar1", "caldav", "1"));
+    QScopedPointer<SyncSession> email1(createSession("email1", "email", "1"));
+
+    SessionExecutor executor;
+    executor.setLimits(0, 1, 2);
+
+    executor.started(contacts1.data());
+    // Same client plugin, different account.
+    QVERIFY(!executor.canStart(contacts2.data()));
+    // Same account, different client plugin.
+    QVERIFY(executor.canStart(calendar1.data()));
+    executor.started(calendar1.data());
+    // Both slots of account 1 are in use.
+    QVERIFY(!executor.canStart(email1.data()));
+
+    executor.finished("contacts1");
+    QVERIFY(executor.canStart(contacts2.data()));
+    QVERIFY(executor.canStart(email1.data()));
+}
+
+void SessionExecutorTest::testStatistics()
+{
+    QScopedPointer<SyncSession> s1(createSession("p1", "client1", "1"));
+    QScopedPointer<SyncSession> s2(createSession("p2", "client1", "2"));
+
+    SessionExecutor executor;
+    executor.setLimits(2, 1, 0);
+    executor.started(s1.data());
+    QVERIFY(!executor.canStart(s2.data()));
+    executor.queued("p2");
+    // Scanning the queue again does not count the session again.
+    QVERIFY(!executor.canStart(s2.data()));
+    QTest::qWait(50);
+    executor.finished("p1");
+    QVERIFY(executor.canStart(s2.data()));
+    executor.started(s2.data());
+
+    QVariantMap stats = executor.statistics();
+    QCOMPARE(stats.value("maxSessions").toInt(), 2);
+    QCOMPARE(stats.value("runningSessions").toInt(), 1);
+    QCOMPARE(stats.value("queuedSessions").toInt(), 0);
+    QCOMPARE(stats.value("peakRunningSessions").toInt(), 1);
+    QCOMPARE(stats.value("startedSessions").toInt(), 2);
+    QCOMPARE(stats.value("clientLimitDeferrals").toInt(), 1);
+    QVERIFY(stats.value("maxQueueWaitMs").toLongLong() >= 40);
+    QCOMPARE(stats.value("totalQueueWaitMs").toLongLong(), stats.value("maxQueueWaitMs").toLongLong());
+    double utilization = stats.value("slotUtilization").toDouble();
+    QVERIFY(utilization > 0.0 && utilization <= 1.0);
+}
+
+QTEST_MAIN(Buteo::SessionExecutorTest)
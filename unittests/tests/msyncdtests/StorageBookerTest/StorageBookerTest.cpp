@@ -22,9 +22,56 @@
  */
 #include "StorageBookerTest.h"
 #include "StorageBooker.h"
+#include <QThread>
 
 using namespace Buteo;
 
+namespace {
+
+// Reserves and releases one storage in a loop, counting the reservations
+// that succeeded.
+class BookingThread : public QThread
+{
+public:
+    BookingThread(StorageBooker *aBooker, const QString &aStorage,
+                  const QString &aClientId, StorageBooker::ReservationMode aMode,
+                  int aRounds)
+        : iBooker(aBooker), iStorage(aStorage), iClientId(aClientId),
+          iMode(aMode), iRounds(aRounds), iSucceeded(0)
+    {
+    }
+
+    int succeeded() const
+    {
+        return iSucceeded;
+    }
+
+protected:
+    void run()
+    {
+        for (int i = 0; i < iRounds; ++i) {
+            if (iBooker->reserveStorage(iStorage, iClientId, iMode)) {
+                ++iSucceeded;
+                yieldCurrentThread();
+                iBooker->releaseStorage(iStorage, iClientId);
+            }
+        }
+        if (iMode == StorageBooker::Exclusive) {
+            iBooker->withdraw(iClientId);
+        }
+    }
+
+private:
+    StorageBooker *iBooker;
+    QString iStorage;
+    QString iClientId;
+    StorageBooker::ReservationMode iMode;
+    int iRounds;
+    int iSucceeded;
+};
+
+}
+
 void StorageBookerTest::testBooking()
 {
     const QString STORAGE1 = "Storage1";
@@ -91,4 +138,256 @@ void StorageBookerTest::testBooking()
 
 }
 
+void StorageBookerTest::testReleaseSignal()
+{
+    const QString STORAGE1 = "Storage1";
+    const QString CLIENT1 = "Client1";
+
+    StorageBooker booker;
+    QSignalSpy released(&booker, SIGNAL(storageReleased(QString)));
+
+    // Only the last release of a reservation frees the storage.
+    QCOMPARE(booker.reserveStorage(STORAGE1, CLIENT1), true);
+    QCOMPARE(booker.reserveStorage(STORAGE1, CLIENT1), true);
+    booker.releaseStorage(STORAGE1);
+    QCOMPARE(released.count(), 0);
+    booker.releaseStorage(STORAGE1);
+    QCOMPARE(released.count(), 1);
+    QCOMPARE(released.first().first().toString(), STORAGE1);
+
+    // Releasing a free storage does nothing.
+    booker.releaseStorage(STORAGE1);
+    QCOMPARE(released.count(), 1);
+}
+
+void StorageBookerTest::testSharedBooking()
+{
+    const QString STORAGE1 = "Storage1";
+    const QString STORAGE2 = "Storage2";
+    const QString READER1 = "Reader1";
+    const QString READER2 = "Reader2";
+    const QString WRITER = "Writer";
+
+    StorageBooker booker;
+    QSignalSpy released(&booker, SIGNAL(storageReleased(QString)));
+    QStringList allStorages;
+    allStorages << STORAGE1 << STORAGE2;
+
+    // Readers share the storages, a writer can not get them, and neither can
+    // one of the readers while the other one shares them.
+    QCOMPARE(booker.reserveStorages(allStorages, READER1, StorageBooker::Shared), true);
+    QCOMPARE(booker.reserveStorages(allStorages, READER2, StorageBooker::Shared), true);
+    QCOMPARE(booker.reserveStorage(STORAGE1, READER1, StorageBooker::Shared), true);
+    QCOMPARE(booker.isStorageAvailable(STORAGE1, WRITER), false);
+    QCOMPARE(booker.isStorageAvailable(STORAGE1, READER1), false);
+    QCOMPARE(booker.isStorageAvailable(STORAGE2, WRITER, StorageBooker::Shared), true);
+
+    // Release counts all remaining references to the storage.
+    QCOMPARE(booker.releaseStorage(STORAGE1, READER1), (unsigned)2);
+    QCOMPARE(booker.releaseStorage(STORAGE1, READER1), (unsigned)1);
+    QCOMPARE(booker.releaseStorage(STORAGE1, WRITER), (unsigned)1);
+    QCOMPARE(released.count(), 0);
+    QCOMPARE(booker.releaseStorage(STORAGE1, READER2), (unsigned)0);
+    QCOMPARE(released.count(), 1);
+    QCOMPARE(booker.reserveStorage(STORAGE1, WRITER), true);
+
+    // An exclusive owner may add shared references, others may not.
+    QCOMPARE(booker.reserveStorage(STORAGE1, WRITER, StorageBooker::Shared), true);
+    QCOMPARE(booker.reserveStorage(STORAGE1, READER1, StorageBooker::Shared), false);
+    QCOMPARE(booker.releaseStorage(STORAGE1, WRITER), (unsigned)1);
+    QCOMPARE(booker.releaseStorage(STORAGE1, WRITER), (unsigned)0);
+
+    booker.releaseStorages(allStorages, READER1);
+    QCOMPARE(booker.storagesAvailable(allStorages, WRITER), false);
+    booker.releaseStorages(allStorages, READER2);
+    QCOMPARE(booker.storagesAvailable(allStorages, WRITER), true);
+}
+
+void StorageBookerTest::testWriterPreference()
+{
+    const QString STORAGE1 = "Storage1";
+    const QString READER1 = "Reader1";
+    const QString READER2 = "Reader2";
+    const QString WRITER = "Writer";
+
+    StorageBooker booker;
+    QSignalSpy released(&booker, SIGNAL(storageReleased(QString)));
+
+    QCOMPARE(booker.reserveStorage(STORAGE1, READER1, StorageBooker::Shared), true);
+
+    // Once a writer waits, new readers are held back, but existing readers
+    // can still add references.
+    QCOMPARE(booker.reserveStorage(STORAGE1, WRITER), false);
+    QCOMPARE(booker.reserveStorage(STORAGE1, READER2, StorageBooker::Shared), false);
+    QCOMPARE(booker.reserveStorage(STORAGE1, READER1, StorageBooker::Shared), true);
+    QCOMPARE(booker.releaseStorage(STORAGE1, READER1), (unsigned)1);
+
+    // The writer gets the storage when the readers are gone, after which
+    // readers are let in again.
+    QCOMPARE(booker.releaseStorage(STORAGE1, READER1), (unsigned)0);
+    QCOMPARE(booker.isStorageAvailable(STORAGE1, READER2, StorageBooker::Shared), false);
+    QCOMPARE(released.count(), 1);
+    QCOMPARE(booker.reserveStorage(STORAGE1, WRITER), true);
+
+    // Getting the storage does not wake waiters, as the writer holds it.
+    QCOMPARE(released.count(), 1);
+    QCOMPARE(booker.releaseStorage(STORAGE1, WRITER), (unsigned)0);
+    QCOMPARE(released.count(), 2);
+    QCOMPARE(booker.reserveStorage(STORAGE1, READER2, StorageBooker::Shared), true);
+
+    // Anonymous writers can not withdraw, so they never hold readers back.
+    QCOMPARE(booker.reserveStorage(STORAGE1, ""), false);
+    QCOMPARE(booker.reserveStorage(STORAGE1, READER1, StorageBooker::Shared), true);
+}
+
+void StorageBookerTest::testWithdraw()
+{
+    const QString STORAGE1 = "Storage1";
+    const QString READER1 = "Reader1";
+    const QString READER2 = "Reader2";
+    const QString WRITER1 = "Writer1";
+    const QString WRITER2 = "Writer2";
+
+    StorageBooker booker;
+    QSignalSpy released(&booker, SIGNAL(storageReleased(QString)));
+
+    QCOMPARE(booker.reserveStorage(STORAGE1, READER1, StorageBooker::Shared), true);
+    QCOMPARE(booker.reserveStorages(QStringList() << STORAGE1, WRITER1), false);
+    QCOMPARE(booker.reserveStorage(STORAGE1, WRITER2), false);
+
+    // Readers are let in and notified only when the last writer gives up.
+    booker.withdraw(WRITER1);
+    QCOMPARE(released.count(), 0);
+    QCOMPARE(booker.isStorageAvailable(STORAGE1, READER2, StorageBooker::Shared), false);
+    booker.withdraw(WRITER2);
+    QCOMPARE(released.count(), 1);
+    QCOMPARE(released.first().first().toString(), STORAGE1);
+    QCOMPARE(booker.reserveStorage(STORAGE1, READER2, StorageBooker::Shared), true);
+
+    // Withdrawing a client that does not wait does nothing.
+    booker.withdraw(WRITER1);
+    QCOMPARE(released.count(), 1);
+
+    // Readers are also notified when the writer gives up on a storage that
+    // was released while it waited.
+    QCOMPARE(booker.reserveStorage(STORAGE1, WRITER1), false);
+    QCOMPARE(booker.releaseStorage(STORAGE1, READER1), (unsigned)1);
+    QCOMPARE(booker.releaseStorage(STORAGE1, READER2), (unsigned)0);
+    QCOMPARE(released.count(), 2);
+    QCOMPARE(booker.isStorageAvailable(STORAGE1, READER2, StorageBooker::Shared), false);
+    booker.withdraw(WRITER1);
+    QCOMPARE(released.count(), 3);
+    QCOMPARE(booker.isStorageAvailable(STORAGE1, READER2, StorageBooker::Shared), true);
+}
+
+void StorageBookerTest::testUpgrade()
+{
+    const QString STORAGE1 = "Storage1";
+    const QString READER1 = "Reader1";
+    const QString READER2 = "Reader2";
+
+    StorageBooker booker;
+    QSignalSpy released(&booker, SIGNAL(storageReleased(QString)));
+
+    // A reader can not upgrade while another reader shares the storage. It
+    // waits like any writer, so new readers are held back.
+    QCOMPARE(booker.reserveStorage(STORAGE1, READER1, StorageBooker::Shared), true);
+    QCOMPARE(booker.reserveStorage(STORAGE1, READER2, StorageBooker::Shared), true);
+    QCOMPARE(booker.reserveStorage(STORAGE1, READER1), false);
+    QCOMPARE(booker.isStorageAvailable(STORAGE1, "Reader3", StorageBooker::Shared), false);
+    QCOMPARE(booker.reserveStorage(STORAGE1, READER2, StorageBooker::Shared), true);
+
+    // Once it is the only reader, the upgrade is granted and the storage is
+    // no longer shared.
+    QCOMPARE(booker.releaseStorage(STORAGE1, READER2), (unsigned)2);
+    QCOMPARE(booker.releaseStorage(STORAGE1, READER2), (unsigned)1);
+    QCOMPARE(booker.reserveStorage(STORAGE1, READER1), true);
+    QCOMPARE(booker.isStorageAvailable(STORAGE1, READER2, StorageBooker::Shared), false);
+    QCOMPARE(booker.reserveStorage(STORAGE1, READER2, StorageBooker::Shared), false);
+
+    // Every reference, shared or exclusive, must be released.
+    QCOMPARE(booker.releaseStorage(STORAGE1, READER1), (unsigned)1);
+    QCOMPARE(released.count(), 0);
+    QCOMPARE(booker.releaseStorage(STORAGE1, READER1), (unsigned)0);
+    QCOMPARE(released.count(), 1);
+    QCOMPARE(booker.reserveStorage(STORAGE1, READER2, StorageBooker::Shared), true);
+}
+
+void StorageBookerTest::testClientMode()
+{
+    const QString STORAGE1 = "Storage1";
+    const QString STORAGE2 = "Storage2";
+    const QString READER1 = "Reader1";
+    const QString READER2 = "Reader2";
+
+    StorageBooker booker;
+
+    // Later reservations of a client use the mode of its reserveStorages.
+    QCOMPARE(booker.reserveStorages(QStringList() << STORAGE1, READER1, StorageBooker::Shared), true);
+    QCOMPARE(booker.reserveStorages(QStringList() << STORAGE1, READER2, StorageBooker::Shared), true);
+    QCOMPARE(booker.reserveClientStorage(STORAGE2, READER1), true);
+    QCOMPARE(booker.reserveClientStorage(STORAGE2, READER2), true);
+    QCOMPARE(booker.reserveClientStorage(STORAGE1, READER1), true);
+    QCOMPARE(booker.releaseStorage(STORAGE1, READER1), (unsigned)2);
+
+    // Once the client is withdrawn its reservations are exclusive again.
+    booker.withdraw(READER1);
+    QCOMPARE(booker.reserveClientStorage(STORAGE1, READER1), false);
+    booker.withdraw(READER1);
+
+    // Clients that have not reserved storages reserve them exclusively.
+    QCOMPARE(booker.reserveClientStorage("Storage3", READER1), true);
+    QCOMPARE(booker.isStorageAvailable("Storage3", READER2, StorageBooker::Shared), false);
+}
+
+void StorageBookerTest::benchmarkContention_data()
+{
+    QTest::addColumn<int>("threads");
+    QTest::addColumn<bool>("shared");
+
+    QTest::newRow("exclusive, 2 threads") << 2 << false;
+    QTest::newRow("shared, 2 threads") << 2 << true;
+    QTest::newRow("exclusive, 8 threads") << 8 << false;
+    QTest::newRow("shared, 8 threads") << 8 << true;
+}
+
+void StorageBookerTest::benchmarkContention()
+{
+    QFETCH(int, threads);
+    QFETCH(bool, shared);
+
+    const int ROUNDS = 1000;
+    const StorageBooker::ReservationMode mode = shared ? StorageBooker::Shared
+                                                : StorageBooker::Exclusive;
+
+    StorageBooker booker;
+    int succeeded = 0;
+    QBENCHMARK {
+        QList<BookingThread *> bookers;
+        for (int i = 0; i < threads; ++i) {
+            bookers.append(new BookingThread(&booker, "hcontacts",
+                                             QString("client%1").arg(i),
+                                             mode, ROUNDS));
+        }
+        foreach (BookingThread *thread, bookers) {
+            thread->start();
+        }
+        succeeded = 0;
+        foreach (BookingThread *thread, bookers) {
+            thread->wait();
+            succeeded += thread->succeeded();
+        }
+        qDeleteAll(bookers);
+    }
+
+    // Readers never turn each other away, writers do under contention.
+    if (shared) {
+        QCOMPARE(succeeded, threads * ROUNDS);
+    } else {
+        QVERIFY(succeeded > 0);
+        QVERIFY(succeeded <= threads * ROUNDS);
+    }
+    QVERIFY(booker.isStorageAvailable("hcontacts", "client0"));
+}
+
 QTEST_MAIN(Buteo::StorageBookerTest)
@@ -34,6 +34,14 @@ class StorageBookerTest: public QObject
 private slots:
 
     void testBooking();
+    void testReleaseSignal();
+    void testSharedBooking();
+    void testWriterPreference();
+    void testWithdraw();
+    void testUpgrade();
+    void testClientMode();
+    void benchmarkContention_data();
+    void benchmarkContention();
 };
 
 }
@@ -0,0 +1,83 @@
+/*
+ * This file is part of buteo-syncfw package
+ *
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+#include "SyncAlarmInventoryTest.h"
+#include "SyncAlarmInventory.h"
+
+using namespace Buteo;
+
+static QList<int> triggeredIds(const QSignalSpy &aSpy)
+{
+    QList<int> ids;
+    foreach (const QList<QVariant> &args, aSpy) {
+        ids << args.first().toInt();
+    }
+    return ids;
+}
+
+void SyncAlarmInventoryTest::testAlarmOrder()
+{
+    SyncAlarmInventory inventory;
+    QVERIFY(inventory.init());
+    QSignalSpy triggered(&inventory, SIGNAL(triggerAlarm(int)));
+
+    // Alarms are added out of order.
+    const QDateTime base = QDateTime::currentDateTime();
+    const int alarm4 = inventory.addAlarm(base.addMSecs(800));
+    const int alarm2 = inventory.addAlarm(base.addMSecs(400));
+    const int alarm5 = inventory.addAlarm(base.addMSecs(1000));
+    const int alarm1 = inventory.addAlarm(base.addMSecs(200));
+    const int alarm3 = inventory.addAlarm(base.addMSecs(600));
+    QVERIFY(alarm1 > 0 && alarm2 > 0 && alarm3 > 0 && alarm4 > 0 && alarm5 > 0);
+
+    // Removing the current head moves the timer to the next alarm, alarms
+    // removed from the middle stay in the heap until they reach the top.
+    QVERIFY(inventory.removeAlarm(alarm1));
+    QVERIFY(inventory.removeAlarm(alarm4));
+    const int alarm0 = inventory.addAlarm(base.addMSecs(300));
+
+    const QList<int> expected = QList<int>() << alarm0 << alarm2 << alarm3 << alarm5;
+    QTRY_COMPARE_WITH_TIMEOUT(triggered.count(), expected.count(), 5000);
+
+    // Nothing else fires later.
+    QTest::qWait(500);
+    QCOMPARE(triggeredIds(triggered), expected);
+}
+
+void SyncAlarmInventoryTest::testRemoveAll()
+{
+    SyncAlarmInventory inventory;
+    QVERIFY(inventory.init());
+    QSignalSpy triggered(&inventory, SIGNAL(triggerAlarm(int)));
+
+    const QDateTime base = QDateTime::currentDateTime();
+    inventory.addAlarm(base.addMSecs(200));
+    inventory.addAlarm(base.addMSecs(100));
+    inventory.removeAllAlarms();
+
+    // Alarms added after clearing still fire, in deadline order.
+    const int alarm2 = inventory.addAlarm(base.addMSecs(400));
+    const int alarm1 = inventory.addAlarm(base.addMSecs(300));
+    QTRY_COMPARE_WITH_TIMEOUT(triggered.count(), 2, 5000);
+    QTest::qWait(300);
+    QCOMPARE(triggeredIds(triggered), QList<int>() << alarm1 << alarm2);
+}
+
+QTEST_MAIN(Buteo::SyncAlarmInventoryTest)
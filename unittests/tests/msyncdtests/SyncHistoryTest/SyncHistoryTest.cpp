@@ -0,0 +1,146 @@
+/*
+ * This file is part of buteo-syncfw package
+ *
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+#include "SyncHistoryTest.h"
+#include "SyncHistory.h"
+#include <SyncLog.h>
+#include <SyncResults.h>
+#include <QDomDocument>
+
+using namespace Buteo;
+
+static const QString PROFILE1("profile1");
+static const QString PROFILE2("profile2");
+static const int COUNT = 50;
+
+static QDateTime syncTime(int aIndex)
+{
+    return QDateTime::fromMSecsSinceEpoch(1000000000000LL + aIndex * 60000LL);
+}
+
+static SyncLog parseLog(const QString &aXml)
+{
+    QDomDocument doc;
+    doc.setContent(aXml);
+    return SyncLog(doc.documentElement());
+}
+
+void SyncHistoryTest::init()
+{
+    iDir = new QTemporaryDir;
+    iHistory = new SyncHistory;
+    QVERIFY(iHistory->init(iDir->filePath("synchistory.db.sqlite")));
+    QVERIFY(iHistory->isEmpty());
+
+    // Every third result is a failure, results alternate between profiles.
+    for (int i = 0; i < COUNT; ++i) {
+        SyncResults results(syncTime(i),
+                            i % 3 ? SyncResults::SYNC_RESULT_SUCCESS : SyncResults::SYNC_RESULT_FAILED,
+                            i % 3 ? SyncResults::NO_ERROR : SyncResults::CONNECTION_ERROR);
+        QVERIFY(iHistory->addResults(i % 2 ? PROFILE2 : PROFILE1, results));
+    }
+    QVERIFY(!iHistory->isEmpty());
+}
+
+void SyncHistoryTest::cleanup()
+{
+    delete iHistory;
+    iHistory = 0;
+    delete iDir;
+    iDir = 0;
+}
+
+void SyncHistoryTest::testProfileQueries()
+{
+    // All profiles, newest first.
+    QStringList all = iHistory->results(QString(), 0, 0, 0, 0);
+    QCOMPARE(all.size(), COUNT);
+    SyncLog newest = parseLog(all.first());
+    QCOMPARE(newest.profileName(), PROFILE2);
+    QCOMPARE(newest.allResults().size(), 1);
+    QCOMPARE(newest.lastResults()->syncTime(), syncTime(COUNT - 1));
+
+    // Paging through one profile covers each of its results once.
+    QStringList paged;
+    for (int offset = 0; ; offset += 10) {
+        QStringList page = iHistory->results(PROFILE1, 0, 0, 10, offset);
+        if (page.isEmpty())
+            break;
+        QVERIFY(page.size() <= 10);
+        paged << page;
+    }
+    QCOMPARE(paged.size(), COUNT / 2);
+    QCOMPARE(parseLog(paged.last()).lastResults()->syncTime(), syncTime(0));
+    foreach (const QString &entry, paged) {
+        QCOMPARE(parseLog(entry).profileName(), PROFILE1);
+    }
+
+    // Time range is inclusive on both ends.
+    QStringList range = iHistory->results(QString(), syncTime(10).toMSecsSinceEpoch(),
+                                          syncTime(19).toMSecsSinceEpoch(), 0, 0);
+    QCOMPARE(range.size(), 10);
+    QCOMPARE(parseLog(range.first()).lastResults()->syncTime(), syncTime(19));
+    QCOMPARE(parseLog(range.last()).lastResults()->syncTime(), syncTime(10));
+
+    QVERIFY(iHistory->results("unknown", 0, 0, 0, 0).isEmpty());
+}
+
+void SyncHistoryTest::testCodeQueries()
+{
+    const int failures = (COUNT + 2) / 3;
+    QCOMPARE(iHistory->resultsByCode(SyncResults::SYNC_RESULT_FAILED, -1, 0, 0, 0, 0).size(), failures);
+    QCOMPARE(iHistory->resultsByCode(SyncResults::SYNC_RESULT_FAILED, SyncResults::CONNECTION_ERROR,
+                                     0, 0, 0, 0).size(), failures);
+    QVERIFY(iHistory->resultsByCode(SyncResults::SYNC_RESULT_FAILED, SyncResults::INTERNAL_ERROR,
+                                    0, 0, 0, 0).isEmpty());
+    QCOMPARE(iHistory->resultsByCode(SyncResults::SYNC_RESULT_SUCCESS, SyncResults::NO_ERROR,
+                                     0, 0, 0, 0).size(), COUNT - failures);
+
+    QStringList page = iHistory->resultsByCode(SyncResults::SYNC_RESULT_FAILED, -1, 0, 0, 5, 5);
+    QCOMPARE(page.size(), 5);
+    const SyncResults *first = parseLog(page.first()).lastResults();
+    QCOMPARE(first->majorCode(), SyncResults::SYNC_RESULT_FAILED);
+    QCOMPARE(first->minorCode(), SyncResults::CONNECTION_ERROR);
+}
+
+void SyncHistoryTest::testImportLog()
+{
+    const QString name("imported");
+    SyncLog log(name);
+    for (int i = 0; i < 3; ++i) {
+        log.addResults(SyncResults(syncTime(COUNT + i), SyncResults::SYNC_RESULT_SUCCESS,
+                                   SyncResults::NO_ERROR));
+    }
+    QVERIFY(iHistory->addLog(log));
+
+    QStringList imported = iHistory->results(name, 0, 0, 0, 0);
+    QCOMPARE(imported.size(), 3);
+    QCOMPARE(parseLog(imported.first()).lastResults()->syncTime(), syncTime(COUNT + 2));
+
+    // The import is recorded in the database.
+    QVERIFY(!iHistory->isImported());
+    QVERIFY(iHistory->setImported());
+    delete iHistory;
+    iHistory = new SyncHistory;
+    QVERIFY(iHistory->init(iDir->filePath("synchistory.db.sqlite")));
+    QVERIFY(iHistory->isImported());
+}
+
+QTEST_MAIN(Buteo::SyncHistoryTest)
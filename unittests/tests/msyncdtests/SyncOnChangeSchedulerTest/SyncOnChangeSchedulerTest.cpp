@@ -0,0 +1,169 @@
+/*
+ * This file is part of buteo-syncfw package
+ *
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+#include "SyncOnChangeSchedulerTest.h"
+#include "SyncOnChangeScheduler.h"
+#include "SyncProfile.h"
+#include "ProfileEngineDefs.h"
+
+using namespace Buteo;
+
+static const qint64 SECOND = 1000;
+
+void SyncOnChangeSchedulerTest::testMerge()
+{
+    SyncOnChangeScheduler scheduler;
+
+    // Changes from several storages while a sync is pending are merged.
+    QVERIFY(scheduler.schedule("p1", 10 * SECOND, 0, 0));
+    QVERIFY(!scheduler.schedule("p1", 10 * SECOND, 0, 2 * SECOND));
+    QVERIFY(!scheduler.schedule("p1", 10 * SECOND, 0, 5 * SECOND));
+    QVERIFY(scheduler.schedule("p2", 1 * SECOND, 0, 5 * SECOND));
+
+    QCOMPARE(scheduler.takeDue(6 * SECOND), QStringList() << "p2");
+    QVERIFY(scheduler.takeDue(9 * SECOND).isEmpty());
+    QCOMPARE(scheduler.takeDue(10 * SECOND), QStringList() << "p1");
+
+    QVariantMap stats = scheduler.changeStatistics();
+    QCOMPARE(stats.value("syncOnChangeNotifications").toInt(), 4);
+    QCOMPARE(stats.value("syncOnChangeMerged").toInt(), 2);
+    QCOMPARE(stats.value("syncOnChangeSyncs").toInt(), 2);
+}
+
+void SyncOnChangeSchedulerTest::testMinGap()
+{
+    SyncOnChangeScheduler scheduler;
+
+    QVERIFY(scheduler.schedule("p1", 0, 60 * SECOND, 0));
+    QCOMPARE(scheduler.takeDue(0), QStringList() << "p1");
+
+    // A change right after the sync waits for the gap.
+    QVERIFY(scheduler.schedule("p1", 0, 60 * SECOND, 1 * SECOND));
+    QVERIFY(scheduler.takeDue(59 * SECOND).isEmpty());
+    QCOMPARE(scheduler.takeDue(60 * SECOND), QStringList() << "p1");
+
+    // A change long after the previous sync does not.
+    QVERIFY(scheduler.schedule("p1", 0, 60 * SECOND, 200 * SECOND));
+    QCOMPARE(scheduler.takeDue(200 * SECOND), QStringList() << "p1");
+
+    // Cancelling keeps the gap, removing the profile forgets it.
+    QVERIFY(scheduler.schedule("p1", 0, 60 * SECOND, 201 * SECOND));
+    scheduler.cancelSync("p1");
+    QVERIFY(scheduler.schedule("p1", 0, 60 * SECOND, 202 * SECOND));
+    QVERIFY(scheduler.takeDue(202 * SECOND).isEmpty());
+    scheduler.removeProfile("p1");
+    QVERIFY(scheduler.schedule("p1", 0, 60 * SECOND, 203 * SECOND));
+    QCOMPARE(scheduler.takeDue(203 * SECOND), QStringList() << "p1");
+
+    QCOMPARE(scheduler.changeStatistics().value("syncOnChangeGapDelayed").toInt(), 3);
+}
+
+void SyncOnChangeSchedulerTest::testRemove()
+{
+    SyncOnChangeScheduler scheduler;
+
+    QVERIFY(scheduler.schedule("p1", 10 * SECOND, 0, 0));
+    scheduler.removeProfile("p1");
+    QVERIFY(scheduler.takeDue(20 * SECOND).isEmpty());
+
+    // Removed and scheduled again, only the new deadline counts.
+    QVERIFY(scheduler.schedule("p2", 10 * SECOND, 0, 0));
+    scheduler.removeProfile("p2");
+    QVERIFY(scheduler.schedule("p2", 10 * SECOND, 0, 5 * SECOND));
+    QVERIFY(scheduler.takeDue(10 * SECOND).isEmpty());
+    QCOMPARE(scheduler.takeDue(15 * SECOND), QStringList() << "p2");
+    QCOMPARE(scheduler.changeStatistics().value("syncOnChangePending").toInt(), 0);
+}
+
+void SyncOnChangeSchedulerTest::testBulkImport()
+{
+    // An import of 5000 contacts notifies a change every 20 ms for 100
+    // seconds to a profile that syncs immediately on change.
+    SyncOnChangeScheduler scheduler;
+
+    int syncs = 0;
+    qint64 now = 0;
+    for (int i = 0; i < 5000; ++i, now += 20) {
+        scheduler.schedule("contacts", 0, 60 * SECOND, now);
+        syncs += scheduler.takeDue(now).size();
+    }
+    for (; now < 300 * SECOND; now += SECOND) {
+        syncs += scheduler.takeDue(now).size();
+    }
+
+    // One sync at the start, one after the gap and one for the changes
+    // after that.
+    QCOMPARE(syncs, 3);
+    QCOMPARE(scheduler.changeStatistics().value("syncOnChangeMerged").toInt(), 5000 - 3);
+}
+
+void SyncOnChangeSchedulerTest::testSyncNow()
+{
+    SyncOnChangeScheduler scheduler;
+    QSignalSpy spy(&scheduler, SIGNAL(syncNow(QString)));
+
+    SyncProfile profile("p1");
+    profile.setKey(KEY_SOC_AFTER, "0");
+    QVERIFY(scheduler.addProfile(&profile));
+    QVERIFY(!scheduler.addProfile(&profile));
+
+    QTRY_COMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).toString(), QString("p1"));
+}
+
+void SyncOnChangeSchedulerTest::testChangeSets()
+{
+    SyncOnChangeScheduler scheduler;
+
+    SyncProfile profile("p1");
+    profile.setKey(KEY_SOC_AFTER, "3600");
+
+    // Changes from two storages within the window end up in one set.
+    StorageChangeSet contacts;
+    contacts.addChanges("hcontacts", QStringList() << "1" << "2", StorageChangeSet::ItemAdded);
+    StorageChangeSet moreContacts;
+    moreContacts.addChanges("hcontacts", QStringList() << "2", StorageChangeSet::ItemModified);
+    moreContacts.addChanges("hcontacts", QStringList() << "3", StorageChangeSet::ItemDeleted);
+    StorageChangeSet calendar;
+    calendar.setIncomplete("hcalendar");
+
+    QVERIFY(scheduler.addProfile(&profile, contacts));
+    QVERIFY(!scheduler.addProfile(&profile, moreContacts));
+    QVERIFY(!scheduler.addProfile(&profile, calendar));
+
+    // Nothing to take before the sync is initiated.
+    QVERIFY(scheduler.takeChangeSet("p1").isEmpty());
+    QCOMPARE(scheduler.takeDue(scheduler.iClock.elapsed() + 3600 * SECOND), QStringList() << "p1");
+
+    StorageChangeSet changes = scheduler.takeChangeSet("p1");
+    QCOMPARE(changes.itemCount(), 3);
+    QCOMPARE(changes.items("hcontacts", StorageChangeSet::ItemAdded).size(), 2);
+    QCOMPARE(changes.items("hcontacts", StorageChangeSet::ItemDeleted), QStringList() << "3");
+    QVERIFY(!changes.isComplete("hcalendar"));
+    QVERIFY(scheduler.takeChangeSet("p1").isEmpty());
+
+    // Removing the profile drops its changes.
+    QVERIFY(scheduler.addProfile(&profile, contacts));
+    scheduler.removeProfile("p1");
+    QVERIFY(scheduler.takeDue(scheduler.iClock.elapsed() + 7200 * SECOND).isEmpty());
+    QVERIFY(scheduler.takeChangeSet("p1").isEmpty());
+}
+
+QTEST_MAIN(Buteo::SyncOnChangeSchedulerTest)
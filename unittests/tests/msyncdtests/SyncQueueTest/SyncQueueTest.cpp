@@ -24,6 +24,7 @@
 #include "SyncQueue.h"
 #include "SyncSession.h"
 #include <SyncProfile.h>
+#include <ProfileEngineDefs.h>
 
 using namespace Buteo;
 
@@ -42,8 +43,8 @@ void SyncQueueTest::testQueue()
     QCOMPARE(q.contains(NAME1), false);
 
     // Add items.
-    q.enqueue(&s1);
-    q.enqueue(&s2);
+    QVERIFY(q.enqueue(&s1));
+    QVERIFY(q.enqueue(&s2));
     QCOMPARE(q.isEmpty(), false);
     QCOMPARE(q.head(), &s1);
     QCOMPARE(q.contains(NAME1), true);
@@ -62,4 +63,100 @@ void SyncQueueTest::testQueue()
 
 }
 
+static SyncSession *createSession(const QString &aName, bool aScheduled, bool aSOC, bool aDevice,
+                                  bool aRetry = false)
+{
+    SyncProfile *profile = new SyncProfile(aName);
+    profile->setKey(KEY_DESTINATION_TYPE, aDevice ? VALUE_DEVICE : VALUE_ONLINE);
+    SyncSession *session = new SyncSession(profile);
+    session->setScheduled(aScheduled);
+    session->setRetry(aRetry);
+    session->setSyncOnChange(aSOC);
+    return session;
+}
+
+void SyncQueueTest::testPriority()
+{
+    QList<SyncSession *> sessions;
+    sessions << createSession("scheduledOnline", true, false, false)
+             << createSession("socOnline", true, true, false)
+             << createSession("manualOnline1", false, false, false)
+             << createSession("scheduledDevice", true, false, true)
+             << createSession("manualOnline2", false, false, false)
+             << createSession("manualDevice", false, false, true)
+             << createSession("retryOnline", true, false, false, true)
+             << createSession("socDevice", true, true, true)
+             << createSession("retryDevice", true, false, true, true)
+             << createSession("timerOfSocProfile", true, false, false);
+    // A scheduled sync of a profile supporting sync on change is not
+    // started by a change.
+    sessions.last()->profile()->setBoolKey(KEY_SOC, true);
+
+    SyncQueue q;
+    foreach (SyncSession *session, sessions) {
+        q.enqueue(session);
+    }
+    QCOMPARE(q.size(), sessions.size());
+
+    // Queuing the same profile again is refused.
+    SyncSession duplicate(new SyncProfile("manualDevice"));
+    QVERIFY(!q.enqueue(&duplicate));
+    QCOMPARE(q.size(), sessions.size());
+
+    const QStringList expected = QStringList() << "manualDevice" << "manualOnline1" << "manualOnline2"
+                                               << "socDevice" << "socOnline"
+                                               << "retryDevice" << "retryOnline"
+                                               << "scheduledDevice" << "scheduledOnline"
+                                               << "timerOfSocProfile";
+    QStringList listed;
+    foreach (const SyncSession *session, q.getQueuedSyncSessions()) {
+        listed << session->profileName();
+    }
+    QCOMPARE(listed, expected);
+
+    // Removing from the middle keeps the order of the rest.
+    QCOMPARE(q.dequeue("manualOnline2")->profileName(), QString("manualOnline2"));
+    QCOMPARE(q.dequeue("manualOnline2"), (SyncSession *)nullptr);
+    QStringList dequeued;
+    while (!q.isEmpty()) {
+        QCOMPARE(q.head()->profileName(), q.getQueuedSyncSessions().first()->profileName());
+        dequeued << q.dequeue()->profileName();
+    }
+    QStringList remaining(expected);
+    remaining.removeOne("manualOnline2");
+    QCOMPARE(dequeued, remaining);
+
+    qDeleteAll(sessions);
+}
+
+void SyncQueueTest::benchmarkQueue()
+{
+    const int COUNT = 10000;
+    QList<SyncSession *> sessions;
+    QStringList names;
+    for (int i = 0; i < COUNT; ++i) {
+        names << QString("profile%1").arg(i);
+        sessions << createSession(names.last(), i % 3 != 0, i % 5 == 0, i % 2 == 0);
+    }
+
+    SyncQueue q;
+    QBENCHMARK {
+        foreach (SyncSession *session, sessions) {
+            q.enqueue(session);
+        }
+        foreach (const QString &name, names) {
+            QVERIFY(q.contains(name));
+        }
+        // Cancel every other sync, then run the rest.
+        for (int i = 0; i < COUNT; i += 2) {
+            QVERIFY(q.dequeue(names.at(i)) != nullptr);
+        }
+        while (q.dequeue() != nullptr) {
+        }
+    }
+    QVERIFY(q.isEmpty());
+
+    qDeleteAll(sessions);
+}
+
 QTEST_MAIN(Buteo::SyncQueueTest)
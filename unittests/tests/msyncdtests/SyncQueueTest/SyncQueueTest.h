@@ -34,6 +34,8 @@ class SyncQueueTest: public QObject
 private slots:
 
     void testQueue();
+    void testPriority();
+    void benchmarkQueue();
 };
 
 }
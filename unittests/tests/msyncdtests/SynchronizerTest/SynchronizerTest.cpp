@@ -213,9 +213,14 @@ void SynchronizerTest::testSignals()
     QStringList alist;
     alist << "storage";
 
-    QSignalSpy sigStorage(iSync, SIGNAL(storageReleased()));
+    // Releasing storages that are not reserved frees nothing.
+    QSignalSpy sigStorage(&iSync->iStorageBooker, SIGNAL(storageReleased(QString)));
+    iSync->releaseStorages(alist);
+    QCOMPARE(sigStorage.count(), 0);
+    QVERIFY(iSync->requestStorages(alist));
     iSync->releaseStorages(alist);
     QCOMPARE(sigStorage.count(), 1);
+    QCOMPARE(sigStorage.first().first().toString(), QString("storage"));
 
     qRegisterMetaType<Sync::TransferDatabase>("Sync::TransferDatabase");
     qRegisterMetaType<Sync::TransferType>("Sync::TransferType");
@@ -226,7 +231,8 @@ void SynchronizerTest::testSignals()
                               Sync::ITEM_ADDED, "Mime", 1);
     QCOMPARE(sigTransfer.count(), 1);
 
-    QSignalSpy sigStorage1(iSync, SIGNAL(storageReleased()));
+    QSignalSpy sigStorage1(&iSync->iStorageBooker, SIGNAL(storageReleased(QString)));
+    QVERIFY(iSync->requestStorages(QStringList() << "Storage"));
     iSync->releaseStorage("Storage", nullptr);
     QCOMPARE(sigStorage1.count(), 1);
 
@@ -251,4 +257,47 @@ void SynchronizerTest::testSignals()
     iSync->onSessionFinished("Profile", Sync::SYNC_DONE, "Msg", SyncResults::NO_ERROR);
     QCOMPARE(sessionStatus.count(), 1);
 }
+
+void SynchronizerTest::testFullSyncOverPartialSync()
+{
+    StorageChangeSet changes;
+    changes.addChanges("hcontacts", QStringList() << "1", StorageChangeSet::ItemModified);
+    QVERIFY(!changes.isEmpty());
+
+    // A full sync request turns a queued partial sync into a full one.
+    SyncProfile *queuedProfile = new SyncProfile("PartialQueued");
+    queuedProfile->setChangeSet(changes);
+    SyncSession *queued = new SyncSession(queuedProfile, nullptr);
+    QVERIFY(iSync->iSyncQueue.enqueue(queued));
+    QCOMPARE(iSync->startSync("PartialQueued"), true);
+    QVERIFY(queuedProfile->changeSet().isEmpty());
+
+    // Changes arriving later do not make it partial again.
+    iSync->mergeQueuedChanges("PartialQueued", changes);
+    QVERIFY(queuedProfile->changeSet().isEmpty());
+    QCOMPARE(iSync->iSyncQueue.dequeue("PartialQueued"), queued);
+    delete queued;
+
+    // A full sync request during an active partial sync is recorded, and
+    // later changes do not make it partial.
+    SyncProfile *activeProfile = new SyncProfile("PartialActive");
+    activeProfile->setChangeSet(changes);
+    SyncSession *active = new SyncSession(activeProfile, nullptr);
+    iSync->iActiveSessions.insert("PartialActive", active);
+    QCOMPARE(iSync->startSync("PartialActive"), true);
+    QVERIFY(iSync->iChangesAfterSession.contains("PartialActive"));
+    QVERIFY(iSync->iChangesAfterSession.value("PartialActive").isEmpty());
+    iSync->addChangesAfterSession("PartialActive", changes);
+    QVERIFY(iSync->iChangesAfterSession.value("PartialActive").isEmpty());
+
+    // A full sync request during a full sync needs nothing more.
+    iSync->iChangesAfterSession.remove("PartialActive");
+    activeProfile->setChangeSet(StorageChangeSet());
+    QCOMPARE(iSync->startSync("PartialActive"), true);
+    QVERIFY(!iSync->iChangesAfterSession.contains("PartialActive"));
+
+    iSync->iActiveSessions.remove("PartialActive");
+    delete active;
+}
+
 QTEST_MAIN(Buteo::SynchronizerTest)
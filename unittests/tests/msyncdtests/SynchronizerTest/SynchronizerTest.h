@@ -42,6 +42,7 @@ private slots:
     void testInitialize();
     void testSync();
     void testSignals();
+    void testFullSyncOverPartialSync();
 
 private:
     Synchronizer *iSync;
@@ -0,0 +1,139 @@
+/*
+ * This file is part of buteo-syncfw package
+ *
+ * Copyright (C) 2026 Jolla Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ *
+ */
+#include "WakeupCoalescerTest.h"
+#include "WakeupCoalescer.h"
+
+using namespace Buteo;
+
+static const qint64 MINUTE = 60 * 1000;
+
+// An arbitrary time aligned to the hour.
+static QDateTime baseTime()
+{
+    return QDateTime::fromMSecsSinceEpoch(qint64(1700000000) / 3600 * 3600 * 1000);
+}
+
+void WakeupCoalescerTest::testNoAlignment()
+{
+    WakeupCoalescer coalescer;
+    QCOMPARE(coalescer.window(), 0);
+
+    const QDateTime deadline = baseTime().addSecs(123);
+    QCOMPARE(coalescer.schedule("p1", deadline), deadline);
+    QCOMPARE(coalescer.slot("p1"), deadline);
+
+    // Nothing is due before the deadline.
+    QVERIFY(coalescer.wakeUp(deadline.addSecs(-1)).isEmpty());
+    QCOMPARE(coalescer.wakeUp(deadline), QStringList() << "p1");
+    QVERIFY(!coalescer.slot("p1").isValid());
+}
+
+void WakeupCoalescerTest::testSharedSlots()
+{
+    WakeupCoalescer coalescer;
+    coalescer.setWindow(300);
+
+    const QDateTime base = baseTime();
+    const QDateTime slot1 = coalescer.schedule("p1", base.addSecs(10));
+    const QDateTime slot2 = coalescer.schedule("p2", base.addSecs(290));
+    const QDateTime slot3 = coalescer.schedule("p3", base.addSecs(310));
+
+    QCOMPARE(slot1, base.addSecs(300));
+    QCOMPARE(slot2, slot1);
+    QCOMPARE(slot3, base.addSecs(600));
+
+    // A deadline on the grid is not delayed.
+    QCOMPARE(coalescer.schedule("p4", base), base);
+
+    // Rescheduling moves the profile to its new slot.
+    QCOMPARE(coalescer.schedule("p1", base.addSecs(500)), slot3);
+    coalescer.remove("p4");
+    QVERIFY(!coalescer.slot("p4").isValid());
+    QVERIFY(coalescer.wakeUp(base).isEmpty());
+}
+
+void WakeupCoalescerTest::testWakeUpBatch()
+{
+    WakeupCoalescer coalescer;
+    coalescer.setWindow(300);
+
+    const QDateTime base = baseTime();
+    coalescer.schedule("p1", base.addSecs(10));
+    coalescer.schedule("p2", base.addSecs(200));
+    coalescer.schedule("p3", base.addSecs(400));
+
+    QStringList batch = coalescer.wakeUp(base.addSecs(300));
+    batch.sort();
+    QCOMPARE(batch, QStringList() << "p1" << "p2");
+
+    // A wake-up caused by a profile takes the slots up to half a window
+    // ahead along with it.
+    coalescer.schedule("p4", base.addSecs(1000));
+    batch = coalescer.wakeUp(base.addSecs(500), "p4");
+    QCOMPARE(batch, QStringList() << "p4" << "p3");
+    QVERIFY(!coalescer.slot("p4").isValid());
+
+    QVariantMap stats = coalescer.statistics();
+    QCOMPARE(stats.value("scheduledWakeups").toInt(), 2);
+    QCOMPARE(stats.value("scheduledSyncs").toInt(), 4);
+    QCOMPARE(stats.value("pendingWakeSlots").toInt(), 0);
+}
+
+void WakeupCoalescerTest::testWakeupsPerHour()
+{
+    // Twenty profiles with 15, 30 and 60 minute intervals over four hours.
+    const int intervals[] = { 15, 30, 60 };
+    const QDateTime base = baseTime();
+    const qint64 end = base.toMSecsSinceEpoch() + 4 * 60 * MINUTE;
+
+    int wakeups[2];
+    for (int aligned = 0; aligned < 2; ++aligned) {
+        WakeupCoalescer coalescer;
+        coalescer.setWindow(aligned ? 300 : 0);
+
+        QHash<QString, qint64> intervalOf;
+        for (int i = 0; i < 20; ++i) {
+            const QString name = QString("p%1").arg(i);
+            intervalOf.insert(name, intervals[i % 3] * MINUTE);
+            coalescer.schedule(name, base.addMSecs(intervalOf.value(name) + i * 37 * 1000));
+        }
+
+        QMap<qint64, bool> due;
+        for (int i = 0; i < 20; ++i) {
+            due.insert(coalescer.slot(QString("p%1").arg(i)).toMSecsSinceEpoch(), true);
+        }
+        while (!due.isEmpty() && due.firstKey() <= end) {
+            const qint64 now = due.firstKey();
+            due.erase(due.begin());
+            foreach (const QString &name, coalescer.wakeUp(QDateTime::fromMSecsSinceEpoch(now))) {
+                const QDateTime slot = coalescer.schedule(name, QDateTime::fromMSecsSinceEpoch(now + intervalOf.value(name)));
+                due.insert(slot.toMSecsSinceEpoch(), true);
+            }
+        }
+        wakeups[aligned] = coalescer.statistics().value("scheduledWakeups").toInt();
+        qDebug() << (aligned ? "Aligned" : "Unaligned") << "wake-ups per hour:"
+                 << coalescer.statistics().value("wakeupsPerHour").toDouble();
+    }
+
+    QVERIFY(wakeups[1] * 3 < wakeups[0]);
+}
+
+QTEST_MAIN(Buteo::WakeupCoalescerTest)
@@ -3,20 +3,28 @@ SUBDIRS = \
         AccountsHelperTest \
         ClientPluginRunnerTest \
         ClientThreadTest \
+        OnlineSyncRampTest \
         PluginRunnerTest \
+        ProfileChangeDebouncerTest \
+        ScheduleSimulatorTest \
         ServerActivatorTest \
         ServerPluginRunnerTest \
         ServerThreadTest \
+        SessionExecutorTest \
         StorageBookerTest \
         SyncBackupTest \
+        SyncHistoryTest \
+        SyncOnChangeSchedulerTest \
         SyncQueueTest \
         SyncSessionTest \
         SyncSigHandlerTest \
         SynchronizerTest \
         TransportTrackerTest \
+        WakeupCoalescerTest \
 
 !contains(DEFINES, USE_KEEPALIVE):contains(DEFINES, USE_IPHB) {
 SUBDIRS += \
         IPHeartBeatTest \
+        SyncAlarmInventoryTest \
         SyncSchedulerTest \
 }
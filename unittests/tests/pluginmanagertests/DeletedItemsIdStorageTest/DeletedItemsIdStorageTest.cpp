@@ -25,6 +25,7 @@
 
 #include <QList>
 #include <QDateTime>
+#include <QFile>
 
 using namespace Buteo;
 
@@ -121,5 +122,181 @@ void DeletedItemsIdStorageTest::testSnapshot()
     iDeletedItems->uninit();
 }
 
+/*!
+    \fn DeletedItemsIdStorageTest::testChangeLog()
+ */
+void DeletedItemsIdStorageTest::testChangeLog()
+{
+    const QString CHANGELOG_DBFILE("/tmp/deleteditemsidstoragetest-changelog.db");
+    QFile::remove(CHANGELOG_DBFILE);
+    QVERIFY(iDeletedItems->init(CHANGELOG_DBFILE));
+    QCOMPARE(iDeletedItems->lastChange(), (qint64)0);
+
+    QList<QString> items;
+    items << "foo" << "bar";
+    QVERIFY(iDeletedItems->addChanges(items, StorageChangeSet::ItemAdded));
+    QVERIFY(iDeletedItems->addChanges(QList<QString>() << "foo", StorageChangeSet::ItemModified));
+    QCOMPARE(iDeletedItems->lastChange(), (qint64)3);
+
+    // Deletions are logged only once the change log is enabled, and not
+    // at all if they can not be stored.
+    QVERIFY(iDeletedItems->addDeletedItem("old", QDateTime::fromTime_t(100000), QDateTime::currentDateTime()));
+    QCOMPARE(iDeletedItems->lastChange(), (qint64)3);
+    iDeletedItems->enableChangeLog();
+    QVERIFY(iDeletedItems->addDeletedItem("bar", QDateTime::fromTime_t(100000), QDateTime::currentDateTime()));
+    QCOMPARE(iDeletedItems->lastChange(), (qint64)4);
+    QVERIFY(!iDeletedItems->addDeletedItem("bar", QDateTime::fromTime_t(100000), QDateTime::currentDateTime()));
+    QCOMPARE(iDeletedItems->lastChange(), (qint64)4);
+
+    QList<QString> changedItems;
+    QList<StorageChangeSet::ChangeKind> kinds;
+    qint64 last = 0;
+    QVERIFY(iDeletedItems->getChanges(1, changedItems, kinds, last));
+    QCOMPARE(changedItems, QList<QString>() << "bar" << "foo" << "bar");
+    QCOMPARE(kinds, QList<StorageChangeSet::ChangeKind>() << StorageChangeSet::ItemAdded
+             << StorageChangeSet::ItemModified << StorageChangeSet::ItemDeleted);
+    QCOMPARE(last, (qint64)4);
+
+    // Nothing new since the last change.
+    changedItems.clear();
+    kinds.clear();
+    QVERIFY(iDeletedItems->getChanges(4, changedItems, kinds, last));
+    QVERIFY(changedItems.isEmpty());
+    QCOMPARE(last, (qint64)4);
+
+    // Pruned changes can not be read anymore, and their numbers are not
+    // reused.
+    QVERIFY(iDeletedItems->pruneChanges(4));
+    QVERIFY(!iDeletedItems->getChanges(1, changedItems, kinds, last));
+    QVERIFY(iDeletedItems->getChanges(4, changedItems, kinds, last));
+    QCOMPARE(iDeletedItems->lastChange(), (qint64)4);
+    QVERIFY(iDeletedItems->addChanges(QList<QString>() << "zed", StorageChangeSet::ItemAdded));
+    QCOMPARE(iDeletedItems->lastChange(), (qint64)5);
+
+    // The log is kept over restarts.
+    iDeletedItems->uninit();
+    QVERIFY(iDeletedItems->init(CHANGELOG_DBFILE));
+    QVERIFY(iDeletedItems->getChanges(4, changedItems, kinds, last));
+    QCOMPARE(changedItems, QList<QString>() << "zed");
+    QCOMPARE(last, (qint64)5);
+
+    iDeletedItems->uninit();
+    QFile::remove(CHANGELOG_DBFILE);
+}
+
+/*!
+    \fn DeletedItemsIdStorageTest::testSnapshotUpdate()
+ */
+void DeletedItemsIdStorageTest::testSnapshotUpdate()
+{
+    const QString SNAPSHOT_DBFILE("/tmp/deleteditemsidstoragetest-snapshot.db");
+    QFile::remove(SNAPSHOT_DBFILE);
+    QVERIFY(iDeletedItems->init(SNAPSHOT_DBFILE));
+    iDeletedItems->enableChangeLog();
+
+    QDateTime created = QDateTime::fromTime_t(100000);
+    QDateTime deleted = QDateTime::fromTime_t(20000000);
+
+    QList<QString> items;
+    items << "foo" << "bar" << "zed";
+    QList<QDateTime> creationTimes;
+    creationTimes << created << created << created;
+    QVERIFY(iDeletedItems->setSnapshot(items, creationTimes));
+
+    // Only the difference is reported and applied.
+    items.clear();
+    items << "bar" << "zed" << "new";
+    QList<QString> added;
+    QList<QString> removed;
+    QVERIFY(iDeletedItems->updateSnapshot(items, creationTimes, deleted, added, removed));
+    QCOMPARE(added, QList<QString>() << "new");
+    QCOMPARE(removed, QList<QString>() << "foo");
+
+    QList<QString> snapshot;
+    QList<QDateTime> snapshotTimes;
+    QVERIFY(iDeletedItems->getSnapshot(snapshot, snapshotTimes));
+    QCOMPARE(snapshot.toSet(), items.toSet());
+
+    // Removed items are recorded as deleted, and both removed and added
+    // items in the change log.
+    QList<QString> deletedItems;
+    QVERIFY(iDeletedItems->getDeletedItems(deletedItems, QDateTime::fromTime_t(5000000)));
+    QCOMPARE(deletedItems, QList<QString>() << "foo");
+    QList<QString> changedItems;
+    QList<StorageChangeSet::ChangeKind> kinds;
+    qint64 last = 0;
+    QVERIFY(iDeletedItems->getChanges(0, changedItems, kinds, last));
+    QCOMPARE(changedItems, QList<QString>() << "foo" << "new");
+    QCOMPARE(kinds, QList<StorageChangeSet::ChangeKind>() << StorageChangeSet::ItemDeleted
+             << StorageChangeSet::ItemAdded);
+
+    // Items without a creation time are refused, and nothing changes.
+    QVERIFY(!iDeletedItems->updateSnapshot(QList<QString>() << "bar", creationTimes, deleted,
+                                           added, removed));
+    QCOMPARE(iDeletedItems->lastChange(), last);
+
+    // Nothing changes when the items are the same.
+    added.clear();
+    removed.clear();
+    QVERIFY(iDeletedItems->updateSnapshot(items, creationTimes, deleted, added, removed));
+    QVERIFY(added.isEmpty());
+    QVERIFY(removed.isEmpty());
+
+    // An item deleted again after coming back keeps its latest deletion.
+    QVERIFY(iDeletedItems->updateSnapshot(QList<QString>() << "foo", QList<QDateTime>() << created,
+                                          deleted, added, removed));
+    QCOMPARE(added, QList<QString>() << "foo");
+    QCOMPARE(removed.count(), 3);
+    added.clear();
+    removed.clear();
+    QVERIFY(iDeletedItems->updateSnapshot(QList<QString>(), QList<QDateTime>(),
+                                          deleted.addSecs(10), added, removed));
+    QCOMPARE(removed, QList<QString>() << "foo");
+    deletedItems.clear();
+    QVERIFY(iDeletedItems->getDeletedItems(deletedItems, deleted));
+    QCOMPARE(deletedItems, QList<QString>() << "foo");
+
+    iDeletedItems->uninit();
+    QFile::remove(SNAPSHOT_DBFILE);
+}
+
+/*!
+    \fn DeletedItemsIdStorageTest::benchmarkSnapshotUpdate()
+ */
+void DeletedItemsIdStorageTest::benchmarkSnapshotUpdate()
+{
+    const QString SNAPSHOT_DBFILE("/tmp/deleteditemsidstoragetest-benchmark.db");
+    const int ITEMS = 10000;
+    QFile::remove(SNAPSHOT_DBFILE);
+    QVERIFY(iDeletedItems->init(SNAPSHOT_DBFILE));
+
+    QDateTime created = QDateTime::fromTime_t(100000);
+    QList<QString> items;
+    QList<QDateTime> creationTimes;
+    for (int i = 0; i < ITEMS; ++i) {
+        items << QString("item%1").arg(i);
+        creationTimes << created;
+    }
+    QVERIFY(iDeletedItems->setSnapshot(items, creationTimes));
+
+    // Each round replaces one percent of the items.
+    int round = 0;
+    QBENCHMARK {
+        for (int i = 0; i < ITEMS / 100; ++i) {
+            items.removeFirst();
+            items << QString("item%1-%2").arg(round).arg(i);
+        }
+        ++round;
+        QList<QString> added;
+        QList<QString> removed;
+        QVERIFY(iDeletedItems->updateSnapshot(items, creationTimes, QDateTime::currentDateTime(),
+                                              added, removed));
+        QCOMPARE(added.count(), ITEMS / 100);
+        QCOMPARE(removed.count(), ITEMS / 100);
+    }
+
+    iDeletedItems->uninit();
+    QFile::remove(SNAPSHOT_DBFILE);
+}
 
 QTEST_GUILESS_MAIN(Buteo::DeletedItemsIdStorageTest)
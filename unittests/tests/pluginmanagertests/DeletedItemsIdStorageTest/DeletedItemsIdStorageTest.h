@@ -40,6 +40,9 @@ private slots:
     void testInit();
     void testItemIdStoring();
     void testSnapshot();
+    void testChangeLog();
+    void testSnapshotUpdate();
+    void benchmarkSnapshotUpdate();
 
 
 private:
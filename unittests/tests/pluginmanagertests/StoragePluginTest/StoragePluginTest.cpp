@@ -23,11 +23,159 @@
 #include "StoragePluginTest.h"
 
 #include "PluginManager.h"
+#include <QFile>
+#include "StorageItem.h"
+#include "StorageItemCursor.h"
+#include "StoragePlugin.h"
+#include "DeletedItemsIdStorage.h"
 
 #define TEST_PLUGIN_PATH "/opt/tests/buteo-syncfw"
 
 using namespace Buteo;
 
+namespace {
+
+// Item keeping its data in memory, viewed without copying.
+class MemoryItem : public StorageItem
+{
+public:
+    MemoryItem() : iReads(0) { }
+
+    bool write(qint64 aOffset, const QByteArray &aData)
+    {
+        if (aOffset < 0 || aOffset > iData.size())
+            return false;
+        iData.replace(aOffset, aData.size(), aData);
+        return true;
+    }
+    bool read(qint64 aOffset, qint64 aLength, QByteArray &aData) const
+    {
+        if (aOffset < 0 || aOffset > iData.size())
+            return false;
+        ++iReads;
+        aData = iData.mid(aOffset, aLength);
+        return true;
+    }
+    bool resize(qint64 aLen)
+    {
+        iData.resize(aLen);
+        return true;
+    }
+    qint64 getSize() const
+    {
+        return iData.size();
+    }
+    bool view(qint64 aOffset, qint64 aLength, QByteArray &aView) const
+    {
+        if (aOffset < 0 || aOffset > iData.size())
+            return false;
+        aView = QByteArray::fromRawData(iData.constData() + aOffset,
+                                        qMin(aLength, iData.size() - aOffset));
+        return true;
+    }
+    bool setData(const QByteArray &aData)
+    {
+        iData = aData;
+        return true;
+    }
+
+    QByteArray iData;
+    mutable int iReads;
+};
+
+// Storage with numbered items, of which the even ones are new and the odd
+// ones modified. Counts the items it has handed out.
+class MemoryStorage : public StoragePlugin
+{
+public:
+    explicit MemoryStorage(int aCount)
+        : StoragePlugin("memory"), iCount(aCount), iItemsRead(0) { }
+
+    bool init(const QMap<QString, QString> &) { return true; }
+    bool uninit() { return true; }
+
+    bool getAllItems(QList<StorageItem *> &aItems)
+    {
+        aItems = getItems(ids(-1));
+        return true;
+    }
+    bool getAllItemIds(QList<QString> &aItems)
+    {
+        aItems = ids(-1);
+        return true;
+    }
+    bool getNewItems(QList<StorageItem *> &aNewItems, const QDateTime &)
+    {
+        aNewItems = getItems(ids(0));
+        return true;
+    }
+    bool getNewItemIds(QList<QString> &aNewItemIds, const QDateTime &)
+    {
+        aNewItemIds = ids(0);
+        return true;
+    }
+    bool getModifiedItems(QList<StorageItem *> &aModifiedItems, const QDateTime &)
+    {
+        aModifiedItems = getItems(ids(1));
+        return true;
+    }
+    bool getModifiedItemIds(QList<QString> &aModifiedItemIds, const QDateTime &)
+    {
+        aModifiedItemIds = ids(1);
+        return true;
+    }
+    bool getDeletedItemIds(QList<QString> &, const QDateTime &) { return true; }
+
+    StorageItem *newItem() { return new MemoryItem; }
+    StorageItem *getItem(const QString &aItemId)
+    {
+        if (aItemId.toInt() >= iCount)
+            return 0;
+        StorageItem *item = new MemoryItem;
+        item->setId(aItemId);
+        ++iItemsRead;
+        return item;
+    }
+    QList<StorageItem *> getItems(const QStringList &aItemIdList)
+    {
+        QList<StorageItem *> items;
+        foreach (const QString &id, aItemIdList) {
+            StorageItem *item = getItem(id);
+            if (item)
+                items.append(item);
+        }
+        return items;
+    }
+
+    OperationStatus addItem(StorageItem &) { return STATUS_OK; }
+    QList<OperationStatus> addItems(const QList<StorageItem *> &) { return QList<OperationStatus>(); }
+    OperationStatus modifyItem(StorageItem &) { return STATUS_OK; }
+    QList<OperationStatus> modifyItems(const QList<StorageItem *> &) { return QList<OperationStatus>(); }
+    OperationStatus deleteItem(const QString &) { return STATUS_OK; }
+    QList<OperationStatus> deleteItems(const QList<QString> &) { return QList<OperationStatus>(); }
+
+    void useChangeLog(DeletedItemsIdStorage *aChangeLog)
+    {
+        setChangeLog(aChangeLog);
+    }
+
+    // Ids of all items, or of the even (0) or odd (1) ones.
+    QStringList ids(int aParity) const
+    {
+        QStringList result;
+        for (int i = 0; i < iCount; ++i) {
+            if (aParity < 0 || i % 2 == aParity)
+                result.append(QString::number(i));
+        }
+        return result;
+    }
+
+    int iCount;
+    int iItemsRead;
+};
+
+}
+
 void StoragePluginTest::testCreateDestroy()
 {
     PluginManager pluginManager( TEST_PLUGIN_PATH );
@@ -50,4 +198,177 @@ void StoragePluginTest::testCreateDestroy()
     QVERIFY( pluginManager.iLoadedDlls.count() == 0 );
 }
 
+void StoragePluginTest::testCursor()
+{
+    const int ITEMS = 250;
+    const int BATCH = 100;
+    MemoryStorage storage(ITEMS);
+
+    StorageItemCursor *cursor = storage.openCursor(StoragePlugin::ALL_ITEMS);
+    QVERIFY(cursor);
+    QCOMPARE(cursor->count(), ITEMS);
+    QCOMPARE(storage.iItemsRead, 0);
+
+    // Items are read only a batch at a time, in order.
+    QStringList fetched;
+    int batches = 0;
+    while (!cursor->atEnd()) {
+        QList<StorageItem *> items;
+        QVERIFY(cursor->fetch(items, BATCH));
+        QVERIFY(items.count() <= BATCH);
+        QCOMPARE(storage.iItemsRead, fetched.count() + items.count());
+        foreach (StorageItem *item, items)
+            fetched.append(item->getId());
+        qDeleteAll(items);
+        ++batches;
+    }
+    QCOMPARE(batches, 3);
+    QCOMPARE(fetched, storage.ids(-1));
+
+    // Fetching past the end gives nothing.
+    QList<StorageItem *> items;
+    QVERIFY(cursor->fetch(items, BATCH));
+    QVERIFY(items.isEmpty());
+    delete cursor;
+
+    // Items removed while the cursor is open are skipped.
+    cursor = storage.openCursor(StoragePlugin::ALL_ITEMS);
+    QVERIFY(cursor);
+    storage.iCount = 150;
+    while (!cursor->atEnd())
+        QVERIFY(cursor->fetch(items, BATCH));
+    QCOMPARE(cursor->count(), ITEMS);
+    QCOMPARE(items.count(), 150);
+    qDeleteAll(items);
+    delete cursor;
+}
+
+void StoragePluginTest::testCursorSelection()
+{
+    MemoryStorage storage(10);
+    QDateTime since = QDateTime::currentDateTime();
+
+    StorageItemCursor *cursor = storage.openCursor(StoragePlugin::NEW_ITEMS, since);
+    QVERIFY(cursor);
+    QList<StorageItem *> items;
+    QVERIFY(cursor->fetch(items, 100));
+    QCOMPARE(items.count(), 5);
+    QCOMPARE(items.first()->getId(), QString("0"));
+    qDeleteAll(items);
+    items.clear();
+    delete cursor;
+
+    cursor = storage.openCursor(StoragePlugin::MODIFIED_ITEMS, since);
+    QVERIFY(cursor);
+    QVERIFY(cursor->fetch(items, 100));
+    QCOMPARE(items.count(), 5);
+    QCOMPARE(items.first()->getId(), QString("1"));
+    qDeleteAll(items);
+    delete cursor;
+}
+
+void StoragePluginTest::testChangesSince()
+{
+    const QString DBFILE("/tmp/storageplugintest-changelog.db");
+    QFile::remove(DBFILE);
+    DeletedItemsIdStorage changeLog;
+    QVERIFY(changeLog.init(DBFILE));
+    MemoryStorage storage(4);
+    storage.useChangeLog(&changeLog);
+
+    // Without an anchor everything is new.
+    QList<StoragePlugin::ItemChange> changes;
+    QString anchor;
+    QVERIFY(storage.changesSince(QString(), changes, anchor));
+    QCOMPARE(changes.count(), 4);
+    QCOMPARE(changes.first(), StoragePlugin::ItemChange("0", StorageChangeSet::ItemAdded));
+    QVERIFY(!anchor.isEmpty());
+
+    // Changes are merged per item and ordered by their last change.
+    changeLog.addChanges(QList<QString>() << "4", StorageChangeSet::ItemAdded);
+    changeLog.addChanges(QList<QString>() << "1", StorageChangeSet::ItemModified);
+    changeLog.addChanges(QList<QString>() << "4", StorageChangeSet::ItemModified);
+    changeLog.addDeletedItem("2", QDateTime::fromTime_t(100000), QDateTime::currentDateTime());
+    changeLog.addChanges(QList<QString>() << "5", StorageChangeSet::ItemAdded);
+    changeLog.addDeletedItem("5", QDateTime::fromTime_t(100000), QDateTime::currentDateTime());
+
+    changes.clear();
+    QString nextAnchor;
+    QVERIFY(storage.changesSince(anchor, changes, nextAnchor));
+    QList<StoragePlugin::ItemChange> expected;
+    expected << StoragePlugin::ItemChange("1", StorageChangeSet::ItemModified)
+             << StoragePlugin::ItemChange("4", StorageChangeSet::ItemAdded)
+             << StoragePlugin::ItemChange("2", StorageChangeSet::ItemDeleted);
+    QCOMPARE(changes, expected);
+
+    changes.clear();
+    QString lastAnchor;
+    QVERIFY(storage.changesSince(nextAnchor, changes, lastAnchor));
+    QVERIFY(changes.isEmpty());
+    QCOMPARE(lastAnchor, nextAnchor);
+
+    // Anchors of pruned changes or of another kind are refused.
+    QVERIFY(changeLog.pruneChanges(changeLog.lastChange()));
+    QVERIFY(!storage.changesSince(anchor, changes, lastAnchor));
+    QVERIFY(storage.changesSince(nextAnchor, changes, lastAnchor));
+    QVERIFY(!storage.changesSince("time:0", changes, lastAnchor));
+
+    changeLog.uninit();
+    QFile::remove(DBFILE);
+}
+
+void StoragePluginTest::testChangesSinceTime()
+{
+    MemoryStorage storage(4);
+
+    QList<StoragePlugin::ItemChange> changes;
+    QString anchor;
+    QVERIFY(storage.changesSince(QString(), changes, anchor));
+    QCOMPARE(changes.count(), 4);
+
+    // Without a change log the time based id functions are used.
+    changes.clear();
+    QString nextAnchor;
+    QVERIFY(storage.changesSince(anchor, changes, nextAnchor));
+    QList<StoragePlugin::ItemChange> expected;
+    expected << StoragePlugin::ItemChange("0", StorageChangeSet::ItemAdded)
+             << StoragePlugin::ItemChange("2", StorageChangeSet::ItemAdded)
+             << StoragePlugin::ItemChange("1", StorageChangeSet::ItemModified)
+             << StoragePlugin::ItemChange("3", StorageChangeSet::ItemModified);
+    QCOMPARE(changes, expected);
+    QVERIFY(!nextAnchor.isEmpty());
+
+    QVERIFY(!storage.changesSince("log:1", changes, nextAnchor));
+    QVERIFY(!storage.changesSince("garbage", changes, nextAnchor));
+}
+
+void StoragePluginTest::testItemView()
+{
+    const QByteArray DATA("0123456789");
+    MemoryItem item;
+
+    // The buffer is shared, not copied, when the data is set.
+    QVERIFY(item.setData(DATA));
+    QVERIFY(item.iData.constData() == DATA.constData());
+
+    // The view points into the item data.
+    QByteArray view;
+    QVERIFY(item.view(2, 5, view));
+    QCOMPARE(view, QByteArray("23456"));
+    QVERIFY(view.constData() == item.iData.constData() + 2);
+    QVERIFY(item.view(8, 5, view));
+    QCOMPARE(view, QByteArray("89"));
+    QCOMPARE(item.iReads, 0);
+
+    // The default implementations fall back to read, write and resize.
+    QVERIFY(item.StorageItem::view(2, 5, view));
+    QCOMPARE(view, QByteArray("23456"));
+    QCOMPARE(item.iReads, 1);
+    QVERIFY(item.StorageItem::setData("abc"));
+    QCOMPARE(item.iData, QByteArray("abc"));
+    QVERIFY(item.StorageItem::setData("abcdefghijkl"));
+    QCOMPARE(item.iData, QByteArray("abcdefghijkl"));
+    QVERIFY(item.getFilePath().isEmpty());
+}
+
 QTEST_GUILESS_MAIN(Buteo::StoragePluginTest)
@@ -34,6 +34,11 @@ class StoragePluginTest : public QObject
 private slots:
 
     void testCreateDestroy();
+    void testCursor();
+    void testCursorSelection();
+    void testChangesSince();
+    void testChangesSinceTime();
+    void testItemView();
 
 private:
 
@@ -22,13 +22,18 @@
  */
 #include "ProfileManagerTest.h"
 #include "ProfileManager.h"
+#include "ProfileStore.h"
 #include "Profile_p.h"
 #include "ProfileEngineDefs.h"
 #include "StorageProfile.h"
 #include "SyncResults.h"
 
 #include <QScopedPointer>
+#include <QSignalSpy>
 #include <QFile>
+#include <QDateTime>
+#include <QDir>
+#include <QTemporaryDir>
 
 using namespace Buteo;
 
@@ -546,13 +551,18 @@ void ProfileManagerTest::testLog()
     // Save results through ProfileManager.
     {
         QCOMPARE(QFile::remove(
-                     USERPROFILE_DIR + "/sync/logs/" + OVI_CALENDAR + ".log.xml"), true);
+                     USERPROFILE_DIR + "/sync/logs/" + OVI_CALENDAR + ".log.journal"), true);
         SyncResults syncResults(QDateTime::currentDateTime(), Buteo::SyncResults::SYNC_RESULT_FAILED,
                                 Buteo::SyncResults::INTERNAL_ERROR);
         syncResults.setMajorCode(Buteo::SyncResults::SYNC_RESULT_SUCCESS);
+        QSignalSpy changed(&pm, SIGNAL(signalProfileChanged(QString, int, QString)));
         pm.saveSyncResults(OVI_CALENDAR, syncResults);
         QScopedPointer<SyncProfile> p(pm.syncProfile(OVI_CALENDAR));
         QVERIFY(p != 0);
+        // The change signal carries the expanded profile.
+        QCOMPARE(changed.count(), 1);
+        QCOMPARE(changed.at(0).at(1).toInt(), int(ProfileManager::PROFILE_LOGS_MODIFIED));
+        QCOMPARE(changed.at(0).at(2).toString(), p->toString());
         const SyncLog *log = p->log();
         QVERIFY(log != 0);
         QVERIFY(log->lastResults() != 0);
@@ -561,6 +571,126 @@ void ProfileManagerTest::testLog()
     }
 }
 
+void ProfileManagerTest::testLogJournal()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString journal = dir.path() + "/sync/logs/" + OVI_CALENDAR + ".log.journal";
+    const QDateTime time = QDateTime::fromString("2020-01-01T12:00:00", Qt::ISODate);
+    const int RETENTION = 20;
+
+    {
+        ProfileManager pm;
+        pm.setPaths(dir.path(), USERPROFILE_DIR);
+        QScopedPointer<SyncProfile> p(pm.syncProfile(OVI_CALENDAR));
+        QVERIFY(p != 0);
+        p->setKey(KEY_LOG_RETENTION, QString::number(RETENTION));
+        QCOMPARE(p->logRetention(), RETENTION);
+        QVERIFY(!pm.updateProfile(*p).isEmpty());
+
+        for (int i = 0; i < 5 * RETENTION; ++i) {
+            QVERIFY(pm.saveSyncResults(OVI_CALENDAR,
+                                       SyncResults(time.addSecs(i), SyncResults::SYNC_RESULT_SUCCESS,
+                                                   SyncResults::NO_ERROR)));
+        }
+    }
+
+    // Compaction keeps the journal bounded.
+    QFile file(journal);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QVERIFY(file.readAll().count("<syncresults") <= 2 * RETENTION);
+    file.close();
+
+    {
+        ProfileManager pm;
+        pm.setPaths(dir.path(), USERPROFILE_DIR);
+        QScopedPointer<SyncProfile> p(pm.syncProfile(OVI_CALENDAR));
+        QVERIFY(p != 0);
+        QCOMPARE(p->log()->allResults().size(), RETENTION);
+        QCOMPARE(p->lastResults()->syncTime(), time.addSecs(5 * RETENTION - 1));
+    }
+
+    // A record cut short only loses itself, and the next save repairs the
+    // journal.
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Append));
+    file.write("<syncresults time=\"2020-");
+    file.close();
+    {
+        ProfileManager pm;
+        pm.setPaths(dir.path(), USERPROFILE_DIR);
+        QScopedPointer<SyncProfile> p(pm.syncProfile(OVI_CALENDAR));
+        QVERIFY(p != 0);
+        QCOMPARE(p->log()->allResults().size(), RETENTION);
+        QVERIFY(pm.saveSyncResults(OVI_CALENDAR,
+                                   SyncResults(time.addSecs(5 * RETENTION), SyncResults::SYNC_RESULT_FAILED,
+                                               SyncResults::NO_ERROR)));
+    }
+    {
+        ProfileManager pm;
+        pm.setPaths(dir.path(), USERPROFILE_DIR);
+        QScopedPointer<SyncProfile> p(pm.syncProfile(OVI_CALENDAR));
+        QVERIFY(p != 0);
+        QCOMPARE(p->log()->allResults().size(), RETENTION);
+        QCOMPARE(p->lastResults()->majorCode(), SyncResults::SYNC_RESULT_FAILED);
+        QVERIFY(p->log()->lastSuccessfulResults() != 0);
+        QCOMPARE(p->log()->lastSuccessfulResults()->syncTime(), time.addSecs(5 * RETENTION - 1));
+    }
+
+    // A log left over from before journals is only removed by a save, not
+    // by reading the log.
+    const QString legacy = dir.path() + "/sync/logs/" + OVI_CALENDAR + ".log.xml";
+    QVERIFY(QFile::copy(journal, legacy));
+    {
+        ProfileManager pm;
+        pm.setPaths(dir.path(), USERPROFILE_DIR);
+        QScopedPointer<SyncProfile> p(pm.syncProfile(OVI_CALENDAR));
+        QVERIFY(p != 0);
+        QVERIFY(p->log() != 0);
+        QVERIFY(QFile::exists(legacy));
+        QVERIFY(pm.saveSyncResults(OVI_CALENDAR,
+                                   SyncResults(time.addSecs(5 * RETENTION + 1), SyncResults::SYNC_RESULT_SUCCESS,
+                                               SyncResults::NO_ERROR)));
+        QVERIFY(!QFile::exists(legacy));
+    }
+
+    // Results saved by another instance are read right away, without
+    // waiting for the file watcher.
+    {
+        ProfileManager pm;
+        pm.setPaths(dir.path(), USERPROFILE_DIR);
+        QScopedPointer<SyncProfile> p(pm.syncProfile(OVI_CALENDAR));
+        QVERIFY(p != 0);
+        ProfileManager other;
+        other.setPaths(dir.path(), USERPROFILE_DIR);
+        QVERIFY(other.saveSyncResults(OVI_CALENDAR,
+                                      SyncResults(time.addSecs(5 * RETENTION + 2), SyncResults::SYNC_RESULT_FAILED,
+                                                  SyncResults::NO_ERROR)));
+        p.reset(pm.syncProfile(OVI_CALENDAR));
+        QVERIFY(p != 0);
+        QCOMPARE(p->lastResults()->syncTime(), time.addSecs(5 * RETENTION + 2));
+    }
+
+    // Results saved for a loaded profile use its retention and send it
+    // with the change signal.
+    {
+        ProfileManager pm;
+        pm.setPaths(dir.path(), USERPROFILE_DIR);
+        QScopedPointer<SyncProfile> p(pm.syncProfile(OVI_CALENDAR));
+        QVERIFY(p != 0);
+        QSignalSpy changed(&pm, SIGNAL(signalProfileChanged(QString, int, QString)));
+        QVERIFY(pm.saveSyncResults(*p, SyncResults(time.addSecs(5 * RETENTION + 3),
+                                                   SyncResults::SYNC_RESULT_SUCCESS,
+                                                   SyncResults::NO_ERROR)));
+        QCOMPARE(changed.count(), 1);
+        QCOMPARE(changed.at(0).at(1).toInt(), int(ProfileManager::PROFILE_LOGS_MODIFIED));
+        QCOMPARE(changed.at(0).at(2).toString(), p->toString());
+        p.reset(pm.syncProfile(OVI_CALENDAR));
+        QVERIFY(p != 0);
+        QCOMPARE(p->log()->allResults().size(), RETENTION);
+        QCOMPARE(p->lastResults()->syncTime(), time.addSecs(5 * RETENTION + 3));
+    }
+}
+
 void ProfileManagerTest::testSave()
 {
     ProfileManager pm;
@@ -666,25 +796,400 @@ void ProfileManagerTest::testOverrideKey()
     QCOMPARE(storage->key(URI_KEY), URI);
 }
 
-void ProfileManagerTest::testBackup()
+static QString syncProfileKey(ProfileManager &aPm, const QString &aName, const QString &aKey)
 {
+    QScopedPointer<SyncProfile> p(aPm.syncProfile(aName));
+    return p ? p->key(aKey) : QString();
+}
+
+void ProfileManagerTest::testAtomicWrite()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
     ProfileManager pm;
-    pm.setPaths(USERPROFILE_DIR + '/', SYSTEMPROFILE_DIR + '/');
+    pm.setPaths(dir.path(), USERPROFILE_DIR);
 
-    // Copy to backup.
-    QString fileName = USERPROFILE_DIR + '/' + Profile::TYPE_SYNC +
-                       '/' + OVI_CALENDAR + ".xml";
-    QFile file(fileName);
-    QVERIFY(file.copy(fileName + ".bak"));
+    QScopedPointer<SyncProfile> p(pm.syncProfile(OVI_CALENDAR));
+    QVERIFY(p != 0);
+    p->setKey("atomictest", "value");
+    QVERIFY(!pm.updateProfile(*p).isEmpty());
 
-    // Get a sync profile. Profile is restored from a backup.
-    QScopedPointer<SyncProfile> sp(pm.syncProfile(OVI_CALENDAR));
-    QVERIFY(sp != 0);
-    QCOMPARE(sp->name(), OVI_CALENDAR);
-    QCOMPARE(sp->type(), Profile::TYPE_SYNC);
+    // Only the profile itself is left behind, no backup or temporary files.
+    QDir syncDir(dir.path() + '/' + Profile::TYPE_SYNC);
+    QCOMPARE(syncDir.entryList(QDir::Files), QStringList() << OVI_CALENDAR + ".xml");
+
+    ProfileManager pm2;
+    pm2.setPaths(dir.path(), USERPROFILE_DIR);
+    QCOMPARE(syncProfileKey(pm2, OVI_CALENDAR, "atomictest"), QString("value"));
+}
+
+void ProfileManagerTest::testWriteGroup()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    ProfileManager pm;
+    pm.setPaths(dir.path(), USERPROFILE_DIR);
+    ProfileManager other;
+    other.setPaths(dir.path(), USERPROFILE_DIR);
+
+    QScopedPointer<SyncProfile> p(pm.syncProfile(OVI_CALENDAR));
+    QVERIFY(p != 0);
+    QSignalSpy changed(&pm, SIGNAL(signalProfileChanged(QString, int, QString)));
+
+    pm.beginWriteGroup();
+    p->setKey("grouptest", "first");
+    pm.updateProfile(*p);
+    p->setKey("grouptest", "second");
+    pm.updateProfile(*p);
+
+    // Visible to the writer right away, but not yet on disk.
+    QCOMPARE(syncProfileKey(pm, OVI_CALENDAR, "grouptest"), QString("second"));
+    QCOMPARE(syncProfileKey(other, OVI_CALENDAR, "grouptest"), QString());
+    QVERIFY(!QFile::exists(dir.path() + '/' + Profile::TYPE_SYNC + '/' + OVI_CALENDAR + ".xml"));
+    QCOMPARE(changed.count(), 0);
+
+    // Change signals follow once the files are written.
+    QVERIFY(pm.endWriteGroup());
+    QCOMPARE(changed.count(), 2);
+    QVERIFY(QDir(dir.path() + '/' + Profile::TYPE_SYNC).entryList(QStringList("*.new*")).isEmpty());
+    QTRY_COMPARE(syncProfileKey(other, OVI_CALENDAR, "grouptest"), QString("second"));
+
+    // A profile added and removed in the same group is never written.
+    const QString GROUP_PROFILE("grouptest-profile");
+    const QString groupPath = dir.path() + '/' + Profile::TYPE_SYNC + '/' + GROUP_PROFILE + ".xml";
+    pm.beginWriteGroup();
+    p->setName(GROUP_PROFILE);
+    QVERIFY(!pm.updateProfile(*p).isEmpty());
+    QScopedPointer<SyncProfile> added(pm.syncProfile(GROUP_PROFILE));
+    QVERIFY(added != 0);
+    QVERIFY(pm.removeProfile(GROUP_PROFILE));
+    QVERIFY(QScopedPointer<SyncProfile>(pm.syncProfile(GROUP_PROFILE)).isNull());
+    QVERIFY(pm.endWriteGroup());
+    QVERIFY(!QFile::exists(groupPath));
+    QVERIFY(QScopedPointer<SyncProfile>(pm.syncProfile(GROUP_PROFILE)).isNull());
+}
+
+void ProfileManagerTest::testBackupRecovery()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString syncDir = dir.path() + '/' + Profile::TYPE_SYNC;
+    const QString profilePath = syncDir + '/' + OVI_CALENDAR + ".xml";
+    QVERIFY(QDir().mkpath(syncDir));
+
+    // A profile damaged while being written in place is restored from the
+    // backup left by the old write format.
+    QVERIFY(QFile::copy(USERPROFILE_DIR + '/' + Profile::TYPE_SYNC + '/' + OVI_CALENDAR + ".xml",
+                        profilePath + ".bak"));
+    QFile damaged(profilePath);
+    QVERIFY(damaged.open(QIODevice::WriteOnly));
+    damaged.write("<profile name=\"");
+    damaged.close();
+    {
+        ProfileManager pm;
+        pm.setPaths(dir.path(), USERPROFILE_DIR);
+        QVERIFY(!QFile::exists(profilePath + ".bak"));
+        QScopedPointer<SyncProfile> p(pm.syncProfile(OVI_CALENDAR));
+        QVERIFY(p != 0);
+        QCOMPARE(p->name(), OVI_CALENDAR);
+        p->setKey("backuptest", "value");
+        QVERIFY(!pm.updateProfile(*p).isEmpty());
+    }
+
+    // An intact profile is kept, a stale backup is only removed.
+    QVERIFY(QFile::copy(USERPROFILE_DIR + '/' + Profile::TYPE_SYNC + '/' + OVI_CALENDAR + ".xml",
+                        profilePath + ".bak"));
+    {
+        ProfileManager pm;
+        pm.setPaths(dir.path(), USERPROFILE_DIR);
+        QVERIFY(!QFile::exists(profilePath + ".bak"));
+        QCOMPARE(syncProfileKey(pm, OVI_CALENDAR, "backuptest"), QString("value"));
+    }
+}
+
+void ProfileManagerTest::testCache()
+{
+    const QString PRIMARY_DIR = USERPROFILE_DIR + "/primary";
+    const QString CACHE_KEY = "cachetest";
+    QVERIFY(QDir().mkpath(PRIMARY_DIR + '/' + Profile::TYPE_SYNC));
 
-    // Backup is removed after successful load.
-    QVERIFY(!QFile::exists(fileName + ".bak"));
+    ProfileManager pm;
+    pm.setPaths(PRIMARY_DIR, USERPROFILE_DIR);
+
+    // Cached profiles are handed out as independent copies.
+    QScopedPointer<SyncProfile> p(pm.syncProfile(OVI_CALENDAR));
+    QVERIFY(p != 0);
+    p->setKey(CACHE_KEY, "modified");
+    QCOMPARE(syncProfileKey(pm, OVI_CALENDAR, CACHE_KEY), QString());
+
+    // Own updates invalidate the cache immediately.
+    pm.updateProfile(*p);
+    QCOMPARE(syncProfileKey(pm, OVI_CALENDAR, CACHE_KEY), QString("modified"));
+
+    // Updates from another instance are noticed right away, without
+    // waiting for the file watcher.
+    {
+        ProfileManager pm2;
+        pm2.setPaths(PRIMARY_DIR, USERPROFILE_DIR);
+        p->setKey(CACHE_KEY, "external");
+        pm2.updateProfile(*p);
+    }
+    QCOMPARE(syncProfileKey(pm, OVI_CALENDAR, CACHE_KEY), QString("external"));
+
+    p->removeKey(CACHE_KEY);
+    pm.updateProfile(*p);
+}
+
+void ProfileManagerTest::testSearchIndex()
+{
+    const QString PRIMARY_DIR = USERPROFILE_DIR + "/primary";
+    const QString INDEX_KEY = "indextest";
+
+    ProfileManager pm;
+    pm.setPaths(PRIMARY_DIR, USERPROFILE_DIR);
+    QList<SyncProfile *> profiles;
+
+    // Sub-profile keys are indexed.
+    profiles = pm.getSyncProfilesByData("", Profile::TYPE_STORAGE,
+                                        "Target URI", "./EventTask/Tasks");
+    QCOMPARE(profiles.size(), 1);
+    QCOMPARE(profiles[0]->name(), OVI_CALENDAR);
+    qDeleteAll(profiles);
+    profiles.clear();
+
+    profiles = pm.getSyncProfilesByData("", "", INDEX_KEY, "first");
+    QVERIFY(profiles.isEmpty());
+
+    // Index follows profile updates.
+    QScopedPointer<SyncProfile> p(pm.syncProfile(OVI_CALENDAR));
+    QVERIFY(p != 0);
+    p->setKey(INDEX_KEY, "first");
+    pm.updateProfile(*p);
+
+    profiles = pm.getSyncProfilesByData("", "", INDEX_KEY, "first");
+    QCOMPARE(profiles.size(), 1);
+    QCOMPARE(profiles[0]->name(), OVI_CALENDAR);
+    qDeleteAll(profiles);
+    profiles.clear();
+
+    p->setKey(INDEX_KEY, "second");
+    pm.updateProfile(*p);
+
+    profiles = pm.getSyncProfilesByData("", "", INDEX_KEY, "first");
+    QVERIFY(profiles.isEmpty());
+
+    ProfileManager::SearchCriteria criteria;
+    criteria.iType = ProfileManager::SearchCriteria::EXISTS;
+    criteria.iKey = INDEX_KEY;
+    profiles = pm.getSyncProfilesByData(QList<ProfileManager::SearchCriteria>() << criteria);
+    QCOMPARE(profiles.size(), 1);
+    QCOMPARE(profiles[0]->key(INDEX_KEY), QString("second"));
+    qDeleteAll(profiles);
+    profiles.clear();
+
+    p->removeKey(INDEX_KEY);
+    pm.updateProfile(*p);
+
+    profiles = pm.getSyncProfilesByData(QList<ProfileManager::SearchCriteria>() << criteria);
+    QVERIFY(profiles.isEmpty());
+
+    // Changes made by another process are seen before the watcher reports
+    // them. No events are processed here.
+    const QString ADDED = "indextest-added";
+    ProfileManager other;
+    other.setPaths(PRIMARY_DIR, USERPROFILE_DIR);
+    p->setKey(INDEX_KEY, "external");
+    QCOMPARE(other.updateProfile(*p), OVI_CALENDAR);
+
+    profiles = pm.getSyncProfilesByData("", "", INDEX_KEY, "external");
+    QCOMPARE(profiles.size(), 1);
+    QCOMPARE(profiles[0]->name(), OVI_CALENDAR);
+    qDeleteAll(profiles);
+    profiles.clear();
+
+    QScopedPointer<SyncProfile> added(p->clone());
+    added->setName(ADDED);
+    added->setKey(INDEX_KEY, "added");
+    QCOMPARE(other.updateProfile(*added), ADDED);
+
+    profiles = pm.getSyncProfilesByData("", "", INDEX_KEY, "added");
+    QCOMPARE(profiles.size(), 1);
+    QCOMPARE(profiles[0]->name(), ADDED);
+    qDeleteAll(profiles);
+    profiles.clear();
+
+    QVERIFY(other.removeProfile(ADDED));
+    p->removeKey(INDEX_KEY);
+    other.updateProfile(*p);
+
+    profiles = pm.getSyncProfilesByData(QList<ProfileManager::SearchCriteria>() << criteria);
+    QVERIFY(profiles.isEmpty());
+}
+
+// Writes aCount copies of the ovi-calendar profile to aDir.
+static bool createSyncProfiles(const QString &aDir, int aCount)
+{
+    QFile source(USERPROFILE_DIR + '/' + Profile::TYPE_SYNC + '/' + OVI_CALENDAR + ".xml");
+    if (!source.open(QIODevice::ReadOnly) || !QDir().mkpath(aDir + '/' + Profile::TYPE_SYNC)) {
+        return false;
+    }
+    const QByteArray data = source.readAll();
+
+    for (int i = 0; i < aCount; ++i) {
+        const QString name = QString("profile%1").arg(i);
+        QFile file(aDir + '/' + Profile::TYPE_SYNC + '/' + name + ".xml");
+        if (!file.open(QIODevice::WriteOnly)) {
+            return false;
+        }
+        QByteArray profileData = data;
+        profileData.replace("name=\"" + OVI_CALENDAR.toUtf8() + "\"",
+                            "name=\"" + name.toUtf8() + "\"");
+        file.write(profileData);
+    }
+
+    return true;
+}
+
+void ProfileManagerTest::testProfileStore()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(createSyncProfiles(dir.path(), 3));
+
+    QStringList expected;
+    {
+        ProfileManager pm;
+        pm.setPaths(dir.path(), USERPROFILE_DIR);
+        pm.setProfileStoreEnabled(true);
+        QList<SyncProfile *> profiles = pm.allSyncProfiles();
+        QCOMPARE(profiles.size(), 3);
+        foreach (SyncProfile *p, profiles) {
+            expected.append(p->toString());
+        }
+        qDeleteAll(profiles);
+    }
+
+    // Profiles read from the store are identical to the parsed ones.
+    ProfileManager pm;
+    pm.setPaths(dir.path(), USERPROFILE_DIR);
+    pm.setProfileStoreEnabled(true);
+    QList<SyncProfile *> profiles = pm.allSyncProfiles();
+    QCOMPARE(profiles.size(), 3);
+    for (int i = 0; i < profiles.size(); ++i) {
+        QCOMPARE(profiles[i]->toString(), expected[i]);
+    }
+    qDeleteAll(profiles);
+
+    // Modified XML files take precedence over the store.
+    QScopedPointer<SyncProfile> p(pm.syncProfile("profile0"));
+    QVERIFY(p != 0);
+    p->setKey("storetest", "value");
+    {
+        ProfileManager pm2;
+        pm2.setPaths(dir.path(), USERPROFILE_DIR);
+        pm2.updateProfile(*p);
+    }
+
+    ProfileManager pm3;
+    pm3.setPaths(dir.path(), USERPROFILE_DIR);
+    pm3.setProfileStoreEnabled(true);
+    p.reset(pm3.syncProfile("profile0"));
+    QVERIFY(p != 0);
+    QCOMPARE(p->key("storetest"), QString("value"));
+    // Writes the updated entry.
+    pm3.setProfileStoreEnabled(false);
+
+    // In-place rewrites keeping the inode, size and modification time are
+    // only caught by an explicit verification.
+    QFile file(dir.path() + '/' + Profile::TYPE_SYNC + "/profile1.xml");
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    const QDateTime modified = file.fileTime(QFileDevice::FileModificationTime);
+    QByteArray data = file.readAll();
+    data.replace("name=\"profile1\"", "name=\"profileX\"");
+    QVERIFY(file.seek(0));
+    QCOMPARE(file.write(data), qint64(data.size()));
+    QVERIFY(file.setFileTime(modified, QFileDevice::FileModificationTime));
+    file.close();
+    {
+        ProfileStore store(dir.path() + "/cache/profiles.bin");
+        QCOMPARE(store.verify(), 1);
+        QCOMPARE(store.verify(), 0);
+    }
+
+    ProfileManager pm4;
+    pm4.setPaths(dir.path(), USERPROFILE_DIR);
+    pm4.setProfileStoreEnabled(true);
+    p.reset(pm4.syncProfile("profile1"));
+    QVERIFY(p != 0);
+    QCOMPARE(p->name(), QString("profileX"));
+}
+
+void ProfileManagerTest::testSharedSubProfiles()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(createSyncProfiles(dir.path(), 2));
+
+    ProfileManager pm;
+    pm.setPaths(dir.path(), USERPROFILE_DIR);
+    QList<SyncProfile *> profiles = pm.allSyncProfiles();
+    QCOMPARE(profiles.size(), 2);
+
+    // Both profiles get the keys of the same storage profile file.
+    Profile *storage0 = profiles[0]->subProfile(HCALENDAR, Profile::TYPE_STORAGE);
+    Profile *storage1 = profiles[1]->subProfile(HCALENDAR, Profile::TYPE_STORAGE);
+    QVERIFY(storage0 != 0);
+    QVERIFY(storage1 != 0);
+    QVERIFY(storage0 != storage1);
+    QCOMPARE(storage0->keyNames(), storage1->keyNames());
+
+    // Modifying one expanded profile does not leak to others.
+    storage0->setKey("sharedtest", "value");
+    qDeleteAll(profiles);
+
+    QScopedPointer<SyncProfile> p(pm.syncProfile("profile1"));
+    QVERIFY(p != 0);
+    QVERIFY(p->subProfile(HCALENDAR, Profile::TYPE_STORAGE) != 0);
+    QCOMPARE(p->subProfile(HCALENDAR, Profile::TYPE_STORAGE)->key("sharedtest"), QString());
+}
+
+void ProfileManagerTest::benchmarkColdStart_data()
+{
+    QTest::addColumn<int>("count");
+    QTest::addColumn<bool>("compiled");
+
+    foreach (int count, QList<int>() << 10 << 100 << 1000) {
+        QTest::newRow(qPrintable(QString("xml-%1").arg(count))) << count << false;
+        QTest::newRow(qPrintable(QString("compiled-%1").arg(count))) << count << true;
+    }
+}
+
+void ProfileManagerTest::benchmarkColdStart()
+{
+    QFETCH(int, count);
+    QFETCH(bool, compiled);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(createSyncProfiles(dir.path(), count));
+
+    if (compiled) {
+        ProfileManager pm;
+        pm.setPaths(dir.path(), USERPROFILE_DIR);
+        pm.setProfileStoreEnabled(true);
+        qDeleteAll(pm.allSyncProfiles());
+    }
+
+    QBENCHMARK {
+        ProfileManager pm;
+        pm.setPaths(dir.path(), USERPROFILE_DIR);
+        pm.setProfileStoreEnabled(compiled);
+        QList<SyncProfile *> profiles = pm.allSyncProfiles();
+        QCOMPARE(profiles.size(), count);
+        qDeleteAll(profiles);
+    }
 }
 
 QTEST_GUILESS_MAIN(Buteo::ProfileManagerTest)
@@ -42,11 +42,20 @@ private slots:
     void testGetByMultipleCriteria();
     void testGetByStorage();
     void testLog();
+    void testLogJournal();
     void testSave();
     void testHiddenProfiles();
     void testRemovingProfiles();
     void testOverrideKey();
-    void testBackup();
+    void testAtomicWrite();
+    void testWriteGroup();
+    void testBackupRecovery();
+    void testCache();
+    void testSearchIndex();
+    void testProfileStore();
+    void testSharedSubProfiles();
+    void benchmarkColdStart_data();
+    void benchmarkColdStart();
 };
 
 }
@@ -23,6 +23,8 @@
 #include "SyncLogTest.h"
 
 #include <QDomDocument>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
 
 #include "SyncLog.h"
 
@@ -157,6 +159,30 @@ void SyncLogTest::testAddResults()
 
 }
 
+void SyncLogTest::testMaxResults()
+{
+    SyncLog log(NAME);
+    QCOMPARE(log.maxResults(), SyncLog::DEFAULT_MAX_RESULTS);
+
+    log.setMaxResults(20);
+    SyncResults successful(QDateTime::currentDateTime(), SyncResults::SYNC_RESULT_SUCCESS,
+                           SyncResults::NO_ERROR);
+    log.addResults(successful);
+    SyncResults failed;
+    failed.setMajorCode(Buteo::SyncResults::SYNC_RESULT_FAILED);
+    for (int i = 0; i < 25; ++i) {
+        log.addResults(failed);
+    }
+    QCOMPARE(log.allResults().size(), 20);
+
+    // Lowering the maximum drops the oldest results, but not the last
+    // successful ones.
+    log.setMaxResults(3);
+    QCOMPARE(log.allResults().size(), 3);
+    QVERIFY(log.lastSuccessfulResults() != 0);
+    QCOMPARE(log.lastSuccessfulResults()->majorCode(), SyncResults::SYNC_RESULT_SUCCESS);
+}
+
 #define FAILURE_MESSAGE "Database error: UID not unique"
 #define FAILURE_SERVER "No resource at URI"
 static const QString DETAILS_XML =
@@ -298,4 +324,97 @@ void SyncLogTest::testAddDetails()
                                  TargetResults::ITEM_OPERATION_FAILED).isEmpty());
 }
 
+void SyncLogTest::testStreamXml()
+{
+    QXmlStreamReader reader(DETAILS_XML);
+    QVERIFY(reader.readNextStartElement());
+    SyncLog log(reader);
+    QVERIFY(!reader.hasError());
+    QVERIFY(reader.isEndElement());
+    QCOMPARE(reader.name().toString(), QString("synclog"));
+
+    // Same content as read through DOM.
+    QDomDocument doc;
+    QVERIFY(doc.setContent(DETAILS_XML, false));
+    SyncLog domLog(doc.documentElement());
+    QDomDocument doc1;
+    doc1.appendChild(log.toXml(doc1));
+    QDomDocument doc2;
+    doc2.appendChild(domLog.toXml(doc2));
+    QCOMPARE(doc1.toString(), doc2.toString());
+
+    const SyncResults *result = log.lastResults();
+    QVERIFY(result);
+    TargetResults target = result->targetResults().first();
+    QCOMPARE(target.localMessage(QLatin1String("123-6")),
+             QLatin1String(FAILURE_MESSAGE));
+    QCOMPARE(target.remoteDetails(TargetResults::ITEM_MODIFIED,
+                                  TargetResults::ITEM_OPERATION_FAILED),
+             QList<QString>() << QLatin1String("456-7"));
+
+    // Streamed output parses back to the same log.
+    QString xml;
+    QXmlStreamWriter writer(&xml);
+    writer.writeStartDocument();
+    log.toXml(writer);
+    writer.writeEndDocument();
+    QDomDocument doc3;
+    QVERIFY(doc3.setContent(xml, false));
+    SyncLog log3(doc3.documentElement());
+    QDomDocument doc4;
+    doc4.appendChild(log3.toXml(doc4));
+    QCOMPARE(doc4.toString(), doc1.toString());
+
+    // Sync results string round trip.
+    QXmlStreamReader resultsReader(result->toString());
+    QVERIFY(resultsReader.readNextStartElement());
+    SyncResults results(resultsReader);
+    QVERIFY(!resultsReader.hasError());
+    QCOMPARE(results.toString(), result->toString());
+
+    // Broken XML is reported.
+    QXmlStreamReader brokenReader(DETAILS_XML.left(DETAILS_XML.size() / 2));
+    QVERIFY(brokenReader.readNextStartElement());
+    SyncLog brokenLog(brokenReader);
+    QVERIFY(brokenReader.hasError());
+}
+
+void SyncLogTest::benchmarkParse_data()
+{
+    QTest::addColumn<bool>("stream");
+
+    QTest::newRow("dom") << false;
+    QTest::newRow("stream") << true;
+}
+
+void SyncLogTest::benchmarkParse()
+{
+    QFETCH(bool, stream);
+
+    TargetResults target(QLatin1String("hcontacts"));
+    for (int i = 0; i < 5000; ++i) {
+        target.addLocalDetails(QString::number(i), TargetResults::ITEM_ADDED);
+        target.addRemoteDetails(QString::number(i), TargetResults::ITEM_MODIFIED,
+                                TargetResults::ITEM_OPERATION_FAILED,
+                                QLatin1String(FAILURE_SERVER));
+    }
+    SyncResults results;
+    results.addTargetResults(target);
+    const QString xml = results.toString();
+
+    QBENCHMARK {
+        if (stream) {
+            QXmlStreamReader reader(xml);
+            QVERIFY(reader.readNextStartElement());
+            SyncResults parsed(reader);
+            QCOMPARE(parsed.targetResults().first().localItems().added, 5000u);
+        } else {
+            QDomDocument doc;
+            QVERIFY(doc.setContent(xml, true));
+            SyncResults parsed(doc.documentElement());
+            QCOMPARE(parsed.targetResults().first().localItems().added, 5000u);
+        }
+    }
+}
+
 QTEST_GUILESS_MAIN(Buteo::SyncLogTest)
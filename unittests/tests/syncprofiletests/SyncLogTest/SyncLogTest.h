@@ -35,8 +35,12 @@ private slots:
 
     void testLog();
     void testAddResults();
+    void testMaxResults();
     void testAddDetails();
     void testDetailsFromXML();
+    void testStreamXml();
+    void benchmarkParse_data();
+    void benchmarkParse();
 
 };
 
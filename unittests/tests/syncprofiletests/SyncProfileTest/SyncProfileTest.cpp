@@ -24,12 +24,33 @@
 
 #include <QDomDocument>
 #include <QScopedPointer>
+#include <QXmlStreamReader>
+#include <cstdlib>
+#include <new>
 
 #include "SyncProfile.h"
 #include "ProfileEngineDefs.h"
 
 using namespace Buteo;
 
+// Number of objects allocated with operator new, used by benchmarkClone().
+static QAtomicInt allocationCount;
+
+void *operator new(std::size_t aSize)
+{
+    allocationCount.ref();
+    void *ptr = std::malloc(aSize ? aSize : 1);
+    if (ptr == 0) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void *aPtr) noexcept
+{
+    std::free(aPtr);
+}
+
 static const QString NAME = "ovi-calendar";
 static const QString TYPE = Profile::TYPE_SYNC;
 static const QString PROFILE_XML =
@@ -227,4 +248,189 @@ void SyncProfileTest::testSubProfiles()
 
 }
 
+void SyncProfileTest::testImplicitSharing()
+{
+    QDomDocument doc;
+    QVERIFY(doc.setContent(PROFILE_XML, false));
+    SyncProfile p(doc.documentElement());
+    const QString original = p.toString();
+
+    // Modifying a clone, its sub-profiles or its log must not affect the
+    // profile the clone shares its data with.
+    QScopedPointer<SyncProfile> copy(p.clone());
+    copy->setKey(KEY_DESTINATION_TYPE, VALUE_ONLINE);
+    copy->clientProfile()->setKey(KEY_SYNC_DIRECTION, VALUE_TWO_WAY);
+    copy->addResults(SyncResults(QDateTime::currentDateTime(),
+                                 SyncResults::SYNC_RESULT_SUCCESS, SyncResults::NO_ERROR));
+    QCOMPARE(copy->destinationType(), SyncProfile::DESTINATION_TYPE_ONLINE);
+    QCOMPARE(copy->syncDirection(), SyncProfile::SYNC_DIRECTION_TWO_WAY);
+    QVERIFY(copy->lastResults() != 0);
+    QCOMPARE(p.toString(), original);
+    QCOMPARE(p.syncDirection(), SyncProfile::SYNC_DIRECTION_UNDEFINED);
+    QVERIFY(p.lastResults() == 0);
+
+    // Sub-profile pointers got before copying keep referring to the
+    // source only.
+    Profile *client = p.clientProfile();
+    QVERIFY(client != 0);
+    QScopedPointer<SyncProfile> later(p.clone());
+    QVERIFY(later->clientProfile() != client);
+    client->setKey(KEY_SYNC_DIRECTION, VALUE_TWO_WAY);
+    QCOMPARE(later->syncDirection(), SyncProfile::SYNC_DIRECTION_UNDEFINED);
+    client->removeKey(KEY_SYNC_DIRECTION);
+
+    // So does the log, even when modified through the const accessor.
+    const SyncProfile &constCopy = *copy;
+    QScopedPointer<SyncProfile> logCopy(copy->clone());
+    QVERIFY(constCopy.log() != logCopy->log());
+    constCopy.log()->addResults(SyncResults(QDateTime::currentDateTime(),
+                                            SyncResults::SYNC_RESULT_FAILED,
+                                            SyncResults::NO_ERROR));
+    QCOMPARE(logCopy->log()->allResults().size(), 1);
+
+    // Pointers got through the const accessors stay valid when the
+    // profile is modified and the copy it shared its data with is deleted.
+    SyncProfile *shared = new SyncProfile(doc.documentElement());
+    shared->addResults(SyncResults(QDateTime::currentDateTime(),
+                                   SyncResults::SYNC_RESULT_SUCCESS, SyncResults::NO_ERROR));
+    QScopedPointer<SyncProfile> reader(shared->clone());
+    const SyncProfile &constReader = *reader;
+    const Profile *constClient = constReader.clientProfile();
+    const SyncResults *constResults = constReader.lastResults();
+    QVERIFY(constClient != 0);
+    QVERIFY(constResults != 0);
+    reader->setKey(KEY_DESTINATION_TYPE, VALUE_ONLINE);
+    reader->addResults(SyncResults(QDateTime::currentDateTime(),
+                                   SyncResults::SYNC_RESULT_FAILED, SyncResults::NO_ERROR));
+    delete shared;
+    QVERIFY(reader->clientProfile() == constClient);
+    QVERIFY(reader->log()->allResults().contains(constResults));
+    QCOMPARE(constResults->majorCode(), SyncResults::SYNC_RESULT_SUCCESS);
+
+    // Same for results copied by assignment.
+    SyncResults failed(QDateTime::currentDateTime(),
+                       SyncResults::SYNC_RESULT_FAILED, SyncResults::NO_ERROR);
+    SyncResults assigned;
+    assigned = failed;
+    assigned.setMajorCode(SyncResults::SYNC_RESULT_SUCCESS);
+    QCOMPARE(failed.majorCode(), SyncResults::SYNC_RESULT_FAILED);
+}
+
+void SyncProfileTest::testChangeSet()
+{
+    const QString CONTACTS("hcontacts");
+    const QString CALENDAR("hcalendar");
+
+    StorageChangeSet changes;
+    QVERIFY(changes.isEmpty());
+    changes.addChanges(CONTACTS, QStringList() << "1" << "2" << "3", StorageChangeSet::ItemAdded);
+    changes.addChanges(CONTACTS, QStringList() << "4" << "5", StorageChangeSet::ItemModified);
+    changes.addChanges(CONTACTS, QStringList() << "6", StorageChangeSet::ItemDeleted);
+
+    // Later changes merge with the earlier ones.
+    StorageChangeSet later;
+    later.addChanges(CONTACTS, QStringList() << "1" << "4", StorageChangeSet::ItemModified);
+    later.addChanges(CONTACTS, QStringList() << "2" << "5", StorageChangeSet::ItemDeleted);
+    later.addChanges(CONTACTS, QStringList() << "6", StorageChangeSet::ItemAdded);
+    later.setIncomplete(CALENDAR);
+    changes.merge(later);
+
+    QStringList added = changes.items(CONTACTS, StorageChangeSet::ItemAdded);
+    QStringList modified = changes.items(CONTACTS, StorageChangeSet::ItemModified);
+    QStringList deleted = changes.items(CONTACTS, StorageChangeSet::ItemDeleted);
+    added.sort();
+    modified.sort();
+    QCOMPARE(added, QStringList() << "1" << "3");
+    QCOMPARE(modified, QStringList() << "4" << "6");
+    QCOMPARE(deleted, QStringList() << "5");
+    QCOMPARE(changes.itemCount(), 5);
+    QVERIFY(changes.isComplete(CONTACTS));
+    QVERIFY(!changes.isComplete(CALENDAR));
+
+    // Too many changes make the storage incomplete.
+    QStringList many;
+    for (int i = 0; i <= StorageChangeSet::MAX_ITEMS; ++i) {
+        many.append(QString::number(i));
+    }
+    StorageChangeSet big;
+    big.addChanges(CONTACTS, many, StorageChangeSet::ItemAdded);
+    QVERIFY(!big.isComplete(CONTACTS));
+    QCOMPARE(big.itemCount(), 0);
+
+    // The set survives the XML used to pass it to out-of-process plugins.
+    QXmlStreamReader reader(changes.toString());
+    QVERIFY(reader.readNextStartElement());
+    StorageChangeSet parsed(reader);
+    QVERIFY(!reader.hasError());
+    QStringList parsedStorages = parsed.storages();
+    parsedStorages.sort();
+    QCOMPARE(parsedStorages, QStringList() << CALENDAR << CONTACTS);
+    QVERIFY(parsed.isComplete(CONTACTS));
+    QVERIFY(!parsed.isComplete(CALENDAR));
+    QCOMPARE(parsed.itemCount(), 5);
+    QCOMPARE(parsed.items(CONTACTS, StorageChangeSet::ItemDeleted), deleted);
+    added = parsed.items(CONTACTS, StorageChangeSet::ItemAdded);
+    added.sort();
+    QCOMPARE(added, QStringList() << "1" << "3");
+
+    // Taking a storage leaves the others, and the profile carries the
+    // set to its copies.
+    StorageChangeSet contacts = changes.take(CONTACTS);
+    QCOMPARE(contacts.storages(), QStringList() << CONTACTS);
+    QCOMPARE(changes.storages(), QStringList() << CALENDAR);
+
+    SyncProfile p(NAME);
+    QVERIFY(p.changeSet().isEmpty());
+    p.setChangeSet(contacts);
+    QScopedPointer<SyncProfile> copy(p.clone());
+    QCOMPARE(copy->changeSet().itemCount(), 5);
+}
+
+void SyncProfileTest::benchmarkClone_data()
+{
+    QTest::addColumn<bool>("detach");
+
+    QTest::newRow("shared") << false;
+    QTest::newRow("detached") << true;
+}
+
+void SyncProfileTest::benchmarkClone()
+{
+    QFETCH(bool, detach);
+
+    QDomDocument doc;
+    QVERIFY(doc.setContent(PROFILE_XML, false));
+    SyncProfile p(doc.documentElement());
+    p.addResults(SyncResults(QDateTime::currentDateTime(),
+                             SyncResults::SYNC_RESULT_SUCCESS, SyncResults::NO_ERROR));
+
+    const int CLONES = 1000;
+    QList<SyncProfile *> clones;
+    clones.reserve(CLONES);
+
+    // Reports the objects allocated per clone. The detached row modifies
+    // every part of the clone, which costs as much as a deep copy.
+    const int before = allocationCount.load();
+    for (int i = 0; i < CLONES; ++i) {
+        SyncProfile *clone = p.clone();
+        if (detach) {
+            clone->setKey(KEY_DESTINATION_TYPE, VALUE_ONLINE);
+            foreach (Profile *sub, clone->allSubProfiles()) {
+                sub->setKey(KEY_ENABLED, BOOLEAN_TRUE);
+            }
+            clone->log()->setProfileName(NAME);
+        }
+        clones.append(clone);
+    }
+    const int allocations = allocationCount.load() - before;
+    qDeleteAll(clones);
+
+    if (!detach) {
+        // The profile and sync profile data are shared. Only the clone
+        // itself is allocated.
+        QVERIFY(allocations <= CLONES);
+    }
+    QTest::setBenchmarkResult(qreal(allocations) / CLONES, QTest::Events);
+}
+
 QTEST_GUILESS_MAIN(Buteo::SyncProfileTest)
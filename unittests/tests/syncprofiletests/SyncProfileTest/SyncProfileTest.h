@@ -43,6 +43,13 @@ private slots:
 
     void testSubProfiles();
 
+    void testImplicitSharing();
+
+    void testChangeSet();
+
+    void benchmarkClone_data();
+    void benchmarkClone();
+
 };
 }
 
@@ -23,6 +23,7 @@
 #include "SyncScheduleTest.h"
 #include "SyncSchedule.h"
 #include "SyncSchedule_p.h"
+#include "SyncProfile.h"
 
 #include <QDomDocument>
 
@@ -267,4 +268,118 @@ void SyncScheduleTest::testIsSyncScheduled()
     QVERIFY(!s.isSyncScheduled(QDateTime(QDate(2019, 8, 29), QTime(9, 0, 0, 0))));
 }
 
+// Monday
+static const QDateTime WEEK_START(QDate(2024, 1, 1), QTime(0, 0));
+
+static SyncSchedule rushSchedule()
+{
+    SyncSchedule s;
+    s.setScheduleEnabled(true);
+    s.setInterval(30);
+    s.setRushEnabled(true);
+    s.setRushInterval(10);
+    s.setRushTime(QTime(8, 0), QTime(16, 0));
+    s.setRushDays(SyncSchedule::Monday | SyncSchedule::Tuesday | SyncSchedule::Wednesday
+                  | SyncSchedule::Thursday | SyncSchedule::Friday);
+    return s;
+}
+
+void SyncScheduleTest::testNextSyncTimeWithClock()
+{
+    SyncClock::setClock(&iClock);
+
+    // The installed clock gives the same results as an explicit time.
+    SyncSchedule s = rushSchedule();
+    QDateTime previous = WEEK_START;
+    for (int minutes = 0; minutes < 7 * 24 * 60; minutes += 7) {
+        iClock.iNow = WEEK_START.addSecs(minutes * 60 + 13);
+        QCOMPARE(s.nextSyncTime(previous), s.nextSyncTime(previous, iClock.iNow));
+        if (minutes % 180 == 0) {
+            previous = iClock.iNow;
+        }
+    }
+
+    // Modifying the schedule changes the result.
+    iClock.iNow = WEEK_START.addSecs(60);
+    s.setRushEnabled(false);
+    QCOMPARE(s.nextSyncTime(WEEK_START), WEEK_START.addSecs(30 * 60));
+    s.setInterval(60);
+    QCOMPARE(s.nextSyncTime(WEEK_START), WEEK_START.addSecs(60 * 60));
+
+    // So does setting the clock back.
+    iClock.iNow = WEEK_START.addSecs(90 * 60);
+    QCOMPARE(s.nextSyncTime(WEEK_START), WEEK_START.addSecs(120 * 60));
+    iClock.iNow = WEEK_START.addSecs(30 * 60);
+    QCOMPARE(s.nextSyncTime(WEEK_START), WEEK_START.addSecs(60 * 60));
+
+    SyncClock::setClock(0);
+}
+
+void SyncScheduleTest::testNextRushSwitchTime()
+{
+    SyncSchedule s = rushSchedule();
+    const QDate monday = WEEK_START.date();
+
+    // Before, inside and after the rush on a rush day.
+    QCOMPARE(s.nextRushSwitchTime(WEEK_START.addSecs(29)), QDateTime(monday, QTime(8, 0)));
+    QCOMPARE(s.nextRushSwitchTime(QDateTime(monday, QTime(9, 0))), QDateTime(monday, QTime(16, 0)));
+    QCOMPARE(s.nextRushSwitchTime(QDateTime(monday, QTime(17, 0))),
+             QDateTime(monday.addDays(1), QTime(8, 0)));
+
+    // Not a rush day, the switch is attempted on the next day.
+    QCOMPARE(s.nextRushSwitchTime(QDateTime(monday.addDays(5), QTime(10, 0))),
+             QDateTime(monday.addDays(6), QTime(8, 0)));
+
+    s.setRushInterval(30);
+    QVERIFY(!s.nextRushSwitchTime(WEEK_START).isValid());
+}
+
+void SyncScheduleTest::testNextSyncTimes()
+{
+    SyncClock::setClock(&iClock);
+    iClock.iNow = WEEK_START.addSecs(9 * 3600 + 5 * 60);
+
+    QList<SyncProfile *> profiles;
+    for (int i = 0; i < 3; ++i) {
+        SyncProfile *profile = new SyncProfile(QString("profile%1").arg(i));
+        SyncSchedule schedule = rushSchedule();
+        schedule.setInterval(15 * (i + 1));
+        schedule.setScheduleConfiguredTime(WEEK_START);
+        profile->setSyncSchedule(schedule);
+        profile->setSyncType(i < 2 ? SyncProfile::SYNC_SCHEDULED : SyncProfile::SYNC_MANUAL);
+        profiles.append(profile);
+    }
+
+    const QHash<QString, QDateTime> times = SyncProfile::nextSyncTimes(profiles);
+    QCOMPARE(times.size(), 2);
+    for (int i = 0; i < 2; ++i) {
+        QCOMPARE(times.value(profiles.at(i)->name()),
+                 profiles.at(i)->nextSyncTime(profiles.at(i)->lastSyncTime()));
+    }
+    QVERIFY(!times.contains(profiles.at(2)->name()));
+
+    qDeleteAll(profiles);
+    SyncClock::setClock(0);
+}
+
+void SyncScheduleTest::benchmarkNextSyncTime()
+{
+    const int SCHEDULES = 1000;
+    QVector<SyncSchedule> schedules;
+    QVector<QDateTime> previous;
+    for (int i = 0; i < SCHEDULES; ++i) {
+        SyncSchedule s = rushSchedule();
+        s.setInterval(15 + i % 4 * 15);
+        schedules.append(s);
+        previous.append(WEEK_START.addSecs(i));
+    }
+
+    const QDateTime now = WEEK_START.addSecs(20 * 3600);
+    QBENCHMARK {
+        for (int i = 0; i < SCHEDULES; ++i) {
+            schedules.at(i).nextSyncTime(previous.at(i), now);
+        }
+    }
+}
+
 QTEST_MAIN(Buteo::SyncScheduleTest)
@@ -24,9 +24,21 @@
 #define SYNCSCHEDULETEST_H
 
 #include <QtTest/QtTest>
+#include "SyncClock.h"
 
 namespace Buteo {
 
+class TestClock : public SyncClock
+{
+public:
+    QDateTime now() const
+    {
+        return iNow;
+    }
+
+    QDateTime iNow;
+};
+
 class SyncScheduleTest: public QObject
 {
     Q_OBJECT
@@ -40,6 +52,17 @@ private slots:
     void testNextSyncTime();
 
     void testIsSyncScheduled();
+
+    void testNextSyncTimeWithClock();
+
+    void testNextRushSwitchTime();
+
+    void testNextSyncTimes();
+
+    void benchmarkNextSyncTime();
+
+private:
+    TestClock iClock;
 };
 
 }